@@ -0,0 +1,22 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Counts heap allocations so benchmarks can report bytes per operation.
+
+/// @file Allocations.h
+/// @brief Heap allocation counter for benchmarks
+/// @author Adam Getchell
+
+#ifndef BENCHMARKS_ALLOCATIONS_H_
+#define BENCHMARKS_ALLOCATIONS_H_
+
+#include <cstddef>
+
+/// @brief Total bytes requested from global operator new so far
+///
+/// Defined in main.cpp, which replaces the global allocation functions.
+/// @return Bytes allocated since the program started
+std::size_t allocated_bytes() noexcept;
+
+#endif  // BENCHMARKS_ALLOCATIONS_H_
@@ -0,0 +1,91 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Benchmarks the action, the Metropolis acceptance probabilities, and
+/// moves made by Metropolis.
+
+/// @file MetropolisBenchmark.cpp
+/// @brief Benchmarks for S3Action and Metropolis
+/// @author Adam Getchell
+
+#include "Allocations.h"
+#include "Metropolis.h"
+#include "S3Action.h"
+#include "SimplicialManifold.h"
+#include "benchmark/benchmark.h"
+
+static void BM_S3BulkAction(benchmark::State& state) {
+  long double        Alpha  = 0.6;
+  long double        K      = 1.1;
+  long double        Lambda = 0.1;
+  SimplicialManifold universe(state.range(0), 16);
+  for (auto _ : state) {
+    auto action = S3_bulk_action(
+        universe.geometry->N1_TL(), universe.geometry->N3_31_13(),
+        universe.geometry->N3_22(), Alpha, K, Lambda);
+    benchmark::DoNotOptimize(action);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_S3BulkAction)->Arg(6400);
+
+/// Runs Metropolis with no passes, which makes one move of each type so
+/// that CalculateA1() and CalculateA2() have counts to work from.
+static void BM_CalculateA1A2(benchmark::State& state) {
+  long double        Alpha  = 0.6;
+  long double        K      = 1.1;
+  long double        Lambda = 0.1;
+  SimplicialManifold universe(state.range(0), 16);
+  Metropolis         run(Alpha, K, Lambda, 0, 1);
+  universe = std::move(run(universe));
+  for (auto _ : state) {
+    for (auto move : {move_type::TWO_THREE, move_type::THREE_TWO,
+                      move_type::TWO_SIX, move_type::SIX_TWO}) {
+      benchmark::DoNotOptimize(run.CalculateA1(move));
+      benchmark::DoNotOptimize(run.CalculateA2(move));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 4);
+}
+BENCHMARK(BM_CalculateA1A2)->Arg(6400);
+
+/// @brief Desired simplices and move_type for BM_MetropolisMakeMove
+/// @param b The benchmark to add arguments to
+static void metropolis_moves(benchmark::internal::Benchmark* b) {
+  for (auto simplices : {6400, 64000}) {
+    for (auto move = 0; move < 4; ++move) b->Args({simplices, move});
+  }
+}
+
+/// Times Basic_metropolis::make_move(), which makes each move in place
+/// through MoveManager, checks it, and updates the geometry, as every
+/// attempt of a run does. Metropolis first runs with no passes, which
+/// builds the flip indexes. Each (3,2) or (6,2) move is set up by an
+/// untimed (2,3) or (2,6) move so that candidates don't run out. Reports
+/// moves/second as items_per_second and heap traffic as bytes/move.
+static void BM_MetropolisMakeMove(benchmark::State& state) {
+  long double        Alpha  = 0.6;
+  long double        K      = 1.1;
+  long double        Lambda = 0.1;
+  SimplicialManifold universe(state.range(0), 16);
+  Metropolis         run(Alpha, K, Lambda, 0, 1);
+  run(universe);
+  auto        move = static_cast<move_type>(state.range(1));
+  std::size_t bytes{0};
+  for (auto _ : state) {
+    if (move == move_type::THREE_TWO || move == move_type::SIX_TWO) {
+      state.PauseTiming();
+      run.make_move(move == move_type::THREE_TWO ? move_type::TWO_THREE
+                                                 : move_type::TWO_SIX);
+      state.ResumeTiming();
+    }
+    auto before = allocated_bytes();
+    run.make_move(move);
+    bytes += allocated_bytes() - before;
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["bytes/move"] = benchmark::Counter(
+      static_cast<double>(bytes), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_MetropolisMakeMove)->Apply(metropolis_moves);
@@ -0,0 +1,98 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Benchmarks each ergodic move on its own, without checking it or
+/// updating the geometry as MoveManager does; MetropolisBenchmark.cpp times
+/// moves as Metropolis makes them. Reports moves/second as items_per_second
+/// and heap traffic as bytes/move.
+///
+/// Moves work in place, so each benchmark keeps one manifold, and the flip
+/// indexes it builds on first use, across iterations. Assigning a move's
+/// result back to the manifold would drop the indexes, and time their O(N)
+/// rebuild instead of the move.
+
+/// @file S3ErgodicMovesBenchmark.cpp
+/// @brief Benchmarks for ergodic moves
+/// @author Adam Getchell
+
+#include <utility>
+
+#include "Allocations.h"
+#include "S3ErgodicMoves.h"
+#include "SimplicialManifold.h"
+#include "benchmark/benchmark.h"
+
+/// @brief Report moves/second and bytes/move
+/// @param state The benchmark state
+/// @param bytes allocated_bytes() before the benchmark loop
+static void report_moves(benchmark::State& state, const std::size_t bytes) {
+  state.SetItemsProcessed(state.iterations());
+  state.counters["bytes/move"] =
+      benchmark::Counter(static_cast<double>(allocated_bytes() - bytes),
+                         benchmark::Counter::kAvgIterations);
+}
+
+/// @brief Build the flip indexes before timing, as a long run has
+/// @param universe The manifold
+static void prime_flip_indexes(SimplicialManifold& universe) {
+  flippable_23_facets(universe);
+  flippable_32_edges(universe);
+}
+
+static void BM_Make23Move(benchmark::State& state) {
+  SimplicialManifold universe(state.range(0), 16);
+  Move_tracker       attempted_moves{};
+  prime_flip_indexes(universe);
+  auto bytes = allocated_bytes();
+  for (auto _ : state) {
+    make_23_move(std::move(universe), attempted_moves);
+  }
+  report_moves(state, bytes);
+}
+BENCHMARK(BM_Make23Move)->Arg(6400)->Arg(64000);
+
+static void BM_Make32Move(benchmark::State& state) {
+  SimplicialManifold universe(state.range(0), 16);
+  Move_tracker       attempted_moves{};
+  prime_flip_indexes(universe);
+  auto bytes = allocated_bytes();
+  for (auto _ : state) {
+    make_32_move(std::move(universe), attempted_moves);
+  }
+  report_moves(state, bytes);
+}
+BENCHMARK(BM_Make32Move)->Arg(6400)->Arg(64000);
+
+static void BM_Make26Move(benchmark::State& state) {
+  SimplicialManifold universe(state.range(0), 16);
+  Move_tracker       attempted_moves{};
+  prime_flip_indexes(universe);
+  auto bytes = allocated_bytes();
+  for (auto _ : state) {
+    make_26_move(std::move(universe), attempted_moves);
+  }
+  report_moves(state, bytes);
+}
+BENCHMARK(BM_Make26Move)->Arg(6400)->Arg(64000);
+
+/// Each (6,2) move is set up by an untimed (2,6) move so that movable
+/// vertices don't run out.
+static void BM_Make62Move(benchmark::State& state) {
+  SimplicialManifold universe(state.range(0), 16);
+  Move_tracker       attempted_moves{};
+  std::size_t        bytes{0};
+  prime_flip_indexes(universe);
+  for (auto _ : state) {
+    state.PauseTiming();
+    make_26_move(std::move(universe), attempted_moves);
+    auto before = allocated_bytes();
+    state.ResumeTiming();
+    make_62_move(std::move(universe), attempted_moves);
+    bytes += allocated_bytes() - before;
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["bytes/move"] = benchmark::Counter(
+      static_cast<double>(bytes), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_Make62Move)->Arg(6400)->Arg(64000);
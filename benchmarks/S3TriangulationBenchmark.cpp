@@ -0,0 +1,65 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Benchmarks triangulation construction, classification, and measurement.
+
+/// @file S3TriangulationBenchmark.cpp
+/// @brief Benchmarks for S3 triangulations
+/// @author Adam Getchell
+
+#include "Allocations.h"
+#include "Measurements.h"
+#include "S3Triangulation.h"
+#include "SimplicialManifold.h"
+#include "benchmark/benchmark.h"
+
+/// @brief Desired simplices and timeslices for BM_MakeTriangulation
+/// @param b The benchmark to add arguments to
+static void triangulation_sizes(benchmark::internal::Benchmark* b) {
+  for (auto simplices : {6400, 32000, 64000}) {
+    for (auto timeslices : {8, 16, 32}) b->Args({simplices, timeslices});
+  }
+}
+
+static void BM_MakeTriangulation(benchmark::State& state) {
+  auto bytes = allocated_bytes();
+  for (auto _ : state) {
+    auto universe = make_triangulation(state.range(0), state.range(1));
+    benchmark::DoNotOptimize(universe);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["bytes/simplex"] = benchmark::Counter(
+      static_cast<double>(allocated_bytes() - bytes) / state.range(0),
+      benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_MakeTriangulation)
+    ->Apply(triangulation_sizes)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_ClassifyAllSimplices(benchmark::State& state) {
+  auto universe = make_triangulation(state.range(0), 16);
+  for (auto _ : state) {
+    auto geometry = classify_all_simplices(universe);
+    benchmark::DoNotOptimize(geometry);
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          universe->number_of_finite_cells());
+}
+BENCHMARK(BM_ClassifyAllSimplices)
+    ->Arg(6400)
+    ->Arg(64000)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_VolumePerTimeslice(benchmark::State& state) {
+  SimplicialManifold universe(state.range(0), 16);
+  for (auto _ : state) {
+    VolumePerTimeslice(universe);
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          universe.geometry->number_of_cells());
+}
+BENCHMARK(BM_VolumePerTimeslice)
+    ->Arg(6400)
+    ->Arg(64000)
+    ->Unit(benchmark::kMillisecond);
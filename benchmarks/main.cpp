@@ -0,0 +1,35 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Runs the Google Benchmark suite. Results can be saved for comparison
+/// between releases with --benchmark_out=FILE --benchmark_out_format=json.
+
+/// @file main.cpp
+/// @brief Google Benchmark driver with a counting allocator
+/// @author Adam Getchell
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "Allocations.h"
+#include "benchmark/benchmark.h"
+
+namespace {
+std::atomic_size_t bytes_allocated{0};
+}  // namespace
+
+std::size_t allocated_bytes() noexcept { return bytes_allocated.load(); }
+
+void* operator new(std::size_t size) {
+  bytes_allocated.fetch_add(size, std::memory_order_relaxed);
+  if (auto* memory = std::malloc(size ? size : 1)) return memory;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+
+BENCHMARK_MAIN();
@@ -1,6 +1,7 @@
 #!/bin/bash -l
 # For use on Slurm
-# sbatch -p high -t 60 slurm.sh
+# sbatch -p high -t 60 -c 8 slurm.sh
+# Worker threads default to the CPUs allocated with -c
 module load cmake gcc boost cgal tbb
 rm -rf build/
 mkdir build && cd build
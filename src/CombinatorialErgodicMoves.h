@@ -0,0 +1,425 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Performs ergodic moves on combinatorial (2+1) spacetimes.
+///
+/// make_ergodic_move() from S3ErgodicMoves.h works on a
+/// CombinatorialManifold through the overloads here, so MoveManager and the
+/// Metropolis algorithm run on it unchanged. Each move draws a random
+/// candidate until one passes its combinatorial test, and scans for every
+/// candidate only when random draws keep failing, so each is chosen
+/// uniformly.
+///
+/// \done (2,3) move
+/// \done (3,2) move
+/// \done (2,6) move
+/// \done (6,2) move
+/// \done Undo the last move with undo_move()
+/// \todo (4,4) move
+
+/// @file CombinatorialErgodicMoves.h
+/// @brief Pachner moves on combinatorial triangulations
+/// @author Adam Getchell
+
+#ifndef SRC_COMBINATORIALERGODICMOVES_H_
+#define SRC_COMBINATORIALERGODICMOVES_H_
+
+// C++ headers
+#include <array>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// CDT headers
+#include "CombinatorialManifold.h"
+#include "S3ErgodicMoves.h"
+
+/// Random draws of a candidate before scanning for all of them
+static constexpr int MAX_CANDIDATE_DRAWS = 64;
+
+/// Indices in a cell of the vertices of each of its six edges
+static constexpr std::array<std::array<int, 2>, 6> EDGE_VERTEX_INDEX{
+    {{{0, 1}}, {{0, 2}}, {{0, 3}}, {{1, 2}}, {{1, 3}}, {{2, 3}}}};
+
+/// @brief Choose a candidate for a move uniformly
+///
+/// Candidates are drawn at random until one passes **test**. If none has
+/// after MAX_CANDIDATE_DRAWS draws, all of them are tested and one that
+/// passes is chosen.
+///
+/// @tparam Drawn A predicate on candidate numbers
+/// @tparam Test A predicate on candidate numbers
+/// @param candidates The number of candidates
+/// @param is_drawn Whether a candidate is of the kind the move counts as
+/// an attempt
+/// @param test Whether the move can be made on a candidate
+/// @param[out] draws Incremented for each attempt
+/// @return The chosen candidate, or -1 if no candidate passes
+template <typename Drawn, typename Test>
+std::intmax_t choose_candidate(const std::intmax_t candidates,
+                               Drawn&& is_drawn, Test&& test,
+                               std::intmax_t& draws) {
+  for (auto n = 0; n < MAX_CANDIDATE_DRAWS && candidates > 0; ++n) {
+    auto choice = generate_random_signed(0, candidates - 1);
+    if (!is_drawn(choice)) continue;
+    ++draws;
+    if (test(choice)) return choice;
+  }
+
+  // Few candidates pass, so find them all
+  thread_local std::vector<std::intmax_t> passing;
+  passing.clear();
+  for (std::intmax_t choice = 0; choice < candidates; ++choice) {
+    if (test(choice)) passing.emplace_back(choice);
+  }
+  if (passing.empty()) return -1;
+  ++draws;
+  return passing[generate_random_signed(
+      0, static_cast<std::intmax_t>(passing.size()) - 1)];
+}  // choose_candidate()
+
+/// @brief Flip a facet of a CombinatorialManifold into an edge
+///
+/// The (2,3) move, and the inverse of a (3,2) move. The triangulation
+/// keeps its own counts and has no flip indexes, so only the move and the
+/// vertices of its inverse are recorded in last_move_record().
+///
+/// @param universe A CombinatorialManifold
+/// @param cell A cell
+/// @param i The index of the vertex opposite a facet for which
+/// is_23_flippable() is true
+inline void flip_23(CombinatorialManifold& universe,
+                    const Combinatorial_cell cell, const int i) {
+  auto& triangulation = *universe.triangulation;
+  auto  top           = triangulation.vertex(cell, i);
+  auto  bottom        = triangulation.vertex(triangulation.neighbor(cell, i),
+                                     triangulation.mirror_index(cell, i));
+  triangulation.flip_23(cell, i);
+
+  auto& record = last_move_record<CombinatorialManifold>();
+  record.clear();
+  record.move     = move_type::TWO_THREE;
+  record.vertices = {top, bottom};
+  last_move_vertices<Combinatorial_vertex>() = {top, bottom};
+}  // flip_23()
+
+/// @brief Flip an edge of degree 3 of a CombinatorialManifold into a facet
+///
+/// The (3,2) move, and the inverse of a (2,3) move, recording the edge and
+/// its ring in last_move_record().
+///
+/// @param universe A CombinatorialManifold
+/// @param cell A cell containing the edge
+/// @param i The index in **cell** of one vertex of an edge for which
+/// is_32_flippable() is true
+/// @param j The index in **cell** of the other vertex of the edge
+inline void flip_32(CombinatorialManifold& universe,
+                    const Combinatorial_cell cell, const int i, const int j) {
+  auto& triangulation = *universe.triangulation;
+  auto  first         = triangulation.vertex(cell, i);
+  auto  second        = triangulation.vertex(cell, j);
+  auto& record        = last_move_record<CombinatorialManifold>();
+  record.clear();
+  record.vertices = {first, second};
+  thread_local std::vector<Combinatorial_cell> around;
+  around.clear();
+  triangulation.incident_cells(cell, i, j, std::back_inserter(around));
+  for (const auto& c : around) {
+    for (auto k = 0; k < 4; ++k) {
+      auto vertex = triangulation.vertex(c, k);
+      if (std::find(record.vertices.begin(), record.vertices.end(), vertex) ==
+          record.vertices.end())
+        record.vertices.emplace_back(vertex);
+    }
+  }
+  triangulation.flip_32(cell, i, j);
+  record.move = move_type::THREE_TWO;
+  last_move_vertices<Combinatorial_vertex>() = {first, second};
+}  // flip_32()
+
+/// @brief Insert a vertex in the spacelike facet of a (1,3) cell of a
+/// CombinatorialManifold
+///
+/// The (2,6) move. The new vertex is at the centroid of the facet.
+///
+/// @param universe A CombinatorialManifold
+/// @param cell A (1,3) cell
+/// @param i The index of the vertex opposite a facet for which
+/// is_26_movable() is true
+/// @return The new vertex
+inline Combinatorial_vertex insert_26_vertex(CombinatorialManifold&   universe,
+                                             const Combinatorial_cell cell,
+                                             const int                i) {
+  auto center = universe.triangulation->insert_in_facet(cell, i);
+
+  auto& record = last_move_record<CombinatorialManifold>();
+  record.clear();
+  record.move = move_type::TWO_SIX;
+  record.vertices.assign({center});
+  last_move_vertices<Combinatorial_vertex>() = {center};
+  return center;
+}  // insert_26_vertex()
+
+/// @brief Insert a vertex at a given point in the spacelike facet of a
+/// (1,3) cell of a CombinatorialManifold
+///
+/// The inverse of a (6,2) move, which restores the removed vertex's point.
+///
+/// @param universe A CombinatorialManifold
+/// @param cell A cell
+/// @param i The index of the vertex opposite a spacelike facet
+/// @param point The point of the new vertex
+/// @return The new vertex
+inline Combinatorial_vertex insert_26_vertex(CombinatorialManifold&   universe,
+                                             const Combinatorial_cell cell,
+                                             const int                i,
+                                             const Point&             point) {
+  auto center = insert_26_vertex(universe, cell, i);
+  universe.triangulation->set_point(center, point);
+  return center;
+}  // insert_26_vertex()
+
+/// @brief Remove the vertex of a (6,2) move from a CombinatorialManifold
+///
+/// The (6,2) move, and the inverse of a (2,6) move, recording the ring of
+/// the removed vertex and its point in last_move_record().
+///
+/// @param universe A CombinatorialManifold
+/// @param vertex A vertex for which is_62_movable() is true
+/// @return **True**, since the collapse can't fail once it is movable
+inline bool remove_62_vertex(CombinatorialManifold&     universe,
+                             const Combinatorial_vertex vertex) {
+  auto& triangulation = *universe.triangulation;
+  auto  point         = triangulation.point(vertex);
+
+  // The link of the removed vertex, renumbered if need be
+  auto link = triangulation.collapse_62(vertex);
+
+  auto& record = last_move_record<CombinatorialManifold>();
+  record.clear();
+  record.move  = move_type::SIX_TWO;
+  record.point = point;
+  record.vertices.assign(link.begin() + 2, link.end());
+  last_move_vertices<Combinatorial_vertex>().assign(link.begin(), link.end());
+  return true;
+}  // remove_62_vertex()
+
+/// @brief A cell of a CombinatorialManifold containing given vertices
+/// @param triangulation The triangulation
+/// @param first A vertex
+/// @param others Other vertices
+/// @return A cell containing **first** and each of **others**
+inline Combinatorial_cell cell_containing(
+    const Combinatorial_triangulation& triangulation,
+    const Combinatorial_vertex first,
+    std::initializer_list<Combinatorial_vertex> others) {
+  thread_local std::vector<Combinatorial_cell> star;
+  star.clear();
+  triangulation.incident_cells(first, std::back_inserter(star));
+  auto found = std::find_if(star.begin(), star.end(), [&](const auto cell) {
+    return std::all_of(others.begin(), others.end(), [&](const auto vertex) {
+      return triangulation.has_vertex(cell, vertex);
+    });
+  });
+  if (found == star.end())
+    throw std::runtime_error("cell_containing() found no such cell!");
+  return *found;
+}  // cell_containing()
+
+/// @brief Undo the last move made on a CombinatorialManifold
+///
+/// Makes the inverse of the move in last_move_record(), which then records
+/// the inverse in turn. Only vertices are recorded, since cells may be
+/// renumbered by a move.
+///
+/// @param universe The CombinatorialManifold last moved
+inline void undo_move(CombinatorialManifold& universe) {
+  // The inverse move overwrites the record
+  auto record = last_move_record<CombinatorialManifold>();
+  if (!record.move) return;
+
+  auto&       triangulation = *universe.triangulation;
+  const auto& vertices      = record.vertices;
+  switch (*record.move) {
+    case move_type::TWO_THREE: {
+      Combinatorial_cell cell{};
+      int                i{0};
+      int                j{0};
+      if (!triangulation.is_edge(vertices[0], vertices[1], cell, i, j))
+        throw std::runtime_error("undo_move() lost the edge of a (2,3) move!");
+      flip_32(universe, cell, i, j);
+      break;
+    }
+    case move_type::THREE_TWO: {
+      auto cell = cell_containing(triangulation, vertices[0],
+                                  {vertices[2], vertices[3], vertices[4]});
+      flip_23(universe, cell, triangulation.index(cell, vertices[0]));
+      break;
+    }
+    case move_type::TWO_SIX:
+      remove_62_vertex(universe, vertices[0]);
+      break;
+    case move_type::SIX_TWO: {
+      auto cell = cell_containing(triangulation, vertices[0],
+                                  {vertices[1], vertices[2]});
+      auto i = 0;
+      while (std::find(vertices.begin(), vertices.end(),
+                       triangulation.vertex(cell, i)) != vertices.end())
+        ++i;
+      insert_26_vertex(universe, cell, i, record.point);
+      break;
+    }
+    case move_type::FOUR_FOUR:
+      break;
+  }
+}  // undo_move()
+
+/// @brief Make a (2,3) move on a CombinatorialManifold
+///
+/// Facets are drawn as a cell and the index of the vertex opposite. As
+/// with a SimplicialManifold, each call counts as one attempt.
+///
+/// @param universe A CombinatorialManifold
+/// @param attempted_moves A count of the attempted moves of each type
+/// @return The CombinatorialManifold after the move has been made
+inline auto make_23_move(CombinatorialManifold&& universe,
+                         Move_tracker& attempted_moves) -> decltype(universe) {
+#ifndef NDEBUG
+  std::cout << __PRETTY_FUNCTION__ << " called." << std::endl;
+#endif
+  CDT_TIME_PHASE(phase::MOVE);
+  auto&         triangulation = *universe.triangulation;
+  std::intmax_t draws{0};
+  auto          choice = choose_candidate(
+      4 * triangulation.number_of_cells(),
+      [](std::intmax_t) { return true; },
+      [&triangulation](const std::intmax_t facet) {
+        return triangulation.is_23_flippable(
+            static_cast<Combinatorial_cell>(facet / 4),
+            static_cast<int>(facet % 4));
+      },
+      draws);
+  if (choice < 0)
+    throw std::runtime_error("make_23_move() found no flippable facet!");
+
+  flip_23(universe, static_cast<Combinatorial_cell>(choice / 4),
+          static_cast<int>(choice % 4));
+
+  // Increment the (2,3) move counter
+  ++attempted_moves[0];
+  CDT_RECORD_RETRIES(move_type::TWO_THREE, draws);
+  return std::move(universe);
+}  // make_23_move()
+
+/// @brief Make a (3,2) move on a CombinatorialManifold
+///
+/// Edges are drawn as a cell and one of its six edges, so an edge of
+/// degree 3 is as likely as any other. Each call counts as one attempt.
+///
+/// @param universe A CombinatorialManifold
+/// @param attempted_moves A count of the attempted moves of each type
+/// @return The CombinatorialManifold after the move has been made
+inline auto make_32_move(CombinatorialManifold&& universe,
+                         Move_tracker& attempted_moves) -> decltype(universe) {
+#ifndef NDEBUG
+  std::cout << "Attempting (3,2) move." << std::endl;
+#endif
+  CDT_TIME_PHASE(phase::MOVE);
+  auto&         triangulation = *universe.triangulation;
+  std::intmax_t draws{0};
+  auto          choice = choose_candidate(
+      6 * triangulation.number_of_cells(),
+      [](std::intmax_t) { return true; },
+      [&triangulation](const std::intmax_t edge) {
+        const auto& index = EDGE_VERTEX_INDEX[edge % 6];
+        return triangulation.is_32_flippable(
+            static_cast<Combinatorial_cell>(edge / 6), index[0], index[1]);
+      },
+      draws);
+  if (choice < 0)
+    throw std::runtime_error("make_32_move() found no flippable edge!");
+
+  const auto& index = EDGE_VERTEX_INDEX[choice % 6];
+  flip_32(universe, static_cast<Combinatorial_cell>(choice / 6), index[0],
+          index[1]);
+
+  // Increment the (3,2) move counter
+  ++attempted_moves[1];
+  CDT_RECORD_RETRIES(move_type::THREE_TWO, draws);
+  return std::move(universe);
+}  // make_32_move()
+
+/// @brief Make a (2,6) move on a CombinatorialManifold
+///
+/// As with a SimplicialManifold, each (1,3) cell tried counts as an
+/// attempt.
+///
+/// @param universe A CombinatorialManifold
+/// @param attempted_moves A count of the attempted moves of each type
+/// @return The CombinatorialManifold after the move has been made
+inline auto make_26_move(CombinatorialManifold&& universe,
+                         Move_tracker& attempted_moves) -> decltype(universe) {
+#ifndef NDEBUG
+  std::cout << "Attempting (2,6) move." << std::endl;
+#endif
+  CDT_TIME_PHASE(phase::MOVE);
+  auto&         triangulation = *universe.triangulation;
+  std::intmax_t draws{0};
+  auto          choice = choose_candidate(
+      triangulation.number_of_cells(),
+      [&triangulation](const std::intmax_t cell) {
+        return triangulation.cell_type(
+                   static_cast<Combinatorial_cell>(cell)) == 13;
+      },
+      [&triangulation](const std::intmax_t cell) {
+        int i{0};
+        return triangulation.is_26_movable(
+            static_cast<Combinatorial_cell>(cell), i);
+      },
+      draws);
+  if (choice < 0) throw std::domain_error("No (2,6) move is possible.");
+
+  auto cell = static_cast<Combinatorial_cell>(choice);
+  int  i{0};
+  triangulation.is_26_movable(cell, i);
+  insert_26_vertex(universe, cell, i);
+
+  // Increment the (2,6) move counter
+  attempted_moves[2] += draws;
+  CDT_RECORD_RETRIES(move_type::TWO_SIX, draws);
+  return std::move(universe);
+}  // make_26_move()
+
+/// @brief Make a (6,2) move on a CombinatorialManifold
+///
+/// As with a SimplicialManifold, each vertex tried counts as an attempt.
+///
+/// @param universe A CombinatorialManifold
+/// @param attempted_moves A count of the attempted moves of each type
+/// @return The CombinatorialManifold after the move has been made
+inline auto make_62_move(CombinatorialManifold&& universe,
+                         Move_tracker& attempted_moves) -> decltype(universe) {
+  CDT_TIME_PHASE(phase::MOVE);
+  auto&         triangulation = *universe.triangulation;
+  std::intmax_t draws{0};
+  auto          choice = choose_candidate(
+      triangulation.number_of_vertices(),
+      [](std::intmax_t) { return true; },
+      [&triangulation](const std::intmax_t vertex) {
+        return triangulation.is_62_movable(
+            static_cast<Combinatorial_vertex>(vertex));
+      },
+      draws);
+  if (choice < 0) throw std::domain_error("No (6,2) move is possible.");
+
+  remove_62_vertex(universe, static_cast<Combinatorial_vertex>(choice));
+
+  // Increment the (6,2) move counter
+  attempted_moves[3] += draws;
+  CDT_RECORD_RETRIES(move_type::SIX_TWO, draws);
+  return std::move(universe);
+}  // make_62_move()
+
+#endif  // SRC_COMBINATORIALERGODICMOVES_H_
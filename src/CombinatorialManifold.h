@@ -0,0 +1,312 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Data structures for operations on combinatorial manifolds
+///
+/// A CombinatorialManifold runs the Monte Carlo phase of a spherical
+/// universe on a Combinatorial_triangulation. It is made from a
+/// SimplicialManifold, which CGAL generates, and converted back to one for
+/// output. In between, the Metropolis algorithm, MoveManager, Simulation,
+/// and trajectories work on it through the overloads below and in
+/// CombinatorialErgodicMoves.h, and no geometric predicate is evaluated.
+///
+/// \done CombinatorialManifold from a SimplicialManifold
+/// \done Conversion back to a SimplicialManifold
+/// \todo Save and load universes without converting them
+
+/// @file  CombinatorialManifold.h
+/// @brief Data structures for combinatorial manifolds
+/// @author Adam Getchell
+
+#ifndef SRC_COMBINATORIALMANIFOLD_H_
+#define SRC_COMBINATORIALMANIFOLD_H_
+
+#include <map>
+#include <memory>
+#include <set>
+#include <utility>
+
+#include "CombinatorialTriangulation.h"
+#include "SimplicialManifold.h"
+#include "Snapshot.h"
+#include "Trace.h"
+
+/// @struct
+/// @brief Simplex counts of a Combinatorial_triangulation
+///
+/// The counterpart of GeometryInfo{}, which holds handles to each simplex.
+/// A Combinatorial_triangulation keeps its counts current through every
+/// move, so only the counts are copied here.
+struct Combinatorial_geometry_info {
+  /// @brief Number of (3,1) cells in the foliation
+  std::intmax_t three_one{0};
+
+  /// @brief Number of (2,2) cells in the foliation
+  std::intmax_t two_two{0};
+
+  /// @brief Number of (1,3) cells in the foliation
+  std::intmax_t one_three{0};
+
+  /// @brief Number of edges spanning two adjacent time slices
+  std::intmax_t timelike_edges{0};
+
+  /// @brief Number of edges on a single time slice
+  std::intmax_t spacelike_edges{0};
+
+  /// @brief Number of vertices
+  std::intmax_t vertices{0};
+
+  /// @brief Number of spacelike facets for each timeslice
+  boost::optional<std::map<std::intmax_t, std::intmax_t>> spacelike_facets;
+
+  /// @brief Actual timevalues of simulation
+  boost::optional<std::set<std::intmax_t>> timevalues;
+
+  /// @brief Default constructor
+  /// @return An empty Combinatorial_geometry_info{}
+  Combinatorial_geometry_info() = default;
+
+  /// @brief Classify the simplices of a triangulation
+  /// @param triangulation The Combinatorial_triangulation
+  /// @return A populated Combinatorial_geometry_info{}
+  explicit Combinatorial_geometry_info(
+      const Combinatorial_triangulation& triangulation)
+      : three_one{triangulation.N3_31()}
+      , two_two{triangulation.N3_22()}
+      , one_three{triangulation.N3_13()}
+      , timelike_edges{triangulation.N1_TL()}
+      , spacelike_edges{triangulation.N1_SL()}
+      , vertices{triangulation.number_of_vertices()} {}
+
+  /// @brief Timelike edges
+  /// @return The number of edges spanning timeslices
+  auto N1_TL() const noexcept { return timelike_edges; }
+
+  /// @brief Spacelike edges
+  /// @return The number of edges on same timeslice
+  auto N1_SL() const noexcept { return spacelike_edges; }
+
+  /// @brief (3,1) simplices
+  /// @return The number of simplices with 3 vertices on the t timeslice
+  /// and 1 vertex on the t+1 timeslice
+  auto N3_31() const noexcept { return three_one; }
+
+  /// @brief (1,3) simplices
+  /// @return The number of simplices with 1 vertex on the t timeslice and
+  /// 3 vertices on the t+1 timeslice
+  auto N3_13() const noexcept { return one_three; }
+
+  /// @brief (3,1) and (1,3) simplices
+  /// @return The number of simplices with 3 vertices on one timeslice and
+  /// 1 vertex on the adjacent timeslice
+  auto N3_31_13() const noexcept { return N3_31() + N3_13(); }
+
+  /// @brief (2,2) simplices
+  /// @return The number of simplices with 2 vertices on one timeslice and
+  /// 2 vertices on the adjacent timeslice
+  auto N3_22() const noexcept { return two_two; }
+
+  /// @brief Number of cells
+  /// @return The number of finite cells
+  auto number_of_cells() const noexcept {
+    return N3_31() + N3_22() + N3_13();
+  }
+
+  /// @brief Number of edges
+  /// @return The number of finite edges
+  auto number_of_edges() const noexcept { return N1_TL() + N1_SL(); }
+
+  /// @brief Largest timevalue, once VolumePerTimeslice() has found them
+  /// @return The largest timevalue, or 0
+  boost::optional<std::intmax_t> max_timevalue() const {
+    return timevalues && !timevalues->empty() ? *timevalues->crbegin() : 0;
+  }
+
+  /// @brief Number of vertices
+  /// @return The number of finite vertices
+  auto N0() const noexcept { return vertices; }
+};
+
+/// @struct
+/// @brief A struct to hold a combinatorial triangulation and its simplex
+/// counts
+///
+/// Copies are deep, and cost a few contiguous copies of the triangulation.
+struct CombinatorialManifold {
+  /// @brief Topology of the foliation
+  static constexpr topology_type TOPOLOGY = topology_type::SPHERICAL;
+
+  /// @brief std::unique_ptr to the Combinatorial_triangulation
+  std::unique_ptr<Combinatorial_triangulation> triangulation;
+
+  /// @brief std::unique_ptr to Combinatorial_geometry_info{}
+  std::unique_ptr<Combinatorial_geometry_info> geometry;
+
+  /// @brief Default constructor
+  /// @return An empty CombinatorialManifold{}
+  CombinatorialManifold()
+      : triangulation{std::make_unique<Combinatorial_triangulation>()}
+      , geometry{std::make_unique<Combinatorial_geometry_info>()} {}
+
+  /// @brief Constructor from a SimplicialManifold
+  /// @param universe The SimplicialManifold, which is unchanged
+  /// @return A CombinatorialManifold{} with the same triangulation
+  explicit CombinatorialManifold(const SimplicialManifold& universe)
+      : triangulation{std::make_unique<Combinatorial_triangulation>(
+            make_snapshot(universe))}
+      , geometry{std::make_unique<Combinatorial_geometry_info>(
+            *triangulation)} {}
+
+  /// @brief make_triangulation constructor
+  ///
+  /// The triangulation is generated as a SimplicialManifold, then
+  /// converted.
+  ///
+  /// @param simplices The number of desired simplices in the triangulation
+  /// @param timeslices The number of timeslices in the triangulation
+  /// @return A populated CombinatorialManifold{}
+  CombinatorialManifold(const std::intmax_t simplices,
+                        const std::intmax_t timeslices)
+      : CombinatorialManifold(SimplicialManifold(simplices, timeslices)) {}
+
+  /// @brief Copy constructor
+  /// @param other The CombinatorialManifold to copy
+  /// @return A copied CombinatorialManifold{}
+  CombinatorialManifold(const CombinatorialManifold& other)
+      : triangulation{std::make_unique<Combinatorial_triangulation>(
+            *(other.triangulation))}
+      , geometry{std::make_unique<Combinatorial_geometry_info>(
+            *(other.geometry))} {}
+
+  /// @brief Default move constructor
+  CombinatorialManifold(CombinatorialManifold&&) = default;
+
+  /// @brief Default move assignment operator
+  /// @return A move-assigned CombinatorialManifold{}
+  CombinatorialManifold& operator=(CombinatorialManifold&&) = default;
+
+  /// @brief Default destructor
+  ~CombinatorialManifold() = default;
+
+  /// @brief Exception-safe swap
+  /// @param first  The first CombinatorialManifold to be swapped
+  /// @param second The second CombinatorialManifold to be swapped with.
+  friend void swap(CombinatorialManifold& first,
+                   CombinatorialManifold& second) {
+    using std::swap;
+    swap(first.triangulation, second.triangulation);
+    swap(first.geometry, second.geometry);
+  }
+};
+
+/// @brief Recalculate the geometry of a CombinatorialManifold after a move
+/// @param universe The CombinatorialManifold
+inline void reclassify(CombinatorialManifold& universe) {
+  universe.geometry =
+      std::make_unique<Combinatorial_geometry_info>(*universe.triangulation);
+}  // reclassify()
+
+/// @brief Make the geometry of a CombinatorialManifold follow its last move
+///
+/// The triangulation keeps its own counts, so this is reclassify(), which
+/// is already O(1).
+///
+/// @param universe The CombinatorialManifold
+inline void update_geometry(CombinatorialManifold& universe) {
+  reclassify(universe);
+}  // update_geometry()
+
+/// @brief Prepare the geometry of a CombinatorialManifold to follow moves,
+/// which it needs no preparation for
+inline void index_geometry(CombinatorialManifold&) {}
+
+/// @brief Whether a cell of a CombinatorialManifold is correctly foliated
+/// @param universe The CombinatorialManifold
+/// @param cell A cell of its triangulation
+/// @return **True** if the cell is infinite or spans adjacent timeslices
+inline bool is_foliated(const CombinatorialManifold& universe,
+                        const Combinatorial_cell&    cell) {
+  return universe.triangulation->is_infinite(cell) ||
+         universe.triangulation->cell_type(cell) != 0;
+}  // is_foliated()
+
+/// @brief Count spacelike facets per timeslice of a CombinatorialManifold
+///
+/// As VolumePerTimeslice() on a SimplicialManifold. Each finite facet is
+/// visited once, from the lower-numbered of its two cells or from its
+/// finite cell.
+///
+/// @param manifold The CombinatorialManifold
+/// @return The **manifold** with its spacelike facets and timevalues saved
+inline auto VolumePerTimeslice(CombinatorialManifold& manifold)
+    -> decltype(manifold) {
+#ifndef NDEBUG
+  std::cout << __PRETTY_FUNCTION__ << " called." << std::endl;
+#endif
+  Trace_span span("VolumePerTimeslice", "measurement");
+
+  print_results(manifold);
+
+  const auto& triangulation = *manifold.triangulation;
+  std::map<std::intmax_t, std::intmax_t> spacelike_facets;
+  for (std::intmax_t c = 0; c < triangulation.number_of_cells(); ++c) {
+    auto cell = static_cast<Combinatorial_cell>(c);
+    if (triangulation.is_infinite(cell)) continue;
+    for (auto i = 0; i < 4; ++i) {
+      auto neighbor = triangulation.neighbor(cell, i);
+      if (!triangulation.is_infinite(neighbor) &&
+          static_cast<std::intmax_t>(neighbor) < c)
+        continue;
+      std::set<std::intmax_t> facet_timevalues;
+      for (auto k = 1; k < 4; ++k) {
+        facet_timevalues.insert(
+            triangulation.timevalue(triangulation.vertex(cell, (i + k) & 3)));
+      }
+      if (facet_timevalues.size() == 1)
+        ++spacelike_facets[*facet_timevalues.begin()];
+    }
+  }
+
+  std::set<std::intmax_t> timevalues;
+  for (std::intmax_t v = 0; v < triangulation.number_of_vertices(); ++v) {
+    timevalues.insert(
+        triangulation.timevalue(static_cast<Combinatorial_vertex>(v)));
+  }
+
+  for (const auto& timevalue : timevalues) {
+    std::cout << "Timeslice " << timevalue << " has "
+              << spacelike_facets[timevalue] << " spacelike faces."
+              << std::endl;
+  }
+
+  manifold.geometry->timevalues       = timevalues;
+  manifold.geometry->spacelike_facets = spacelike_facets;
+  return manifold;
+}  // VolumePerTimeslice()
+
+/// @brief Make a Snapshot of a CombinatorialManifold
+/// @param universe A CombinatorialManifold
+/// @return The Snapshot of **universe**
+inline auto make_snapshot(const CombinatorialManifold& universe) {
+#ifndef NDEBUG
+  std::cout << __PRETTY_FUNCTION__ << " called." << std::endl;
+#endif
+  return universe.triangulation->snapshot();
+}  // make_snapshot()
+
+/// @brief Convert a CombinatorialManifold back to a SimplicialManifold
+///
+/// The Delaunay triangulation is rebuilt from a Snapshot, so it has the
+/// same cells, but after (2,3) and (3,2) moves is no longer Delaunay.
+///
+/// @param universe A CombinatorialManifold
+/// @return A SimplicialManifold{} with the same triangulation
+inline auto to_simplicial_manifold(const CombinatorialManifold& universe) {
+#ifndef NDEBUG
+  std::cout << __PRETTY_FUNCTION__ << " called." << std::endl;
+#endif
+  return SimplicialManifold(rebuild_triangulation(make_snapshot(universe)));
+}  // to_simplicial_manifold()
+
+#endif  // SRC_COMBINATORIALMANIFOLD_H_
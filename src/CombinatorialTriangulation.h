@@ -0,0 +1,1105 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// A coordinate-free foliated triangulation for the Monte Carlo phase.
+///
+/// Cells are flat arrays of 32-bit vertex and neighbor indices plus a cell
+/// type, and vertices are a timevalue and one incident cell, so copying a
+/// triangulation is a few contiguous copies and walking it never chases a
+/// pointer. Ergodic moves rewrite these arrays without evaluating any
+/// geometric predicate. CGAL generates the initial triangulation and
+/// exports the result, both through a Snapshot; points are carried along
+/// only for that export.
+///
+/// \done Import from and export to a Snapshot
+/// \done Dense storage, filling deleted cells and vertices from the end
+/// \done Simplex counts kept current by each move
+/// \done (2,3), (3,2), (2,6), and (6,2) moves
+/// \done Combinatorial, orientation, and count checks in is_valid()
+/// \done Version stamps of cell slots for optimistic concurrency
+/// \todo Toroidal triangulations
+
+/// @file CombinatorialTriangulation.h
+/// @brief Flat, coordinate-free foliated triangulations
+/// @author Adam Getchell
+
+#ifndef SRC_COMBINATORIALTRIANGULATION_H_
+#define SRC_COMBINATORIALTRIANGULATION_H_
+
+// CGAL headers
+#include <CGAL/centroid.h>
+
+// C++ headers
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// CDT headers
+#include "Foliation.h"
+#include "Snapshot.h"
+
+/// Vertex_handle of a Combinatorial_triangulation, which is its index
+enum class Combinatorial_vertex : Snapshot_index {};
+
+/// Cell_handle of a Combinatorial_triangulation, which is its index
+enum class Combinatorial_cell : Snapshot_index {};
+
+/// Indices of the vertices of the facet opposite vertex i, ordered as in
+/// CGAL so that every facet of a positively oriented cell is seen with the
+/// same orientation from inside the cell
+static constexpr std::array<std::array<int, 3>, 4> FACET_VERTEX_INDEX{
+    {{{1, 3, 2}}, {{3, 0, 2}}, {{3, 1, 0}}, {{2, 0, 1}}}};
+
+/// @class Combinatorial_triangulation
+/// @brief A foliated triangulation stored as flat index arrays
+///
+/// Vertex i of a cell is opposite its neighbor i, as in CGAL, and cells
+/// with the vertex at infinity close the triangulation into a sphere. The
+/// triangulation is its own data structure, so code written against
+/// Delaunay::tds(), such as MoveManager, works on it unchanged.
+class Combinatorial_triangulation {
+ public:
+  using Vertex_handle = Combinatorial_vertex;
+  using Cell_handle   = Combinatorial_cell;
+  using Point         = ::Point;
+
+  /// @brief Dimension of the triangulation, whose cells are tetrahedra
+  static constexpr int DIMENSION = 3;
+
+  /// @brief Default constructor
+  /// @return An empty Combinatorial_triangulation{}
+  Combinatorial_triangulation() = default;
+
+  /// @brief Import a triangulation from a Snapshot
+  ///
+  /// Vertices and cells keep their Snapshot numbering. Cell types are
+  /// recomputed from vertex timevalues.
+  ///
+  /// @param snapshot The Snapshot, usually from make_snapshot()
+  /// @return A Combinatorial_triangulation{}
+  explicit Combinatorial_triangulation(const Snapshot& snapshot) {
+    const auto vertices =
+        static_cast<std::size_t>(snapshot.number_of_vertices());
+    const auto cells = static_cast<std::size_t>(snapshot.number_of_cells());
+    timevalues_.reserve(vertices);
+    points_.reserve(vertices);
+    for (Snapshot_index v = 0; v < snapshot.number_of_vertices(); ++v) {
+      timevalues_.emplace_back(
+          static_cast<std::int32_t>(snapshot.timevalue(v)));
+      points_.emplace_back(snapshot.point(v));
+    }
+    vertex_cells_.assign(vertices, Cell_handle{0});
+
+    cell_vertices_.reserve(4 * cells);
+    cell_neighbors_.reserve(4 * cells);
+    cell_types_.reserve(cells);
+    for (Snapshot_index c = 0; c < snapshot.number_of_cells(); ++c) {
+      for (auto i = 0; i < 4; ++i) {
+        auto vertex = static_cast<Vertex_handle>(snapshot.vertex(c, i));
+        cell_vertices_.emplace_back(vertex);
+        cell_neighbors_.emplace_back(
+            static_cast<Cell_handle>(snapshot.neighbor(c, i)));
+        if (vertex != infinite_vertex())
+          vertex_cells_[at(vertex)] = static_cast<Cell_handle>(c);
+      }
+      cell_types_.emplace_back(type_of(static_cast<Cell_handle>(c)));
+      count_cell(static_cast<Cell_handle>(c), 1);
+    }
+    cell_versions_.assign(cells, 0);
+    std::tie(timelike_edges_, spacelike_edges_) = count_edges();
+  }
+
+  /// @return This triangulation, which is its own data structure
+  Combinatorial_triangulation& tds() noexcept { return *this; }
+
+  /// @return This triangulation, which is its own data structure
+  const Combinatorial_triangulation& tds() const noexcept { return *this; }
+
+  /// @return The vertex at infinity
+  static constexpr Vertex_handle infinite_vertex() noexcept {
+    return static_cast<Vertex_handle>(INFINITE_VERTEX);
+  }
+
+  /// @return The number of finite vertices
+  std::intmax_t number_of_vertices() const noexcept {
+    return static_cast<std::intmax_t>(timevalues_.size());
+  }
+
+  /// @return The number of cells, finite and infinite
+  std::intmax_t number_of_cells() const noexcept {
+    return static_cast<std::intmax_t>(cell_types_.size());
+  }
+
+  /// @return The number of finite cells
+  std::intmax_t number_of_finite_cells() const noexcept {
+    return N3_31() + N3_22() + N3_13();
+  }
+
+  /// @return The number of finite edges
+  std::intmax_t number_of_finite_edges() const noexcept {
+    return N1_TL() + N1_SL();
+  }
+
+  /// @return The number of finite facets, each shared by two cells of
+  /// which at least one is finite
+  std::intmax_t number_of_finite_facets() const noexcept {
+    auto infinite_cells = number_of_cells() - number_of_finite_cells();
+    return (4 * number_of_finite_cells() + infinite_cells) / 2;
+  }
+
+  /// @return The number of (3,1) cells
+  std::intmax_t N3_31() const noexcept { return cells_of_type_[0]; }
+
+  /// @return The number of (2,2) cells
+  std::intmax_t N3_22() const noexcept { return cells_of_type_[1]; }
+
+  /// @return The number of (1,3) cells
+  std::intmax_t N3_13() const noexcept { return cells_of_type_[2]; }
+
+  /// @return The number of timelike edges
+  std::intmax_t N1_TL() const noexcept { return timelike_edges_; }
+
+  /// @return The number of spacelike edges
+  std::intmax_t N1_SL() const noexcept { return spacelike_edges_; }
+
+  /// @param cell A cell
+  /// @param i A vertex index from 0 to 3
+  /// @return Vertex i of **cell**
+  Vertex_handle vertex(const Cell_handle cell, const int i) const {
+    return cell_vertices_[4 * at(cell) + i];
+  }
+
+  /// @param cell A cell
+  /// @param i A vertex index from 0 to 3
+  /// @return The neighbor of **cell** opposite vertex i
+  Cell_handle neighbor(const Cell_handle cell, const int i) const {
+    return cell_neighbors_[4 * at(cell) + i];
+  }
+
+  /// @param cell A cell
+  /// @return The type of **cell**: 31, 22, or 13, or 0 if it is infinite
+  std::int8_t cell_type(const Cell_handle cell) const {
+    return cell_types_[at(cell)];
+  }
+
+  /// @brief Version stamp of a cell slot
+  ///
+  /// The stamp changes whenever a cell is written to, moved into, or
+  /// deleted from the slot, so a move tested against cells whose stamps
+  /// are unchanged can still be made.
+  ///
+  /// @param cell A cell, which may since have been deleted
+  /// @return The version of the slot of **cell**
+  std::uint32_t version(const Cell_handle cell) const {
+    return cell_versions_[at(cell)];
+  }
+
+  /// @param vertex A finite vertex
+  /// @return The timevalue of **vertex**
+  std::intmax_t timevalue(const Vertex_handle vertex) const {
+    return timevalues_[at(vertex)];
+  }
+
+  /// @param vertex A finite vertex
+  /// @return The point of **vertex**, used only for export
+  const Point& point(const Vertex_handle vertex) const {
+    return points_[at(vertex)];
+  }
+
+  /// @brief Move a vertex to another point
+  /// @param vertex A finite vertex
+  /// @param point The new point of **vertex**
+  void set_point(const Vertex_handle vertex, const Point& point) {
+    points_[at(vertex)] = point;
+  }
+
+  /// @param vertex A finite vertex
+  /// @return A cell incident to **vertex**
+  Cell_handle cell(const Vertex_handle vertex) const {
+    return vertex_cells_[at(vertex)];
+  }
+
+  /// @param cell A cell
+  /// @return **True** if **cell** has the vertex at infinity
+  bool is_infinite(const Cell_handle cell) const {
+    return has_vertex(cell, infinite_vertex());
+  }
+
+  /// @param cell A cell
+  /// @param vertex A vertex
+  /// @return **True** if **vertex** is a vertex of **cell**
+  bool has_vertex(const Cell_handle cell, const Vertex_handle vertex) const {
+    return index(cell, vertex) < 4;
+  }
+
+  /// @param cell A cell
+  /// @param vertex A vertex
+  /// @return The index of **vertex** in **cell**, or 4 if it isn't there
+  int index(const Cell_handle cell, const Vertex_handle vertex) const {
+    auto i = 0;
+    while (i < 4 && this->vertex(cell, i) != vertex) ++i;
+    return i;
+  }
+
+  /// @param cell A cell
+  /// @param i A vertex index from 0 to 3
+  /// @return The index of **cell** in its neighbor opposite vertex i
+  int mirror_index(const Cell_handle cell, const int i) const {
+    auto other = neighbor(cell, i);
+    auto j     = 0;
+    while (j < 4 && neighbor(other, j) != cell) ++j;
+    return j;
+  }
+
+  /// @brief The cells incident to a vertex
+  /// @tparam OutputIterator An output iterator of Cell_handle
+  /// @param vertex A finite vertex
+  /// @param out Where to write the cells
+  /// @return **out** past the last cell written
+  template <typename OutputIterator>
+  OutputIterator incident_cells(const Vertex_handle vertex,
+                                OutputIterator      out) const {
+    thread_local std::vector<Cell_handle> star;
+    star.clear();
+    star.emplace_back(cell(vertex));
+    // Every cell across a facet containing vertex contains it too
+    for (std::size_t n = 0; n < star.size(); ++n) {
+      for (auto i = 0; i < 4; ++i) {
+        if (this->vertex(star[n], i) == vertex) continue;
+        auto next = neighbor(star[n], i);
+        if (std::find(star.begin(), star.end(), next) == star.end())
+          star.emplace_back(next);
+      }
+    }
+    return std::copy(star.begin(), star.end(), out);
+  }
+
+  /// @brief The cells incident to an edge, in order around it
+  /// @tparam OutputIterator An output iterator of Cell_handle
+  /// @param cell A cell containing the edge
+  /// @param i The index in **cell** of one vertex of the edge
+  /// @param j The index in **cell** of the other vertex of the edge
+  /// @param out Where to write the cells
+  /// @return **out** past the last cell written
+  template <typename OutputIterator>
+  OutputIterator incident_cells(const Cell_handle cell, const int i,
+                                const int j, OutputIterator out) const {
+    for_each_cell_around(cell, i, j, [&out](const Cell_handle c) {
+      *out++ = c;
+    });
+    return out;
+  }
+
+  /// @brief Whether two vertices are joined by an edge
+  /// @param first One vertex
+  /// @param second The other vertex
+  /// @param[out] cell A cell containing the edge
+  /// @param[out] i The index of **first** in **cell**
+  /// @param[out] j The index of **second** in **cell**
+  /// @return **True** if the edge exists
+  bool is_edge(const Vertex_handle first, const Vertex_handle second,
+               Cell_handle& cell, int& i, int& j) const {
+    thread_local std::vector<Cell_handle> star;
+    star.clear();
+    incident_cells(first, std::back_inserter(star));
+    for (const auto& candidate : star) {
+      auto k = index(candidate, second);
+      if (k < 4) {
+        cell = candidate;
+        i    = index(candidate, first);
+        j    = k;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /// @param first One vertex
+  /// @param second Another vertex
+  /// @param third A third vertex
+  /// @return **True** if the three vertices form a facet
+  bool is_facet(const Vertex_handle first, const Vertex_handle second,
+                const Vertex_handle third) const {
+    thread_local std::vector<Cell_handle> star;
+    star.clear();
+    incident_cells(first, std::back_inserter(star));
+    return std::any_of(star.begin(), star.end(), [&](const Cell_handle c) {
+      return has_vertex(c, second) && has_vertex(c, third);
+    });
+  }
+
+  /// @brief Whether a (2,3) move can be made on a facet
+  ///
+  /// The facet is between a (2,2) cell and a finite cell, and the vertices
+  /// opposite it are on different timeslices and not already joined, so
+  /// the three new cells are foliated and the result is a triangulation.
+  ///
+  /// @param cell A cell
+  /// @param i The index of the vertex opposite the facet
+  /// @return **True** if flipping the facet is a (2,3) move
+  bool is_23_flippable(const Cell_handle cell, const int i) const {
+    if (cell_type(cell) != 22) return false;
+    auto other = neighbor(cell, i);
+    if (cell_type(other) == 0) return false;
+    auto top    = vertex(cell, i);
+    auto bottom = vertex(other, mirror_index(cell, i));
+    if (timevalue(top) == timevalue(bottom)) return false;
+    Cell_handle edge_cell;
+    int         j{0};
+    int         k{0};
+    return !is_edge(top, bottom, edge_cell, j, k);
+  }
+
+  /// @brief Whether a (3,2) move can be made on an edge
+  ///
+  /// The edge is timelike with three finite cells around it, and the ring
+  /// of vertices around it spans two timeslices and isn't already a facet.
+  ///
+  /// @param cell A cell containing the edge
+  /// @param i The index in **cell** of one vertex of the edge
+  /// @param j The index in **cell** of the other vertex of the edge
+  /// @return **True** if flipping the edge is a (3,2) move
+  bool is_32_flippable(const Cell_handle cell, const int i,
+                       const int j) const {
+    if (cell_type(cell) == 0) return false;
+    if (timevalue(vertex(cell, i)) == timevalue(vertex(cell, j))) return false;
+    std::array<Cell_handle, 3> around;
+    auto                       degree = 0;
+    auto                       count  = [&](const Cell_handle c) {
+      if (degree < 3) around[degree] = c;
+      ++degree;
+    };
+    for_each_cell_around(cell, i, j, count);
+    if (degree != 3) return false;
+    if (std::any_of(around.begin(), around.end(),
+                    [this](const Cell_handle c) { return cell_type(c) == 0; }))
+      return false;
+    auto ring = ring_of(around, vertex(cell, i), vertex(cell, j));
+    if (timevalue(ring[0]) == timevalue(ring[1]) &&
+        timevalue(ring[0]) == timevalue(ring[2]))
+      return false;
+    return !is_facet(ring[0], ring[1], ring[2]);
+  }
+
+  /// @brief Whether a (2,6) move can be made on a (1,3) cell
+  /// @param cell A cell
+  /// @param[out] i The index of the vertex opposite its spacelike facet
+  /// @return **True** if the (1,3) cell has a (3,1) cell across that facet
+  bool is_26_movable(const Cell_handle cell, int& i) const {
+    if (cell_type(cell) != 13) return false;
+    i = 0;
+    for (auto k = 1; k < 4; ++k) {
+      if (timevalue(vertex(cell, k)) < timevalue(vertex(cell, i))) i = k;
+    }
+    return cell_type(neighbor(cell, i)) == 31;
+  }
+
+  /// @brief Whether a (6,2) move can be made on a vertex
+  ///
+  /// The vertex has three (3,1) and three (1,3) cells around it, whose
+  /// link is an apex on each neighboring timeslice and a ring of three
+  /// vertices on its own timeslice that isn't already a facet.
+  ///
+  /// @param vertex A finite vertex
+  /// @return **True** if the vertex can be collapsed
+  bool is_62_movable(const Vertex_handle vertex) const {
+    thread_local std::vector<Cell_handle> star;
+    star.clear();
+    incident_cells(vertex, std::back_inserter(star));
+    if (star.size() != 6) return false;
+    auto three_one = std::count_if(star.begin(), star.end(), [this](auto c) {
+      return cell_type(c) == 31;
+    });
+    auto one_three = std::count_if(star.begin(), star.end(), [this](auto c) {
+      return cell_type(c) == 13;
+    });
+    if (three_one != 3 || one_three != 3) return false;
+    std::array<Vertex_handle, 2> apexes;
+    std::array<Vertex_handle, 3> ring;
+    if (!link_of(star, vertex, apexes, ring)) return false;
+    return !is_facet(ring[0], ring[1], ring[2]);
+  }
+
+  /// @brief Make a (2,3) move
+  /// @param cell A cell
+  /// @param i The index of the vertex opposite a facet for which
+  /// is_23_flippable() is true
+  void flip_23(const Cell_handle cell, const int i) {
+    auto other  = neighbor(cell, i);
+    auto top    = vertex(cell, i);
+    auto bottom = vertex(other, mirror_index(cell, i));
+    // Each new cell has a facet of cell, so is cell with the vertex
+    // opposite that facet replaced by bottom
+    thread_local std::vector<Cell_handle>                  removed;
+    thread_local std::vector<std::array<Vertex_handle, 4>> added;
+    removed.assign({cell, other});
+    added.clear();
+    for (auto k = 0; k < 4; ++k) {
+      if (k != i) added.emplace_back(replaced(cell, k, bottom));
+    }
+    replace_cells(removed, added);
+    count_edge(top, bottom, 1);
+  }
+
+  /// @brief Make a (3,2) move
+  /// @param cell A cell containing the edge
+  /// @param i The index in **cell** of one vertex of an edge for which
+  /// is_32_flippable() is true
+  /// @param j The index in **cell** of the other vertex of the edge
+  void flip_32(const Cell_handle cell, const int i, const int j) {
+    auto                       first  = vertex(cell, i);
+    auto                       second = vertex(cell, j);
+    std::array<Cell_handle, 3> around;
+    auto                       n = 0;
+    for_each_cell_around(cell, i, j, [&](const Cell_handle c) {
+      around[n++] = c;
+    });
+    auto ring = ring_of(around, first, second);
+    auto missing =
+        *std::find_if(ring.begin(), ring.end(), [&](const Vertex_handle v) {
+          return !has_vertex(cell, v);
+        });
+    // Each new cell is cell with one end of the edge replaced by the ring
+    // vertex cell lacks
+    thread_local std::vector<Cell_handle>                  removed;
+    thread_local std::vector<std::array<Vertex_handle, 4>> added;
+    removed.assign(around.begin(), around.end());
+    added.assign({replaced(cell, j, missing), replaced(cell, i, missing)});
+    replace_cells(removed, added);
+    count_edge(first, second, -1);
+  }
+
+  /// @brief Make a (2,6) move
+  ///
+  /// A vertex is added in the spacelike facet of a (1,3) cell at the
+  /// centroid of its points, so that it can be exported.
+  ///
+  /// @param cell A (1,3) cell
+  /// @param i The index of the vertex opposite a facet for which
+  /// is_26_movable() is true
+  /// @return The new vertex
+  Vertex_handle insert_in_facet(const Cell_handle cell, const int i) {
+    auto other = neighbor(cell, i);
+    auto j     = mirror_index(cell, i);
+    auto lower = vertex(cell, i);
+    auto upper = vertex(other, j);
+    auto v1    = vertex(cell, (i + 1) & 3);
+    auto v2    = vertex(cell, (i + 2) & 3);
+    auto v3    = vertex(cell, (i + 3) & 3);
+
+    auto center = static_cast<Vertex_handle>(number_of_vertices());
+    timevalues_.emplace_back(timevalues_[at(v1)]);
+    points_.emplace_back(CGAL::centroid(point(v1), point(v2), point(v3)));
+    vertex_cells_.emplace_back(cell);
+
+    // Each new cell is cell or other with a vertex of the facet replaced
+    // by center
+    thread_local std::vector<Cell_handle>                  removed;
+    thread_local std::vector<std::array<Vertex_handle, 4>> added;
+    removed.assign({cell, other});
+    added.clear();
+    for (auto k = 0; k < 4; ++k) {
+      if (k != i) added.emplace_back(replaced(cell, k, center));
+      if (k != j) added.emplace_back(replaced(other, k, center));
+    }
+    replace_cells(removed, added);
+    for (const auto& v : {v1, v2, v3, lower, upper}) count_edge(center, v, 1);
+    return center;
+  }
+
+  /// @brief Make a (6,2) move
+  ///
+  /// The six cells around **center** are replaced by the two cells joining
+  /// the ring of its link to each apex.
+  ///
+  /// @param center A vertex for which is_62_movable() is true
+  /// @return The vertices that were joined to **center**, whose handles
+  /// may have changed when the last vertex took its place
+  std::array<Vertex_handle, 5> collapse_62(const Vertex_handle center) {
+    thread_local std::vector<Cell_handle> star;
+    star.clear();
+    incident_cells(center, std::back_inserter(star));
+    std::array<Vertex_handle, 2> apexes;
+    std::array<Vertex_handle, 3> ring;
+    link_of(star, center, apexes, ring);
+
+    // Take any star cell of each apex, and put the ring vertex it lacks
+    // where center was
+    thread_local std::vector<std::array<Vertex_handle, 4>> added;
+    added.clear();
+    for (const auto& apex : apexes) {
+      auto cell = *std::find_if(star.begin(), star.end(), [&](auto c) {
+        return has_vertex(c, apex);
+      });
+      auto missing =
+          *std::find_if(ring.begin(), ring.end(), [&](const Vertex_handle v) {
+            return !has_vertex(cell, v);
+          });
+      added.emplace_back(replaced(cell, index(cell, center), missing));
+    }
+    replace_cells(star, added);
+    std::array<Vertex_handle, 5> link{
+        {apexes[0], apexes[1], ring[0], ring[1], ring[2]}};
+    for (const auto& v : link) count_edge(center, v, -1);
+
+    auto last = static_cast<Vertex_handle>(number_of_vertices() - 1);
+    delete_vertex(center);
+    std::replace(link.begin(), link.end(), last, center);
+    return link;
+  }
+
+  /// @param vertex A vertex
+  /// @return **True** if **vertex** exists and its cell contains it
+  bool is_valid(const Vertex_handle vertex) const {
+    if (vertex == infinite_vertex()) return true;
+    if (static_cast<Snapshot_index>(vertex) < 0 ||
+        static_cast<std::intmax_t>(at(vertex)) >= number_of_vertices())
+      return false;
+    auto c = cell(vertex);
+    return is_cell(c) && has_vertex(c, vertex);
+  }
+
+  /// @param cell A cell
+  /// @return **True** if **cell** exists, has the right type, and shares
+  /// each facet with its neighbor in the opposite orientation
+  bool is_valid(const Cell_handle cell) const {
+    if (!is_cell(cell)) return false;
+    if (cell_type(cell) != type_of(cell)) return false;
+    for (auto i = 0; i < 4; ++i) {
+      if (!is_cell(neighbor(cell, i)) || !is_coherent(cell, i)) return false;
+    }
+    return true;
+  }
+
+  /// @brief Check every vertex and cell, and the simplex counts
+  /// @param verbose Report the first problem found to std::cerr
+  /// @return **True** if the triangulation is valid
+  bool is_valid(const bool verbose = false) const {
+    auto report = [verbose](const char* problem) {
+      if (verbose) std::cerr << problem << std::endl;
+      return false;
+    };
+    for (std::intmax_t v = 0; v < number_of_vertices(); ++v) {
+      if (!is_valid(static_cast<Vertex_handle>(v)))
+        return report("A vertex isn't in its cell.");
+    }
+    std::array<std::intmax_t, Foliation<DIMENSION>::TYPES> types{};
+    for (std::intmax_t c = 0; c < number_of_cells(); ++c) {
+      auto cell = static_cast<Cell_handle>(c);
+      if (!is_valid(cell))
+        return report("A cell doesn't match its neighbors.");
+      if (cell_type(cell) != 0) ++types[type_index(cell_type(cell))];
+    }
+    if (types != cells_of_type_)
+      return report("Cell counts are out of date.");
+    if (count_edges() != std::make_pair(timelike_edges_, spacelike_edges_))
+      return report("Edge counts are out of date.");
+    return true;
+  }
+
+  /// @brief Export to a Snapshot
+  ///
+  /// As make_snapshot(): vertices are ordered by timeslice, keeping their
+  /// order within it, and finite cells come first, sorted by their
+  /// lowest-numbered vertex.
+  ///
+  /// @return The Snapshot
+  Snapshot snapshot() const {
+    Snapshot snapshot;
+
+    std::vector<Snapshot_index> vertex_order(timevalues_.size());
+    std::iota(vertex_order.begin(), vertex_order.end(), 0);
+    std::stable_sort(vertex_order.begin(), vertex_order.end(),
+                     [this](auto a, auto b) {
+                       return timevalues_[a] < timevalues_[b];
+                     });
+    std::vector<Snapshot_index> vertex_index(timevalues_.size());
+    for (const auto v : vertex_order) {
+      vertex_index[v] = snapshot.number_of_vertices();
+      snapshot.vertex_timevalues.emplace_back(timevalues_[v]);
+      snapshot.x.emplace_back(points_[v].x());
+      snapshot.y.emplace_back(points_[v].y());
+      snapshot.z.emplace_back(points_[v].z());
+    }
+    auto new_vertex = [&vertex_index](const Vertex_handle v) {
+      return v == infinite_vertex() ? INFINITE_VERTEX
+                                    : vertex_index[at(v)];
+    };
+
+    std::vector<std::pair<Snapshot_index, Snapshot_index>> keyed_cells;
+    keyed_cells.reserve(cell_types_.size());
+    for (std::intmax_t c = 0; c < number_of_cells(); ++c) {
+      auto key = std::numeric_limits<Snapshot_index>::max();
+      for (auto i = 0; i < 4; ++i) {
+        auto v = vertex(static_cast<Cell_handle>(c), i);
+        if (v != infinite_vertex()) key = std::min(key, new_vertex(v));
+      }
+      keyed_cells.emplace_back(key, static_cast<Snapshot_index>(c));
+    }
+    std::stable_sort(keyed_cells.begin(), keyed_cells.end(),
+                     [this](const auto& a, const auto& b) {
+                       return std::make_pair(cell_types_[a.second] == 0,
+                                             a.first) <
+                              std::make_pair(cell_types_[b.second] == 0,
+                                             b.first);
+                     });
+    std::vector<Snapshot_index> cell_index(cell_types_.size());
+    for (std::size_t j = 0; j < keyed_cells.size(); ++j) {
+      cell_index[keyed_cells[j].second] = static_cast<Snapshot_index>(j);
+    }
+
+    snapshot.cell_vertices.reserve(4 * keyed_cells.size());
+    snapshot.cell_neighbors.reserve(4 * keyed_cells.size());
+    snapshot.cell_types.reserve(keyed_cells.size());
+    for (const auto& keyed_cell : keyed_cells) {
+      auto c = static_cast<Cell_handle>(keyed_cell.second);
+      for (auto i = 0; i < 4; ++i) {
+        snapshot.cell_vertices.emplace_back(new_vertex(vertex(c, i)));
+        snapshot.cell_neighbors.emplace_back(cell_index[at(neighbor(c, i))]);
+      }
+      snapshot.cell_types.emplace_back(cell_type(c));
+      if (cell_type(c) != 0) ++snapshot.finite_cells;
+    }
+    return snapshot;
+  }
+
+ private:
+  /// @param handle A vertex or cell
+  /// @return Its position in the arrays
+  template <typename Handle>
+  static std::size_t at(const Handle handle) noexcept {
+    return static_cast<std::size_t>(handle);
+  }
+
+  /// @param type A cell type
+  /// @return The position of **type** in cells_of_type_
+  static std::size_t type_index(const std::int8_t type) noexcept {
+    return Foliation<DIMENSION>::type_index(type);
+  }
+
+  /// @param cell A cell handle
+  /// @return **True** if **cell** is stored
+  bool is_cell(const Cell_handle cell) const {
+    return static_cast<Snapshot_index>(cell) >= 0 &&
+           static_cast<std::intmax_t>(at(cell)) < number_of_cells();
+  }
+
+  /// @param cell A cell
+  /// @return The type of **cell** from the timevalues of its vertices, 0
+  /// if it is infinite or doesn't span adjacent timeslices
+  std::int8_t type_of(const Cell_handle cell) const {
+    if (is_infinite(cell)) return 0;
+    return Foliation<DIMENSION>::classify(
+        std::array<std::intmax_t, Foliation<DIMENSION>::VERTICES>{
+            {timevalue(vertex(cell, 0)), timevalue(vertex(cell, 1)),
+             timevalue(vertex(cell, 2)), timevalue(vertex(cell, 3))}});
+  }
+
+  /// @brief Add or remove a cell from the counts
+  /// @param cell A cell
+  /// @param delta 1 to add, -1 to remove
+  void count_cell(const Cell_handle cell, const int delta) {
+    if (cell_type(cell) != 0)
+      cells_of_type_[type_index(cell_type(cell))] += delta;
+  }
+
+  /// @brief Add or remove an edge from the counts
+  /// @param u One vertex of the edge
+  /// @param v The other vertex of the edge
+  /// @param delta 1 to add, -1 to remove
+  void count_edge(const Vertex_handle u, const Vertex_handle v,
+                  const int delta) {
+    if (timevalue(u) == timevalue(v)) {
+      spacelike_edges_ += delta;
+    } else {
+      timelike_edges_ += delta;
+    }
+  }
+
+  /// @brief Count finite edges from scratch
+  ///
+  /// Each edge is counted from the lowest-numbered finite cell around it.
+  ///
+  /// @return The number of timelike and spacelike edges
+  std::pair<std::intmax_t, std::intmax_t> count_edges() const {
+    std::intmax_t timelike{0};
+    std::intmax_t spacelike{0};
+    for (std::intmax_t c = 0; c < number_of_cells(); ++c) {
+      auto cell = static_cast<Cell_handle>(c);
+      if (is_infinite(cell)) continue;
+      for (auto i = 0; i < 3; ++i) {
+        for (auto j = i + 1; j < 4; ++j) {
+          auto lowest = true;
+          for_each_cell_around(cell, i, j, [&](const Cell_handle other) {
+            if (other < cell && !is_infinite(other)) lowest = false;
+          });
+          if (!lowest) continue;
+          if (timevalue(vertex(cell, i)) == timevalue(vertex(cell, j))) {
+            ++spacelike;
+          } else {
+            ++timelike;
+          }
+        }
+      }
+    }
+    return {timelike, spacelike};
+  }
+
+  /// @brief Call a function on each cell around an edge
+  /// @tparam Function Callable with a Cell_handle
+  /// @param cell A cell containing the edge
+  /// @param i The index in **cell** of one vertex of the edge
+  /// @param j The index in **cell** of the other vertex of the edge
+  /// @param function The function
+  template <typename Function>
+  void for_each_cell_around(const Cell_handle cell, const int i, const int j,
+                            Function&& function) const {
+    const auto first   = vertex(cell, i);
+    const auto second  = vertex(cell, j);
+    auto       k       = (i != 0 && j != 0) ? 0 : ((i != 1 && j != 1) ? 1 : 2);
+    auto       current = cell;
+    auto       across  = vertex(cell, k);
+    // Cross the facet opposite a vertex off the edge, then the facet
+    // opposite the vertex shared with the cell just left
+    do {
+      function(current);
+      auto other = vertex(current, 6 - index(current, first) -
+                                       index(current, second) -
+                                       index(current, across));
+      current    = neighbor(current, index(current, across));
+      across     = other;
+    } while (current != cell);
+  }
+
+  /// @param around The three cells around an edge
+  /// @param first One vertex of the edge
+  /// @param second The other vertex of the edge
+  /// @return The vertices of the cells not on the edge
+  std::array<Vertex_handle, 3> ring_of(
+      const std::array<Cell_handle, 3>& around, const Vertex_handle first,
+      const Vertex_handle second) const {
+    std::array<Vertex_handle, 3> ring;
+    auto                         n = 0;
+    for (const auto& c : around) {
+      for (auto i = 0; i < 4 && n < 3; ++i) {
+        auto v = vertex(c, i);
+        if (v != first && v != second &&
+            std::find(ring.begin(), ring.begin() + n, v) == ring.begin() + n)
+          ring[n++] = v;
+      }
+    }
+    return ring;
+  }
+
+  /// @brief Find the apexes and ring of the link of a vertex with six
+  /// cells
+  /// @param star The cells around **center**
+  /// @param center The vertex
+  /// @param[out] apexes The link vertices in three cells
+  /// @param[out] ring The link vertices in four cells
+  /// @return **True** if the link is two apexes and a ring of three
+  bool link_of(const std::vector<Cell_handle>& star,
+               const Vertex_handle center, std::array<Vertex_handle, 2>& apexes,
+               std::array<Vertex_handle, 3>& ring) const {
+    std::array<std::pair<Vertex_handle, int>, 6> link;
+    std::size_t                                  size = 0;
+    for (const auto& c : star) {
+      for (auto i = 0; i < 4; ++i) {
+        auto v = vertex(c, i);
+        if (v == center) continue;
+        auto found = std::find_if(link.begin(), link.begin() + size,
+                                  [v](const auto& l) { return l.first == v; });
+        if (found != link.begin() + size) {
+          ++found->second;
+        } else if (size == link.size()) {
+          return false;
+        } else {
+          link[size++] = {v, 1};
+        }
+      }
+    }
+    if (size != 5) return false;
+    std::size_t a = 0;
+    std::size_t r = 0;
+    for (std::size_t n = 0; n < size; ++n) {
+      if (link[n].second == 3 && a < 2) {
+        apexes[a++] = link[n].first;
+      } else if (link[n].second == 4 && r < 3) {
+        ring[r++] = link[n].first;
+      }
+    }
+    return a == 2 && r == 3;
+  }
+
+  /// @param cell A cell
+  /// @param i A vertex index from 0 to 3
+  /// @param vertex The vertex to put in its place
+  /// @return The vertices of **cell** with vertex i replaced by **vertex**,
+  /// which keeps the orientation of **cell**
+  std::array<Vertex_handle, 4> replaced(const Cell_handle cell, const int i,
+                                        const Vertex_handle vertex) const {
+    std::array<Vertex_handle, 4> vertices;
+    for (auto k = 0; k < 4; ++k) vertices[k] = this->vertex(cell, k);
+    vertices[i] = vertex;
+    return vertices;
+  }
+
+  /// @param cell A cell
+  /// @param i A vertex index from 0 to 3
+  /// @return The vertices of the facet opposite vertex i, sorted
+  std::array<Vertex_handle, 3> facet_key(const Cell_handle cell,
+                                         const int i) const {
+    std::array<Vertex_handle, 3> key;
+    for (auto k = 0; k < 3; ++k) key[k] = vertex(cell, (i + k + 1) & 3);
+    std::sort(key.begin(), key.end());
+    return key;
+  }
+
+  /// @param cell A cell
+  /// @param i A vertex index from 0 to 3
+  /// @return **True** if the neighbor opposite vertex i has **cell** as a
+  /// neighbor, through the same facet seen in the opposite orientation
+  bool is_coherent(const Cell_handle cell, const int i) const {
+    auto other = neighbor(cell, i);
+    auto j     = mirror_index(cell, i);
+    if (j == 4) return false;
+    std::array<Vertex_handle, 3> ours;
+    std::array<Vertex_handle, 3> theirs;
+    for (auto k = 0; k < 3; ++k) {
+      ours[k]   = vertex(cell, FACET_VERTEX_INDEX[i][k]);
+      theirs[k] = vertex(other, FACET_VERTEX_INDEX[j][k]);
+    }
+    for (auto r = 0; r < 3; ++r) {
+      if (theirs[r] == ours[0] && theirs[(r + 1) % 3] == ours[2] &&
+          theirs[(r + 2) % 3] == ours[1])
+        return true;
+    }
+    return false;
+  }
+
+  /// @brief Replace cells with new cells filling the same region
+  ///
+  /// The slots of removed cells are reused, and any left over are filled
+  /// from the end. Each new cell must be oriented as a removed cell with
+  /// one vertex replaced, as replaced() does. New facets are glued to the
+  /// cells outside the region or to each other by their vertices.
+  ///
+  /// @param removed The cells to remove
+  /// @param added The vertices of each new cell
+  void replace_cells(const std::vector<Cell_handle>&                  removed,
+                     const std::vector<std::array<Vertex_handle, 4>>& added) {
+    // Outer facets of the region, with the outside cell and its index
+    struct Boundary {
+      std::array<Vertex_handle, 3> key;
+      Cell_handle                  outside;
+      int                          mirror;
+    };
+    thread_local std::vector<Boundary> boundary;
+    boundary.clear();
+    for (const auto& cell : removed) {
+      for (auto i = 0; i < 4; ++i) {
+        auto outside = neighbor(cell, i);
+        if (std::find(removed.begin(), removed.end(), outside) !=
+            removed.end())
+          continue;
+        boundary.push_back({facet_key(cell, i), outside,
+                            mirror_index(cell, i)});
+      }
+      count_cell(cell, -1);
+    }
+
+    thread_local std::vector<Cell_handle> slots;
+    slots.clear();
+    for (std::size_t n = 0; n < added.size(); ++n) {
+      Cell_handle slot;
+      if (n < removed.size()) {
+        slot = removed[n];
+      } else {
+        slot = static_cast<Cell_handle>(number_of_cells());
+        cell_vertices_.resize(cell_vertices_.size() + 4);
+        cell_neighbors_.resize(cell_neighbors_.size() + 4);
+        cell_types_.emplace_back(0);
+      }
+      std::copy(added[n].begin(), added[n].end(),
+                cell_vertices_.begin() + 4 * at(slot));
+      stamp(slot);
+      cell_types_[at(slot)] = type_of(slot);
+      count_cell(slot, 1);
+      slots.emplace_back(slot);
+    }
+
+    for (const auto& slot : slots) {
+      for (auto i = 0; i < 4; ++i) {
+        auto key = facet_key(slot, i);
+        auto outer =
+            std::find_if(boundary.begin(), boundary.end(),
+                         [&key](const Boundary& b) { return b.key == key; });
+        if (outer != boundary.end()) {
+          auto outside                                     = outer->outside;
+          cell_neighbors_[4 * at(slot) + i]                = outside;
+          cell_neighbors_[4 * at(outside) + outer->mirror] = slot;
+          continue;
+        }
+        auto inner = std::find_if(slots.begin(), slots.end(), [&](auto other) {
+          return other != slot && index_opposite(other, key) < 4;
+        });
+        if (inner == slots.end())
+          throw std::logic_error("replace_cells() left a facet unglued.");
+        cell_neighbors_[4 * at(slot) + i] = *inner;
+      }
+      for (auto i = 0; i < 4; ++i) {
+        auto v = vertex(slot, i);
+        if (v != infinite_vertex()) vertex_cells_[at(v)] = slot;
+      }
+    }
+
+    // Fill left over slots from the end, highest first so that the cell
+    // moved into each is one that is kept
+    if (removed.size() > added.size()) {
+      thread_local std::vector<Cell_handle> surplus;
+      surplus.assign(removed.begin() + added.size(), removed.end());
+      std::sort(surplus.begin(), surplus.end(), std::greater<Cell_handle>{});
+      for (const auto& cell : surplus) delete_cell(cell);
+    }
+  }
+
+  /// @param cell A cell
+  /// @param key The sorted vertices of a facet
+  /// @return The index of the vertex of **cell** not in **key**, or 4 if
+  /// there isn't exactly one
+  int index_opposite(const Cell_handle cell,
+                     const std::array<Vertex_handle, 3>& key) const {
+    auto opposite = 4;
+    for (auto i = 0; i < 4; ++i) {
+      if (!std::binary_search(key.begin(), key.end(), vertex(cell, i))) {
+        if (opposite != 4) return 4;
+        opposite = i;
+      }
+    }
+    return opposite;
+  }
+
+  /// @brief Change the version stamp of a cell slot
+  /// @param cell A cell, which may be past the slots stamped so far
+  void stamp(const Cell_handle cell) {
+    if (at(cell) >= cell_versions_.size())
+      cell_versions_.resize(at(cell) + 1, 0);
+    ++cell_versions_[at(cell)];
+  }
+
+  /// @brief Delete a cell no other cell refers to, moving the last cell
+  /// into its slot
+  /// @param cell The cell
+  void delete_cell(const Cell_handle cell) {
+    auto last = static_cast<Cell_handle>(number_of_cells() - 1);
+    stamp(last);
+    if (cell != last) {
+      stamp(cell);
+      for (auto i = 0; i < 4; ++i) {
+        cell_vertices_[4 * at(cell) + i]  = vertex(last, i);
+        cell_neighbors_[4 * at(cell) + i] = neighbor(last, i);
+      }
+      cell_types_[at(cell)] = cell_types_[at(last)];
+      for (auto i = 0; i < 4; ++i) {
+        auto j = mirror_of(cell, i, last);
+        cell_neighbors_[4 * at(neighbor(cell, i)) + j] = cell;
+        auto v = vertex(cell, i);
+        if (v != infinite_vertex() && vertex_cells_[at(v)] == last)
+          vertex_cells_[at(v)] = cell;
+      }
+    }
+    cell_vertices_.resize(cell_vertices_.size() - 4);
+    cell_neighbors_.resize(cell_neighbors_.size() - 4);
+    cell_types_.pop_back();
+  }
+
+  /// @param cell A cell
+  /// @param i A vertex index from 0 to 3
+  /// @param old The handle its neighbor opposite vertex i knows it by
+  /// @return The index of **old** in that neighbor
+  int mirror_of(const Cell_handle cell, const int i,
+                const Cell_handle old) const {
+    auto other = neighbor(cell, i);
+    auto j     = 0;
+    while (j < 3 && neighbor(other, j) != old) ++j;
+    return j;
+  }
+
+  /// @brief Delete a vertex no cell refers to, moving the last vertex into
+  /// its slot
+  /// @param vertex The vertex
+  void delete_vertex(const Vertex_handle vertex) {
+    auto last = static_cast<Vertex_handle>(number_of_vertices() - 1);
+    if (vertex != last) {
+      thread_local std::vector<Cell_handle> star;
+      star.clear();
+      incident_cells(last, std::back_inserter(star));
+      for (const auto& c : star) {
+        cell_vertices_[4 * at(c) + index(c, last)] = vertex;
+        stamp(c);
+      }
+      timevalues_[at(vertex)]   = timevalues_[at(last)];
+      points_[at(vertex)]       = points_[at(last)];
+      vertex_cells_[at(vertex)] = vertex_cells_[at(last)];
+    }
+    timevalues_.pop_back();
+    points_.pop_back();
+    vertex_cells_.pop_back();
+  }
+
+  /// @brief Timevalue of each vertex
+  std::vector<std::int32_t> timevalues_;
+
+  /// @brief Point of each vertex, carried only for export
+  std::vector<Point> points_;
+
+  /// @brief A cell incident to each vertex
+  std::vector<Cell_handle> vertex_cells_;
+
+  /// @brief Four vertices per cell, infinite_vertex() for infinity
+  std::vector<Vertex_handle> cell_vertices_;
+
+  /// @brief Four neighbors per cell, neighbor i opposite vertex i
+  std::vector<Cell_handle> cell_neighbors_;
+
+  /// @brief Type (31, 22, 13) of each cell, 0 for infinite cells
+  std::vector<std::int8_t> cell_types_;
+
+  /// @brief Version stamp of each cell slot, kept for deleted slots too
+  std::vector<std::uint32_t> cell_versions_;
+
+  /// @brief Number of (3,1), (2,2), and (1,3) cells
+  std::array<std::intmax_t, Foliation<DIMENSION>::TYPES> cells_of_type_{};
+
+  /// @brief Number of timelike edges
+  std::intmax_t timelike_edges_{0};
+
+  /// @brief Number of spacelike edges
+  std::intmax_t spacelike_edges_{0};
+};
+
+/// @brief Write a Combinatorial_triangulation as a Delaunay triangulation
+///
+/// The triangulation is rebuilt as a Delaunay triangulation from its
+/// Snapshot, so it is written in the same format as a SimplicialManifold.
+///
+/// @param os The output stream
+/// @param triangulation The Combinatorial_triangulation
+/// @return **os**
+inline std::ostream& operator<<(
+    std::ostream& os, const Combinatorial_triangulation& triangulation) {
+  return os << *rebuild_triangulation(triangulation.snapshot());
+}
+
+#endif  // SRC_COMBINATORIALTRIANGULATION_H_
@@ -0,0 +1,302 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Indexes of the facets and edges of a triangulation on which (2,3) and
+/// (3,2) moves can be made. Moves keep them current by erasing what they
+/// removed and re-checking what lies around the vertices they touch, so
+/// make_23_move() and make_32_move() draw a flippable facet or edge in
+/// O(1) instead of trying random cells or edges until one flips.
+///
+/// \done O(1) insertion, removal, and uniform draws
+/// \done Kept current by every ergodic move
+/// \done Incident cell counts of every edge
+
+/// @file FlipIndex.h
+/// @brief Indexes of (2,3)-flippable facets and (3,2)-flippable edges
+/// @author Adam Getchell
+
+#ifndef SRC_FLIPINDEX_H_
+#define SRC_FLIPINDEX_H_
+
+// C++ headers
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/// @brief The addresses of two vertices, lowest first, keying an edge
+using Address_pair = std::pair<const void*, const void*>;
+
+/// @brief Hash of an Address_pair
+struct Address_pair_hash {
+  std::size_t operator()(const Address_pair& pair) const noexcept {
+    std::hash<const void*> hash;
+    auto                   seed = hash(pair.first);
+    return seed ^ (hash(pair.second) + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+  }
+};
+
+/// @brief The key of an edge, without reading its vertices
+/// @tparam Vertex The Vertex_handle type
+/// @param u One vertex of the edge
+/// @param v The other vertex of the edge
+/// @return The addresses of **u** and **v**, lowest first
+template <typename Vertex>
+Address_pair edge_key(const Vertex& u, const Vertex& v) {
+  const void* first  = std::addressof(*u);
+  const void* second = std::addressof(*v);
+  return std::less<const void*>{}(first, second) ? Address_pair{first, second}
+                                                 : Address_pair{second, first};
+}
+
+/// @class Flip_index
+/// @brief A set of facets supporting uniform random draws
+///
+/// Facets are stored densely, so the n-th facet is a uniform draw for
+/// a uniform n. Positions are keyed by the address of the cell, so a cell
+/// that has been deleted can still be erased, provided that is done
+/// before a new cell reuses its storage.
+///
+/// @tparam Cell The Cell_handle type
+template <typename Cell>
+class Flip_index {
+ public:
+  /// @brief A facet as a cell and the index of the vertex opposite it
+  using Facet = std::pair<Cell, int>;
+
+  /// @brief Add a facet
+  /// @param cell The cell
+  /// @param i The index of the vertex opposite the facet
+  /// @return **True** if the facet wasn't already indexed
+  bool insert(const Cell& cell, const int i) {
+    auto& positions = positions_[key(cell)];
+    if (positions[i] != 0) return false;
+    facets_.emplace_back(cell, i);
+    positions[i] = facets_.size();
+    return true;
+  }
+
+  /// @brief Remove a facet
+  /// @param cell The cell
+  /// @param i The index of the vertex opposite the facet
+  /// @return **True** if the facet was indexed
+  bool erase(const Cell& cell, const int i) {
+    auto found = positions_.find(key(cell));
+    if (found == positions_.end() || found->second[i] == 0) return false;
+    remove_at(found->second[i] - 1);
+    found->second[i] = 0;
+    if (found->second == std::array<std::size_t, 4>{}) positions_.erase(found);
+    return true;
+  }
+
+  /// @brief Remove every facet of a cell, which may have been deleted
+  /// @param cell The cell
+  void erase(const Cell& cell) {
+    auto found = positions_.find(key(cell));
+    if (found == positions_.end()) return;
+    for (auto i = 0; i < 4; ++i) {
+      if (found->second[i] != 0) {
+        remove_at(found->second[i] - 1);
+        found->second[i] = 0;
+      }
+    }
+    positions_.erase(found);
+  }
+
+  /// @param cell The cell
+  /// @param i The index of the vertex opposite the facet
+  /// @return **True** if the facet is indexed
+  bool contains(const Cell& cell, const int i) const {
+    auto found = positions_.find(key(cell));
+    return found != positions_.end() && found->second[i] != 0;
+  }
+
+  /// @param n A position from 0 to size()-1
+  /// @return The facet at position **n**
+  const Facet& operator[](const std::size_t n) const { return facets_[n]; }
+
+  /// @return The number of indexed facets
+  std::size_t size() const noexcept { return facets_.size(); }
+
+  /// @return **True** if no facets are indexed
+  bool empty() const noexcept { return facets_.empty(); }
+
+  /// @brief Remove all facets
+  void clear() noexcept {
+    facets_.clear();
+    positions_.clear();
+  }
+
+ private:
+  /// @param cell The cell
+  /// @return The key of **cell**, without reading it
+  static const void* key(const Cell& cell) { return std::addressof(*cell); }
+
+  /// @brief Remove the facet at position **n** by moving the last into it
+  /// @param n The position to remove
+  void remove_at(const std::size_t n) {
+    if (n + 1 != facets_.size()) {
+      facets_[n] = facets_.back();
+      positions_[key(facets_[n].first)][facets_[n].second] = n + 1;
+    }
+    facets_.pop_back();
+  }
+
+  /// @brief The indexed facets
+  std::vector<Facet> facets_;
+
+  /// @brief One plus the position of each facet of a cell, or 0
+  std::unordered_map<const void*, std::array<std::size_t, 4>> positions_;
+};
+
+/// @class Edge_index
+/// @brief Incident cell counts of edges, and a set of edges supporting
+/// uniform random draws
+///
+/// Edges are keyed by the addresses of their vertices, in either order,
+/// so an edge whose vertex has been deleted can still be erased.
+///
+/// @tparam Vertex The Vertex_handle type
+template <typename Vertex>
+class Edge_index {
+ public:
+  /// @brief An edge as its two vertices
+  using Edge = std::pair<Vertex, Vertex>;
+
+  /// @param u One vertex of the edge
+  /// @param v The other vertex of the edge
+  /// @return The number of cells incident to the edge, or 0 if unknown
+  int degree(const Vertex& u, const Vertex& v) const {
+    auto found = entries_.find(key(u, v));
+    return found == entries_.end() ? 0 : found->second.degree;
+  }
+
+  /// @brief Record the number of cells incident to an edge
+  /// @param u One vertex of the edge
+  /// @param v The other vertex of the edge
+  /// @param degree The number of incident cells
+  void set_degree(const Vertex& u, const Vertex& v, const int degree) {
+    entries_[key(u, v)].degree = degree;
+  }
+
+  /// @brief Add an edge to the set
+  /// @param u One vertex of the edge
+  /// @param v The other vertex of the edge
+  /// @return **True** if the edge wasn't already in the set
+  bool insert(const Vertex& u, const Vertex& v) {
+    auto& entry = entries_[key(u, v)];
+    if (entry.position != 0) return false;
+    edges_.emplace_back(u, v);
+    entry.position = edges_.size();
+    return true;
+  }
+
+  /// @brief Remove an edge from the set, keeping its degree
+  /// @param u One vertex of the edge
+  /// @param v The other vertex of the edge
+  /// @return **True** if the edge was in the set
+  bool erase(const Vertex& u, const Vertex& v) {
+    auto found = entries_.find(key(u, v));
+    if (found == entries_.end() || found->second.position == 0) return false;
+    remove_at(found->second.position - 1);
+    found->second.position = 0;
+    return true;
+  }
+
+  /// @brief Forget an edge that no longer exists
+  /// @param u One vertex of the edge
+  /// @param v The other vertex of the edge
+  void forget(const Vertex& u, const Vertex& v) {
+    auto found = entries_.find(key(u, v));
+    if (found == entries_.end()) return;
+    if (found->second.position != 0) remove_at(found->second.position - 1);
+    entries_.erase(found);
+  }
+
+  /// @param u One vertex of the edge
+  /// @param v The other vertex of the edge
+  /// @return **True** if the edge is in the set
+  bool contains(const Vertex& u, const Vertex& v) const {
+    auto found = entries_.find(key(u, v));
+    return found != entries_.end() && found->second.position != 0;
+  }
+
+  /// @brief Start a pass in which each edge is visited once
+  void begin_pass() noexcept { ++pass_; }
+
+  /// @brief Visit an edge in the current pass
+  /// @param u One vertex of the edge
+  /// @param v The other vertex of the edge
+  /// @return **True** if the edge hadn't been visited yet in this pass
+  bool visit(const Vertex& u, const Vertex& v) {
+    auto& entry = entries_[key(u, v)];
+    if (entry.pass == pass_) return false;
+    entry.pass = pass_;
+    return true;
+  }
+
+  /// @param n A position from 0 to size()-1
+  /// @return The edge at position **n** of the set
+  const Edge& operator[](const std::size_t n) const { return edges_[n]; }
+
+  /// @return The number of edges in the set
+  std::size_t size() const noexcept { return edges_.size(); }
+
+  /// @return **True** if the set is empty
+  bool empty() const noexcept { return edges_.empty(); }
+
+  /// @return The number of edges whose degree is known
+  std::size_t number_of_edges() const noexcept { return entries_.size(); }
+
+  /// @brief Forget all edges
+  void clear() noexcept {
+    edges_.clear();
+    entries_.clear();
+  }
+
+ private:
+  /// @brief What is known about an edge
+  struct Entry {
+    /// @brief Number of incident cells
+    int degree{0};
+
+    /// @brief One plus the position of the edge in the set, or 0
+    std::size_t position{0};
+
+    /// @brief The last pass that visited the edge
+    std::uint64_t pass{0};
+  };
+
+  /// @param u One vertex of the edge
+  /// @param v The other vertex of the edge
+  /// @return The key of the edge, without reading its vertices
+  static Address_pair key(const Vertex& u, const Vertex& v) {
+    return edge_key(u, v);
+  }
+
+  /// @brief Remove the edge at position **n** by moving the last into it
+  /// @param n The position to remove
+  void remove_at(const std::size_t n) {
+    if (n + 1 != edges_.size()) {
+      edges_[n] = edges_.back();
+      entries_[key(edges_[n].first, edges_[n].second)].position = n + 1;
+    }
+    edges_.pop_back();
+  }
+
+  /// @brief The edges in the set
+  std::vector<Edge> edges_;
+
+  /// @brief Every edge whose degree is known
+  std::unordered_map<Address_pair, Entry, Address_pair_hash> entries_;
+
+  /// @brief The current pass
+  std::uint64_t pass_{0};
+};
+
+#endif  // SRC_FLIPINDEX_H_
@@ -0,0 +1,138 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Compile-time descriptions of foliated triangulations of each dimension.
+///
+/// A D-simplex of a foliated triangulation spans two adjacent timeslices,
+/// with some of its D+1 vertices on the lower one and the rest on the
+/// upper. Foliation<D> names these types and classifies a simplex from the
+/// timevalues of its vertices in a fixed-size array, with the loops over
+/// vertices unrolled, so that no dimension is chosen at run time.
+/// Foliated_moves<D> holds the change each ergodic move makes to the
+/// simplex counts.
+///
+/// Only these descriptions are generic. The Delaunay and combinatorial
+/// triangulations, their moves, and the action are built for D = 3 and
+/// name their dimension as DIMENSION, so (3+1) runs aren't supported yet.
+///
+/// \done Simplex types and classification for any D
+/// \done Move deltas for D = 3
+/// \todo Triangulations and moves templated on D
+/// \todo Move deltas for D = 4, once there are (3+1) moves
+
+/// @file Foliation.h
+/// @brief Simplex types and move deltas of D-dimensional foliations
+/// @author Adam Getchell
+
+#ifndef SRC_FOLIATION_H_
+#define SRC_FOLIATION_H_
+
+#include <array>
+#include <cstdint>
+#include <utility>
+
+/// @struct
+/// @brief The simplex types of a D-dimensional foliated triangulation
+///
+/// Simplex types are written as in the (3,1) and (1,3) of D = 3: the
+/// number of vertices on the lower timeslice, then on the upper one, so
+/// for D = 4 the types are 41, 32, 23, and 14.
+///
+/// @tparam D The dimension of the triangulation
+template <int D>
+struct Foliation {
+  static_assert(D >= 2 && D <= 8, "Foliations have 2 to 8 dimensions.");
+
+  /// @brief Dimension of the triangulation
+  static constexpr int DIMENSION = D;
+
+  /// @brief Vertices of each simplex
+  static constexpr int VERTICES = D + 1;
+
+  /// @brief Number of simplex types
+  static constexpr int TYPES = D;
+
+  /// @brief Simplex types, from the most vertices on the lower timeslice
+  /// to the fewest
+  static constexpr std::array<std::int8_t, D> SIMPLEX_TYPES = [] {
+    std::array<std::int8_t, D> types{};
+    for (auto i = 0; i < D; ++i)
+      types[i] = static_cast<std::int8_t>((D - i) * 10 + 1 + i);
+    return types;
+  }();
+
+  /// @param on_lower The number of vertices on the lower timeslice
+  /// @return The type of a simplex with **on_lower** vertices on the
+  /// lower of two adjacent timeslices, or 0 if it has none on either
+  static constexpr std::int8_t simplex_type(const int on_lower) noexcept {
+    return on_lower >= 1 && on_lower <= D
+               ? static_cast<std::int8_t>(on_lower * 10 + VERTICES - on_lower)
+               : 0;
+  }
+
+  /// @param type A simplex type
+  /// @return Its position in SIMPLEX_TYPES, from the most vertices on the
+  /// lower timeslice to the fewest
+  static constexpr std::size_t type_index(const std::int8_t type) noexcept {
+    return static_cast<std::size_t>(D - type / 10);
+  }
+
+  /// @brief Classify a simplex
+  /// @tparam Time The type of a timevalue
+  /// @param timevalues The timevalues of its vertices
+  /// @return Its type, or 0 if it doesn't span exactly one timeslice
+  template <typename Time>
+  static constexpr std::int8_t classify(
+      const std::array<Time, VERTICES>& timevalues) noexcept {
+    return classify(timevalues, std::make_index_sequence<VERTICES>{});
+  }
+
+ private:
+  template <typename Time, std::size_t... I>
+  static constexpr std::int8_t classify(
+      const std::array<Time, VERTICES>& timevalues,
+      std::index_sequence<I...>) noexcept {
+    Time min_time = timevalues[0];
+    Time max_time = timevalues[0];
+    ((min_time = timevalues[I] < min_time ? timevalues[I] : min_time,
+      max_time = timevalues[I] > max_time ? timevalues[I] : max_time),
+     ...);
+    if (max_time - min_time != 1) return 0;
+    return simplex_type(((timevalues[I] == min_time ? 1 : 0) + ...));
+  }
+};
+
+/// @struct
+/// @brief Changes in simplex counts made by the ergodic moves of a
+/// D-dimensional foliated triangulation
+///
+/// Only D = 3 has moves, so using Foliated_moves of any other dimension
+/// doesn't compile.
+///
+/// @tparam D The dimension of the triangulation
+template <int D>
+struct Foliated_moves {
+  static_assert(D == 3, "There are no ergodic moves in this dimension.");
+};
+
+/// @struct
+/// @brief Changes in simplex counts made by (2+1) ergodic moves
+template <>
+struct Foliated_moves<3> {
+  /// @brief (3,1), (2,2), and (1,3) simplices, timelike edges, spacelike
+  /// edges, and vertices
+  using Invariants = std::array<std::intmax_t, 6>;
+
+  /// Change in each of the Invariants made by each move_type. The (4,4)
+  /// move isn't implemented, so it never satisfies its postconditions.
+  static constexpr std::array<Invariants, 5> DELTAS{{
+      {{0, 1, 0, 1, 0, 0}},       // (2,3)
+      {{0, -1, 0, -1, 0, 0}},     // (3,2)
+      {{2, 0, 2, 2, 3, 1}},       // (2,6)
+      {{-2, 0, -2, -2, -3, -1}},  // (6,2)
+      {{0, 0, 0, 0, 0, 0}}        // (4,4)
+  }};
+};
+
+#endif  // SRC_FOLIATION_H_
@@ -0,0 +1,308 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Low-overhead timers and counters for the Metropolis hot path.
+/// Each thread accumulates into its own counters, which are summed on
+/// demand and folded into a global total when the thread exits. A phase
+/// timed inside another on the same thread is left out of the outer
+/// phase's time, so each phase's time is exclusive and the report's shares
+/// add up to 100%. The CDT_TIME_PHASE and CDT_RECORD_RETRIES macros
+/// compile to nothing unless CDT_INSTRUMENTATION is defined
+/// (cmake -DINSTRUMENTATION:BOOL=ON).
+///
+/// \done Scoped phase timers on std::chrono::steady_clock
+/// \done Per-move retry histograms
+/// \done Per-phase report
+/// \done Exclusive phase times, so nested phases aren't counted twice
+
+/// @file Instrumentation.h
+/// @brief Hot-path phase timers and retry histograms
+/// @author Adam Getchell
+
+#ifndef SRC_INSTRUMENTATION_H_
+#define SRC_INSTRUMENTATION_H_
+
+// C++ headers
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <mutex>  // NOLINT
+#include <vector>
+
+/// Phases of a Metropolis step that are timed separately
+enum class phase : std::size_t {
+  PROPOSAL = 0,    ///< Choosing a move and its trial value
+  ACCEPTANCE,      ///< CalculateA1() and CalculateA2(), including the action
+  ROLLBACK,        ///< Undoing a move that MoveManager rejected
+  MOVE,            ///< The make_XX_move() functions themselves
+  VALIDATION,      ///< MoveManager checks after a move
+  CLASSIFICATION,  ///< classify_all_simplices()
+  CHECKPOINT,      ///< Writing files and compacting at checkpoints
+  PUBLICATION      ///< Copying the universe for a Measurement_pipeline
+};
+
+/// The number of phases
+static constexpr std::size_t PHASES = 8;
+
+/// Names of the phases, for reports
+static constexpr std::array<const char*, PHASES> PHASE_NAMES{
+    {"Proposal", "Acceptance", "Rollback", "Move", "Validation",
+     "Classification", "Checkpoint", "Publication"}};
+
+/// The number of move types with retry histograms
+static constexpr std::size_t RETRY_MOVES = 5;
+
+/// Retry histogram bucket k counts moves that took [2^k, 2^(k+1)) attempts;
+/// the last bucket is open-ended
+static constexpr std::size_t RETRY_BUCKETS = 8;
+
+/// @struct
+/// @brief A snapshot of instrumentation totals
+struct Instrumentation_report {
+  /// @brief Nanoseconds spent in each phase, excluding phases nested in it
+  std::array<std::uintmax_t, PHASES> nanoseconds{};
+
+  /// @brief Times each phase was entered
+  std::array<std::uintmax_t, PHASES> calls{};
+
+  /// @brief Retry histogram for each move type
+  std::array<std::array<std::uintmax_t, RETRY_BUCKETS>, RETRY_MOVES> retries{};
+};
+
+/// @brief Histogram bucket for a number of attempts
+/// @param attempts Attempts needed to make one move
+/// @return The bucket index, floor(log2(attempts)) capped at the last bucket
+inline auto retry_bucket(std::uintmax_t attempts) noexcept {
+  std::size_t bucket{0};
+  while (attempts > 1 && bucket < RETRY_BUCKETS - 1) {
+    attempts >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}  // retry_bucket()
+
+/// @class Instrumentation
+/// @brief Registry of per-thread instrumentation counters
+///
+/// Counters are atomics written only by their own thread with relaxed
+/// ordering, so recording is an uncontended load and store, while
+/// report() may read them from another thread at any time.
+class Instrumentation {
+ private:
+  /// @brief One thread's counters
+  struct Counters {
+    std::array<std::atomic_uintmax_t, PHASES> nanoseconds{};
+    std::array<std::atomic_uintmax_t, PHASES> calls{};
+    std::array<std::array<std::atomic_uintmax_t, RETRY_BUCKETS>, RETRY_MOVES>
+        retries{};
+  };
+
+  /// @brief Registers a thread's Counters, and retires them at thread exit
+  struct Registration {
+    Counters counters;
+    Registration() { instance().attach(&counters); }
+    ~Registration() { instance().detach(&counters); }
+  };
+
+  /// @brief Protects threads_ and retired_
+  std::mutex mutex_;
+
+  /// @brief Counters of live threads
+  std::vector<Counters*> threads_;
+
+  /// @brief Totals from threads that have exited
+  Instrumentation_report retired_;
+
+  /// @brief Add one relaxed atomic to another value
+  static void bump(std::atomic_uintmax_t& counter, std::uintmax_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value,
+                  std::memory_order_relaxed);
+  }
+
+  /// @brief Add a thread's counters to a report
+  static void accumulate(const Counters& counters,
+                         Instrumentation_report* report) {
+    for (std::size_t p = 0; p < PHASES; ++p) {
+      report->nanoseconds[p] +=
+          counters.nanoseconds[p].load(std::memory_order_relaxed);
+      report->calls[p] += counters.calls[p].load(std::memory_order_relaxed);
+    }
+    for (std::size_t m = 0; m < RETRY_MOVES; ++m) {
+      for (std::size_t b = 0; b < RETRY_BUCKETS; ++b) {
+        report->retries[m][b] +=
+            counters.retries[m][b].load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  void attach(Counters* counters) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    threads_.push_back(counters);
+  }
+
+  void detach(Counters* counters) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    accumulate(*counters, &retired_);
+    threads_.erase(std::remove(threads_.begin(), threads_.end(), counters),
+                   threads_.end());
+  }
+
+  /// @brief This thread's counters
+  static Counters& local() {
+    thread_local Registration registration;
+    return registration.counters;
+  }
+
+ public:
+  /// @brief The process-wide registry
+  static Instrumentation& instance() {
+    static Instrumentation registry;
+    return registry;
+  }
+
+  /// @brief Record time spent in a phase on this thread
+  /// @param p The phase
+  /// @param nanoseconds Time spent
+  static void record_phase(const phase p, const std::uintmax_t nanoseconds) {
+    auto& counters = local();
+    bump(counters.nanoseconds[static_cast<std::size_t>(p)], nanoseconds);
+    bump(counters.calls[static_cast<std::size_t>(p)], 1);
+  }
+
+  /// @brief Record how many attempts a move took on this thread
+  /// @param move The move_type, as its underlying integer
+  /// @param attempts Attempts made before the move succeeded
+  static void record_retries(const std::size_t    move,
+                             const std::uintmax_t attempts) {
+    if (move >= RETRY_MOVES) return;
+    bump(local().retries[move][retry_bucket(attempts)], 1);
+  }
+
+  /// @brief Sum the counters of all threads, live and exited
+  /// @return The totals so far
+  Instrumentation_report report() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto                        totals = retired_;
+    for (const auto* counters : threads_) accumulate(*counters, &totals);
+    return totals;
+  }
+
+  /// @brief Zero all counters
+  ///
+  /// Threads that are recording concurrently may lose a few counts.
+  void reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    retired_ = Instrumentation_report{};
+    for (auto* counters : threads_) {
+      for (auto& counter : counters->nanoseconds) counter.store(0);
+      for (auto& counter : counters->calls) counter.store(0);
+      for (auto& move : counters->retries) {
+        for (auto& counter : move) counter.store(0);
+      }
+    }
+  }
+};
+
+/// @class Scoped_phase_timer
+/// @brief Times a phase from construction to destruction
+///
+/// Timers on one thread nest. Each records its elapsed time less that of
+/// the timers nested in it, so no time is counted in two phases.
+class Scoped_phase_timer {
+ private:
+  /// @brief The phase being timed
+  phase phase_;
+
+  /// @brief When timing started
+  std::chrono::steady_clock::time_point start_;
+
+  /// @brief The timer this one is nested in, if any
+  Scoped_phase_timer* outer_;
+
+  /// @brief Time spent in timers nested in this one
+  std::uintmax_t nested_{0};
+
+  /// @brief The innermost running timer of this thread
+  static Scoped_phase_timer*& innermost() {
+    thread_local Scoped_phase_timer* timer{nullptr};
+    return timer;
+  }
+
+ public:
+  /// @brief Start timing a phase
+  /// @param p The phase
+  explicit Scoped_phase_timer(const phase p)
+      : phase_{p}
+      , start_{std::chrono::steady_clock::now()}
+      , outer_{innermost()} {
+    innermost() = this;
+  }
+
+  Scoped_phase_timer(const Scoped_phase_timer&) = delete;
+  Scoped_phase_timer& operator=(const Scoped_phase_timer&) = delete;
+
+  /// @brief Stop timing and record the elapsed time, less nested phases
+  ~Scoped_phase_timer() {
+    auto elapsed = static_cast<std::uintmax_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_)
+            .count());
+    Instrumentation::record_phase(phase_,
+                                  elapsed - std::min(nested_, elapsed));
+    if (outer_ != nullptr) outer_->nested_ += elapsed;
+    innermost() = outer_;
+  }
+};
+
+/// @brief Print a per-phase breakdown and the retry histograms
+/// @param report Totals from Instrumentation::report()
+inline void print_instrumentation(const Instrumentation_report& report) {
+  std::uintmax_t total{0};
+  for (auto nanoseconds : report.nanoseconds) total += nanoseconds;
+
+  std::cout << "Phase timings, excluding nested phases:" << std::endl;
+  for (std::size_t p = 0; p < PHASES; ++p) {
+    auto seconds = static_cast<double>(report.nanoseconds[p]) * 1e-9;
+    auto percent =
+        total ? 100.0 * static_cast<double>(report.nanoseconds[p]) / total
+              : 0.0;
+    std::cout << std::setw(16) << std::left << PHASE_NAMES[p] << std::right
+              << std::setw(12) << std::fixed << std::setprecision(3) << seconds
+              << " s " << std::setw(6) << std::setprecision(1) << percent
+              << "% " << std::setw(12) << report.calls[p] << " calls"
+              << std::endl;
+  }
+  std::cout << std::defaultfloat;
+
+  static constexpr std::array<const char*, RETRY_MOVES> move_names{
+      {"(2,3)", "(3,2)", "(2,6)", "(6,2)", "(4,4)"}};
+  std::cout << "Attempts per successful move (buckets 1, 2-3, 4-7, ...):"
+            << std::endl;
+  for (std::size_t m = 0; m < RETRY_MOVES; ++m) {
+    std::cout << std::setw(6) << std::left << move_names[m] << std::right;
+    for (auto count : report.retries[m]) std::cout << std::setw(10) << count;
+    std::cout << std::endl;
+  }
+}  // print_instrumentation()
+
+#ifdef CDT_INSTRUMENTATION
+#define CDT_CONCATENATE_DETAIL(x, y) x##y
+#define CDT_CONCATENATE(x, y) CDT_CONCATENATE_DETAIL(x, y)
+/// Time the rest of the enclosing scope as phase **p**
+#define CDT_TIME_PHASE(p) \
+  Scoped_phase_timer CDT_CONCATENATE(cdt_phase_timer_, __LINE__)(p)
+/// Record that a move of type **move** took **attempts** attempts
+#define CDT_RECORD_RETRIES(move, attempts)                       \
+  Instrumentation::record_retries(static_cast<std::size_t>(move), \
+                                  static_cast<std::uintmax_t>(attempts))
+#else
+#define CDT_TIME_PHASE(p) static_cast<void>(0)
+#define CDT_RECORD_RETRIES(move, attempts) static_cast<void>(attempts)
+#endif
+
+#endif  // SRC_INSTRUMENTATION_H_
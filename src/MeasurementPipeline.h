@@ -0,0 +1,406 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Measure snapshots of a run on other threads while the Markov chain goes
+/// on.
+///
+/// The Metropolis algorithm publishes a Measurement_frame, a Snapshot of
+/// the universe with its pass and move statistics, every so many passes.
+/// Frames wait in a bounded lock-free queue and are taken by drain tasks on
+/// the shared Thread_pool, which call each observer on each frame. The
+/// chain pays only for copying the universe into the Snapshot; however
+/// long the observers take, it doesn't wait for them unless the queue is
+/// full. Then it measures the oldest frames itself until there is room, so
+/// measurements that can't keep up slow the chain instead of piling up
+/// snapshots without bound.
+///
+/// Frames are immutable and shared, so observers may read them on any
+/// number of threads at once. Different frames are measured concurrently
+/// and may finish out of order, so an observer that keeps results must
+/// guard them and key them by pass.
+///
+/// \done Bounded lock-free queue of frames
+/// \done Drain tasks on the shared thread pool
+/// \done Volume profiles
+/// \todo Distance and curvature observables
+
+/// @file MeasurementPipeline.h
+/// @brief Concurrent measurements of published snapshots
+/// @author Adam Getchell
+
+#ifndef SRC_MEASUREMENTPIPELINE_H_
+#define SRC_MEASUREMENTPIPELINE_H_
+
+// CDT headers
+#include "Snapshot.h"
+#include "ThreadPool.h"
+#include "Trace.h"
+
+// C++ headers
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+/// @class Bounded_queue
+/// @brief A fixed-capacity lock-free queue for any number of producers and
+/// consumers
+///
+/// D. Vyukov's bounded MPMC queue: each slot carries a sequence number
+/// telling whether it is ready to be written for a given position or read
+/// from it, so producers and consumers claim positions with one
+/// compare-and-swap and never wait for each other's locks.
+///
+/// @tparam T The type of the elements
+template <typename T>
+class Bounded_queue {
+ public:
+  /// @param capacity The most elements held at once, at least 2
+  explicit Bounded_queue(const std::size_t capacity)
+      : capacity_{std::max<std::size_t>(capacity, 2)}
+      , slots_{std::make_unique<Slot[]>(capacity_)} {
+    for (std::size_t n = 0; n < capacity_; ++n)
+      slots_[n].sequence.store(n, std::memory_order_relaxed);
+  }
+
+  Bounded_queue(const Bounded_queue&) = delete;
+  Bounded_queue& operator=(const Bounded_queue&) = delete;
+
+  /// @brief Gets the capacity.
+  /// @return The most elements held at once
+  auto capacity() const noexcept { return capacity_; }
+
+  /// @brief Add an element, unless the queue is full
+  /// @param value The element, moved from only if it was added
+  /// @return **True** if **value** was added
+  bool try_push(T& value) {
+    auto position = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      auto&      slot     = slots_[position % capacity_];
+      const auto sequence = slot.sequence.load(std::memory_order_acquire);
+      const auto difference =
+          static_cast<std::ptrdiff_t>(sequence - position);
+      if (difference == 0) {
+        if (tail_.compare_exchange_weak(position, position + 1,
+                                        std::memory_order_relaxed)) {
+          slot.value = std::move(value);
+          slot.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        // The slot still holds the element from a lap ago
+        return false;
+      } else {
+        position = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// @brief Take the oldest element, unless the queue is empty
+  /// @param value Overwritten with the element
+  /// @return **True** if an element was taken
+  bool try_pop(T& value) {
+    auto position = head_.load(std::memory_order_relaxed);
+    for (;;) {
+      auto&      slot     = slots_[position % capacity_];
+      const auto sequence = slot.sequence.load(std::memory_order_acquire);
+      const auto difference =
+          static_cast<std::ptrdiff_t>(sequence - (position + 1));
+      if (difference == 0) {
+        if (head_.compare_exchange_weak(position, position + 1,
+                                        std::memory_order_relaxed)) {
+          value      = std::move(slot.value);
+          slot.value = T{};
+          slot.sequence.store(position + capacity_,
+                              std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        // The slot hasn't been written for this position yet
+        return false;
+      } else {
+        position = head_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+ private:
+  /// @brief An element and where it is in the queue
+  struct Slot {
+    std::atomic_size_t sequence{0};
+    T                  value{};
+  };
+
+  /// @brief The most elements held at once
+  std::size_t capacity_;
+
+  /// @brief The ring of slots
+  std::unique_ptr<Slot[]> slots_;
+
+  /// @brief The next position to read; apart from **tail_** so that
+  /// producers and consumers don't share a cache line
+  alignas(64) std::atomic_size_t head_{0};
+
+  /// @brief The next position to write
+  alignas(64) std::atomic_size_t tail_{0};
+};
+
+/// @struct
+/// @brief A universe published for measurement
+struct Measurement_frame {
+  /// @brief The pass after which the universe was copied
+  std::intmax_t pass{0};
+
+  /// @brief The universe
+  Snapshot snapshot;
+
+  /// @brief Attempted moves up to **pass**
+  Move_tracker attempted_moves{};
+
+  /// @brief Successful moves up to **pass**
+  Move_tracker successful_moves{};
+};
+
+/// @class Measurement_pipeline
+/// @brief Observers of frames published by a running Metropolis algorithm
+class Measurement_pipeline {
+ public:
+  /// @brief A measurement of a frame, called on any thread
+  using Observer = std::function<void(const Measurement_frame&)>;
+
+  /// Frames held by default before publish() waits; each is a copy of the
+  /// universe, so the queue is kept short
+  static constexpr std::size_t DEFAULT_CAPACITY = 4;
+
+  /// @param capacity The most frames waiting to be measured at once
+  /// @param consumers Most frames measured at once; 0 for one per worker
+  /// @param pool The pool the frames are measured on
+  explicit Measurement_pipeline(const std::size_t capacity = DEFAULT_CAPACITY,
+                                const std::size_t consumers = 0,
+                                Thread_pool& pool = Thread_pool::instance())
+      : state_{std::make_shared<State>(capacity)}
+      , consumers_{consumers == 0 ? pool.size() : consumers}
+      , pool_{pool} {}
+
+  Measurement_pipeline(const Measurement_pipeline&) = delete;
+  Measurement_pipeline& operator=(const Measurement_pipeline&) = delete;
+
+  /// @brief Measure what is left, ignoring failures; call finish() first
+  /// to see them
+  ~Measurement_pipeline() {
+    try {
+      finish();
+    } catch (...) {
+    }
+  }
+
+  /// @brief Add a measurement of every frame
+  ///
+  /// Observers are called in the order they were added.
+  ///
+  /// @param observer The measurement
+  void add_observer(Observer observer) {
+    if (published_ > 0)
+      throw std::logic_error("Observers must be added before publishing.");
+    state_->observers.emplace_back(std::move(observer));
+  }
+
+  /// @brief Queue a frame to be measured
+  ///
+  /// Returns once the frame is queued, which is at once unless the queue
+  /// is full. Then the oldest frames are measured on this thread until
+  /// there is room. No other tasks of the pool are run here, since this
+  /// thread may itself be a pool task that others are waiting on.
+  ///
+  /// @param snapshot The universe
+  /// @param pass The pass after which it was copied
+  /// @param attempted_moves Attempted moves up to **pass**
+  /// @param successful_moves Successful moves up to **pass**
+  void publish(Snapshot snapshot, const std::intmax_t pass,
+               const Move_tracker& attempted_moves,
+               const Move_tracker& successful_moves) {
+    Frame frame = std::make_shared<const Measurement_frame>(
+        Measurement_frame{pass, std::move(snapshot), attempted_moves,
+                          successful_moves});
+    ++published_;
+    if (!state_->queue.try_push(frame)) {
+      Trace_span span("Wait for measurements", "measurement", pass);
+      ++stalls_;
+      do {
+        Frame oldest;
+        if (state_->queue.try_pop(oldest)) {
+          state_->measure(std::move(oldest));
+        } else {
+          std::this_thread::yield();
+        }
+      } while (!state_->queue.try_push(frame));
+    }
+    start_consumer();
+  }
+
+  /// @brief Wait until every frame published so far has been measured
+  ///
+  /// Frames still queued are measured on this thread, and frames that
+  /// drain tasks are measuring are waited for. Rethrows the first
+  /// exception an observer threw.
+  void finish() {
+    Frame frame;
+    while (state_->queue.try_pop(frame)) state_->measure(std::move(frame));
+    while (state_->measured < published_) {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    std::lock_guard<std::mutex> lock(state_->failure_mutex);
+    if (state_->failure) {
+      std::rethrow_exception(std::exchange(state_->failure, nullptr));
+    }
+  }
+
+  /// @brief Gets the number of frames published.
+  /// @return published_
+  auto Published() const noexcept { return published_.load(); }
+
+  /// @brief Gets the number of frames measured.
+  /// @return The number of frames measured, successfully or not
+  auto Measured() const noexcept { return state_->measured.load(); }
+
+  /// @brief Gets the number of frames that found the queue full.
+  /// @return stalls_
+  auto Stalls() const noexcept { return stalls_.load(); }
+
+  /// @brief Gets the capacity of the queue.
+  /// @return The most frames waiting to be measured at once
+  auto Capacity() const noexcept { return state_->queue.capacity(); }
+
+  /// @brief Gets the most frames measured at once.
+  /// @return consumers_
+  auto Consumers() const noexcept { return consumers_; }
+
+ private:
+  using Frame = std::shared_ptr<const Measurement_frame>;
+
+  /// @brief What drain tasks share with the pipeline
+  ///
+  /// A drain task may still be waiting for a worker when the pipeline is
+  /// finished and destroyed, so it holds this instead of the pipeline, and
+  /// finds the queue empty when it runs.
+  struct State {
+    explicit State(const std::size_t capacity) : queue{capacity} {}
+
+    /// @brief Call each observer on a frame
+    /// @param frame The frame, released before it is counted as measured
+    void measure(Frame frame) {
+      {
+        Trace_span span("Measure", "measurement", frame->pass);
+        try {
+          for (const auto& observer : observers) observer(*frame);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(failure_mutex);
+          if (!failure) failure = std::current_exception();
+        }
+        // Let go of the copy of the universe before the next one
+        frame.reset();
+      }
+      ++measured;
+    }
+
+    /// @brief Frames waiting to be measured
+    Bounded_queue<Frame> queue;
+
+    /// @brief The measurements
+    std::vector<Observer> observers;
+
+    /// @brief Drain tasks submitted and not yet finished
+    std::atomic_size_t active{0};
+
+    /// @brief Frames measured, successfully or not
+    std::atomic_intmax_t measured{0};
+
+    /// @brief The first exception an observer threw
+    std::exception_ptr failure;
+
+    /// @brief Guards **failure**
+    std::mutex failure_mutex;
+  };
+
+  /// @brief Submit a drain task, unless **consumers_** are already
+  /// submitted
+  ///
+  /// A frame queued just as the last drain task finds the queue empty
+  /// waits for the next publish(), or is measured by finish().
+  void start_consumer() {
+    auto active = state_->active.load();
+    while (active < consumers_) {
+      if (state_->active.compare_exchange_weak(active, active + 1)) {
+        pool_.submit([state = state_] {
+          Frame frame;
+          while (state->queue.try_pop(frame)) state->measure(std::move(frame));
+          --state->active;
+        });
+        return;
+      }
+    }
+  }
+
+  /// @brief The queue and observers, shared with the drain tasks
+  std::shared_ptr<State> state_;
+
+  /// @brief Most drain tasks at once
+  std::size_t consumers_;
+
+  /// @brief The pool the drain tasks run on
+  Thread_pool& pool_;
+
+  /// @brief Frames published
+  std::atomic_intmax_t published_{0};
+
+  /// @brief Frames that found the queue full
+  std::atomic_intmax_t stalls_{0};
+};
+
+/// @class Volume_profile_writer
+/// @brief Observer writing the volume profile of each frame as rows of
+/// pass, timeslice, and spacelike facets
+///
+/// Each frame's rows are written together, but frames may be written out
+/// of order.
+class Volume_profile_writer {
+ public:
+  /// @param output The stream, which must outlive the pipeline
+  explicit Volume_profile_writer(std::ostream& output)
+      : output_{&output}, mutex_{std::make_shared<std::mutex>()} {
+    *output_ << "pass,timeslice,volume\n";
+  }
+
+  /// @brief Measure and write one frame
+  /// @param frame The frame
+  void operator()(const Measurement_frame& frame) const {
+    std::ostringstream rows;
+    for (const auto& [timeslice, volume] :
+         volume_per_timeslice(frame.snapshot)) {
+      rows << frame.pass << ',' << timeslice << ',' << volume << '\n';
+    }
+    std::lock_guard<std::mutex> lock(*mutex_);
+    *output_ << rows.str() << std::flush;
+  }
+
+ private:
+  /// @brief Where the rows go
+  std::ostream* output_;
+
+  /// @brief Guards **output_**, shared by copies of the observer
+  std::shared_ptr<std::mutex> mutex_;
+};
+
+#endif  // SRC_MEASUREMENTPIPELINE_H_
@@ -28,6 +28,7 @@ auto VolumePerTimeslice(T&& manifold) -> decltype(manifold) {
 #ifndef NDEBUG
   std::cout << __PRETTY_FUNCTION__ << " called." << std::endl;
 #endif
+  Trace_span span("VolumePerTimeslice", "measurement");
 
   print_results(manifold);
 
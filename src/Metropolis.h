@@ -14,6 +14,12 @@
 /// \done CalculateA1
 /// \done CalculateA2
 /// \done Update N1_TL_, N3_31_ and N3_22_ after successful moves
+/// \done Compact the triangulation at checkpoints
+/// \done Continue from saved move statistics
+/// \done Record checkpoints to a trajectory file
+/// \done Run on any manifold type, including toroidal ones
+/// \done Reproducible runs from a seed
+/// \done Publish snapshots to a measurement pipeline
 /// \todo Atomic integral types for safe multithreading
 /// \todo Debug occasional infinite loops and segfaults!
 /// \todo Implement 3D Metropolis algorithm in operator()
@@ -34,14 +40,21 @@
 // #include <CGAL/Mpzf.h>
 
 // CDT headers
+#include "Instrumentation.h"
+#include "MeasurementPipeline.h"
 #include "Measurements.h"
 #include "MoveManager.h"
 #include "S3Action.h"
 #include "S3ErgodicMoves.h"
+#include "Snapshot.h"
+#include "Trajectory.h"
 
 // C++ headers
 #include <algorithm>
 #include <atomic>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -61,7 +74,7 @@ template <typename E>
 constexpr auto to_integral(E e) -> typename std::underlying_type<E>::type {
   return static_cast<typename std::underlying_type<E>::type>(e);
 }
-/// @class Metropolis
+/// @class Basic_metropolis
 /// @brief Metropolis-Hastings algorithm function object
 ///
 /// The Metropolis-Hastings algorithm is a Markov Chain Monte Carlo method.
@@ -70,10 +83,13 @@ constexpr auto to_integral(E e) -> typename std::underlying_type<E>::type {
 /// \f[P_{ergodic move}=a_{1}a_{2}\f]
 /// \f[a_1=\frac{move[i]}{\sum\limits_{i}move[i]}\f]
 /// \f[a_2=e^{\Delta S}\f]
-class Metropolis {
+///
+/// @tparam Manifold The manifold type, such as SimplicialManifold
+template <typename Manifold>
+class Basic_metropolis {
  private:
-  /// @brief A SimplicialManifold.
-  SimplicialManifold universe_;
+  /// @brief The manifold.
+  Manifold universe_;
 
   /// @brief The length of the timelike edges.
   long double Alpha_;
@@ -100,12 +116,33 @@ class Metropolis {
   /// @brief How often to print/write output.
   std::intmax_t checkpoint_{10};
 
+  /// @brief Compact the triangulation every n checkpoints, 0 to never.
+  std::intmax_t compaction_{1};
+
   /// @brief Attempted (2,3), (3,2), (2,6), (6,2), and (4,4) moves.
   Move_tracker attempted_moves_{};
 
   /// @brief Successful (2,3), (3,2), (2,6), (6,2), and (4,4) moves.
   std::array<std::atomic_intmax_t, 5> successful_moves_{};
 
+  /// @brief Whether move statistics were restored from a previous run.
+  bool warm_start_{false};
+
+  /// @brief Passes made by previous runs, which this run's passes follow.
+  std::intmax_t pass_offset_{0};
+
+  /// @brief Trajectory to record checkpoints to, if any; not owned.
+  Trajectory_writer* trajectory_{nullptr};
+
+  /// @brief The seed of each move attempt's random numbers, if any.
+  std::optional<std::uint64_t> seed_{};
+
+  /// @brief Pipeline to publish snapshots to, if any; not owned.
+  Measurement_pipeline* pipeline_{nullptr};
+
+  /// @brief Publish a snapshot every n passes.
+  std::intmax_t cadence_{1};
+
  public:
   /// @brief Metropolis function object constructor
   ///
@@ -117,14 +154,18 @@ class Metropolis {
   /// Cosmological constant.
   /// @param passes Number of passes of ergodic moves on triangulation.
   /// @param checkpoint Print/write output for every n=checkpoint passes.
-  Metropolis(const long double Alpha, const long double K,
-             const long double Lambda, const std::intmax_t passes,
-             const std::intmax_t checkpoint)
+  /// @param compaction Compact the triangulation every n=compaction
+  /// checkpoints, or never if 0.
+  Basic_metropolis(const long double Alpha, const long double K,
+                   const long double Lambda, const std::intmax_t passes,
+                   const std::intmax_t checkpoint,
+                   const std::intmax_t compaction = 1)
       : Alpha_(Alpha)
       , K_(K)
       , Lambda_(Lambda)
       , passes_(passes)
-      , checkpoint_(checkpoint) {
+      , checkpoint_(checkpoint)
+      , compaction_(compaction) {
 #ifndef NDEBUG
     std::cout << __PRETTY_FUNCTION__ << " called." << std::endl;
 #endif
@@ -150,6 +191,10 @@ class Metropolis {
   /// @return checkpoint_
   auto Checkpoint() const noexcept { return checkpoint_; }
 
+  /// @brief Gets value of **compaction_**.
+  /// @return compaction_
+  auto Compaction() const noexcept { return compaction_; }
+
   /// @brief Gets attempted (2,3) moves.
   /// @return attempted_moves_[0]
   auto TwoThreeMoves() const noexcept { return attempted_moves_[0]; }
@@ -210,6 +255,89 @@ class Metropolis {
 
   auto CurrentTotalSimplices() const noexcept { return N3_31_13_ + N3_22_; }
 
+  /// @brief Gets all attempted moves.
+  /// @return A copy of attempted_moves_
+  auto AttemptedMoves() const noexcept { return attempted_moves_; }
+
+  /// @brief Gets all successful moves.
+  /// @return A copy of successful_moves_
+  auto SuccessfulMoves() const noexcept {
+    Move_tracker moves{};
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+      moves[i] = successful_moves_[i].load();
+    }
+    return moves;
+  }
+
+  /// @brief Continue from the move statistics of a previous run
+  ///
+  /// operator() then skips its initial move of each type, which exists
+  /// only to seed these statistics, and numbers its passes after the
+  /// previous run's, so a seeded run draws new random numbers rather than
+  /// replaying the ones the previous run used.
+  ///
+  /// @param attempted Attempted moves so far
+  /// @param successful Successful moves so far
+  /// @param passes Passes made so far
+  void restore_moves(const Move_tracker& attempted,
+                     const Move_tracker& successful,
+                     const std::intmax_t passes = 0) noexcept {
+    attempted_moves_ = attempted;
+    for (std::size_t i = 0; i < successful.size(); ++i) {
+      successful_moves_[i] = successful[i];
+    }
+    pass_offset_ = passes;
+    warm_start_  = true;
+  }
+
+  /// @brief Number this run's passes after **pass**, such as the last
+  /// frame of a trajectory it appends to
+  ///
+  /// @param pass The pass to follow
+  void start_after(const std::intmax_t pass) noexcept { pass_offset_ = pass; }
+
+  /// @brief Gets value of **pass_offset_**.
+  /// @return pass_offset_
+  auto PassOffset() const noexcept { return pass_offset_; }
+
+  /// @brief Append checkpoints to a trajectory instead of writing a file
+  /// for each
+  ///
+  /// @param trajectory The trajectory, which must outlive the run
+  void record_trajectory(Trajectory_writer& trajectory) noexcept {
+    trajectory_ = &trajectory;
+  }
+
+  /// @brief Draw the random numbers of each move attempt from a
+  /// Random_stream, so that runs with the same seed make the same moves
+  ///
+  /// @param seed The run seed
+  void use_seed(const std::uint64_t seed) noexcept { seed_ = seed; }
+
+  /// @brief Gets the run seed, if any.
+  /// @return seed_
+  auto Seed() const noexcept { return seed_; }
+
+  /// @brief Publish a Snapshot of the universe every **cadence** passes,
+  /// to be measured on other threads while the passes go on
+  ///
+  /// @param pipeline The pipeline, which must outlive the run
+  /// @param cadence Publish every n=cadence passes
+  void publish_to(Measurement_pipeline& pipeline, const std::intmax_t cadence) {
+    if (cadence < 1)
+      throw std::invalid_argument("Cadence must be at least one pass.");
+    pipeline_ = &pipeline;
+    cadence_  = cadence;
+  }
+
+  /// @brief Gets the pipeline snapshots are published to, if any.
+  /// @return pipeline_
+  auto Pipeline() const noexcept { return pipeline_; }
+
+  /// @brief Gets value of **cadence_**.
+  /// @return cadence_
+  auto Cadence() const noexcept { return cadence_; }
+
   /// @brief Calculate A1
   ///
   /// Calculate the probability of making a move divided by the
@@ -354,6 +482,9 @@ class Metropolis {
     std::cout << "Successful (4,4) moves: " << SuccessfulFourFourMoves()
               << std::endl;
     std::cout << "Attempted (4,4) moves: " << FourFourMoves() << std::endl;
+#ifdef CDT_INSTRUMENTATION
+    print_instrumentation(Instrumentation::instance().report());
+#endif
   }
 
   /// @brief Make a move of the selected type
@@ -366,6 +497,9 @@ class Metropolis {
   ///
   /// \done Add exception handling for moves to gracefully recover
   /// \done Use MoveManager RAII class
+  /// \done Compile-time move dispatch instead of function_ref lambdas
+  /// \done No copies of the manifold inside MoveManager or the moves
+  /// \done Make moves in place and undo failed ones, with no working copy
   ///
   /// @param move The type of move
   void make_move(const move_type move) {
@@ -373,67 +507,12 @@ class Metropolis {
     std::cout << __PRETTY_FUNCTION__ << " called." << std::endl;
 #endif
 
-    // Make working copies
-    boost::optional<decltype(universe_)> maybe_moved_universe{universe_};
-    auto maybe_move_count = boost::make_optional(true, attempted_moves_);
-
-    // Initialize MoveManager
-    MoveManager<decltype(maybe_moved_universe), decltype(maybe_move_count)>
-        this_move(std::move(maybe_moved_universe), std::move(maybe_move_count));
-
-    // Setup moves
-    auto move_23_lambda = [](
-        SimplicialManifold manifold,
-        Move_tracker&      attempted_moves) -> SimplicialManifold {
-      return make_23_move(std::move(manifold), attempted_moves);
-    };
-    auto move_32_lambda = [](
-        SimplicialManifold manifold,
-        Move_tracker&      attempted_moves) -> SimplicialManifold {
-      return make_32_move(std::move(manifold), attempted_moves);
-    };
-    auto move_26_lambda = [](
-        SimplicialManifold manifold,
-        Move_tracker&      attempted_moves) -> SimplicialManifold {
-      return make_26_move(std::move(manifold), attempted_moves);
-    };
-    auto move_62_lambda = [](
-        SimplicialManifold manifold,
-        Move_tracker&      attempted_moves) -> SimplicialManifold {
-      return make_62_move(std::move(manifold), attempted_moves);
-    };
-
-    switch (move) {
-      case move_type::TWO_THREE: {
-        function_ref<SimplicialManifold(SimplicialManifold, Move_tracker&)>
-            move_function(move_23_lambda);
-        maybe_moved_universe = this_move.operator()(move_function);
-      } break;
-      case move_type::THREE_TWO: {
-        function_ref<SimplicialManifold(SimplicialManifold, Move_tracker&)>
-            move_function(move_32_lambda);
-        maybe_moved_universe = this_move.operator()(move_function);
-      } break;
-      case move_type::TWO_SIX: {
-        function_ref<SimplicialManifold(SimplicialManifold, Move_tracker&)>
-            move_function(move_26_lambda);
-        maybe_moved_universe = this_move.operator()(move_function);
-      } break;
-      case move_type::SIX_TWO: {
-        function_ref<SimplicialManifold(SimplicialManifold, Move_tracker&)>
-            move_function(move_62_lambda);
-        maybe_moved_universe = this_move.operator()(move_function);
-      } break;
-      case move_type::FOUR_FOUR:
-        break;
-    }
+    // The move is made on universe_ itself, and undone if it fails
+    MoveManager<Manifold&, Move_tracker&> this_move(universe_,
+                                                    attempted_moves_);
 
-    // Check if move completed successfully and update if so
-    if (maybe_moved_universe) {
-      swap(universe_, maybe_moved_universe.get());
-      swap(attempted_moves_, this_move.attempted_moves_.get());
-      ++successful_moves_[to_integral(move)];
-    }
+    // Dispatch once to the statically typed move
+    if (this_move.make_move(move)) ++successful_moves_[to_integral(move)];
 
     // Update counters
     N1_TL_    = universe_.geometry->N1_TL();
@@ -450,12 +529,20 @@ class Metropolis {
   ///
   /// @param move The type of move
   void attempt_move(const move_type move) {
-    // Calculate probability
-    auto a1 = CalculateA1(move);
-    // Make move if random number < probability
-    auto a2 = CalculateA2(move);
+    double a1{0};
+    double a2{0};
+    {
+      CDT_TIME_PHASE(phase::ACCEPTANCE);
+      // Calculate probability
+      a1 = CalculateA1(move);
+      // Make move if random number < probability
+      a2 = CalculateA2(move);
+    }
 
-    const auto trial_value = generate_probability();
+    const auto trial_value = [] {
+      CDT_TIME_PHASE(phase::PROPOSAL);
+      return generate_probability();
+    }();
     // Convert to Gmpzf because trial_value will be set to 0 when
     // comparing with a1 and a2!
     //    const auto trial = Gmpzf(static_cast<double>(trial_value));
@@ -516,13 +603,18 @@ class Metropolis {
     // Populate attempted_moves_ and successful_moves_
     std::cout << "Making initial moves ...\n";
     try {
+      Trace_span span("Initial moves", "metropolis");
       // Determine how many actual timeslices there are
-      universe_ = std::move(VolumePerTimeslice(universe_));
-      // Make a successful move of each type
-      make_move(move_type::TWO_THREE);
-      make_move(move_type::THREE_TWO);
-      make_move(move_type::TWO_SIX);
-      make_move(move_type::SIX_TWO);
+      VolumePerTimeslice(universe_);
+      // Make a successful move of each type, unless continuing a run
+      if (!warm_start_) {
+        for (auto move : {move_type::TWO_THREE, move_type::THREE_TWO,
+                          move_type::TWO_SIX, move_type::SIX_TWO}) {
+          std::optional<Random_scope> random;
+          if (seed_) random.emplace(*seed_, 0, to_integral(move));
+          make_move(move);
+        }
+      }
       print_run();
     } catch (std::logic_error& LogicError) {
       std::cerr << LogicError.what() << std::endl;
@@ -530,14 +622,23 @@ class Metropolis {
     }
 
     std::cout << "Making random moves ..." << std::endl;
-    // Loop through passes_
-    for (std::intmax_t pass_number = 1; pass_number <= passes_; ++pass_number) {
-      auto total_simplices_this_pass = CurrentTotalSimplices();
+    // Loop through passes_, numbered after those of previous runs
+    for (std::intmax_t pass_number = pass_offset_ + 1;
+         pass_number <= pass_offset_ + passes_; ++pass_number) {
+      Trace_span pass_span("Pass", "metropolis", pass_number);
+      auto       total_simplices_this_pass = CurrentTotalSimplices();
       // Loop through CurrentTotalSimplices
       for (std::intmax_t move_attempt = 0;
            move_attempt < total_simplices_this_pass; ++move_attempt) {
+        // Key the attempt's random numbers to where it is in the run
+        std::optional<Random_scope> random;
+        if (seed_) random.emplace(*seed_, pass_number, move_attempt);
+
         // Pick a move to attempt
-        auto move_choice = generate_random_signed(0, 3);
+        auto move_choice = [] {
+          CDT_TIME_PHASE(phase::PROPOSAL);
+          return generate_random_signed(0, 3);
+        }();
 #ifndef NDEBUG
         std::cout << "Move choice = " << move_choice << std::endl;
 #endif
@@ -547,13 +648,36 @@ class Metropolis {
         attempt_move(move);
       }  // End loop through CurrentTotalSimplices
 
+      // Hand a copy of the universe to be measured off the chain
+      if (pipeline_ != nullptr && (pass_number % cadence_) == 0) {
+        CDT_TIME_PHASE(phase::PUBLICATION);
+        Trace_span publish_span("Publish", "metropolis", pass_number);
+        pipeline_->publish(make_snapshot(universe_), pass_number,
+                           attempted_moves_, SuccessfulMoves());
+      }
+
       // Do stuff on checkpoint_
       if ((pass_number % checkpoint_) == 0) {
+        CDT_TIME_PHASE(phase::CHECKPOINT);
+        Trace_span checkpoint_span("Checkpoint", "metropolis", pass_number);
         std::cout << "Pass " << pass_number << std::endl;
         // write results to a file
-        write_file(universe_, topology_type::SPHERICAL, 3,
-                   universe_.geometry->number_of_cells(),
-                   universe_.geometry->max_timevalue().get());
+        if (trajectory_ != nullptr) {
+          trajectory_->append_universe(universe_, pass_number,
+                                       attempted_moves_, SuccessfulMoves());
+        } else {
+          write_file(universe_, Manifold::TOPOLOGY, 3,
+                     universe_.geometry->number_of_cells(),
+                     universe_.geometry->max_timevalue().get());
+        }
+        // Restore memory locality after heavy churn; only Delaunay
+        // triangulations can be rebuilt from a Snapshot
+        if constexpr (std::is_same<Manifold, SimplicialManifold>::value) {
+          if (compaction_ > 0 &&
+              (pass_number / checkpoint_) % compaction_ == 0) {
+            compact(std::move(universe_));
+          }
+        }
       }
     }  // End loop through passes_
     // output results
@@ -561,6 +685,9 @@ class Metropolis {
     print_run();
     return universe_;
   }
-};  // Metropolis
+};  // Basic_metropolis
+
+/// The Metropolis algorithm on spherical (S3) manifolds
+using Metropolis = Basic_metropolis<SimplicialManifold>;
 
 #endif  // SRC_METROPOLIS_H_
@@ -18,40 +18,99 @@
 #define SRC_MOVEMANAGER_H_
 
 #include <algorithm>
+#include <atomic>
+#include <iterator>
 #include <memory>
 #include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "Foliation.h"
 #include "Function_ref.h"
+#include "S3ErgodicMoves.h"
 #include "SimplicialManifold.h"
 
-using move_invariants = std::array<std::intmax_t, 6>;
+using move_invariants = Foliated_moves<DIMENSION>::Invariants;
+
+/// Change in (3,1), (2,2), and (1,3) simplices, timelike edges, spacelike
+/// edges, and vertices made by each move_type
+static constexpr const auto& MOVE_DELTAS = Foliated_moves<DIMENSION>::DELTAS;
+
+/// Validate the whole triangulation once every this many moves. Other
+/// moves validate only the cells they touched. Debug builds validate the
+/// whole triangulation after every move.
+static constexpr std::intmax_t FULL_VALIDATION_INTERVAL = 1000;
+
+/// @brief The value held in an option type
+/// @tparam T The type of the value
+/// @param held An engaged option type
+/// @return A reference to the value of **held**
+template <typename T>
+T& held_value(boost::optional<T>& held) {
+  return held.get();
+}
+
+/// @brief The value held in a const option type
+/// @tparam T The type of the value
+/// @param held An engaged option type
+/// @return A const reference to the value of **held**
+template <typename T>
+const T& held_value(const boost::optional<T>& held) {
+  return held.get();
+}
+
+/// @brief The value held by reference
+/// @tparam T The type of the value
+/// @param held The value
+/// @return **held**
+template <typename T>
+T& held_value(T& held) {
+  return held;
+}
 
 /// @class MoveManager
 /// @brief RAII Function object to handle moves
-/// @tparam T1 SimplicialManifold type
-/// @tparam T2 Move counter type
+///
+/// Holds either option types, which are disengaged when a move fails, or
+/// references to the caller's manifold and move counter, on which a failed
+/// move is undone.
+///
+/// @tparam T1 SimplicialManifold type, as an option type or a reference
+/// @tparam T2 Move counter type, as an option type or a reference
 template <class T1, class T2>
 class MoveManager {
  public:
-  /// @brief An option type SimplicialManifold
+  /// @brief The manifold type held by T1
+  using Manifold = std::decay_t<decltype(held_value(std::declval<T1&>()))>;
+
+  /// @brief The Vertex_handle type of Manifold
+  using Vertex = Manifold_vertex_handle<Manifold>;
+
+  /// @brief Whether moves are made on the caller's manifold, and undone if
+  /// they fail
+  static constexpr bool IN_PLACE = std::is_reference<T1>::value;
+
+  /// @brief An option type SimplicialManifold, or a reference to one
   T1 universe_;
 
-  /// @brief An option type move counter
+  /// @brief An option type move counter, or a reference to one
   T2 attempted_moves_;
 
   move_invariants check{};
 
+  /// @brief Whether the geometry has followed every change to the manifold
+  bool geometry_current_{true};
+
   /// @brief Perfect forwarding constructor initializer
   ///
-  /// Because a SimplicialManifold is move-only and uses std::unique_ptrs,
-  /// this RAII class should be initialized with option types. The general
-  /// pattern is to make option-types and pass those to the ctor, and then
-  /// check that the returned data structures are non-empty before consuming
-  /// them. Any thrown exceptions will call the destructor, so the returned
-  /// data structures will be empty (point to nullptr).
+  /// Initialized with option types, the general pattern is to make them and
+  /// pass those to the ctor, and then check that the returned data
+  /// structures are non-empty before consuming them. Any thrown exceptions
+  /// will call the destructor, so the returned data structures will be
+  /// empty (point to nullptr). Initialized with references, as
+  /// Basic_metropolis::make_move() does, nothing is copied: moves are made
+  /// on the referenced manifold, and a failed move is undone.
   ///
   /// @param universe Initializes universe_
   /// @param attempted_moves Initializes attempted_moves_
@@ -68,92 +127,238 @@ class MoveManager {
     throw std::runtime_error("No move found!");
   }
 
+  /// @brief Current values of the move invariants
+  /// @return (3,1), (2,2), (1,3) simplices, timelike and spacelike edges,
+  /// and vertices, in the order of MOVE_DELTAS
+  move_invariants geometry_counts() const {
+    const auto& geometry = held_value(universe_).geometry;
+    return {{geometry->N3_31(), geometry->N3_22(), geometry->N3_13(),
+             geometry->N1_TL(), geometry->N1_SL(), geometry->N0()}};
+  }
+
+  /// @brief Check that a move changed the invariants as it should
+  /// @param move The move that was made
+  /// @return **True** if every invariant in **check** changed by
+  /// MOVE_DELTAS[move]
+  bool check_postconditions(const move_type move) const {
+    if (move == move_type::FOUR_FOUR) return false;
+    const auto& delta  = MOVE_DELTAS[static_cast<std::size_t>(move)];
+    auto        counts = geometry_counts();
+    for (std::size_t i = 0; i < counts.size(); ++i) {
+      if (counts[i] != check[i] + delta[i]) return false;
+    }
+    return true;
+  }
+
   bool check_move_postconditions(Move_tracker new_moves,
                                  Move_tracker old_moves) {
 #ifndef NDEBUG
     std::cout << __PRETTY_FUNCTION__ << " called." << std::endl;
 #endif
-    auto move = static_cast<move_type>(ArrayDifference(new_moves, old_moves));
-    switch (move) {
-      case move_type::TWO_THREE: {
-        return (check[0] == universe_.get().geometry->N3_31() &&
-                check[1] == universe_.get().geometry->N3_22() - 1 &&
-                check[2] == universe_.get().geometry->N3_13() &&
-                check[3] == universe_.get().geometry->N1_TL() - 1 &&
-                check[4] == universe_.get().geometry->N1_SL() &&
-                check[5] == universe_.get().geometry->N0());
-      }
-      case move_type::THREE_TWO: {
-        return (check[0] == universe_.get().geometry->N3_31() &&
-                check[1] == universe_.get().geometry->N3_22() + 1 &&
-                check[2] == universe_.get().geometry->N3_13() &&
-                check[3] == universe_.get().geometry->N1_TL() + 1 &&
-                check[4] == universe_.get().geometry->N1_SL() &&
-                check[5] == universe_.get().geometry->N0());
-      }
-      case move_type::TWO_SIX: {
-        return (check[0] == universe_.get().geometry->N3_31() - 2 &&
-                check[1] == universe_.get().geometry->N3_22() &&
-                check[2] == universe_.get().geometry->N3_13() - 2 &&
-                check[3] == universe_.get().geometry->N1_TL() - 2 &&
-                check[4] == universe_.get().geometry->N1_SL() - 3 &&
-                check[5] == universe_.get().geometry->N0() - 1);
-      }
-      case move_type::SIX_TWO: {
-        return (check[0] == universe_.get().geometry->N3_31() + 2 &&
-                check[1] == universe_.get().geometry->N3_22() &&
-                check[2] == universe_.get().geometry->N3_13() + 2 &&
-                check[3] == universe_.get().geometry->N1_TL() + 2 &&
-                check[4] == universe_.get().geometry->N1_SL() + 3 &&
-                check[5] == universe_.get().geometry->N0() + 1);
+    return check_postconditions(
+        static_cast<move_type>(ArrayDifference(new_moves, old_moves)));
+  }
+
+  /// @brief Check the cells a move touched
+  ///
+  /// Checks the star of each vertex in last_move_vertices() for
+  /// combinatorial consistency (each cell valid and mutually adjacent to
+  /// its neighbors) and foliation (finite cells span exactly one
+  /// timeslice). This is O(size of the stars) rather than O(N).
+  ///
+  /// @return **True** if the stars of the touched vertices are valid
+  bool check_local_validity() {
+#ifndef NDEBUG
+    std::cout << __PRETTY_FUNCTION__ << " called." << std::endl;
+#endif
+    const auto& manifold = held_value(universe_);
+    const auto& tds      = manifold.triangulation->tds();
+
+    thread_local std::vector<Manifold_cell_handle<Manifold>> star;
+    for (const auto& vertex : last_move_vertices<Vertex>()) {
+      if (!tds.is_valid(vertex)) return false;
+      star.clear();
+      tds.incident_cells(vertex, std::back_inserter(star));
+      for (const auto& cell : star) {
+        if (!tds.is_valid(cell)) return false;
+        if (!is_foliated(manifold, cell)) return false;
       }
-      case move_type::FOUR_FOUR: {
-        return false;
+    }
+    return true;
+  }
+
+  /// @brief Whether this move should validate the whole triangulation
+  ///
+  /// True in debug builds, every FULL_VALIDATION_INTERVAL moves otherwise,
+  /// and whenever the move didn't record which vertices it touched.
+  ///
+  /// @return **True** if tds().is_valid() should be run
+  static bool full_validation_due() {
+#ifndef NDEBUG
+    return true;
+#else
+    static std::atomic_intmax_t moves{0};
+    return last_move_vertices<Vertex>().empty() ||
+           (++moves % FULL_VALIDATION_INTERVAL) == 0;
+#endif
+  }
+
+  /// @brief Check the invariants after a move, throwing if any fail
+  /// @param old_moves Attempted moves before the move
+  void check_move(const Move_tracker& old_moves) {
+    CDT_TIME_PHASE(phase::VALIDATION);
+    if constexpr (!IN_PLACE) {
+      if (!universe_) throw std::runtime_error("working manifold is empty!");
+      if (!attempted_moves_)
+        throw std::runtime_error("attempted_moves_ is empty!");
+    }
+    if (!check_local_validity())
+      throw std::runtime_error("Move invalidated its cells.");
+    if (full_validation_due() &&
+        !held_value(universe_).triangulation->tds().is_valid())
+      throw std::runtime_error("Move invalidated triangulation.");
+
+    auto moves_are_good =
+        check_move_postconditions(held_value(attempted_moves_), old_moves);
+#ifndef NDEBUG
+    std::cout << "Moves are good: " << std::boolalpha << moves_are_good
+              << std::endl;
+#endif
+    if (!moves_are_good)
+      throw std::runtime_error("Move postconditions violated.");
+  }
+
+  /// @brief Recover from a failed move
+  ///
+  /// A manifold held by reference has the move undone, and the attempts
+  /// counted for it forgotten, as they were when moves were made on a
+  /// working copy. Its geometry follows the undo as it followed the move,
+  /// or is reclassified if the move failed before it could. One held in an
+  /// option type is disengaged. An exception thrown while undoing the move
+  /// propagates, since the manifold can't be trusted after it.
+  ///
+  /// @param old_moves Attempted moves before the move
+  void roll_back(const Move_tracker& old_moves) {
+    if constexpr (IN_PLACE) {
+      CDT_TIME_PHASE(phase::ROLLBACK);
+      auto& manifold = held_value(universe_);
+      undo_move(manifold);
+      if (geometry_current_) {
+        update_geometry(manifold);
+      } else {
+        reclassify(manifold);
+        geometry_current_ = true;
       }
+      held_value(attempted_moves_) = old_moves;
+    } else {
+      universe_ = {};
     }
   }
-  /// @brief Function call
+
+  /// @brief Make a move of type M in place
+  ///
+  /// The move is chosen at compile time and works on universe_ by
+  /// reference, so the triangulation is neither copied nor moved. Its
+  /// geometry follows the move with update_geometry(), in time proportional
+  /// to the cells the move changed. On success universe_ holds the moved
+  /// manifold; on failure it is rolled back with roll_back().
+  ///
+  /// @tparam M The move_type
+  /// @return **True** if the move succeeded
+  template <move_type M>
+  bool make_move() {
+#ifndef NDEBUG
+    std::cout << __PRETTY_FUNCTION__ << " called." << std::endl;
+#endif
+    Move_tracker old_moves = held_value(attempted_moves_);
+    try {
+      check = geometry_counts();
+
+      last_move_vertices<Vertex>().clear();
+      last_move_record<Manifold>().clear();
+      auto& manifold = held_value(universe_);
+      index_geometry(manifold);
+      geometry_current_ = false;
+      make_ergodic_move<M>(manifold, held_value(attempted_moves_));
+      update_geometry(manifold);
+      geometry_current_ = true;
+
+      check_move(old_moves);
+      return true;
+    }
+
+    catch (const std::exception& ex) {
+      std::cerr << "Caught move error: " << ex.what() << std::endl;
+    }
+
+    catch (...) {
+      std::cerr << "Caught non-std::exception!" << std::endl;
+    }
+    roll_back(old_moves);
+    return false;
+  }
+
+  /// @brief Make a move chosen at runtime
+  ///
+  /// Dispatches once to the statically typed make_move<M>().
+  ///
+  /// @param move The move_type
+  /// @return **True** if the move succeeded
+  bool make_move(const move_type move) {
+    switch (move) {
+      case move_type::TWO_THREE:
+        return make_move<move_type::TWO_THREE>();
+      case move_type::THREE_TWO:
+        return make_move<move_type::THREE_TWO>();
+      case move_type::TWO_SIX:
+        return make_move<move_type::TWO_SIX>();
+      case move_type::SIX_TWO:
+        return make_move<move_type::SIX_TWO>();
+      case move_type::FOUR_FOUR:
+        break;
+    }
+    // Nothing was moved, so there is nothing to undo
+    if constexpr (!IN_PLACE) universe_ = {};
+    return false;
+  }
+
+  /// @brief Make the move in place through a function_ref
+  ///
+  /// On success universe_ holds the moved manifold; on failure it is
+  /// disengaged. A move that throws has already taken the manifold, so
+  /// there is nothing to undo, and this needs option types. Callers that
+  /// only want the result can move it out of universe_ rather than copying
+  /// it as operator() does. Prefer make_move<M>(), which avoids the
+  /// type-erased call and the by-value hand-offs.
+  ///
   /// @param move A function_ref to the move being performed
-  /// @return The results of move on universe_
-  auto operator()(
+  /// @return **True** if the move succeeded
+  bool make_move(
       function_ref<SimplicialManifold(SimplicialManifold, Move_tracker&)>
           move) {
+    static_assert(!IN_PLACE, "A function_ref move needs option types.");
 #ifndef NDEBUG
     std::cout << __PRETTY_FUNCTION__ << " called." << std::endl;
 #endif
 
     try {
       // Look at moves made so far
-      auto old_moves = attempted_moves_.get();
-      //      auto N3_31_13_ = universe_.get().geometry->N3_31();
-      check[0] = universe_.get().geometry->N3_31();
-      check[1] = universe_.get().geometry->N3_22();
-      check[2] = universe_.get().geometry->N3_13();
-      check[3] = universe_.get().geometry->N1_TL();
-      check[4] = universe_.get().geometry->N1_SL();
-      check[5] = universe_.get().geometry->N0();
-
-      // Now make new move
-      universe_.get() = move(universe_.get(), attempted_moves_.get());
+      auto old_moves = held_value(attempted_moves_);
+      check          = geometry_counts();
 
-      // Check move invariants
-      if (!universe_) throw std::runtime_error("working manifold is empty!");
-      if (!universe_.get().triangulation->tds().is_valid())
-        throw std::runtime_error("Move invalidated triangulation.");
-      if (!attempted_moves_)
-        throw std::runtime_error("attempted_moves_ is empty!");
+      // Now make new move, handing over the manifold rather than copying it
+      last_move_vertices().clear();
+      last_move_record<SimplicialManifold>().clear();
+      index_geometry(held_value(universe_));
+      held_value(universe_) =
+          move(std::move(held_value(universe_)), held_value(attempted_moves_));
+      update_geometry(held_value(universe_));
 
-      auto moves_are_good =
-          check_move_postconditions(attempted_moves_.get(), old_moves);
-#ifndef NDEBUG
-      std::cout << "Moves are good: " << std::boolalpha << moves_are_good
-                << std::endl;
-#endif
-      if (!moves_are_good)
-        throw std::runtime_error("Move postconditions violated.");
+      // Check move invariants
+      check_move(old_moves);
 
-      // Return results of valid move
-      return universe_;
+      // universe_ holds results of valid move
+      return true;
     }
 
     catch (const std::exception& ex) {
@@ -166,6 +371,16 @@ class MoveManager {
     // Disengage boost::optional value which returns results of invalid move
     // Only works on recent versions of Boost (>1.63)
     universe_ = {};
+    return false;
+  }
+
+  /// @brief Function call
+  /// @param move A function_ref to the move being performed
+  /// @return The results of move on universe_
+  auto operator()(
+      function_ref<SimplicialManifold(SimplicialManifold, Move_tracker&)>
+          move) {
+    make_move(move);
     return universe_;
   }
 };
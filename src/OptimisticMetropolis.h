@@ -0,0 +1,618 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Performs the Metropolis-Hastings algorithm on a CombinatorialManifold
+/// with several threads making moves anywhere in it.
+///
+/// Each worker proposes a move under a shared lock: it decides whether to
+/// accept it, finds a candidate as make_ergodic_move() would, and records
+/// the version stamps of every cell the candidate's test read. It then
+/// commits under an exclusive lock, but only if none of those stamps has
+/// changed; otherwise another worker's move got there first, and the
+/// proposal is retried. Tests and acceptance, which are most of the work,
+/// run concurrently, while commits rewrite a few cells each.
+///
+/// A seeded run commits in order instead. Proposal n of a pass draws its
+/// move, trial, and candidate from Random_scope(seed, pass, n), and waits
+/// for proposals 0 to n-1 to finish before committing. If any of them
+/// committed after it was proposed, it is proposed again from the same
+/// stream. The chain is then that of proposals made one at a time, however
+/// many threads there are.
+///
+/// \done Proposals on every thread, validated commits
+/// \done Acceptance re-evaluated against the counts at commit
+/// \done Reproducible chains on any number of threads from a seed
+/// \done Publish snapshots to a measurement pipeline
+/// \todo Commit moves with disjoint stars concurrently
+
+/// @file OptimisticMetropolis.h
+/// @brief Metropolis-Hastings with optimistic concurrency
+/// @author Adam Getchell
+
+#ifndef SRC_OPTIMISTICMETROPOLIS_H_
+#define SRC_OPTIMISTICMETROPOLIS_H_
+
+// C++ headers
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// CDT headers
+#include "CombinatorialErgodicMoves.h"
+#include "CombinatorialManifold.h"
+#include "Metropolis.h"
+#include "ThreadPool.h"
+
+/// @class Optimistic_metropolis
+/// @brief Metropolis-Hastings function object with optimistic concurrency
+///
+/// The acceptance probability is that of Basic_metropolis, \f$a_1a_2\f$,
+/// with \f$a_2\f$ from the change each move makes to the action. Each
+/// attempt counts once, whatever its move type, and \f$a_1\f$ is taken
+/// from the counts at the start of each pass, so it doesn't depend on the
+/// order in which threads finish.
+class Optimistic_metropolis {
+ public:
+  /// @brief A move found and tested under a shared lock
+  struct Proposal {
+    /// @brief The type of move
+    move_type move{move_type::TWO_THREE};
+
+    /// @brief The cell of the candidate, unless it is a vertex
+    Combinatorial_cell cell{};
+
+    /// @brief Vertex index in **cell** of a facet or an edge
+    int i{0};
+
+    /// @brief Vertex index in **cell** of the other end of an edge
+    int j{0};
+
+    /// @brief The vertex of a (6,2) candidate
+    Combinatorial_vertex vertex{};
+
+    /// @brief Cells the candidate's test read, with their version stamps
+    std::vector<std::pair<Combinatorial_cell, std::uint32_t>> read_set;
+  };
+
+  /// @brief Optimistic_metropolis function object constructor
+  /// @param Alpha \f$\alpha\f$ is the timelike edge length.
+  /// @param K \f$k=\frac{1}{8\pi G_{Newton}}\f$
+  /// @param Lambda \f$\lambda=k*\Lambda\f$ where \f$\Lambda\f$ is the
+  /// Cosmological constant.
+  /// @param passes Number of passes of ergodic moves on triangulation.
+  /// @param checkpoint Print/write output for every n=checkpoint passes.
+  /// @param threads Number of tasks making moves; 0 for one per worker of
+  /// the shared Thread_pool
+  Optimistic_metropolis(const long double Alpha, const long double K,
+                        const long double Lambda, const std::intmax_t passes,
+                        const std::intmax_t checkpoint, unsigned threads = 0)
+      : Alpha_(Alpha)
+      , K_(K)
+      , Lambda_(Lambda)
+      , passes_(passes)
+      , checkpoint_(checkpoint)
+      , threads_(threads == 0 ? Thread_pool::instance().size() : threads) {
+#ifndef NDEBUG
+    std::cout << __PRETTY_FUNCTION__ << " called." << std::endl;
+#endif
+  }
+
+  /// @brief Gets value of **Alpha_**.
+  /// @return Alpha_
+  auto Alpha() const noexcept { return Alpha_; }
+
+  /// @brief Gets value of **K_**.
+  /// @return K_
+  auto K() const noexcept { return K_; }
+
+  /// @brief Gets value of **Lambda_**.
+  /// @return Lambda_
+  auto Lambda() const noexcept { return Lambda_; }
+
+  /// @brief Gets value of **passes_**.
+  /// @return passes_
+  auto Passes() const noexcept { return passes_; }
+
+  /// @brief Gets value of **checkpoint_**.
+  /// @return checkpoint_
+  auto Checkpoint() const noexcept { return checkpoint_; }
+
+  /// @brief Gets value of **threads_**.
+  /// @return threads_
+  auto Threads() const noexcept { return threads_; }
+
+  /// @brief Gets all attempted moves.
+  /// @return The attempted moves of each type
+  auto AttemptedMoves() const noexcept { return load(attempted_moves_); }
+
+  /// @brief Gets all successful moves.
+  /// @return The successful moves of each type
+  auto SuccessfulMoves() const noexcept { return load(successful_moves_); }
+
+  /// @brief Gets the total number of attempted moves.
+  /// @return The sum of AttemptedMoves()
+  auto TotalMoves() const noexcept {
+    std::intmax_t total{0};
+    for (const auto& moves : attempted_moves_) total += moves.load();
+    return total;
+  }
+
+  /// @brief Gets the number of proposals retried because another move
+  /// changed a cell they read
+  /// @return conflicts_
+  auto Conflicts() const noexcept { return conflicts_.load(); }
+
+  /// @brief Continue from the move statistics and pass count of a
+  /// previous run
+  /// @param attempted Attempted moves so far
+  /// @param successful Successful moves so far
+  /// @param passes Passes made so far, which this run's passes follow
+  void restore_moves(const Move_tracker& attempted,
+                     const Move_tracker& successful,
+                     const std::intmax_t passes = 0) noexcept {
+    for (std::size_t n = 0; n < attempted.size(); ++n) {
+      attempted_moves_[n]  = attempted[n];
+      successful_moves_[n] = successful[n];
+    }
+    pass_offset_ = passes;
+  }
+
+  /// @brief Number this run's passes after **pass**
+  /// @param pass The pass to follow
+  void start_after(const std::intmax_t pass) noexcept { pass_offset_ = pass; }
+
+  /// @brief Gets value of **pass_offset_**.
+  /// @return pass_offset_
+  auto PassOffset() const noexcept { return pass_offset_; }
+
+  /// @brief Append checkpoints to a trajectory instead of writing a file
+  /// for each
+  /// @param trajectory The trajectory, which must outlive the run
+  void record_trajectory(Trajectory_writer& trajectory) noexcept {
+    trajectory_ = &trajectory;
+  }
+
+  /// @brief Draw the random numbers of each proposal from a Random_stream
+  /// and commit proposals in order, so that runs with the same seed make
+  /// the same moves on any number of threads
+  /// @param seed The run seed
+  void use_seed(const std::uint64_t seed) noexcept { seed_ = seed; }
+
+  /// @brief Gets the run seed, if any.
+  /// @return seed_
+  auto Seed() const noexcept { return seed_; }
+
+  /// @brief Publish a Snapshot of the universe every **cadence** passes,
+  /// to be measured on other threads while the passes go on
+  /// @param pipeline The pipeline, which must outlive the run
+  /// @param cadence Publish every n=cadence passes
+  void publish_to(Measurement_pipeline& pipeline, const std::intmax_t cadence) {
+    if (cadence < 1)
+      throw std::invalid_argument("Cadence must be at least one pass.");
+    pipeline_ = &pipeline;
+    cadence_  = cadence;
+  }
+
+  /// @brief Call operator
+  ///
+  /// Each pass attempts as many moves as there were simplices at its
+  /// start, shared among the worker threads as they finish.
+  ///
+  /// @tparam T Type of manifold, a CombinatorialManifold
+  /// @param universe Manifold on which to operate
+  /// @return The **universe** upon which the passes have been completed.
+  template <typename T>
+  auto operator()(T&& universe) -> decltype(universe) {
+#ifndef NDEBUG
+    std::cout << __PRETTY_FUNCTION__ << " called." << std::endl;
+#endif
+    std::cout << "Starting optimistic Metropolis-Hastings algorithm on "
+              << threads_ << " threads ...\n";
+    universe_ = std::move(universe);
+    VolumePerTimeslice(universe_);
+
+    // Seed the move statistics that the acceptance probability uses with
+    // an attempt of each type drawn
+    if (TotalMoves() == 0) {
+      for (std::size_t n = 0; n < 4; ++n) attempted_moves_[n] = 1;
+    }
+    refresh_a1();
+
+    for (std::intmax_t pass_number = pass_offset_ + 1;
+         pass_number <= pass_offset_ + passes_; ++pass_number) {
+      Trace_span pass_span("Pass", "metropolis", pass_number);
+      run_pass(pass_number, universe_.geometry->number_of_cells());
+      refresh_a1();
+      reclassify(universe_);
+
+      if (pipeline_ != nullptr && (pass_number % cadence_) == 0) {
+        CDT_TIME_PHASE(phase::PUBLICATION);
+        Trace_span publish_span("Publish", "metropolis", pass_number);
+        pipeline_->publish(make_snapshot(universe_), pass_number,
+                           AttemptedMoves(), SuccessfulMoves());
+      }
+
+      if (checkpoint_ > 0 && (pass_number % checkpoint_) == 0) {
+        CDT_TIME_PHASE(phase::CHECKPOINT);
+        Trace_span checkpoint_span("Checkpoint", "metropolis", pass_number);
+        std::cout << "Pass " << pass_number << std::endl;
+        VolumePerTimeslice(universe_);
+        if (trajectory_ != nullptr) {
+          trajectory_->append_universe(universe_, pass_number,
+                                       AttemptedMoves(), SuccessfulMoves());
+        } else {
+          write_file(universe_, CombinatorialManifold::TOPOLOGY, 3,
+                     universe_.geometry->number_of_cells(),
+                     universe_.geometry->max_timevalue().get());
+        }
+      }
+    }
+    std::cout << "Run results: " << std::endl;
+    print_results(universe_);
+    std::cout << "Conflicting proposals retried: " << Conflicts()
+              << std::endl;
+    return universe_;
+  }
+
+  /// @brief Attempt a move, retrying its proposal until it commits or is
+  /// rejected
+  ///
+  /// Safe to call from several threads at once.
+  ///
+  /// @param move The type of move
+  /// @param proposal Scratch space, reused across attempts
+  /// @return **True** if the move was made
+  bool attempt_move(const move_type move, Proposal& proposal) {
+    const auto index = static_cast<std::size_t>(to_integral(move));
+    const auto trial = static_cast<double>(generate_probability());
+    ++attempted_moves_[index];
+    proposal.move = move;
+    for (;;) {
+      {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        if (trial > acceptance(move) || !propose(proposal)) return false;
+      }
+      std::unique_lock<std::shared_mutex> lock(mutex_);
+      if (!is_current(proposal)) {
+        ++conflicts_;
+        continue;
+      }
+      // Other moves may have changed the counts the action depends on
+      if (trial > acceptance(move)) return false;
+      commit(proposal);
+      ++commits_;
+      ++successful_moves_[index];
+      return true;
+    }
+  }  // attempt_move()
+
+ private:
+  /// @param moves Atomic counts of each move type
+  /// @return A copy of **moves**
+  static Move_tracker load(
+      const std::array<std::atomic_intmax_t, 5>& moves) noexcept {
+    Move_tracker result{};
+    for (std::size_t n = 0; n < result.size(); ++n) result[n] = moves[n];
+    return result;
+  }
+
+  /// @brief Make **moves** attempts in **threads_** tasks on the shared
+  /// Thread_pool
+  /// @param pass_number The pass
+  /// @param moves The number of attempts
+  void run_pass(const std::intmax_t pass_number, const std::intmax_t moves) {
+    std::atomic_intmax_t next{0};
+    turn_   = 0;
+    failed_ = false;
+    Thread_pool::instance().parallel_for(
+        0, threads_,
+        [&](std::size_t) {
+          Proposal proposal;
+          try {
+            for (auto n = next++; n < moves; n = next++) {
+              if (seed_) {
+                attempt_in_turn(pass_number, n, proposal);
+              } else {
+                attempt_move(
+                    static_cast<move_type>(generate_random_signed(0, 3)),
+                    proposal);
+              }
+            }
+          } catch (...) {
+            next = moves;
+            // Release the tasks waiting for a turn that won't come
+            {
+              std::unique_lock<std::shared_mutex> lock(mutex_);
+              failed_ = true;
+            }
+            turn_changed_.notify_all();
+            throw;
+          }
+        },
+        threads_);
+  }  // run_pass()
+
+  /// @brief Attempt proposal **n** of a seeded pass, committing it after
+  /// proposals 0 to n-1
+  /// @param pass_number The pass
+  /// @param n The proposal within the pass
+  /// @param proposal Scratch space, reused across attempts
+  /// @return **True** if the move was made
+  bool attempt_in_turn(const std::intmax_t pass_number, const std::intmax_t n,
+                       Proposal& proposal) {
+    // Draw the move, the trial, and the candidate from proposal n's stream
+    auto speculate = [this, pass_number, n, &proposal] {
+      Random_scope random(*seed_, pass_number, n);
+      proposal.move    = static_cast<move_type>(generate_random_signed(0, 3));
+      const auto trial = static_cast<double>(generate_probability());
+      return trial <= acceptance(proposal.move) && propose(proposal);
+    };
+
+    bool          accepted;
+    std::intmax_t commits_seen;
+    {
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      commits_seen = commits_;
+      accepted     = speculate();
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    turn_changed_.wait(lock, [this, n] { return turn_ == n || failed_; });
+    if (failed_) return false;
+    // An earlier proposal changed the triangulation since, so propose again
+    // from the same stream
+    if (commits_ != commits_seen) {
+      ++conflicts_;
+      accepted = speculate();
+    }
+    const auto index = static_cast<std::size_t>(to_integral(proposal.move));
+    ++attempted_moves_[index];
+    if (accepted) {
+      commit(proposal);
+      ++commits_;
+      ++successful_moves_[index];
+    }
+    ++turn_;
+    turn_changed_.notify_all();
+    return accepted;
+  }  // attempt_in_turn()
+
+  /// @brief Take \f$a_1\f$ of each move type from the counts so far
+  void refresh_a1() noexcept {
+    const auto total = static_cast<double>(TotalMoves());
+    for (std::size_t n = 0; n < a1_.size(); ++n) {
+      a1_[n] = total > 0 ? static_cast<double>(attempted_moves_[n]) / total : 0;
+    }
+  }  // refresh_a1()
+
+  /// @brief Calculate \f$a_1a_2\f$ from the current simplex counts
+  /// @param move The type of move
+  /// @return The probability of accepting **move**
+  double acceptance(const move_type move) const {
+    const auto& triangulation = *universe_.triangulation;
+    const auto& delta = MOVE_DELTAS[static_cast<std::size_t>(move)];
+    const auto  a1    = a1_[static_cast<std::size_t>(move)];
+
+    const auto N1_TL    = triangulation.N1_TL();
+    const auto N3_31_13 = triangulation.N3_31() + triangulation.N3_13();
+    const auto N3_22    = triangulation.N3_22();
+    auto       current =
+        S3_bulk_action(N1_TL, N3_31_13, N3_22, Alpha_, K_, Lambda_);
+    auto changed = S3_bulk_action(N1_TL + delta[3],
+                                  N3_31_13 + delta[0] + delta[2],
+                                  N3_22 + delta[1], Alpha_, K_, Lambda_);
+    auto exponent = Gmpzf_to_double(current - changed);
+    return exponent >= 0 ? a1 : a1 * std::exp(exponent);
+  }  // acceptance()
+
+  /// @brief Find a candidate for a move and record what its test read
+  /// @param proposal The proposal, whose **move** is set
+  /// @return **True** if a candidate was found
+  bool propose(Proposal& proposal) const {
+    const auto&   triangulation = *universe_.triangulation;
+    std::intmax_t draws{0};
+    std::intmax_t choice{-1};
+    thread_local std::vector<Combinatorial_cell> cells;
+    cells.clear();
+    switch (proposal.move) {
+      case move_type::TWO_THREE:
+        choice = choose_candidate(
+            4 * triangulation.number_of_cells(),
+            [](std::intmax_t) { return true; },
+            [&triangulation](const std::intmax_t facet) {
+              return triangulation.is_23_flippable(
+                  static_cast<Combinatorial_cell>(facet / 4),
+                  static_cast<int>(facet % 4));
+            },
+            draws);
+        if (choice < 0) return false;
+        proposal.cell = static_cast<Combinatorial_cell>(choice / 4);
+        proposal.i    = static_cast<int>(choice % 4);
+        cells.assign({proposal.cell,
+                      triangulation.neighbor(proposal.cell, proposal.i)});
+        break;
+      case move_type::THREE_TWO:
+        choice = choose_candidate(
+            6 * triangulation.number_of_cells(),
+            [](std::intmax_t) { return true; },
+            [&triangulation](const std::intmax_t edge) {
+              const auto& index = EDGE_VERTEX_INDEX[edge % 6];
+              return triangulation.is_32_flippable(
+                  static_cast<Combinatorial_cell>(edge / 6), index[0],
+                  index[1]);
+            },
+            draws);
+        if (choice < 0) return false;
+        proposal.cell = static_cast<Combinatorial_cell>(choice / 6);
+        proposal.i    = EDGE_VERTEX_INDEX[choice % 6][0];
+        proposal.j    = EDGE_VERTEX_INDEX[choice % 6][1];
+        triangulation.incident_cells(proposal.cell, proposal.i, proposal.j,
+                                     std::back_inserter(cells));
+        break;
+      case move_type::TWO_SIX:
+        choice = choose_candidate(
+            triangulation.number_of_cells(),
+            [&triangulation](const std::intmax_t cell) {
+              return triangulation.cell_type(
+                         static_cast<Combinatorial_cell>(cell)) == 13;
+            },
+            [&triangulation](const std::intmax_t cell) {
+              int i{0};
+              return triangulation.is_26_movable(
+                  static_cast<Combinatorial_cell>(cell), i);
+            },
+            draws);
+        if (choice < 0) return false;
+        proposal.cell = static_cast<Combinatorial_cell>(choice);
+        triangulation.is_26_movable(proposal.cell, proposal.i);
+        cells.assign({proposal.cell,
+                      triangulation.neighbor(proposal.cell, proposal.i)});
+        break;
+      case move_type::SIX_TWO:
+        choice = choose_candidate(
+            triangulation.number_of_vertices(),
+            [](std::intmax_t) { return true; },
+            [&triangulation](const std::intmax_t vertex) {
+              return triangulation.is_62_movable(
+                  static_cast<Combinatorial_vertex>(vertex));
+            },
+            draws);
+        if (choice < 0) return false;
+        proposal.vertex = static_cast<Combinatorial_vertex>(choice);
+        triangulation.incident_cells(proposal.vertex,
+                                     std::back_inserter(cells));
+        break;
+      case move_type::FOUR_FOUR:
+        return false;
+    }
+
+    // Every test reads the cells the move replaces and the stars of their
+    // vertices, so a move that changes none of them leaves it true
+    thread_local std::vector<Combinatorial_cell> read;
+    read.clear();
+    for (const auto& cell : cells) {
+      for (auto k = 0; k < 4; ++k) {
+        auto v = triangulation.vertex(cell, k);
+        if (v != Combinatorial_triangulation::infinite_vertex())
+          triangulation.incident_cells(v, std::back_inserter(read));
+      }
+    }
+    std::sort(read.begin(), read.end());
+    read.erase(std::unique(read.begin(), read.end()), read.end());
+    proposal.read_set.clear();
+    for (const auto& cell : read) {
+      proposal.read_set.emplace_back(cell, triangulation.version(cell));
+    }
+    return true;
+  }  // propose()
+
+  /// @param proposal A proposal
+  /// @return **True** if no cell the proposal read has changed since
+  bool is_current(const Proposal& proposal) const {
+    const auto& triangulation = *universe_.triangulation;
+    return std::all_of(proposal.read_set.begin(), proposal.read_set.end(),
+                       [&triangulation](const auto& read) {
+                         return triangulation.version(read.first) ==
+                                read.second;
+                       });
+  }  // is_current()
+
+  /// @brief Make a move whose proposal is current
+  /// @param proposal The proposal
+  void commit(const Proposal& proposal) {
+    CDT_TIME_PHASE(phase::MOVE);
+    auto& triangulation = *universe_.triangulation;
+    switch (proposal.move) {
+      case move_type::TWO_THREE:
+        triangulation.flip_23(proposal.cell, proposal.i);
+        break;
+      case move_type::THREE_TWO:
+        triangulation.flip_32(proposal.cell, proposal.i, proposal.j);
+        break;
+      case move_type::TWO_SIX:
+        triangulation.insert_in_facet(proposal.cell, proposal.i);
+        break;
+      case move_type::SIX_TWO:
+        triangulation.collapse_62(proposal.vertex);
+        break;
+      case move_type::FOUR_FOUR:
+        break;
+    }
+  }  // commit()
+
+  /// @brief The manifold
+  CombinatorialManifold universe_;
+
+  /// @brief Shared while proposing, exclusive while committing
+  mutable std::shared_mutex mutex_;
+
+  /// @brief Signalled when a seeded proposal finishes its turn
+  std::condition_variable_any turn_changed_;
+
+  /// @brief The seeded proposal whose turn it is to commit
+  std::intmax_t turn_{0};
+
+  /// @brief Moves committed so far
+  std::intmax_t commits_{0};
+
+  /// @brief Whether a worker of a seeded pass threw
+  bool failed_{false};
+
+  /// @brief The length of the timelike edges.
+  long double Alpha_;
+
+  /// @brief \f$K=\frac{1}{8\pi G_{N}}\f$.
+  long double K_;
+
+  /// @brief \f$\lambda=\frac{\Lambda}{8\pi G_{N}}\f$ where \f$\Lambda\f$ is
+  /// the cosmological constant.
+  long double Lambda_;
+
+  /// @brief Number of passes of ergodic moves on triangulation.
+  std::intmax_t passes_{100};
+
+  /// @brief Passes made by previous runs, which this run's passes follow.
+  std::intmax_t pass_offset_{0};
+
+  /// @brief How often to print/write output.
+  std::intmax_t checkpoint_{10};
+
+  /// @brief Number of tasks making moves
+  unsigned threads_{1};
+
+  /// @brief Attempted (2,3), (3,2), (2,6), (6,2), and (4,4) moves.
+  std::array<std::atomic_intmax_t, 5> attempted_moves_{};
+
+  /// @brief Successful (2,3), (3,2), (2,6), (6,2), and (4,4) moves.
+  std::array<std::atomic_intmax_t, 5> successful_moves_{};
+
+  /// @brief Proposals retried after a conflicting commit
+  std::atomic_intmax_t conflicts_{0};
+
+  /// @brief \f$a_1\f$ of each move type for the current pass
+  std::array<double, 5> a1_{};
+
+  /// @brief The seed of each proposal's random numbers, if any
+  std::optional<std::uint64_t> seed_{};
+
+  /// @brief Trajectory to record checkpoints to, if any; not owned.
+  Trajectory_writer* trajectory_{nullptr};
+
+  /// @brief Pipeline to publish snapshots to, if any; not owned.
+  Measurement_pipeline* pipeline_{nullptr};
+
+  /// @brief Publish a snapshot every n passes.
+  std::intmax_t cadence_{1};
+};  // Optimistic_metropolis
+
+#endif  // SRC_OPTIMISTICMETROPOLIS_H_
@@ -11,8 +11,14 @@
 /// \done Complete function documentation
 /// \done (2,6) move
 /// \done Multi-threaded operations using Intel TBB
+/// \done Record the vertices whose stars each move changes
+/// \done Compile-time move dispatch with make_ergodic_move()
+/// \done Draw (2,3) moves from an index of flippable facets
+/// \done Draw (3,2) moves from an index of degree 3 timelike edges
 /// \todo Handle neighboring_31_index != 5 condition
-/// \todo Debug (6,2) move
+/// \done (6,2) move as a combinatorial collapse
+/// \done Record each move, and undo the last one with undo_move()
+/// \done Update the geometry from the record with update_geometry()
 /// \todo (4,4) move
 
 /// @file S3ErgodicMoves.h
@@ -34,10 +40,89 @@
 // C++ headers
 // #include <random>
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
 #include <tuple>
 #include <utility>
 #include <vector>
 
+/// @brief Vertices touched by the last move made on this thread
+///
+/// Every cell created by a move is incident to one of these vertices, so
+/// checking their stars checks the move. See MoveManager.
+///
+/// @tparam Vertex The Vertex_handle type of the triangulation moved
+/// @return A reference to the thread-local vector of touched vertices
+template <typename Vertex = Vertex_handle>
+auto& last_move_vertices() {
+  thread_local std::vector<Vertex> vertices;
+  return vertices;
+}
+
+/// @struct
+/// @brief What a move changed, so that it can be followed or undone
+///
+/// A move records the cells, edges, and vertices it removed, whose handles
+/// serve only as keys once they are gone, and the cells it created. The
+/// **vertices** are those its inverse is made on: the new edge of a (2,3)
+/// move, the old edge and its ring of a (3,2) move, the new vertex of a
+/// (2,6) move, or the ring of a (6,2) move, whose vertex was at **point**.
+///
+/// @tparam Vertex The Vertex_handle type
+/// @tparam Cell The Cell_handle type
+/// @tparam Point The Point type
+template <typename Vertex, typename Cell, typename Point>
+struct Move_record {
+  /// @brief The move made, or none if the triangulation is unchanged
+  std::optional<move_type> move;
+
+  /// @brief The vertices the inverse move is made on
+  std::vector<Vertex> vertices;
+
+  /// @brief The point of the vertex removed by a (6,2) move
+  Point point;
+
+  /// @brief Cells the move removed
+  std::vector<Cell> removed_cells;
+
+  /// @brief Cells the move created
+  std::vector<Cell> created_cells;
+
+  /// @brief Edges the move removed, as pairs of vertices
+  std::vector<std::pair<Vertex, Vertex>> removed_edges;
+
+  /// @brief Vertices the move removed
+  std::vector<Vertex> removed_vertices;
+
+  /// @brief Forget the move, keeping the storage for the next one
+  void clear() noexcept {
+    move.reset();
+    vertices.clear();
+    removed_cells.clear();
+    created_cells.clear();
+    removed_edges.clear();
+    removed_vertices.clear();
+  }
+
+  /// @return A reference to the thread-local record of this type
+  static Move_record& last() {
+    thread_local Move_record record;
+    return record;
+  }
+};
+
+/// @brief The last move made on this thread on a manifold of type T
+/// @tparam T The manifold type
+/// @return A reference to the thread-local Move_record
+template <typename T>
+auto& last_move_record() {
+  return Move_record<Manifold_vertex_handle<T>, Manifold_cell_handle<T>,
+                     Manifold_point<T>>::last();
+}
+
 /// @brief Try a (2,3) move
 ///
 /// This function performs the (2,3) move by converting the facet
@@ -51,12 +136,15 @@ template <typename T>
 auto try_23_move(T&& universe, Cell_handle to_be_moved) {
   auto flipped = false;
   for (auto i = 0; i < 4; ++i) {
+    // The new timelike edge joins the vertices opposite facet i
+    auto top    = to_be_moved->vertex(i);
+    auto bottom = universe.triangulation->mirror_vertex(to_be_moved, i);
     if (universe.triangulation->flip(to_be_moved, i)) {
 #ifndef NDEBUG
       std::cout << "Facet " << i << " was flippable." << std::endl;
 #endif
-
-      flipped = true;
+      last_move_vertices() = {top, bottom};
+      flipped              = true;
       break;
     } else {
 #ifndef NDEBUG
@@ -67,12 +155,391 @@ auto try_23_move(T&& universe, Cell_handle to_be_moved) {
   return flipped;
 }  // try_23_move()
 
+/// @brief Whether a (2,3) move can be made on a facet
+///
+/// The facet opposite vertex i of a (2,2) cell is flippable if the edge
+/// joining vertex i to its mirror vertex would be timelike and the union
+/// of the two cells is convex, which are the orientation tests
+/// Triangulation_3::flip() makes. Cells made by a move aren't classified
+/// yet, so the cell type is found from its timevalues. Like the
+/// combinatorial and toroidal versions, it also checks that the edge
+/// doesn't exist yet, since a (6,2) collapse places cells without reading
+/// points, and the orientation tests alone can't rule out a duplicate edge.
+///
+/// @tparam T The manifold type
+/// @param universe A SimplicialManifold
+/// @param cell The cell
+/// @param i The index of the vertex opposite the facet
+/// @return **True** if flipping the facet is a (2,3) move
+template <typename T>
+bool is_23_flippable(const T& universe, const Cell_handle& cell,
+                     const int i) {
+  const auto& triangulation = *universe.triangulation;
+  auto        neighbor      = cell->neighbor(i);
+  if (triangulation.is_infinite(cell) || triangulation.is_infinite(neighbor))
+    return false;
+
+  std::array<std::intmax_t, 4> times{
+      {cell->vertex(0)->info(), cell->vertex(1)->info(),
+       cell->vertex(2)->info(), cell->vertex(3)->info()}};
+  auto bounds = std::minmax_element(times.begin(), times.end());
+  if (*bounds.second - *bounds.first != 1 ||
+      std::count(times.begin(), times.end(), *bounds.first) != 2)
+    return false;
+
+  auto top    = cell->vertex(i);
+  auto bottom = neighbor->vertex(neighbor->index(cell));
+  if (top == bottom || top->info() == bottom->info()) return false;
+
+  Cell_handle edge_cell;
+  int         top_index{0};
+  int         bottom_index{0};
+  if (triangulation.tds().is_edge(top, bottom, edge_cell, top_index,
+                                  bottom_index))
+    return false;
+
+  auto orientation = triangulation.geom_traits().orientation_3_object();
+  for (auto k = 0; k < 3; ++k) {
+    auto first  = cell->vertex(Delaunay::vertex_triple_index(i, k));
+    auto second = cell->vertex(Delaunay::vertex_triple_index(i, (k + 1) % 3));
+    if (orientation(top->point(), first->point(), second->point(),
+                    bottom->point()) != CGAL::POSITIVE)
+      return false;
+  }
+  return true;
+}  // is_23_flippable()
+
+/// @brief How often the flip indexes were built from scratch on this thread
+///
+/// Each index is built once and kept current by every move after that, so
+/// these only grow when a manifold is copied, compacted, or created.
+///
+/// @return A reference to the builds of flippable_23_facets() and of
+/// flippable_32_edges(), in that order
+inline auto& flip_index_builds() {
+  thread_local std::array<std::uintmax_t, 2> builds{};
+  return builds;
+}
+
+/// @brief The (2,3)-flippable facets of a manifold
+///
+/// Builds the index from the (2,2) cells on first use.
+///
+/// @tparam T The manifold type
+/// @param universe A SimplicialManifold
+/// @return A reference to universe.flippable_facets
+template <typename T>
+auto& flippable_23_facets(T& universe) {
+  if (!universe.flippable_facets) {
+    universe.flippable_facets.emplace();
+    ++flip_index_builds()[0];
+    for (const auto& cell : universe.geometry->two_two) {
+      for (auto i = 0; i < 4; ++i) {
+        if (is_23_flippable(universe, cell, i))
+          universe.flippable_facets->insert(cell, i);
+      }
+    }
+  }
+  return *universe.flippable_facets;
+}  // flippable_23_facets()
+
+/// @brief Update the flippable facets after a move
+///
+/// Facets of the removed cells are erased. Every cell a move creates
+/// contains one of last_move_vertices(), as does one of the two cells
+/// of any facet whose new edge it created or removed, so re-checking the
+/// facets of their stars, from both sides, finds every facet that became
+/// flippable or stopped being so.
+///
+/// @tparam T The manifold type
+/// @tparam Cells A container of Cell_handles
+/// @param universe A SimplicialManifold
+/// @param removed The cells the move removed, which may no longer exist
+template <typename T, typename Cells>
+void update_flippable_facets(T& universe, const Cells& removed) {
+  if (!universe.flippable_facets) return;
+  auto& facets = *universe.flippable_facets;
+  for (const auto& cell : removed) facets.erase(cell);
+
+  using Cell = Manifold_cell_handle<T>;
+  auto refresh = [&universe, &facets](const Cell& cell, const int i) {
+    if (is_23_flippable(universe, cell, i)) {
+      facets.insert(cell, i);
+    } else {
+      facets.erase(cell, i);
+    }
+  };
+
+  const auto&                    tds = universe.triangulation->tds();
+  thread_local std::vector<Cell> star;
+  for (const auto& vertex : last_move_vertices<Manifold_vertex_handle<T>>()) {
+    star.clear();
+    tds.incident_cells(vertex, std::back_inserter(star));
+    for (const auto& cell : star) {
+      for (auto i = 0; i < 4; ++i) {
+        refresh(cell, i);
+        auto neighbor = cell->neighbor(i);
+        refresh(neighbor, neighbor->index(cell));
+      }
+    }
+  }
+}  // update_flippable_facets()
+
+/// @brief Whether a (3,2) move can be made on an edge of degree 3
+///
+/// The edge must be timelike, and its ring of vertices must span both
+/// timeslices so that neither new cell lies on a single timeslice. The
+/// three cells around the edge form a bipyramid over the ring, which can
+/// be split into two cells only if it is convex, that is, if the edge
+/// crosses the interior of the ring's triangle, and only if the ring isn't
+/// already a facet.
+///
+/// @tparam T The manifold type
+/// @param universe A SimplicialManifold
+/// @param first One vertex of the edge
+/// @param second The other vertex of the edge
+/// @param ring The vertices of the three cells around the edge not on it
+/// @return **True** if flipping the edge is a (3,2) move
+template <typename T>
+bool is_32_flippable(const T& universe, const Vertex_handle& first,
+                     const Vertex_handle&                 second,
+                     const std::array<Vertex_handle, 3>& ring) {
+  const auto& triangulation = *universe.triangulation;
+  if (triangulation.is_infinite(first) || triangulation.is_infinite(second))
+    return false;
+  for (const auto& vertex : ring) {
+    if (triangulation.is_infinite(vertex)) return false;
+  }
+  if (first->info() == second->info()) return false;
+  if (ring[0]->info() == ring[1]->info() && ring[0]->info() == ring[2]->info())
+    return false;
+
+  Cell_handle facet_cell;
+  int         i{0};
+  int         j{0};
+  int         k{0};
+  if (triangulation.tds().is_facet(ring[0], ring[1], ring[2], facet_cell, i,
+                                   j, k))
+    return false;
+
+  auto        orientation = triangulation.geom_traits().orientation_3_object();
+  const auto& p           = first->point();
+  const auto& q           = second->point();
+  const auto& r0          = ring[0]->point();
+  const auto& r1          = ring[1]->point();
+  const auto& r2          = ring[2]->point();
+  auto        above       = orientation(r0, r1, r2, p);
+  auto        below       = orientation(r0, r1, r2, q);
+  if (above == CGAL::ZERO || below == CGAL::ZERO || above == below)
+    return false;
+  auto side = orientation(p, q, r0, r1);
+  return side != CGAL::ZERO && orientation(p, q, r1, r2) == side &&
+         orientation(p, q, r2, r0) == side;
+}  // is_32_flippable()
+
+/// @brief Recount the cells around an edge and re-check it
+///
+/// Records the degree of the edge given by **cell**, **i**, and **j**, and
+/// adds it to or removes it from the set of (3,2)-flippable edges.
+///
+/// @tparam T The manifold type
+/// @tparam Edges The Edge_index type
+/// @tparam Cell The Cell_handle type
+/// @param universe A SimplicialManifold
+/// @param edges The edge index of **universe**
+/// @param cell A cell containing the edge
+/// @param i The index in **cell** of one vertex of the edge
+/// @param j The index in **cell** of the other vertex of the edge
+template <typename T, typename Edges, typename Cell>
+void refresh_32_edge(const T& universe, Edges& edges, const Cell& cell,
+                     const int i, const int j) {
+  using Vertex = Manifold_vertex_handle<T>;
+  auto                  first  = cell->vertex(i);
+  auto                  second = cell->vertex(j);
+  std::array<Vertex, 3> ring;
+  std::size_t           ring_size{0};
+  auto                  degree{0};
+
+  auto circulator = universe.triangulation->tds().incident_cells(cell, i, j);
+  auto done       = circulator;
+  do {
+    Cell around = circulator;
+    if (++degree > 3) continue;
+    for (auto k = 0; k < 4; ++k) {
+      auto vertex = around->vertex(k);
+      if (vertex == first || vertex == second) continue;
+      auto last = ring.begin() + ring_size;
+      if (std::find(ring.begin(), last, vertex) == last && ring_size < 3)
+        ring[ring_size++] = vertex;
+    }
+  } while (++circulator != done);
+
+  edges.set_degree(first, second, degree);
+  if (degree == 3 && ring_size == 3 &&
+      is_32_flippable(universe, first, second, ring)) {
+    edges.insert(first, second);
+  } else {
+    edges.erase(first, second);
+  }
+}  // refresh_32_edge()
+
+/// @brief The (3,2)-flippable edges of a manifold
+///
+/// Counts the cells around every edge on first use.
+///
+/// @tparam T The manifold type
+/// @param universe A SimplicialManifold
+/// @return A reference to universe.flippable_edges
+template <typename T>
+auto& flippable_32_edges(T& universe) {
+  if (!universe.flippable_edges) {
+    universe.flippable_edges.emplace();
+    ++flip_index_builds()[1];
+    const auto& tds = universe.triangulation->tds();
+    for (auto eit = tds.edges_begin(); eit != tds.edges_end(); ++eit) {
+      refresh_32_edge(universe, *universe.flippable_edges, eit->first,
+                      eit->second, eit->third);
+    }
+  }
+  return *universe.flippable_edges;
+}  // flippable_32_edges()
+
+/// @brief Update the edge degrees and flippable edges after a move
+///
+/// Edges the move removed are forgotten. Every other edge whose star
+/// changed is an edge of a cell the move created, so recounting the edges
+/// of the stars of last_move_vertices() keeps every degree current.
+///
+/// @tparam T The manifold type
+/// @param universe A SimplicialManifold
+/// @param vanished The edges the move removed, as pairs of vertices
+template <typename T>
+void update_flippable_edges(
+    T& universe, const std::vector<std::pair<Manifold_vertex_handle<T>,
+                                             Manifold_vertex_handle<T>>>&
+                     vanished = {}) {
+  if (!universe.flippable_edges) return;
+  auto& edges = *universe.flippable_edges;
+  for (const auto& edge : vanished) edges.forget(edge.first, edge.second);
+
+  const auto& tds = universe.triangulation->tds();
+  thread_local std::vector<Manifold_cell_handle<T>> star;
+  edges.begin_pass();
+  for (const auto& vertex : last_move_vertices<Manifold_vertex_handle<T>>()) {
+    star.clear();
+    tds.incident_cells(vertex, std::back_inserter(star));
+    for (const auto& cell : star) {
+      for (auto i = 0; i < 3; ++i) {
+        for (auto j = i + 1; j < 4; ++j) {
+          if (edges.visit(cell->vertex(i), cell->vertex(j)))
+            refresh_32_edge(universe, edges, cell, i, j);
+        }
+      }
+    }
+  }
+}  // update_flippable_edges()
+
+/// @brief Flip a facet into an edge
+///
+/// The (2,3) move, and the inverse of a (3,2) move, with its bookkeeping:
+/// last_move_vertices(), last_move_record(), and the flip indexes.
+///
+/// @tparam T The manifold type
+/// @param universe A SimplicialManifold
+/// @param cell A cell
+/// @param i The index of the vertex opposite a facet for which
+/// is_23_flippable() is true
+template <typename T>
+void flip_23(T& universe, const Manifold_cell_handle<T> cell, const int i) {
+  auto& tds      = universe.triangulation->tds();
+  auto  neighbor = cell->neighbor(i);
+  auto& record   = last_move_record<T>();
+  record.clear();
+  record.removed_cells.assign({cell, neighbor});
+
+  // The new timelike edge joins the vertices opposite the facet
+  auto top    = cell->vertex(i);
+  auto bottom = neighbor->vertex(neighbor->index(cell));
+  tds.flip_flippable(cell, i);
+  record.move     = move_type::TWO_THREE;
+  record.vertices = {top, bottom};
+
+  // The new cells are the three around the new edge
+  Manifold_cell_handle<T> edge_cell;
+  int                     top_index{0};
+  int                     bottom_index{0};
+  tds.is_edge(top, bottom, edge_cell, top_index, bottom_index);
+  auto circulator = tds.incident_cells(edge_cell, top_index, bottom_index);
+  auto done       = circulator;
+  do {
+    record.created_cells.emplace_back(circulator);
+  } while (++circulator != done);
+
+  last_move_vertices<decltype(top)>() = {top, bottom};
+  update_flippable_facets(universe, record.removed_cells);
+  update_flippable_edges(universe);
+}  // flip_23()
+
+/// @brief Flip an edge of degree 3 into a facet
+///
+/// The (3,2) move, and the inverse of a (2,3) move, with its bookkeeping:
+/// last_move_vertices(), last_move_record(), and the flip indexes.
+///
+/// @tparam T The manifold type
+/// @param universe A SimplicialManifold
+/// @param first One vertex of an edge for which is_32_flippable() is true
+/// @param second The other vertex of the edge
+template <typename T>
+void flip_32(T& universe, const Manifold_vertex_handle<T> first,
+             const Manifold_vertex_handle<T> second) {
+  auto&                   tds = universe.triangulation->tds();
+  Manifold_cell_handle<T> cell;
+  int                     i{0};
+  int                     j{0};
+  if (!tds.is_edge(first, second, cell, i, j))
+    throw std::runtime_error("flip_32() was given an edge that is gone!");
+
+  // The cells around the edge, which the flip removes, and their ring
+  auto& record = last_move_record<T>();
+  record.clear();
+  record.vertices = {first, second};
+  auto circulator = tds.incident_cells(cell, i, j);
+  auto done       = circulator;
+  do {
+    Manifold_cell_handle<T> around = circulator;
+    record.removed_cells.emplace_back(around);
+    for (auto k = 0; k < 4; ++k) {
+      auto vertex = around->vertex(k);
+      if (std::find(record.vertices.begin(), record.vertices.end(), vertex) ==
+          record.vertices.end())
+        record.vertices.emplace_back(vertex);
+    }
+  } while (++circulator != done);
+
+  // The two new cells have the old edge's vertices as apexes, and share
+  // the ring
+  tds.flip_flippable(cell, i, j);
+  record.move = move_type::THREE_TWO;
+  Manifold_cell_handle<T> made;
+  int                     r0{0};
+  int                     r1{0};
+  int                     r2{0};
+  tds.is_facet(record.vertices[2], record.vertices[3], record.vertices[4],
+               made, r0, r1, r2);
+  record.created_cells = {made, made->neighbor(6 - r0 - r1 - r2)};
+  record.removed_edges = {{first, second}};
+
+  last_move_vertices<Manifold_vertex_handle<T>>() = {first, second};
+  update_flippable_facets(universe, record.removed_cells);
+  update_flippable_edges(universe, record.removed_edges);
+}  // flip_32()
+
 /// @brief Make a (2,3) move
 ///
 /// A (2,3) moves adds a (2,2) simplex and a timelike edge.
 ///
-/// This function calls **try_23_move()** until it succeeds; the
-/// triangulation is no longer Delaunay.
+/// This function draws a facet from flippable_23_facets() and flips it,
+/// so every attempt succeeds; the triangulation is no longer Delaunay.
 ///
 /// @tparam T1 The manifold type
 /// @tparam T2 The type of the tuple holding attempted moves
@@ -84,19 +551,19 @@ auto make_23_move(T1&& universe, T2&& attempted_moves) -> decltype(universe) {
 #ifndef NDEBUG
   std::cout << __PRETTY_FUNCTION__ << " called." << std::endl;
 #endif
+  CDT_TIME_PHASE(phase::MOVE);
+  auto& facets = flippable_23_facets(universe);
+  if (facets.empty())
+    throw std::runtime_error("make_23_move() found no flippable facet!");
 
-  auto not_flipped = true;
-  while (not_flipped) {
-    // Pick out a random (2,2) which ranges from 0 to size()-1
-    auto choice =
-        generate_random_signed(0, universe.geometry->two_two.size() - 1);
-
-    Cell_handle to_be_moved = universe.geometry->two_two[choice];
-    if (try_23_move(universe, to_be_moved)) not_flipped = false;
+  // Pick out a random flippable facet which ranges from 0 to size()-1
+  auto choice = generate_random_signed(
+      0, static_cast<std::intmax_t>(facets.size()) - 1);
+  flip_23(universe, facets[choice].first, facets[choice].second);
 
-    // Increment the (2,3) move counter
-    ++attempted_moves[0];
-  }
+  // Increment the (2,3) move counter
+  ++attempted_moves[0];
+  CDT_RECORD_RETRIES(move_type::TWO_THREE, 1);
   // Uses return value optimization and allows chaining function calls
   return std::move(universe);
 }  // make_23_move()
@@ -113,10 +580,14 @@ auto make_23_move(T1&& universe, T2&& attempted_moves) -> decltype(universe) {
 template <typename T>
 auto try_32_move(T&& universe, Edge_handle to_be_moved) {
   auto flipped = false;
+  // The two new cells have the old edge's vertices as apexes
+  auto first  = std::get<0>(to_be_moved)->vertex(std::get<1>(to_be_moved));
+  auto second = std::get<0>(to_be_moved)->vertex(std::get<2>(to_be_moved));
   if (universe.triangulation->flip(std::get<0>(to_be_moved),
                                    std::get<1>(to_be_moved),
                                    std::get<2>(to_be_moved))) {
-    flipped = true;
+    last_move_vertices() = {first, second};
+    flipped              = true;
   }
   return flipped;
 }  // try_32_move()
@@ -125,8 +596,8 @@ auto try_32_move(T&& universe, Edge_handle to_be_moved) {
 ///
 /// A (3,2) move removes a (2,2) simplex and a timelike edge.
 ///
-/// This function calls **try_32_move()** until it succeeds; the
-/// triangulation is no longer Delaunay.
+/// This function draws an edge from flippable_32_edges() and flips it,
+/// so every attempt succeeds; the triangulation is no longer Delaunay.
 ///
 /// @tparam T1 The manifold type
 /// @tparam T2 The type of the tuple holding attempted moves
@@ -138,27 +609,19 @@ auto make_32_move(T1&& universe, T2&& attempted_moves) -> decltype(universe) {
 #ifndef NDEBUG
   std::cout << "Attempting (3,2) move." << std::endl;
 #endif
+  CDT_TIME_PHASE(phase::MOVE);
+  auto& edges = flippable_32_edges(universe);
+  if (edges.empty())
+    throw std::runtime_error("make_32_move() found no flippable edge!");
 
-  auto not_flipped = true;
-  while (not_flipped) {
-    // Pick a random timelike edge out of the timelike_edges vector
-    // which ranges from 0 to size()-1
-    auto choice = generate_random_signed(0, universe.geometry->N1_TL() - 1);
-    Edge_handle to_be_moved = universe.geometry->timelike_edges[choice];
+  // Pick out a random flippable edge which ranges from 0 to size()-1
+  auto choice =
+      generate_random_signed(0, static_cast<std::intmax_t>(edges.size()) - 1);
+  flip_32(universe, edges[choice].first, edges[choice].second);
 
-    if (try_32_move(universe, to_be_moved)) {
-#ifndef NDEBUG
-      std::cout << "Edge " << choice << " was flippable." << std::endl;
-#endif
-      not_flipped = false;
-    } else {
-#ifndef NDEBUG
-      std::cout << "Edge " << choice << " was not flippable." << std::endl;
-#endif
-    }
-    // Increment the (3,2) move counter
-    ++attempted_moves[1];
-  }
+  // Increment the (3,2) move counter
+  ++attempted_moves[1];
+  CDT_RECORD_RETRIES(move_type::THREE_TWO, 1);
   // Uses return value optimization and allows chaining function calls
   return std::move(universe);
 }  // make_32_move()
@@ -171,10 +634,12 @@ auto make_32_move(T1&& universe, T2&& attempted_moves) -> decltype(universe) {
 /// the timelike foliation. This condition can be relaxed in the more
 /// general case.
 ///
+/// @tparam Cell The Cell_handle type
 /// @param c The presumed (1,3) cell
 /// @param i The i-th neighbor of c
 /// @return **True** if c is a (1,3) cell and it's i-th neighbor is a (3,1)
-inline auto is_26_movable(const Cell_handle& c, unsigned i) {
+template <typename Cell>
+auto is_26_movable(const Cell& c, unsigned i) {
   // Source cell should be a 13
   auto source_is_13 = (c->info() == 13);
   // Neighbor should be a 31
@@ -188,10 +653,12 @@ inline auto is_26_movable(const Cell_handle& c, unsigned i) {
 /// a (1,3) simplex, it checks all neighbors to see if there is a (3,1).
 /// If so, the index **n** of that neighbor is passed via an out parameter.
 ///
+/// @tparam Cell The Cell_handle type
 /// @param c The (1,3) simplex that is checked
 /// @param n The integer value of the neighboring (3,1) simplex
 /// @return **True** if the (2,6) move is possible
-inline auto find_26_movable(const Cell_handle& c, unsigned* n) {
+template <typename Cell>
+auto find_26_movable(const Cell& c, unsigned* n) {
   auto movable = false;
   for (unsigned i = 0; i < 4; ++i) {
 #ifndef NDEBUG
@@ -207,6 +674,42 @@ inline auto find_26_movable(const Cell_handle& c, unsigned* n) {
   return movable;
 }  // find_26_movable()
 
+/// @brief Insert a vertex in the spacelike facet of a (1,3) cell
+///
+/// The (2,6) move, and the inverse of a (6,2) move, with its bookkeeping:
+/// last_move_vertices(), last_move_record(), and the flip indexes. The new
+/// vertex is at **point**, on the timeslice of the facet.
+///
+/// @tparam T The manifold type
+/// @param universe A SimplicialManifold
+/// @param cell A (1,3) cell
+/// @param i The index of the vertex opposite a facet for which
+/// is_26_movable() is true
+/// @param point The point of the new vertex
+/// @return The new vertex
+template <typename T>
+auto insert_26_vertex(T& universe, const Manifold_cell_handle<T> cell,
+                      const int i, const Manifold_point<T>& point) {
+  auto& tds       = universe.triangulation->tds();
+  auto  timeslice = cell->vertex((i + 1) & 3)->info();
+  auto& record    = last_move_record<T>();
+  record.clear();
+  record.removed_cells.assign({cell, cell->neighbor(i)});
+
+  auto center = tds.insert_in_facet(cell, i);
+  center->set_point(point);
+  center->info() = timeslice;
+  record.move    = move_type::TWO_SIX;
+  record.vertices.assign({center});
+  tds.incident_cells(center, std::back_inserter(record.created_cells));
+
+  // Every new cell contains the new vertex
+  last_move_vertices<decltype(center)>() = {center};
+  update_flippable_facets(universe, record.removed_cells);
+  update_flippable_edges(universe);
+  return center;
+}  // insert_26_vertex()
+
 /// @brief Make a (2,6) move
 ///
 /// A (2,6) move adds 2 (1,3) simplices and 2 (3,1) simplices for a
@@ -221,9 +724,8 @@ inline auto find_26_movable(const Cell_handle& c, unsigned* n) {
 ///
 /// After some other values are gathered for debugging purposes,
 /// the **v_center** vertex is inserted into the facet delineated by
-/// **neighboring_31_index** using **tds().insert_in_facet()**.
-/// Finally, the centroid of the common face calculated using
-/// **CGAL::centroid()** and assigned to **v_center**, along with a
+/// **neighboring_31_index** using insert_26_vertex(), at the centroid of
+/// the common face calculated using **CGAL::centroid()**, and with a
 /// timevalue taken from one of the vertices of the common face.
 ///
 /// @image html 26.png
@@ -240,14 +742,16 @@ auto make_26_move(T1&& universe, T2&& attempted_moves) -> decltype(universe) {
 #ifndef NDEBUG
   std::cout << "Attempting (2,6) move." << std::endl;
 #endif
+  CDT_TIME_PHASE(phase::MOVE);
+  auto attempts_before = attempted_moves[2];
 
   auto not_moved = true;
   while (not_moved) {
     // Pick out a random (1,3) from simplex_types
     auto choice = generate_random_signed(0, universe.geometry->N3_13() - 1);
 
-    unsigned    neighboring_31_index{5};
-    Cell_handle bottom = universe.geometry->one_three[choice];
+    unsigned neighboring_31_index{5};
+    auto     bottom = universe.geometry->one_three[choice];
 
     //    CGAL_triangulation_expensive_precondition(is_cell(bottom));
     if (!universe.triangulation->tds().is_cell(bottom))
@@ -265,7 +769,7 @@ auto make_26_move(T1&& universe, T2&& attempted_moves) -> decltype(universe) {
               << std::endl;
 #endif
 
-    Cell_handle top = bottom->neighbor(neighboring_31_index);
+    auto top = bottom->neighbor(neighboring_31_index);
 
     // Check has_neighbor() returns the index of the common face
     int common_face_index{5};
@@ -303,9 +807,9 @@ auto make_26_move(T1&& universe, T2&& attempted_moves) -> decltype(universe) {
 
     // Get vertices of the common face
     // They're denoted wrt the bottom, but could easily be wrt to top
-    Vertex_handle v1 = bottom->vertex(i1);
-    Vertex_handle v2 = bottom->vertex(i2);
-    Vertex_handle v3 = bottom->vertex(i3);
+    auto v1 = bottom->vertex(i1);
+    auto v2 = bottom->vertex(i2);
+    auto v3 = bottom->vertex(i3);
 
     // Timeslices of v1, v2, and v3 should be same
     //    CGAL_triangulation_precondition(v1->info() == v2->info());
@@ -318,7 +822,7 @@ auto make_26_move(T1&& universe, T2&& attempted_moves) -> decltype(universe) {
     int in1 = top->index(bottom->vertex(i1));
     // int in2 = top->index(bottom->vertex(i2));
     // int in3 = top->index(bottom->vertex(i3));
-    Vertex_handle v5 = top->vertex(in1);
+    auto v5 = top->vertex(in1);
     (v1 == v5)
         ? std::cout << "bottom->vertex(i1) == top->vertex(in1)" << std::endl
         : std::cout << "bottom->vertex(i1) != top->vertex(in1)" << std::endl;
@@ -334,32 +838,16 @@ auto make_26_move(T1&& universe, T2&& attempted_moves) -> decltype(universe) {
 #endif
 
       // Do the (2,6) move
-      // Insert new vertex
-      Vertex_handle v_center = universe.triangulation->tds().insert_in_facet(
-          bottom, neighboring_31_index);
-
-#ifndef NDEBUG
-      // Find the center of the facet
       // A vertex is a topological object which may be associated with a
-      // point, which is a geometrical object.
+      // point, which is a geometrical object. The flip indexes test
+      // orientations of these points, so every build needs it.
       auto center_point = CGAL::centroid(v1->point(), v2->point(), v3->point());
-      std::cout << "Center point is: " << center_point << std::endl;
-      v_center->set_point(center_point);
-#endif
-
-      // Assign a timeslice to the new vertex
-      auto timeslice   = v1->info();
-      v_center->info() = timeslice;
+      auto v_center     = insert_26_vertex(
+          universe, bottom, static_cast<int>(neighboring_31_index),
+          center_point);
 
 #ifndef NDEBUG
-      // Check we have a vertex
-      if (universe.triangulation->tds().is_vertex(v_center)) {
-        std::cout << "It's a vertex in the TDS." << std::endl;
-      } else {
-        std::cout << "It's not a vertex in the TDS." << std::endl;
-      }
-
-      std::cout << "Spacelike face timeslice is " << timeslice << std::endl;
+      std::cout << "Spacelike face timeslice is " << v1->info() << std::endl;
       std::cout << "Inserted vertex " << v_center->point() << " with timeslice "
                 << v_center->info() << std::endl;
 #endif
@@ -376,26 +864,206 @@ auto make_26_move(T1&& universe, T2&& attempted_moves) -> decltype(universe) {
     // Increment the (2,6) move counter
     ++attempted_moves[2];
   }
+  CDT_RECORD_RETRIES(move_type::TWO_SIX,
+                     attempted_moves[2] - attempts_before);
   return std::move(universe);
 }  // make_26_move()
 
+/// @brief Collapse a vertex with 3 (3,1) and 3 (1,3) cells around it
+///
+/// The (6,2) move done on the triangulation data structure alone, in
+/// constant time and without reading any point. The link of **center**
+/// has two apexes, one on each neighboring timeslice, and a ring of three
+/// vertices on its own timeslice. The six cells around **center** are
+/// replaced by the two cells joining the ring to each apex, keeping the
+/// orientation and outside neighbors of the cells they replace.
+///
+/// @tparam T The triangulation data structure type
+/// @param tds The triangulation data structure
+/// @param center A vertex for which find_62_movable() is true
+/// @return **True** if the vertex was removed; **false** leaves **tds**
+/// unchanged
+template <typename T>
+bool collapse_62(T& tds, const typename T::Vertex_handle center) {
+  using Vertex = typename T::Vertex_handle;
+  using Cell   = typename T::Cell_handle;
+
+  thread_local std::vector<Cell> star;
+  star.clear();
+  tds.incident_cells(center, std::back_inserter(star));
+  if (star.size() != 6) return false;
+
+  // Link vertices, and the number of cells around center containing each
+  thread_local std::vector<std::pair<Vertex, int>> link;
+  link.clear();
+  for (const auto& cell : star) {
+    for (auto i = 0; i < 4; ++i) {
+      auto vertex = cell->vertex(i);
+      if (vertex == center) continue;
+      auto found = std::find_if(link.begin(), link.end(), [&](const auto& v) {
+        return v.first == vertex;
+      });
+      if (found == link.end()) {
+        link.emplace_back(vertex, 1);
+      } else {
+        ++found->second;
+      }
+    }
+  }
+  if (link.size() != 5) return false;
+
+  // Apexes are in 3 cells, ring vertices in 4
+  thread_local std::vector<Vertex> apexes;
+  thread_local std::vector<Vertex> ring;
+  apexes.clear();
+  ring.clear();
+  for (const auto& vertex : link) {
+    if (vertex.second == 3) {
+      apexes.emplace_back(vertex.first);
+    } else if (vertex.second == 4) {
+      ring.emplace_back(vertex.first);
+    }
+  }
+  if (apexes.size() != 2 || ring.size() != 3) return false;
+
+  // The new cells would share a facet that already exists
+  Cell existing;
+  int  i0{0};
+  int  i1{0};
+  int  i2{0};
+  if (tds.is_facet(ring[0], ring[1], ring[2], existing, i0, i1, i2))
+    return false;
+
+  // Star cell containing three given vertices besides center
+  auto star_cell = [&](const Vertex& a, const Vertex& b, const Vertex& c) {
+    return *std::find_if(star.begin(), star.end(), [&](const Cell& cell) {
+      return cell->has_vertex(a) && cell->has_vertex(b) && cell->has_vertex(c);
+    });
+  };
+
+  std::array<Cell, 2> new_cells;
+  for (std::size_t n = 0; n < 2; ++n) {
+    const auto& apex = apexes[n];
+    // Take any star cell of this apex, and put the ring vertex it lacks
+    // where center was
+    auto template_cell = *std::find_if(
+        star.begin(), star.end(),
+        [&apex](const Cell& cell) { return cell->has_vertex(apex); });
+    auto missing =
+        *std::find_if(ring.begin(), ring.end(), [&](const Vertex& vertex) {
+          return !template_cell->has_vertex(vertex);
+        });
+    std::array<Vertex, 4> vertices;
+    for (auto i = 0; i < 4; ++i) {
+      auto vertex = template_cell->vertex(i);
+      vertices[i] = (vertex == center) ? missing : vertex;
+    }
+    auto cell = tds.create_cell(vertices[0], vertices[1], vertices[2],
+                                vertices[3]);
+
+    // Each facet but the one opposite the apex was the outer facet of a
+    // star cell, opposite center
+    for (auto i = 0; i < 4; ++i) {
+      if (vertices[i] == apex) continue;
+      std::array<Vertex, 3> facet;
+      auto                  k = 0;
+      for (auto j = 0; j < 4; ++j) {
+        if (j != i) facet[k++] = vertices[j];
+      }
+      auto old_cell  = star_cell(facet[0], facet[1], facet[2]);
+      auto old_index = old_cell->index(center);
+      auto outside   = old_cell->neighbor(old_index);
+      auto mirror    = tds.mirror_index(old_cell, old_index);
+      cell->set_neighbor(i, outside);
+      outside->set_neighbor(mirror, cell);
+    }
+    new_cells[n] = cell;
+  }
+  new_cells[0]->set_neighbor(new_cells[0]->index(apexes[0]), new_cells[1]);
+  new_cells[1]->set_neighbor(new_cells[1]->index(apexes[1]), new_cells[0]);
+
+  // Every vertex of the link is left on a new cell, which remove_62_vertex()
+  // relies on to find them
+  for (const auto& vertex : ring) vertex->set_cell(new_cells[0]);
+  apexes[0]->set_cell(new_cells[0]);
+  apexes[1]->set_cell(new_cells[1]);
+
+  tds.delete_cells(star.begin(), star.end());
+  tds.delete_vertex(center);
+  return true;
+}  // collapse_62()
+
+/// @brief Remove the vertex of a (6,2) move
+///
+/// The six cells around the vertex are collapsed into two with
+/// collapse_62(), the inverse of the insert_in_facet() of a (2,6) move,
+/// rather than retriangulating the hole left by removing it. This is the
+/// (6,2) move, and the inverse of a (2,6) move, with its bookkeeping:
+/// last_move_vertices(), last_move_record(), and the flip indexes.
+///
+/// @tparam T The manifold type
+/// @param universe A SimplicialManifold
+/// @param to_be_moved A vertex for which find_62_movable() is true
+/// @return **True** if the vertex was removed
+template <typename T>
+bool remove_62_vertex(T&& universe, Manifold_vertex_handle<T> to_be_moved) {
+  auto& tds    = universe.triangulation->tds();
+  auto& record = last_move_record<T>();
+  record.clear();
+  tds.incident_cells(to_be_moved, std::back_inserter(record.removed_cells));
+
+  // The new cells are made of the removed vertex's neighbors
+  auto& touched = last_move_vertices<decltype(to_be_moved)>();
+  touched.clear();
+  tds.adjacent_vertices(to_be_moved, std::back_inserter(touched));
+  auto point = to_be_moved->point();
+  if (!collapse_62(tds, to_be_moved)) {
+    record.clear();
+    touched.clear();
+    return false;
+  }
+  record.move  = move_type::SIX_TWO;
+  record.point = point;
+  record.removed_vertices.assign({to_be_moved});
+  for (const auto& vertex : touched)
+    record.removed_edges.emplace_back(to_be_moved, vertex);
+
+  // collapse_62() leaves each vertex of the link on a new cell, and the two
+  // new cells share the ring
+  for (const auto& vertex : touched) {
+    if (std::find(record.created_cells.begin(), record.created_cells.end(),
+                  vertex->cell()) == record.created_cells.end())
+      record.created_cells.emplace_back(vertex->cell());
+  }
+  auto shared = record.created_cells[0]->index(record.created_cells[1]);
+  for (auto i = 1; i < 4; ++i)
+    record.vertices.emplace_back(
+        record.created_cells[0]->vertex((shared + i) & 3));
+
+  update_flippable_facets(universe, record.removed_cells);
+  update_flippable_edges(universe, record.removed_edges);
+  return true;
+}  // remove_62_vertex()
+
 /// @brief Find a (6,2) move
 /// @tparam T The manifold type
 /// @param universe A SimplicialManifold
 /// @param candidate A vertex to test
 /// @return True if a (6,2) move can be made on the candidate vertex
 template <typename T>
-auto find_62_movable(T&& universe, Vertex_handle candidate) {
-  std::vector<Cell_handle> candidate_cells;
+auto find_62_movable(T&& universe, Manifold_vertex_handle<T> candidate) {
+  // Reuse storage across calls so steady-state sweeps don't allocate
+  thread_local std::vector<Manifold_cell_handle<T>> candidate_cells;
+  candidate_cells.clear();
   // Adjacent (3,1), (2,2), and (1,3) cells
   auto adjacent_cell = std::make_tuple(0, 0, 0);
-  universe.triangulation->incident_cells(candidate,
-                                         back_inserter(candidate_cells));
+  universe.triangulation->tds().incident_cells(
+      candidate, back_inserter(candidate_cells));
   // We must have 6 cells around the vertex to be able to make a (6,2) move
   if (candidate_cells.size() != 6) return false;
 
   for (const auto& cit : candidate_cells) {
-    CGAL_triangulation_precondition(universe.triangulation->is_cell(cit));
+    CGAL_triangulation_precondition(universe.triangulation->tds().is_cell(cit));
     if (cit->info() == 31) {
       ++std::get<0>(adjacent_cell);
     } else if (cit->info() == 22) {
@@ -433,28 +1101,36 @@ auto find_62_movable(T&& universe, Vertex_handle candidate) {
 /// @return The SimplicialManifold after the move has been made
 template <typename T1, typename T2>
 auto make_62_move(T1&& universe, T2&& attempted_moves) -> decltype(universe) {
-  std::vector<Vertex_handle> tds_vertices      = universe.geometry->vertices;
-  auto                       not_moved         = true;
-  intmax_t                   tds_vertices_size = tds_vertices.size();
+  CDT_TIME_PHASE(phase::MOVE);
+  auto attempts_before = attempted_moves[3];
+  // Candidates not yet tried, in storage reused across calls
+  thread_local std::vector<Manifold_vertex_handle<T1>> tds_vertices;
+  tds_vertices.assign(universe.geometry->vertices.begin(),
+                      universe.geometry->vertices.end());
+  auto     not_moved         = true;
+  intmax_t tds_vertices_size = tds_vertices.size();
   while ((not_moved) && (tds_vertices_size > 0)) {
-    auto          choice = generate_random_signed(0, tds_vertices_size - 1);
-    Vertex_handle to_be_moved = tds_vertices[choice];
+    auto choice      = generate_random_signed(0, tds_vertices_size - 1);
+    auto to_be_moved = tds_vertices[choice];
     // Ensure pre-conditions are satisfied
     CGAL_triangulation_precondition(universe.triangulation->dimension() == 3);
     CGAL_triangulation_expensive_precondition(is_vertex(to_be_moved));
     if (find_62_movable(universe, to_be_moved)) {
-      universe.triangulation->remove(to_be_moved);
-      not_moved = false;
+      not_moved = !remove_62_vertex(universe, to_be_moved);
     }
-    tds_vertices.erase(tds_vertices.begin() + choice);  // O(|V|) bottleneck
+    // Order of the remaining candidates doesn't matter, so swap and pop
+    tds_vertices[choice] = tds_vertices.back();
+    tds_vertices.pop_back();
     tds_vertices_size--;
     // Increment the (6,2) move counter
     ++attempted_moves[3];
   }
 
-  if (tds_vertices_size == 0) {
+  if (not_moved) {
     throw std::domain_error("No (6,2) move is possible.");
   }
+  CDT_RECORD_RETRIES(move_type::SIX_TWO,
+                     attempted_moves[3] - attempts_before);
   return std::move(universe);
 }  // make_62_move()
 
@@ -493,4 +1169,104 @@ auto make_44_move(T1&& universe, T2&& attempted_moves) -> decltype(universe) {
   return std::move(universe);
 }  // make_44_move()
 
+/// @brief Undo the last move made on a manifold
+///
+/// Makes the inverse of the move in last_move_record(), which then records
+/// the inverse in turn. The triangulation is restored up to its cell
+/// handles, and the handle of the vertex a (6,2) move removed.
+///
+/// @tparam T The manifold type
+/// @param universe The SimplicialManifold last moved
+template <typename T>
+void undo_move(T& universe) {
+  // The inverse move overwrites the record
+  auto record = last_move_record<T>();
+  if (!record.move) return;
+
+  auto&                   tds      = universe.triangulation->tds();
+  const auto&             vertices = record.vertices;
+  Manifold_cell_handle<T> cell;
+  int                     i{0};
+  int                     j{0};
+  int                     k{0};
+  switch (*record.move) {
+    case move_type::TWO_THREE:
+      flip_32(universe, vertices[0], vertices[1]);
+      break;
+    case move_type::THREE_TWO:
+      // The ring, seen from the new cell with the first vertex as apex
+      if (!tds.is_facet(vertices[2], vertices[3], vertices[4], cell, i, j, k))
+        throw std::runtime_error("undo_move() lost the ring of a (3,2) move!");
+      if (!cell->has_vertex(vertices[0])) cell = cell->neighbor(6 - i - j - k);
+      flip_23(universe, cell, cell->index(vertices[0]));
+      break;
+    case move_type::TWO_SIX:
+      if (!remove_62_vertex(universe, vertices[0]))
+        throw std::runtime_error("undo_move() couldn't undo a (2,6) move!");
+      break;
+    case move_type::SIX_TWO:
+      if (!tds.is_facet(vertices[0], vertices[1], vertices[2], cell, i, j, k))
+        throw std::runtime_error("undo_move() lost the ring of a (6,2) move!");
+      insert_26_vertex(universe, cell, 6 - i - j - k, record.point);
+      break;
+    case move_type::FOUR_FOUR:
+      break;
+  }
+}  // undo_move()
+
+/// @brief Prepare the geometry of a manifold to follow moves
+///
+/// Indexes where the geometry holds each cell, edge, and vertex, once and
+/// before the first move, while its handles are current.
+///
+/// @tparam T The manifold type
+/// @param universe A SimplicialManifold
+template <typename T>
+void index_geometry(T& universe) {
+  universe.geometry->index();
+}  // index_geometry()
+
+/// @brief Make the geometry of a manifold follow its last move
+///
+/// Uses last_move_record() and cell_type() to update the cells, edges,
+/// and vertices in time proportional to what the move changed, rather than
+/// reclassifying the whole triangulation.
+///
+/// @tparam T The manifold type
+/// @param universe The SimplicialManifold last moved
+template <typename T>
+void update_geometry(T& universe) {
+  CDT_TIME_PHASE(phase::CLASSIFICATION);
+  universe.geometry->update(
+      last_move_record<T>(),
+      [&universe](const auto& cell) { return cell_type(universe, cell); });
+}  // update_geometry()
+
+/// @brief Make a move chosen at compile time, in place
+///
+/// Each make_XX_move() already works through a reference to the manifold,
+/// so passing it as an rvalue here neither copies nor moves it; the
+/// returned reference is simply discarded. As with make_XX_move(), the
+/// geometry is not reclassified.
+///
+/// @tparam M The move_type
+/// @tparam T1 The manifold type
+/// @tparam T2 The type of the tuple holding attempted moves
+/// @param universe A SimplicialManifold, modified in place
+/// @param attempted_moves A tuple holding a count of the attempted moves
+template <move_type M, typename T1, typename T2>
+void make_ergodic_move(T1& universe, T2& attempted_moves) {
+  if constexpr (M == move_type::TWO_THREE) {
+    make_23_move(std::move(universe), attempted_moves);
+  } else if constexpr (M == move_type::THREE_TWO) {
+    make_32_move(std::move(universe), attempted_moves);
+  } else if constexpr (M == move_type::TWO_SIX) {
+    make_26_move(std::move(universe), attempted_moves);
+  } else if constexpr (M == move_type::SIX_TWO) {
+    make_62_move(std::move(universe), attempted_moves);
+  } else {
+    make_44_move(std::move(universe), attempted_moves);
+  }
+}  // make_ergodic_move()
+
 #endif  // SRC_S3ERGODICMOVES_H_
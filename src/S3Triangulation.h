@@ -62,16 +62,25 @@
 #include <CGAL/Triangulation_vertex_base_with_info_3.h>
 #include <CGAL/point_generators_3.h>
 
+#ifdef CGAL_LINKED_WITH_TBB
+#include <tbb/task_arena.h>
+#endif
+
 // C++ headers
 #include <algorithm>
+#include <limits>
 #include <memory>
 #include <set>
 #include <stdexcept>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 // CDT headers
+#include "Instrumentation.h"
+#include "ThreadPool.h"
+#include "Trace.h"
 #include "Utilities.h"
 
 using K             = CGAL::Exact_predicates_inexact_constructions_kernel;
@@ -81,6 +90,9 @@ using Vb = CGAL::Triangulation_vertex_base_with_info_3<std::intmax_t, K>;
 using Cb = CGAL::Triangulation_cell_base_with_info_3<std::intmax_t, K>;
 
 // Parallel operations
+// Cells and vertices live in CGAL's Compact_container (the concurrent one
+// with per-thread free lists under Parallel_tag), which already pools
+// them: creating a cell after removing one reuses its slot.
 #ifdef CGAL_LINKED_WITH_TBB
 using Tds = CGAL::Triangulation_data_structure_3<Vb, Cb, CGAL::Parallel_tag>;
 #else
@@ -91,13 +103,41 @@ using Cell_handle   = Delaunay::Cell_handle;
 using Vertex_handle = Delaunay::Vertex_handle;
 using Locate_type   = Delaunay::Locate_type;
 using Point         = Delaunay::Point;
-using Edge_handle   = std::tuple<Cell_handle, std::intmax_t, std::intmax_t>;
+/// An edge as a cell and the indices of its two vertices in that cell
+template <typename Cell>
+using Basic_edge_handle = std::tuple<Cell, std::intmax_t, std::intmax_t>;
+using Edge_handle       = Basic_edge_handle<Cell_handle>;
 using Causal_vertices =
     std::pair<std::vector<Point>, std::vector<std::intmax_t>>;
-using Geometry_tuple =
-    std::tuple<std::vector<Cell_handle>, std::vector<Cell_handle>,
-               std::vector<Cell_handle>, std::vector<Edge_handle>,
-               std::vector<Edge_handle>, std::vector<Vertex_handle>>;
+/// (3,1), (2,2), and (1,3) cells, timelike and spacelike edges, and
+/// vertices of a triangulation of type Triangulation
+template <typename Triangulation>
+using Basic_geometry_tuple =
+    std::tuple<std::vector<typename Triangulation::Cell_handle>,
+               std::vector<typename Triangulation::Cell_handle>,
+               std::vector<typename Triangulation::Cell_handle>,
+               std::vector<Basic_edge_handle<
+                   typename Triangulation::Cell_handle>>,
+               std::vector<Basic_edge_handle<
+                   typename Triangulation::Cell_handle>>,
+               std::vector<typename Triangulation::Vertex_handle>>;
+using Geometry_tuple = Basic_geometry_tuple<Delaunay>;
+
+/// Cell_handle of the triangulation of manifold type T
+template <typename T>
+using Manifold_cell_handle = typename std::decay_t<
+    decltype(*std::declval<T&>().triangulation)>::Cell_handle;
+
+/// Vertex_handle of the triangulation of manifold type T
+template <typename T>
+using Manifold_vertex_handle = typename std::decay_t<
+    decltype(*std::declval<T&>().triangulation)>::Vertex_handle;
+
+/// Point of the triangulation of manifold type T
+template <typename T>
+using Manifold_point = typename std::decay_t<
+    decltype(*std::declval<T&>().triangulation)>::Point;
+
 using Move_tracker = std::array<intmax_t, 5>;
 
 enum class move_type {
@@ -245,6 +285,7 @@ auto classify_all_simplices(T&& universe_ptr) {
 #ifndef NDEBUG
   std::cout << "Classifying all simplices...." << std::endl;
 #endif
+  CDT_TIME_PHASE(phase::CLASSIFICATION);
 
   auto                       cells = classify_simplices(universe_ptr);
   auto                       edges = classify_edges(universe_ptr);
@@ -363,6 +404,7 @@ void fix_triangulation(T&& universe_ptr) {
 #ifndef NDEBUG
     std::cout << "Fix Pass #" << (pass + 1) << std::endl;
 #endif
+    Trace_span span("Fix pass", "generation", pass + 1);
     if (fix_timeslices(universe_ptr)) break;
   }
   if (!fix_timeslices(universe_ptr))
@@ -389,6 +431,8 @@ void insert_into_triangulation(T1&& universe_ptr, T2&& causal_vertices) {
 ///
 /// The radius is used to denote the time value, so we can nest 2-spheres
 /// such that our time foliation contains leaves of identical topology.
+/// Each sphere is generated by a task on the shared Thread_pool, with its
+/// own CGAL::Random seeded by generate_random_signed().
 ///
 /// @param[in] simplices  The number of desired simplices in the triangulation
 /// @param[in] timeslices The number of timeslices in the triangulation
@@ -400,17 +444,28 @@ auto inline make_foliated_sphere(const std::intmax_t simplices,
   const auto points_per_timeslice =
       expected_points_per_simplex(DIMENSION, simplices, timeslices);
   CGAL_triangulation_precondition(points_per_timeslice >= 4);
+  const auto      points = static_cast<std::size_t>(points_per_timeslice);
   Causal_vertices causal_vertices;
+  causal_vertices.first.resize(points * timeslices);
+  causal_vertices.second.resize(points * timeslices);
+
+  // Seed the spheres in order, so a Random_scope makes them reproducible
+  std::vector<unsigned> seeds(timeslices);
+  for (auto& seed : seeds) {
+    seed = static_cast<unsigned>(
+        generate_random_signed(0, std::numeric_limits<unsigned>::max()));
+  }
 
-  for (std::intmax_t i = 0; i < timeslices; ++i) {
-    auto radius = 1.0 + static_cast<double>(i);
-    CGAL::Random_points_on_sphere_3<Point> gen{radius};
+  Thread_pool::instance().parallel_for(0, timeslices, [&](const std::size_t i) {
+    auto         radius = 1.0 + static_cast<double>(i);
+    CGAL::Random random{seeds[i]};
+    CGAL::Random_points_on_sphere_3<Point> gen{radius, random};
     // At each radius, generate a sphere of random points
-    for (std::intmax_t j = 0; j < points_per_timeslice; ++j) {
-      causal_vertices.first.push_back(*gen++);
-      causal_vertices.second.emplace_back(radius);
+    for (auto j = i * points; j < (i + 1) * points; ++j) {
+      causal_vertices.first[j]  = *gen++;
+      causal_vertices.second[j] = static_cast<std::intmax_t>(radius);
     }  // end j
-  }    // end i
+  });
   return causal_vertices;
 }  // make_foliated_sphere()
 
@@ -435,6 +490,7 @@ auto inline make_foliated_sphere(const std::intmax_t simplices,
 auto inline make_triangulation(const std::intmax_t simplices,
                                const std::intmax_t timeslices) {
   std::cout << "Generating universe ... " << std::endl;
+  Trace_span span("make_triangulation", "generation");
 
 #ifdef CGAL_LINKED_WITH_TBB
   // Construct the locking data-structure
@@ -451,7 +507,17 @@ auto inline make_triangulation(const std::intmax_t simplices,
 
   auto universe_ptr    = std::make_unique<decltype(universe)>(universe);
   auto causal_vertices = make_foliated_sphere(simplices, timeslices);
-  insert_into_triangulation(universe_ptr, causal_vertices);
+  {
+    Trace_span insertion("Insert vertices", "generation");
+#ifdef CGAL_LINKED_WITH_TBB
+    // Insert with no more TBB threads than the Thread_pool has workers
+    tbb::task_arena arena(static_cast<int>(Thread_pool::instance().size()));
+    arena.execute(
+        [&] { insert_into_triangulation(universe_ptr, causal_vertices); });
+#else
+    insert_into_triangulation(universe_ptr, causal_vertices);
+#endif
+  }
   fix_triangulation(universe_ptr);
   return universe_ptr;
 }  // make_triangulation()
@@ -9,15 +9,23 @@
 /// @author Adam Getchell
 
 /// \todo: Devise a way to copy the boost::optional data in move/copy ctors
+/// \done Copies classify their own triangulation
+/// \done Geometry follows each move in time proportional to what it changed
+/// \done Moves take the geometry along instead of reclassifying
 
 #ifndef SRC_SIMPLICIALMANIFOLD_H_
 #define SRC_SIMPLICIALMANIFOLD_H_
 
+#include "FlipIndex.h"
+#include "Foliation.h"
 #include "S3Triangulation.h"
 #include <boost/optional.hpp>
+#include <algorithm>
+#include <array>
 #include <map>
 #include <memory>
 #include <set>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -27,15 +35,26 @@ using Facet = Delaunay::Facet;
 /// @brief A struct containing detailed geometry information
 ///
 /// GeometryInfo contains information about the geometry of
-/// a triangulation. In addition, it defines convenient functions to
+/// a triangulation. Basic_geometry_info holds the same information for
+/// any triangulation type, such as the periodic triangulations of
+/// T3Triangulation.h. In addition, it defines convenient functions to
 /// retrieve commonly used values. This is to save the expense of
 /// calculating manually from the triangulation. GeometryInfo() is
-/// recalculated using the move assignment operator anytime a
-/// SimplicialManifold() is move constructed.
+/// recalculated using the move assignment operator by reclassify(), and
+/// otherwise follows each move with update(); a moved SimplicialManifold()
+/// takes its GeometryInfo() along.
 /// The default constructor, destructor, move constructor, copy
 /// constructor, and copy assignment operator are explicitly defaulted.
 /// See http://en.cppreference.com/w/cpp/language/rule_of_three
-struct GeometryInfo {
+///
+/// @tparam Triangulation The triangulation type
+template <typename Triangulation>
+struct Basic_geometry_info {
+  using Cell_handle   = typename Triangulation::Cell_handle;
+  using Vertex_handle = typename Triangulation::Vertex_handle;
+  using Facet         = typename Triangulation::Facet;
+  using Edge_handle   = Basic_edge_handle<Cell_handle>;
+
   /// @brief (3,1) cells in the foliation
   std::vector<Cell_handle> three_one;
 
@@ -64,7 +83,7 @@ struct GeometryInfo {
 
   /// @brief Default constructor
   /// @return A GeometryInfo{}
-  GeometryInfo() = default;
+  Basic_geometry_info() = default;
 
   /// @brief Constructor from Geometry_tuple
   ///
@@ -72,7 +91,8 @@ struct GeometryInfo {
   /// which itself takes a std::unique_ptr<Delaunay>
   /// @param geometry Geometry_tuple initializing values
   /// @return A populated GeometryInfo{}
-  explicit GeometryInfo(const Geometry_tuple&& geometry)  // NOLINT
+  explicit Basic_geometry_info(  // NOLINT
+      const Basic_geometry_tuple<Triangulation>&& geometry)
       : three_one{std::get<0>(geometry)}
       , two_two{std::get<1>(geometry)}
       , one_three{std::get<2>(geometry)}
@@ -81,18 +101,18 @@ struct GeometryInfo {
       , vertices{std::get<5>(geometry)} {}
 
   /// @brief Default destructor
-  ~GeometryInfo() = default;
+  ~Basic_geometry_info() = default;
 
   /// @brief Default move constructor
   /// @return A GeometryInfo{}
-  GeometryInfo(GeometryInfo&&) = default;
+  Basic_geometry_info(Basic_geometry_info&&) = default;
 
   /// @brief Move assignment operator
   /// @param other The moved-from Geometry_tuple, usually generated by
-  /// classify_all_simplices() which is in turn called by the
-  /// SimplicialManifold move assignment operator.
+  /// classify_all_simplices() which is in turn called by reclassify().
   /// @return A moved GeometryInfo{}
-  GeometryInfo& operator=(Geometry_tuple&& other) {  // NOLINT
+  Basic_geometry_info& operator=(  // NOLINT
+      Basic_geometry_tuple<Triangulation>&& other) {
 #ifndef NDEBUG
     std::cout << "GeometryInfo move assignment operator." << std::endl;
 #endif
@@ -102,16 +122,23 @@ struct GeometryInfo {
     timelike_edges  = std::move(std::get<3>(other));
     spacelike_edges = std::move(std::get<4>(other));
     vertices        = std::move(std::get<5>(other));
+    // Indexed again by the next update()
+    indexed_ = false;
+    cell_positions_.clear();
+    edge_positions_.clear();
+    edge_keys_[0].clear();
+    edge_keys_[1].clear();
+    vertex_positions_.clear();
     return *this;
   }
 
   /// @brief Default copy constructor
   /// @return A copied GeometryInfo{}
-  GeometryInfo(const GeometryInfo&) = default;
+  Basic_geometry_info(const Basic_geometry_info&) = default;
 
   /// @brief Default copy assignment operator
   /// @return A copy-assigned GeometryInfo{}
-  GeometryInfo& operator=(const GeometryInfo&) = default;
+  Basic_geometry_info& operator=(const Basic_geometry_info&) = default;
 
   /// @brief Timelike edges
   /// @return The number of edges spanning timeslices
@@ -169,20 +196,218 @@ struct GeometryInfo {
   /// @brief Number of vertices
   /// @return The number of vertices in the triangulation
   auto N0() {return static_cast<std::intmax_t>(vertices.size());}
+
+  /// @brief Index where each cell, edge, and vertex is held
+  ///
+  /// Done once, while the handles held are current, which is before the
+  /// first move that update() follows.
+  void index() {
+    if (indexed_) return;
+    for (std::size_t k = 0; k < 3; ++k) {
+      const auto& cells = cells_of(k);
+      for (std::size_t n = 0; n < cells.size(); ++n)
+        cell_positions_[address(cells[n])] = {k, n};
+    }
+    for (std::size_t k = 0; k < 2; ++k) {
+      const auto& edges = edges_of(k);
+      edge_keys_[k].clear();
+      for (std::size_t n = 0; n < edges.size(); ++n) {
+        edge_keys_[k].emplace_back(key_of(edges[n]));
+        edge_positions_[edge_keys_[k].back()] = {k, n};
+      }
+    }
+    for (std::size_t n = 0; n < vertices.size(); ++n)
+      vertex_positions_[address(vertices[n])] = n;
+    indexed_ = true;
+  }
+
+  /// @brief Follow a move, in time proportional to the cells it changed
+  ///
+  /// What the move removed is erased by moving the last entry of its
+  /// vector into its place, so the vectors keep no order. Created cells
+  /// are classified by **cell_type**, which is written to info() as
+  /// classify_all_simplices() does. Each edge of a created cell is added,
+  /// or pointed at that cell in case the cell holding it is gone, and each
+  /// new vertex is added.
+  ///
+  /// @tparam Record The Move_record type
+  /// @tparam Type A callable giving the type of a cell, or 0 for a cell
+  /// the geometry doesn't hold
+  /// @param record What the move changed
+  /// @param cell_type Classifies a cell
+  template <typename Record, typename Type>
+  void update(const Record& record, Type&& cell_type) {
+    index();
+    for (const auto& cell : record.removed_cells) erase_cell(cell);
+    for (const auto& edge : record.removed_edges)
+      erase_edge(edge_key(edge.first, edge.second));
+    for (const auto& vertex : record.removed_vertices) erase_vertex(vertex);
+
+    for (const auto& cell : record.created_cells) {
+      auto type = cell_type(cell);
+      if (type == 0) continue;
+      auto k                         = Foliation<DIMENSION>::type_index(type);
+      cell->info()                   = type;
+      cell_positions_[address(cell)] = {k, cells_of(k).size()};
+      cells_of(k).emplace_back(cell);
+
+      for (auto i = 0; i < 3; ++i) {
+        for (auto j = i + 1; j < 4; ++j) add_edge(cell, i, j);
+      }
+      for (auto i = 0; i < 4; ++i) {
+        auto vertex = cell->vertex(i);
+        if (vertex_positions_.emplace(address(vertex), vertices.size()).second)
+          vertices.emplace_back(vertex);
+      }
+    }
+  }
+
+ private:
+  /// @param handle A handle
+  /// @return The address of what **handle** refers to, without reading it
+  template <typename Handle>
+  static const void* address(const Handle& handle) {
+    return std::addressof(*handle);
+  }
+
+  /// @param edge An edge
+  /// @return The key of **edge**
+  static Address_pair key_of(const Edge_handle& edge) {
+    const auto& cell = std::get<0>(edge);
+    return edge_key(cell->vertex(static_cast<int>(std::get<1>(edge))),
+                    cell->vertex(static_cast<int>(std::get<2>(edge))));
+  }
+
+  /// @param k A position in Foliation<DIMENSION>::SIMPLEX_TYPES
+  /// @return The cells of that type
+  std::vector<Cell_handle>& cells_of(const std::size_t k) {
+    return k == 0 ? three_one : (k == 1 ? two_two : one_three);
+  }
+
+  /// @param k 0 for timelike edges, 1 for spacelike
+  /// @return Those edges
+  std::vector<Edge_handle>& edges_of(const std::size_t k) {
+    return k == 0 ? timelike_edges : spacelike_edges;
+  }
+
+  /// @brief Erase a cell, which may have been deleted
+  /// @param cell The cell
+  void erase_cell(const Cell_handle& cell) {
+    auto found = cell_positions_.find(address(cell));
+    if (found == cell_positions_.end()) return;
+    auto  position = found->second;
+    auto& cells    = cells_of(position.first);
+    cell_positions_.erase(found);
+    if (position.second + 1 != cells.size()) {
+      cells[position.second]                 = cells.back();
+      cell_positions_[address(cells.back())] = position;
+    }
+    cells.pop_back();
+  }
+
+  /// @brief Erase an edge
+  /// @param key The key of the edge
+  void erase_edge(const Address_pair& key) {
+    auto found = edge_positions_.find(key);
+    if (found == edge_positions_.end()) return;
+    auto  position = found->second;
+    auto& edges    = edges_of(position.first);
+    auto& keys     = edge_keys_[position.first];
+    edge_positions_.erase(found);
+    if (position.second + 1 != edges.size()) {
+      edges[position.second]       = edges.back();
+      keys[position.second]        = keys.back();
+      edge_positions_[keys.back()] = position;
+    }
+    edges.pop_back();
+    keys.pop_back();
+  }
+
+  /// @brief Add an edge of a cell, or point it at the cell
+  /// @param cell The cell
+  /// @param i The index in **cell** of one vertex of the edge
+  /// @param j The index in **cell** of the other vertex of the edge
+  void add_edge(const Cell_handle& cell, const int i, const int j) {
+    auto        u   = cell->vertex(i);
+    auto        v   = cell->vertex(j);
+    auto        key = edge_key(u, v);
+    Edge_handle edge{cell, i, j};
+    auto        found = edge_positions_.find(key);
+    if (found != edge_positions_.end()) {
+      edges_of(found->second.first)[found->second.second] = edge;
+      return;
+    }
+    std::size_t k        = u->info() != v->info() ? 0 : 1;
+    edge_positions_[key] = {k, edges_of(k).size()};
+    edges_of(k).emplace_back(edge);
+    edge_keys_[k].emplace_back(key);
+  }
+
+  /// @brief Erase a vertex, which may have been deleted
+  /// @param vertex The vertex
+  void erase_vertex(const Vertex_handle& vertex) {
+    auto found = vertex_positions_.find(address(vertex));
+    if (found == vertex_positions_.end()) return;
+    auto position = found->second;
+    vertex_positions_.erase(found);
+    if (position + 1 != vertices.size()) {
+      vertices[position]                          = vertices.back();
+      vertex_positions_[address(vertices.back())] = position;
+    }
+    vertices.pop_back();
+  }
+
+  /// @brief Whether the positions below are indexed
+  bool indexed_{false};
+
+  /// @brief The vector holding each cell, by position in
+  /// Foliation<DIMENSION>::SIMPLEX_TYPES, and its position there
+  std::unordered_map<const void*, std::pair<std::size_t, std::size_t>>
+      cell_positions_;
+
+  /// @brief Whether each edge is timelike (0) or spacelike (1), and its
+  /// position in that vector
+  std::unordered_map<Address_pair, std::pair<std::size_t, std::size_t>,
+                     Address_pair_hash>
+      edge_positions_;
+
+  /// @brief The key of each timelike and spacelike edge, by position
+  std::array<std::vector<Address_pair>, 2> edge_keys_;
+
+  /// @brief The position of each vertex
+  std::unordered_map<const void*, std::size_t> vertex_positions_;
 };
 
+using GeometryInfo = Basic_geometry_info<Delaunay>;
+
 /// @struct
 /// @brief A struct to hold triangulation and geometry information
 ///
 /// SimplicialManifold contains information about the triangulation and
 /// its geometry. In addition, it defines convenient constructors.
 struct SimplicialManifold {
+  /// @brief Topology of the foliation
+  static constexpr topology_type TOPOLOGY = topology_type::SPHERICAL;
+
   /// @brief std::unique_ptr to the Delaunay triangulation
   std::unique_ptr<Delaunay> triangulation;
 
   /// @brief std::unique_ptr to GeometryInfo{}
   std::unique_ptr<GeometryInfo> geometry;
 
+  /// @brief Facets on which a (2,3) move can be made
+  ///
+  /// Built by make_23_move() on first use, and kept current by each move
+  /// after that.
+  boost::optional<Flip_index<Cell_handle>> flippable_facets;
+
+  /// @brief Incident cell counts of edges, and edges on which a (3,2) move
+  /// can be made
+  ///
+  /// Built by make_32_move() on first use, and kept current by each move
+  /// after that.
+  boost::optional<Edge_index<Vertex_handle>> flippable_edges;
+
   /// @brief Default constructor
   /// @return An empty SimplicialManifold{}
   SimplicialManifold()
@@ -229,36 +454,57 @@ struct SimplicialManifold {
   }
 
   /// @brief Move constructor
+  ///
+  /// Handles stay valid when the triangulation is moved, so the geometry
+  /// and indexes of **other** are taken along rather than recalculated.
+  ///
   /// @param other The SimplicialManifold to be move-constructed from
   /// @return A moved-to SimplicialManifold{}
   SimplicialManifold(SimplicialManifold&& other)  // NOLINT
       : triangulation{std::move(other.triangulation)}
-      , geometry{std::make_unique<GeometryInfo>(
-            classify_all_simplices(triangulation))} {
+      , geometry{std::move(other.geometry)}
+      , flippable_facets{std::move(other.flippable_facets)}
+      , flippable_edges{std::move(other.flippable_edges)} {
 #ifndef NDEBUG
     std::cout << "SimplicialManifold move ctor." << std::endl;
 #endif
   }
 
   /// @brief Move assignment operator
+  ///
+  /// Takes the geometry and indexes of **other** along with its
+  /// triangulation, as the move constructor does. Assigning a
+  /// SimplicialManifold to itself, as chained moves do, leaves it as it is.
+  ///
   /// @param other The SimplicialManifold to be moved from
   /// @return A moved-assigned SimplicialManifold{}
   SimplicialManifold& operator=(SimplicialManifold&& other) {  // NOLINT
 #ifndef NDEBUG
     std::cout << "SimplicialManifold move assignment operator." << std::endl;
 #endif
-    triangulation = std::move(other.triangulation);
-    geometry      = std::make_unique<GeometryInfo>(
-        classify_all_simplices(std::move(triangulation)));
+    if (this == &other) return *this;
+    triangulation    = std::move(other.triangulation);
+    geometry         = std::move(other.geometry);
+    flippable_facets = std::move(other.flippable_facets);
+    flippable_edges  = std::move(other.flippable_edges);
     return *this;
   }
 
   /// @brief SimplicialManifold copy constructor
+  ///
+  /// The geometry, **flippable_facets**, and **flippable_edges** of
+  /// **other** hold handles into its triangulation, so the copy classifies
+  /// its own, as a ToroidalManifold does, and rebuilds the indexes on first
+  /// use.
+  ///
   /// @param other The SimplicialManifold to copy
   /// @return A copied SimplicialManifold{}
   SimplicialManifold(const SimplicialManifold& other)
       : triangulation{std::make_unique<Delaunay>(*(other.triangulation))}
-      , geometry{std::make_unique<GeometryInfo>(*(other.geometry))} {
+      , geometry{std::make_unique<GeometryInfo>(
+            classify_all_simplices(triangulation))}
+      , flippable_facets{boost::none}
+      , flippable_edges{boost::none} {
 #ifndef NDEBUG
     std::cout << "SimplicialManifold copy ctor." << std::endl;
 #endif
@@ -274,6 +520,8 @@ struct SimplicialManifold {
     using std::swap;
     swap(first.triangulation, second.triangulation);
     swap(first.geometry, second.geometry);
+    swap(first.flippable_facets, second.flippable_facets);
+    swap(first.flippable_edges, second.flippable_edges);
   }
 
   /// @brief Default copy assignment operator
@@ -281,4 +529,42 @@ struct SimplicialManifold {
   SimplicialManifold& operator=(const SimplicialManifold&) = default;
 };
 
+/// @brief Reclassify a SimplicialManifold after its triangulation changed
+/// @param universe The SimplicialManifold
+inline void reclassify(SimplicialManifold& universe) {
+  universe.geometry = std::make_unique<GeometryInfo>(
+      classify_all_simplices(universe.triangulation));
+}  // reclassify()
+
+/// @brief Whether a cell of a SimplicialManifold is correctly foliated
+///
+/// Finite cells must span exactly one timeslice; cells with the vertex at
+/// infinity carry no foliation.
+///
+/// @param universe The SimplicialManifold
+/// @param cell A cell of its triangulation
+/// @return **True** if the cell is infinite or spans adjacent timeslices
+inline bool is_foliated(const SimplicialManifold& universe,
+                        const Cell_handle&        cell) {
+  if (universe.triangulation->is_infinite(cell)) return true;
+  return Foliation<DIMENSION>::classify(
+             std::array<std::intmax_t, Foliation<DIMENSION>::VERTICES>{
+                 {cell->vertex(0)->info(), cell->vertex(1)->info(),
+                  cell->vertex(2)->info(), cell->vertex(3)->info()}}) != 0;
+}  // is_foliated()
+
+/// @brief The type of a cell of a SimplicialManifold
+/// @param universe The SimplicialManifold
+/// @param cell A cell of its triangulation
+/// @return 31, 22, or 13, or 0 if the cell is infinite or doesn't span
+/// adjacent timeslices
+inline std::int8_t cell_type(const SimplicialManifold& universe,
+                             const Cell_handle&        cell) {
+  if (universe.triangulation->is_infinite(cell)) return 0;
+  return Foliation<DIMENSION>::classify(
+      std::array<std::intmax_t, Foliation<DIMENSION>::VERTICES>{
+          {cell->vertex(0)->info(), cell->vertex(1)->info(),
+           cell->vertex(2)->info(), cell->vertex(3)->info()}});
+}  // cell_type()
+
 #endif  // SRC_SIMPLICIALMANIFOLD_H_
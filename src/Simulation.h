@@ -4,10 +4,22 @@
 ///
 /// Simulation class methods. This is essentially the main loop of CDT.
 /// You push algorithms and other methods you want executed onto the
-/// Simulation{} using lambdas and Function_refs and the queue() method, and
-/// then call start().
+/// Simulation{} using lambdas and the queue() method, and then call start().
+///
+/// Stages receive the SimplicialManifold by reference and work on it in
+/// place, so running a queue never copies the triangulation. A stage that
+/// needs its own copy opts in with queue_snapshot(), which hands it a
+/// compact, read-only Snapshot instead.
+///
+/// Stages run one after another, so a measurement queued as a stage waits
+/// for the passes before it. To measure while the passes go on, have the
+/// Metropolis algorithm publish to a Measurement_pipeline instead.
 ///
 /// Inspired by http://cppcon.org/modernizing-your-c/
+///
+/// \done Stages take SimplicialManifold& instead of copies
+/// \done Opt-in Snapshot stages
+/// \done Queues for any manifold type
 
 /// @file  Simulation.h
 /// @brief Simulation class
@@ -16,34 +28,74 @@
 #ifndef SRC_SIMULATION_H_
 #define SRC_SIMULATION_H_
 
-#include "Function_ref.h"
 #include "SimplicialManifold.h"
+#include "Snapshot.h"
+#include "Trace.h"
+#include <functional>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 /// @struct
-/// @brief Simulation queue of various functions on SimplicialManifold.
-struct Simulation {
-  using element = function_ref<SimplicialManifold(SimplicialManifold)>;
+/// @brief Simulation queue of various functions on a manifold.
+/// @tparam Manifold The manifold type, such as SimplicialManifold
+template <typename Manifold>
+struct Basic_simulation {
+  /// Stages own their callables, so temporaries such as lambdas may be
+  /// queued directly
+  using element = std::function<void(Manifold&)>;
   std::vector<element> queue_;
 
-  /// @brief Queue of function objects.
+  /// @brief Queue a stage that works on the manifold in place
+  ///
+  /// The callable is invoked with a Manifold&. Its return value is
+  /// ignored, so it must not return a modified copy of the manifold.
+  ///
   /// @tparam T Function object type
   /// @param callable The function to be called
   template <typename T>
   void queue(T&& callable) {
+    static_assert(
+        !std::is_same<std::invoke_result_t<T&, Manifold&>, Manifold>::value,
+        "Stages work in place; a manifold returned by value would be "
+        "discarded.");
     queue_.emplace_back(std::forward<T>(callable));
   }
 
-  /// @brief Start running queued functions in Simulation
-  /// @param value The SimplicialManifold
-  /// @return The SimplicialManifold with item applied to it
-  SimplicialManifold start(SimplicialManifold value) const {
+  /// @brief Queue a stage that observes a Snapshot of the manifold
+  ///
+  /// The Snapshot is the only copy made, and only when this stage runs.
+  ///
+  /// @tparam T Function object type taking a const Snapshot&
+  /// @param callable The function to be called
+  template <typename T>
+  void queue_snapshot(T&& callable) {
+    queue_.emplace_back(
+        [callable = std::forward<T>(callable)](Manifold& universe) {
+          callable(make_snapshot(universe));
+        });
+  }
+
+  /// @brief Run queued functions on a manifold in place
+  /// @param universe The manifold
+  void run(Manifold& universe) const {
+    std::intmax_t stage{0};
     for (const auto& item : queue_) {
-      value = item(value);
+      Trace_span span("Simulation stage", "simulation", stage++);
+      item(universe);
     }
+  }
+
+  /// @brief Start running queued functions in Simulation
+  /// @param value The manifold, moved in by the caller
+  /// @return The manifold with each item applied to it
+  Manifold start(Manifold value) const {
+    run(value);
     return value;
   }
 };
 
+/// A Simulation on spherical (S3) manifolds
+using Simulation = Basic_simulation<SimplicialManifold>;
+
 #endif  // SRC_SIMULATION_H_
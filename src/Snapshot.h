@@ -0,0 +1,422 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Compact, read-only snapshots of a foliated triangulation for analysis.
+/// A Snapshot holds contiguous arrays instead of CGAL handles, so
+/// measurements can stream over it without chasing pointers, while
+/// the mutable Delaunay triangulation carries on.
+///
+/// \done Vertex timevalues and coordinates in structure-of-arrays form
+/// \done Cell-to-vertex and cell-to-neighbor indices, and cell types
+/// \done Timeslice-major, space-filling (Morton) renumbering
+/// \done Volume per timeslice on a Snapshot
+/// \done Rebuild (compact) a triangulation in Snapshot order
+
+/// @file Snapshot.h
+/// @brief Compact snapshot of a foliated triangulation
+/// @author Adam Getchell
+
+#ifndef SRC_SNAPSHOT_H_
+#define SRC_SNAPSHOT_H_
+
+// CGAL headers
+#include <CGAL/Unique_hash_map.h>
+
+// C++ headers
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// CDT headers
+#include "SimplicialManifold.h"
+
+/// Index type of vertices and cells in a Snapshot
+using Snapshot_index = std::int32_t;
+
+/// Index of the vertex at infinity in Snapshot::cell_vertices
+static constexpr Snapshot_index INFINITE_VERTEX = -1;
+
+/// @brief Spread the low 21 bits of a value so they occupy every third bit
+/// @param value The value to spread
+/// @return The spread bits
+inline auto spread_bits(std::uint64_t value) noexcept {
+  value &= 0x1fffff;
+  value = (value | value << 32) & 0x1f00000000ffff;
+  value = (value | value << 16) & 0x1f0000ff0000ff;
+  value = (value | value << 8) & 0x100f00f00f00f00f;
+  value = (value | value << 4) & 0x10c30c30c30c30c3;
+  value = (value | value << 2) & 0x1249249249249249;
+  return value;
+}  // spread_bits()
+
+/// @brief Morton (Z-order) code of a point on a 21-bit integer grid
+///
+/// Nearby points on the grid mostly have nearby codes, so sorting by Morton
+/// code lays out points along a space-filling curve.
+///
+/// @param x The x grid coordinate
+/// @param y The y grid coordinate
+/// @param z The z grid coordinate
+/// @return The 63-bit interleaved code
+inline auto morton_code(const std::uint32_t x, const std::uint32_t y,
+                        const std::uint32_t z) noexcept {
+  return spread_bits(x) | spread_bits(y) << 1 | spread_bits(z) << 2;
+}  // morton_code()
+
+/// @struct
+/// @brief A frozen, compact copy of a foliated triangulation
+///
+/// Vertices are renumbered timeslice-major, and within each timeslice in
+/// Morton order of their points. Finite cells come first, sorted by their
+/// lowest-numbered vertex so that cells sit near their vertices; infinite
+/// cells (those with the vertex at infinity) follow. Each cell stores 4
+/// vertex and 4 neighbor indices, where neighbor i is opposite vertex i as
+/// in CGAL.
+struct Snapshot {
+  /// @brief Timevalue of each finite vertex
+  std::vector<std::intmax_t> vertex_timevalues;
+
+  /// @brief x coordinate of each finite vertex
+  std::vector<double> x;
+
+  /// @brief y coordinate of each finite vertex
+  std::vector<double> y;
+
+  /// @brief z coordinate of each finite vertex
+  std::vector<double> z;
+
+  /// @brief Four vertex indices per cell, INFINITE_VERTEX for infinity
+  std::vector<Snapshot_index> cell_vertices;
+
+  /// @brief Four neighbor cell indices per cell
+  std::vector<Snapshot_index> cell_neighbors;
+
+  /// @brief Cell type (31, 22, 13) per cell, 0 for infinite cells
+  std::vector<std::int8_t> cell_types;
+
+  /// @brief Number of finite cells, which are stored first
+  Snapshot_index finite_cells{0};
+
+  /// @brief Number of finite vertices
+  auto number_of_vertices() const noexcept {
+    return static_cast<Snapshot_index>(vertex_timevalues.size());
+  }
+
+  /// @brief Number of cells, finite and infinite
+  auto number_of_cells() const noexcept {
+    return static_cast<Snapshot_index>(cell_types.size());
+  }
+
+  /// @brief Number of finite cells
+  auto number_of_finite_cells() const noexcept { return finite_cells; }
+
+  /// @brief Timevalue of vertex v
+  auto timevalue(const Snapshot_index v) const noexcept {
+    return vertex_timevalues[v];
+  }
+
+  /// @brief Point of vertex v
+  auto point(const Snapshot_index v) const { return Point(x[v], y[v], z[v]); }
+
+  /// @brief Type of cell c
+  auto cell_type(const Snapshot_index c) const noexcept {
+    return cell_types[c];
+  }
+
+  /// @brief Vertex i of cell c
+  auto vertex(const Snapshot_index c, const int i) const noexcept {
+    return cell_vertices[4 * c + i];
+  }
+
+  /// @brief Neighbor i of cell c, opposite vertex i
+  auto neighbor(const Snapshot_index c, const int i) const noexcept {
+    return cell_neighbors[4 * c + i];
+  }
+
+  /// @brief Whether cell c contains the vertex at infinity
+  auto is_infinite(const Snapshot_index c) const noexcept {
+    return c >= finite_cells;
+  }
+};
+
+/// @brief Order vertices timeslice-major, then along a Morton curve
+///
+/// @tparam Vertex The Vertex_handle type
+/// @param vertices The vertices to order
+/// @return A permutation of indices into **vertices**
+template <typename Vertex>
+auto space_filling_order(const std::vector<Vertex>& vertices) {
+  std::array<double, 3> lower{{std::numeric_limits<double>::max(),
+                               std::numeric_limits<double>::max(),
+                               std::numeric_limits<double>::max()}};
+  std::array<double, 3> upper{{std::numeric_limits<double>::lowest(),
+                               std::numeric_limits<double>::lowest(),
+                               std::numeric_limits<double>::lowest()}};
+  for (const auto& v : vertices) {
+    for (auto d = 0; d < 3; ++d) {
+      lower[d] = std::min(lower[d], v->point()[d]);
+      upper[d] = std::max(upper[d], v->point()[d]);
+    }
+  }
+
+  // Quantize each coordinate onto a 21-bit grid spanning the bounding box
+  constexpr auto             grid = static_cast<double>(0x1fffff);
+  std::vector<std::uint64_t> codes(vertices.size());
+  for (std::size_t j = 0; j < vertices.size(); ++j) {
+    std::array<std::uint32_t, 3> cell{};
+    for (auto d = 0; d < 3; ++d) {
+      auto extent = upper[d] - lower[d];
+      if (extent > 0) {
+        cell[d] = static_cast<std::uint32_t>(
+            grid * (vertices[j]->point()[d] - lower[d]) / extent);
+      }
+    }
+    codes[j] = morton_code(cell[0], cell[1], cell[2]);
+  }
+
+  std::vector<std::size_t> order(vertices.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](auto a, auto b) {
+    return std::make_pair(vertices[a]->info(), codes[a]) <
+           std::make_pair(vertices[b]->info(), codes[b]);
+  });
+  return order;
+}  // space_filling_order()
+
+/// @brief Make a Snapshot of the given vertices and cells
+///
+/// Cell types are read from Cell_handle->info(), so the triangulation
+/// should have been classified (it is after construction or a move).
+///
+/// @tparam Vertex The Vertex_handle type
+/// @tparam Cell The Cell_handle type
+/// @tparam Infinite Predicate type
+/// @param vertices Every finite vertex of the triangulation
+/// @param cells Every cell of the triangulation
+/// @param is_infinite Whether a vertex or cell involves the vertex at
+/// infinity
+/// @return The Snapshot
+template <typename Vertex, typename Cell, typename Infinite>
+auto snapshot_of(const std::vector<Vertex>& vertices,
+                 const std::vector<Cell>& cells, Infinite is_infinite) {
+  Snapshot snapshot;
+
+  // Renumber vertices
+  auto vertex_order = space_filling_order(vertices);
+
+  CGAL::Unique_hash_map<Vertex, Snapshot_index> vertex_index(INFINITE_VERTEX,
+                                                             vertices.size());
+  snapshot.vertex_timevalues.reserve(vertices.size());
+  snapshot.x.reserve(vertices.size());
+  snapshot.y.reserve(vertices.size());
+  snapshot.z.reserve(vertices.size());
+  for (const auto j : vertex_order) {
+    const auto& v   = vertices[j];
+    vertex_index[v] = snapshot.number_of_vertices();
+    snapshot.vertex_timevalues.emplace_back(v->info());
+    snapshot.x.emplace_back(v->point().x());
+    snapshot.y.emplace_back(v->point().y());
+    snapshot.z.emplace_back(v->point().z());
+  }
+
+  // Renumber cells by their lowest vertex, finite cells first
+  std::vector<std::pair<Snapshot_index, Cell>> keyed_cells;
+  keyed_cells.reserve(cells.size());
+  for (const auto& cit : cells) {
+    Snapshot_index key = std::numeric_limits<Snapshot_index>::max();
+    for (auto i = 0; i < 4; ++i) {
+      if (!is_infinite(cit->vertex(i)))
+        key = std::min(key, vertex_index[cit->vertex(i)]);
+    }
+    keyed_cells.emplace_back(key, cit);
+  }
+  std::stable_sort(keyed_cells.begin(), keyed_cells.end(),
+                   [&](const auto& a, const auto& b) {
+                     auto a_infinite = is_infinite(a.second);
+                     auto b_infinite = is_infinite(b.second);
+                     return std::make_pair(a_infinite, a.first) <
+                            std::make_pair(b_infinite, b.first);
+                   });
+
+  CGAL::Unique_hash_map<Cell, Snapshot_index> cell_index(0,
+                                                         keyed_cells.size());
+  for (std::size_t j = 0; j < keyed_cells.size(); ++j) {
+    cell_index[keyed_cells[j].second] = static_cast<Snapshot_index>(j);
+  }
+
+  snapshot.cell_vertices.reserve(4 * keyed_cells.size());
+  snapshot.cell_neighbors.reserve(4 * keyed_cells.size());
+  snapshot.cell_types.reserve(keyed_cells.size());
+  for (const auto& keyed_cell : keyed_cells) {
+    const auto& c = keyed_cell.second;
+    for (auto i = 0; i < 4; ++i) {
+      snapshot.cell_vertices.emplace_back(vertex_index[c->vertex(i)]);
+      snapshot.cell_neighbors.emplace_back(cell_index[c->neighbor(i)]);
+    }
+    if (is_infinite(c)) {
+      snapshot.cell_types.emplace_back(0);
+    } else {
+      snapshot.cell_types.emplace_back(static_cast<std::int8_t>(c->info()));
+      ++snapshot.finite_cells;
+    }
+  }
+
+#ifndef NDEBUG
+  std::cout << "Snapshot has " << snapshot.number_of_vertices()
+            << " vertices and " << snapshot.number_of_finite_cells()
+            << " finite cells." << std::endl;
+#endif
+  return snapshot;
+}  // snapshot_of()
+
+/// @brief Make a Snapshot of a SimplicialManifold
+///
+/// @param universe A SimplicialManifold
+/// @return The Snapshot of **universe**
+inline auto make_snapshot(const SimplicialManifold& universe) {
+#ifndef NDEBUG
+  std::cout << __PRETTY_FUNCTION__ << " called." << std::endl;
+#endif
+  const auto& triangulation = universe.triangulation;
+
+  std::vector<Vertex_handle> vertices;
+  vertices.reserve(triangulation->number_of_vertices());
+  for (auto vit = triangulation->finite_vertices_begin();
+       vit != triangulation->finite_vertices_end(); ++vit) {
+    vertices.emplace_back(vit);
+  }
+
+  std::vector<Cell_handle> cells;
+  cells.reserve(triangulation->number_of_cells());
+  for (auto cit = triangulation->all_cells_begin();
+       cit != triangulation->all_cells_end(); ++cit) {
+    cells.emplace_back(cit);
+  }
+
+  return snapshot_of(vertices, cells, [&](const auto& handle) {
+    return triangulation->is_infinite(handle);
+  });
+}  // make_snapshot()
+
+/// @brief Count spacelike facets per timeslice on a Snapshot
+///
+/// The Snapshot analogue of VolumePerTimeslice(). Each finite facet is
+/// visited once, from the lower-numbered of its two cells (or from its
+/// finite cell if it lies on the convex hull).
+///
+/// @tparam T Snapshot, or another type with the same accessors
+/// @param snapshot The Snapshot
+/// @return A std::map of timevalue to number of spacelike facets
+template <typename T>
+auto volume_per_timeslice(const T& snapshot) {
+  std::map<std::intmax_t, std::intmax_t> volumes;
+  for (Snapshot_index c = 0; c < snapshot.number_of_finite_cells(); ++c) {
+    for (auto i = 0; i < 4; ++i) {
+      auto n = snapshot.neighbor(c, i);
+      if (!snapshot.is_infinite(n) && n < c) continue;
+      // Timevalues of the three vertices opposite vertex i
+      std::array<std::intmax_t, 3> times{};
+      for (auto k = 1; k < 4; ++k) {
+        times[k - 1] = snapshot.timevalue(snapshot.vertex(c, (i + k) & 3));
+      }
+      if (times[0] == times[1] && times[1] == times[2]) ++volumes[times[0]];
+    }
+  }
+  return volumes;
+}  // volume_per_timeslice()
+
+/// @brief Rebuild a Delaunay triangulation from a Snapshot
+///
+/// Vertices and cells are created in Snapshot order, so a freshly
+/// allocated triangulation stores them contiguously in that order. No
+/// geometric predicates are evaluated: the combinatorics, points,
+/// timevalues, and cell types are copied verbatim.
+///
+/// @tparam T Snapshot, or another type with the same accessors
+/// @param snapshot The Snapshot to rebuild from
+/// @return A std::unique_ptr<Delaunay> to the rebuilt triangulation
+template <typename T>
+auto rebuild_triangulation(const T& snapshot) {
+#ifndef NDEBUG
+  std::cout << __PRETTY_FUNCTION__ << " called." << std::endl;
+#endif
+  auto  triangulation = std::make_unique<Delaunay>();
+  auto& tds           = triangulation->tds();
+
+  // A new triangulation holds only the vertex at infinity and its face
+  auto infinite = triangulation->infinite_vertex();
+  tds.delete_cell(infinite->cell());
+  tds.set_dimension(3);
+
+  std::vector<Vertex_handle> vertices;
+  vertices.reserve(snapshot.number_of_vertices());
+  for (Snapshot_index v = 0; v < snapshot.number_of_vertices(); ++v) {
+    auto vertex = tds.create_vertex();
+    vertex->set_point(snapshot.point(v));
+    vertex->info() = snapshot.timevalue(v);
+    vertices.emplace_back(vertex);
+  }
+  auto vertex_handle = [&](const Snapshot_index v) {
+    return v == INFINITE_VERTEX ? infinite : vertices[v];
+  };
+
+  std::vector<Cell_handle> cells;
+  cells.reserve(snapshot.number_of_cells());
+  for (Snapshot_index c = 0; c < snapshot.number_of_cells(); ++c) {
+    auto cell    = tds.create_cell(vertex_handle(snapshot.vertex(c, 0)),
+                                vertex_handle(snapshot.vertex(c, 1)),
+                                vertex_handle(snapshot.vertex(c, 2)),
+                                vertex_handle(snapshot.vertex(c, 3)));
+    cell->info() = snapshot.cell_type(c);
+    cells.emplace_back(cell);
+  }
+
+  for (Snapshot_index c = 0; c < snapshot.number_of_cells(); ++c) {
+    for (auto i = 0; i < 4; ++i) {
+      cells[c]->set_neighbor(i, cells[snapshot.neighbor(c, i)]);
+      cells[c]->vertex(i)->set_cell(cells[c]);
+    }
+  }
+
+  if (!tds.is_valid()) {
+    throw std::runtime_error("Rebuilt triangulation is invalid.");
+  }
+  return triangulation;
+}  // rebuild_triangulation()
+
+/// @brief Compact a SimplicialManifold for memory locality
+///
+/// After many ergodic moves the cells and vertices of a triangulation are
+/// scattered through its containers, with freed slots reused in no
+/// particular order. Compaction rebuilds it from a Snapshot so that
+/// storage follows timeslice-major, space-filling order, then
+/// reclassifies the GeometryInfo handles against the new triangulation.
+/// The flip indexes held handles into the old one, so they are rebuilt on
+/// their next use.
+///
+/// @tparam T The manifold type
+/// @param universe A SimplicialManifold
+/// @return The compacted **universe**
+template <typename T>
+auto compact(T&& universe) -> decltype(universe) {
+#ifndef NDEBUG
+  std::cout << __PRETTY_FUNCTION__ << " called." << std::endl;
+#endif
+  auto triangulation = rebuild_triangulation(make_snapshot(universe));
+  universe.triangulation = std::move(triangulation);
+  universe.geometry      = std::make_unique<GeometryInfo>(
+      classify_all_simplices(universe.triangulation));
+  universe.flippable_facets = boost::none;
+  universe.flippable_edges  = boost::none;
+  return std::move(universe);
+}  // compact()
+
+#endif  // SRC_SNAPSHOT_H_
@@ -0,0 +1,308 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Calculates the spectral dimension of a foliated triangulation by
+/// diffusion on the dual graph of its cells.
+/// For details see:
+/// J. Ambjorn, J. Jurkiewicz, and R. Loll. "Spectral Dimension of the
+/// Universe." Phys. Rev. Lett. 95 (2005): 171301.
+/// http://arxiv.org/abs/hep-th/0505113
+///
+/// \done Dual graph in compressed sparse row (CSR) format
+/// \done Heat kernel evolution by sparse matrix-vector products
+/// \done Parallel random walks with per-thread random number streams
+/// \done Spectral dimension from the return probability
+
+/// @file SpectralDimension.h
+/// @brief Spectral dimension via diffusion on the dual graph
+/// @author Adam Getchell
+
+#ifndef SRC_SPECTRALDIMENSION_H_
+#define SRC_SPECTRALDIMENSION_H_
+
+// CGAL headers
+#include <CGAL/Unique_hash_map.h>
+
+// C++ headers
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// CDT headers
+#include "SimplicialManifold.h"
+#include "ThreadPool.h"
+
+/// @brief Default probability that a walker moves on each diffusion step
+///
+/// A lazy walk avoids the even/odd oscillations of the return probability
+/// a pure random walk shows on nearly bipartite graphs.
+static constexpr double DIFFUSION_CONSTANT = 0.5;
+
+/// @struct
+/// @brief Dual graph of a triangulation in compressed sparse row format
+///
+/// Each finite cell is a node, and two nodes are joined if their cells share
+/// a facet. Facets on the convex hull border infinite cells and have no dual
+/// edge, so those nodes have degree less than 4. Nodes are numbered in the
+/// order of the GeometryInfo classification: (3,1), then (2,2), then (1,3).
+struct DualGraph {
+  /// @brief Offsets into **neighbors** for each node; size is nodes + 1
+  std::vector<std::size_t> row_offsets{0};
+
+  /// @brief Concatenated neighbor lists of every node
+  std::vector<std::size_t> neighbors;
+
+  /// @brief Cell type of each node, as given by Cell_handle->info()
+  std::vector<std::intmax_t> cell_types;
+
+  /// @brief Number of nodes
+  /// @return The number of finite cells in the triangulation
+  auto number_of_nodes() const noexcept { return cell_types.size(); }
+
+  /// @brief Degree of a node
+  /// @param node The node index
+  /// @return The number of dual edges incident to **node**
+  auto degree(const std::size_t node) const noexcept {
+    return row_offsets[node + 1] - row_offsets[node];
+  }
+};
+
+/// @brief Make the dual graph of a SimplicialManifold
+///
+/// Cells are enumerated from the GeometryInfo classification, which must be
+/// current (it is after construction or a move), and their neighbors are
+/// looked up through a CGAL::Unique_hash_map of Cell_handle to node index.
+///
+/// @tparam T The manifold type
+/// @param universe A SimplicialManifold
+/// @return The DualGraph of **universe**
+template <typename T>
+auto make_dual_graph(T&& universe) {
+#ifndef NDEBUG
+  std::cout << __PRETTY_FUNCTION__ << " called." << std::endl;
+#endif
+  DualGraph                                       graph;
+  CGAL::Unique_hash_map<Cell_handle, std::size_t> index;
+  std::vector<Cell_handle>                        cells;
+  cells.reserve(universe.geometry->number_of_cells());
+
+  for (const auto* cell_list :
+       {&universe.geometry->three_one, &universe.geometry->two_two,
+        &universe.geometry->one_three}) {
+    for (const auto& cell : *cell_list) {
+      index[cell] = cells.size();
+      cells.emplace_back(cell);
+      graph.cell_types.emplace_back(cell->info());
+    }
+  }
+
+  graph.row_offsets.reserve(cells.size() + 1);
+  graph.neighbors.reserve(4 * cells.size());
+  for (const auto& cell : cells) {
+    for (auto i = 0; i < 4; ++i) {
+      auto neighbor = cell->neighbor(i);
+      if (!universe.triangulation->is_infinite(neighbor))
+        graph.neighbors.emplace_back(index[neighbor]);
+    }
+    graph.row_offsets.emplace_back(graph.neighbors.size());
+  }
+
+#ifndef NDEBUG
+  std::cout << "Dual graph has " << graph.number_of_nodes() << " nodes and "
+            << graph.neighbors.size() / 2 << " edges." << std::endl;
+#endif
+  return graph;
+}  // make_dual_graph()
+
+/// @brief Evolve the heat kernel by one diffusion step
+///
+/// Computes the sparse matrix-vector product
+/// \f[K(x,\sigma+1)=(1-\epsilon)K(x,\sigma)+\epsilon\sum_{y\sim x}
+/// \frac{K(y,\sigma)}{d_y}\f]
+/// which conserves total probability on any graph.
+///
+/// @param graph The DualGraph
+/// @param current \f$K(\cdot,\sigma)\f$
+/// @param next \f$K(\cdot,\sigma+1)\f$, overwritten
+/// @param diffusion \f$\epsilon\f$, the probability of moving on each step
+inline void diffuse(const DualGraph& graph, const std::vector<double>& current,
+                    std::vector<double>* const next,
+                    const double               diffusion) noexcept {
+  const auto nodes = graph.number_of_nodes();
+  for (std::size_t x = 0; x < nodes; ++x) {
+    auto inflow = 0.0;
+    for (auto j = graph.row_offsets[x]; j < graph.row_offsets[x + 1]; ++j) {
+      auto y = graph.neighbors[j];
+      inflow += current[y] / static_cast<double>(graph.degree(y));
+    }
+    (*next)[x] = (1.0 - diffusion) * current[x] + diffusion * inflow;
+  }
+}  // diffuse()
+
+/// @brief Return probability by heat kernel evolution
+///
+/// Evolves a unit heat source placed at each origin for **max_sigma** steps
+/// and averages \f$P(\sigma)=K(x_0,x_0;\sigma)\f$ over the origins. The
+/// origins are split into **threads** parts, run as tasks on the shared
+/// Thread_pool.
+///
+/// @param graph The DualGraph
+/// @param origins The nodes on which heat sources are placed
+/// @param max_sigma The maximum diffusion time
+/// @param diffusion \f$\epsilon\f$, the probability of moving on each step
+/// @param threads Number of parts; 0 for one per worker of the pool
+/// @return \f$P(\sigma)\f$ for \f$\sigma=0\ldots\f$ **max_sigma**
+inline auto heat_kernel_return_probability(
+    const DualGraph& graph, const std::vector<std::size_t>& origins,
+    const std::intmax_t max_sigma, const double diffusion = DIFFUSION_CONSTANT,
+    unsigned threads = 0) {
+  if (graph.number_of_nodes() == 0 || origins.empty() || max_sigma < 0)
+    throw std::invalid_argument("Nothing to diffuse on.");
+  if (threads == 0) threads = Thread_pool::instance().size();
+  threads = std::min(threads, static_cast<unsigned>(origins.size()));
+
+  std::vector<std::vector<double>> partial_sums(
+      threads, std::vector<double>(max_sigma + 1, 0.0));
+  Thread_pool::instance().parallel_for(0, threads, [&](const std::size_t t) {
+    std::vector<double> current(graph.number_of_nodes());
+    std::vector<double> next(graph.number_of_nodes());
+    for (auto o = t; o < origins.size(); o += threads) {
+      std::fill(current.begin(), current.end(), 0.0);
+      current[origins[o]] = 1.0;
+      partial_sums[t][0] += 1.0;
+      for (std::intmax_t sigma = 1; sigma <= max_sigma; ++sigma) {
+        diffuse(graph, current, &next, diffusion);
+        current.swap(next);
+        partial_sums[t][sigma] += current[origins[o]];
+      }
+    }
+  });
+
+  std::vector<double> return_probability(max_sigma + 1, 0.0);
+  for (const auto& sums : partial_sums) {
+    for (std::intmax_t sigma = 0; sigma <= max_sigma; ++sigma)
+      return_probability[sigma] += sums[sigma];
+  }
+  for (auto& p : return_probability) p /= static_cast<double>(origins.size());
+  return return_probability;
+}  // heat_kernel_return_probability()
+
+/// @brief Return probability by independent random walks
+///
+/// Each of **walkers** walkers starts on a uniformly chosen node and, with
+/// probability \f$\epsilon\f$ per step, hops to a uniformly chosen neighbor.
+/// \f$P(\sigma)\f$ is the fraction of walkers back at their origin after
+/// \f$\sigma\f$ steps. Walkers are split into **threads** parts, run as
+/// tasks on the shared Thread_pool, each with its own std::mt19937_64
+/// stream seeded from (**seed**, part).
+///
+/// @param graph The DualGraph
+/// @param walkers The number of random walks
+/// @param max_sigma The maximum diffusion time
+/// @param seed Seed for the per-thread random number streams
+/// @param diffusion \f$\epsilon\f$, the probability of moving on each step
+/// @param threads Number of parts; 0 for one per worker of the pool
+/// @return \f$P(\sigma)\f$ for \f$\sigma=0\ldots\f$ **max_sigma**
+inline auto random_walk_return_probability(
+    const DualGraph& graph, const std::intmax_t walkers,
+    const std::intmax_t max_sigma, const std::uint64_t seed,
+    const double diffusion = DIFFUSION_CONSTANT, unsigned threads = 0) {
+  if (graph.number_of_nodes() == 0 || walkers <= 0 || max_sigma < 0)
+    throw std::invalid_argument("Nothing to diffuse on.");
+  if (threads == 0) threads = Thread_pool::instance().size();
+  threads = std::min(threads, static_cast<unsigned>(walkers));
+
+  std::vector<std::vector<std::intmax_t>> partial_returns(
+      threads, std::vector<std::intmax_t>(max_sigma + 1, 0));
+  Thread_pool::instance().parallel_for(0, threads, [&](const std::size_t t) {
+    std::seed_seq   sequence{seed, static_cast<std::uint64_t>(t)};
+    std::mt19937_64 generator(sequence);
+    std::uniform_int_distribution<std::size_t> pick_node(
+        0, graph.number_of_nodes() - 1);
+    std::bernoulli_distribution hop(diffusion);
+    for (auto w = static_cast<std::intmax_t>(t); w < walkers; w += threads) {
+      const auto origin   = pick_node(generator);
+      auto       position = origin;
+      ++partial_returns[t][0];
+      for (std::intmax_t sigma = 1; sigma <= max_sigma; ++sigma) {
+        const auto degree = graph.degree(position);
+        if (degree > 0 && hop(generator)) {
+          std::uniform_int_distribution<std::size_t> pick_edge(0, degree - 1);
+          position = graph.neighbors[graph.row_offsets[position] +
+                                     pick_edge(generator)];
+        }
+        if (position == origin) ++partial_returns[t][sigma];
+      }
+    }
+  });
+
+  std::vector<double> return_probability(max_sigma + 1, 0.0);
+  for (const auto& returns : partial_returns) {
+    for (std::intmax_t sigma = 0; sigma <= max_sigma; ++sigma)
+      return_probability[sigma] += static_cast<double>(returns[sigma]);
+  }
+  for (auto& p : return_probability) p /= static_cast<double>(walkers);
+  return return_probability;
+}  // random_walk_return_probability()
+
+/// @brief Spectral dimension from the return probability
+///
+/// Uses the centered logarithmic derivative
+/// \f[D_S(\sigma)=-2\frac{d\ln P(\sigma)}{d\ln\sigma}\f]
+/// which is defined for \f$1\le\sigma<\sigma_{max}\f$; entry 0 and the last
+/// entry are set to 0, as are entries where \f$P(\sigma)\f$ vanishes.
+///
+/// @param return_probability \f$P(\sigma)\f$
+/// @return \f$D_S(\sigma)\f$, the same size as **return_probability**
+inline auto spectral_dimension(const std::vector<double>& return_probability) {
+  std::vector<double> dimension(return_probability.size(), 0.0);
+  for (std::size_t sigma = 2; sigma + 1 < return_probability.size(); ++sigma) {
+    const auto p_before = return_probability[sigma - 1];
+    const auto p_after  = return_probability[sigma + 1];
+    if (p_before <= 0.0 || p_after <= 0.0) continue;
+    dimension[sigma] =
+        -2.0 * (std::log(p_after) - std::log(p_before)) /
+        (std::log(static_cast<double>(sigma + 1)) -
+         std::log(static_cast<double>(sigma - 1)));
+  }
+  // sigma = 1 needs a one-sided difference since ln(0) is undefined
+  if (return_probability.size() > 2 && return_probability[1] > 0.0 &&
+      return_probability[2] > 0.0) {
+    dimension[1] =
+        -2.0 * (std::log(return_probability[2]) -
+                std::log(return_probability[1])) /
+        std::log(2.0);
+  }
+  return dimension;
+}  // spectral_dimension()
+
+/// @brief Calculate the spectral dimension of a SimplicialManifold
+///
+/// Builds the DualGraph and runs heat kernel evolution from **origins**
+/// uniformly chosen cells.
+///
+/// @tparam T The manifold type
+/// @param universe A SimplicialManifold
+/// @param origins Number of heat sources to average over
+/// @param max_sigma The maximum diffusion time
+/// @return A std::pair of \f$P(\sigma)\f$ and \f$D_S(\sigma)\f$
+template <typename T>
+auto SpectralDimension(T&& universe, const std::intmax_t origins,
+                       const std::intmax_t max_sigma) {
+  auto                     graph = make_dual_graph(universe);
+  std::vector<std::size_t> sources;
+  for (std::intmax_t i = 0; i < origins; ++i) {
+    sources.emplace_back(static_cast<std::size_t>(generate_random_signed(
+        0, static_cast<std::intmax_t>(graph.number_of_nodes()) - 1)));
+  }
+  auto return_probability =
+      heat_kernel_return_probability(graph, sources, max_sigma);
+  auto dimension = spectral_dimension(return_probability);
+  return std::make_pair(return_probability, dimension);
+}  // SpectralDimension()
+
+#endif  // SRC_SPECTRALDIMENSION_H_
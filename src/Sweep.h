@@ -0,0 +1,406 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Parameter sweeps run as a batch inside one process. A sweep
+/// specification lists values for each coupling and size; every
+/// combination is an independent Metropolis run. Runs are tasks on the
+/// shared Thread_pool, and each writes its results as soon as it finishes.
+///
+/// Runs of the same size start from a shared seed universe, built (and
+/// optionally thermalized) once. Each run copies the seed when it starts,
+/// which is much cheaper than calling make_triangulation() again. Each NUMA
+/// node keeps its own copy of the seed, made by one of its workers, so runs
+/// copy from memory on their own node, and the run's copy is then made and
+/// swept by the same pinned worker.
+///
+/// \done Sweep specification parser
+/// \done Shared seed universes per size
+/// \done Thread pool of independent runs
+/// \done Streaming per-point results
+/// \done Seed copies on each NUMA node
+
+/// @file Sweep.h
+/// @brief Batch parameter sweeps
+/// @author Adam Getchell
+
+#ifndef SRC_SWEEP_H_
+#define SRC_SWEEP_H_
+
+// CDT headers
+#include "Metropolis.h"
+#include "ThreadPool.h"
+
+// C++ headers
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <future>  // NOLINT
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/// @struct
+/// @brief One point of a sweep: the parameters of a single run
+struct Sweep_point {
+  long double   alpha;
+  long double   k;
+  long double   lambda;
+  std::intmax_t simplices;
+  std::intmax_t timeslices;
+};
+
+/// @struct
+/// @brief A parsed sweep specification
+struct Sweep_spec {
+  std::vector<long double>   alphas;
+  std::vector<long double>   ks;
+  std::vector<long double>   lambdas;
+  std::vector<std::intmax_t> simplices;
+  std::vector<std::intmax_t> timeslices;
+
+  /// @brief Passes for each run
+  std::intmax_t passes{100};
+
+  /// @brief Checkpoint every n passes of each run, to the trajectory
+  /// sweep-<point>.traj, which each sweep starts afresh
+  std::intmax_t checkpoint{10};
+
+  /// @brief Passes used to thermalize each seed universe before it's
+  /// shared, at the couplings of the lowest-index point of its size
+  std::intmax_t thermalization{0};
+
+  /// @brief File receiving one line of results per run
+  std::string output{"sweep.csv"};
+
+  /// @brief Whether to write each run's final triangulation
+  bool save_triangulations{true};
+};
+
+/// @brief Parse the values of one specification key
+///
+/// Values are separated by whitespace or commas. A value of the form
+/// start:stop:step expands to start, start + step, ... up to and including
+/// stop.
+///
+/// @tparam T The value type
+/// @param key The key, for error messages
+/// @param values The text after the '='
+/// @return The values
+template <typename T>
+auto parse_sweep_values(const std::string& key, std::string values) {
+  std::replace(values.begin(), values.end(), ',', ' ');
+  std::istringstream tokens(values);
+  std::vector<T>     result;
+  std::string        token;
+  while (tokens >> token) {
+    std::replace(token.begin(), token.end(), ':', ' ');
+    std::istringstream range(token);
+    long double        start{0};
+    long double        stop{0};
+    long double        step{0};
+    if (!(range >> start))
+      throw std::invalid_argument("Bad value for " + key + ": " + token);
+    if (range >> stop) {
+      if (!(range >> step) || step <= 0)
+        throw std::invalid_argument("Bad range for " + key + ": " + token);
+      // Tolerate rounding in the step so the stop value is included
+      auto count = static_cast<std::intmax_t>(
+          std::floor((stop - start) / step + 1e-9L));
+      for (std::intmax_t i = 0; i <= count; ++i) {
+        result.emplace_back(static_cast<T>(start + i * step));
+      }
+    } else {
+      result.emplace_back(static_cast<T>(start));
+    }
+  }
+  if (result.empty()) throw std::invalid_argument("No values for " + key);
+  return result;
+}  // parse_sweep_values()
+
+/// @brief Parse a sweep specification
+///
+/// Each line is `key = values`; `#` starts a comment. The keys alpha, k,
+/// lambda, simplices, and timeslices take lists of values and are
+/// required. The keys passes, checkpoint, thermalization, output, and
+/// save_triangulations take single values. For example:
+///
+///     alpha      = 0.6:0.8:0.1
+///     k          = 1.1
+///     lambda     = 0.1, 0.2
+///     simplices  = 64000
+///     timeslices = 16
+///     passes     = 100
+///
+/// @param input The specification
+/// @return The Sweep_spec
+inline auto parse_sweep(std::istream& input) {
+  Sweep_spec  spec;
+  std::string line;
+  while (std::getline(input, line)) {
+    line = line.substr(0, line.find('#'));
+    if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+    auto equals = line.find('=');
+    if (equals == std::string::npos)
+      throw std::invalid_argument("Expected key = values: " + line);
+    std::istringstream key_stream(line.substr(0, equals));
+    std::string        key;
+    key_stream >> key;
+    auto values = line.substr(equals + 1);
+
+    if (key == "alpha") {
+      spec.alphas = parse_sweep_values<long double>(key, values);
+    } else if (key == "k") {
+      spec.ks = parse_sweep_values<long double>(key, values);
+    } else if (key == "lambda") {
+      spec.lambdas = parse_sweep_values<long double>(key, values);
+    } else if (key == "simplices") {
+      spec.simplices = parse_sweep_values<std::intmax_t>(key, values);
+    } else if (key == "timeslices") {
+      spec.timeslices = parse_sweep_values<std::intmax_t>(key, values);
+    } else if (key == "passes") {
+      spec.passes = parse_sweep_values<std::intmax_t>(key, values).front();
+    } else if (key == "checkpoint") {
+      spec.checkpoint = parse_sweep_values<std::intmax_t>(key, values).front();
+    } else if (key == "thermalization") {
+      spec.thermalization =
+          parse_sweep_values<std::intmax_t>(key, values).front();
+    } else if (key == "save_triangulations") {
+      spec.save_triangulations =
+          parse_sweep_values<std::intmax_t>(key, values).front() != 0;
+    } else if (key == "output") {
+      std::istringstream value_stream(values);
+      if (!(value_stream >> spec.output))
+        throw std::invalid_argument("No value for output");
+    } else {
+      throw std::invalid_argument("Unknown sweep key: " + key);
+    }
+  }
+
+  if (spec.alphas.empty() || spec.ks.empty() || spec.lambdas.empty() ||
+      spec.simplices.empty() || spec.timeslices.empty())
+    throw std::invalid_argument(
+        "Sweep needs alpha, k, lambda, simplices, and timeslices.");
+  if (spec.checkpoint <= 0)
+    throw std::invalid_argument("Checkpoint must be positive.");
+  for (auto alpha : spec.alphas) {
+    if (alpha < 0.5)
+      throw std::domain_error("Alpha in 3D should be greater than 1/2.");
+  }
+  return spec;
+}  // parse_sweep()
+
+/// @brief Expand a specification into its grid of points
+///
+/// Points are ordered by size first, so runs sharing a seed are scheduled
+/// together.
+///
+/// @param spec The Sweep_spec
+/// @return Every combination of the specification's values
+inline auto sweep_points(const Sweep_spec& spec) {
+  std::vector<Sweep_point> points;
+  points.reserve(spec.simplices.size() * spec.timeslices.size() *
+                 spec.alphas.size() * spec.ks.size() * spec.lambdas.size());
+  for (auto simplices : spec.simplices) {
+    for (auto timeslices : spec.timeslices) {
+      for (auto alpha : spec.alphas) {
+        for (auto k : spec.ks) {
+          for (auto lambda : spec.lambdas) {
+            points.emplace_back(
+                Sweep_point{alpha, k, lambda, simplices, timeslices});
+          }
+        }
+      }
+    }
+  }
+  return points;
+}  // sweep_points()
+
+/// @class Sweep
+/// @brief Runs every point of a sweep on the shared Thread_pool
+class Sweep {
+ private:
+  /// @brief A seed universe shared by every run of one size
+  using Seed = std::shared_future<std::shared_ptr<const SimplicialManifold>>;
+
+  /// @brief The specification
+  Sweep_spec spec_;
+
+  /// @brief The points to run
+  std::vector<Sweep_point> points_;
+
+  /// @brief Protects seeds_ and the results stream
+  std::mutex mutex_;
+
+  /// @brief Seed universes by (simplices, timeslices, NUMA node)
+  std::map<std::tuple<std::intmax_t, std::intmax_t, std::size_t>, Seed>
+      seeds_;
+
+  /// @brief Get the seed for a point on this thread's NUMA node, building
+  /// it if this is the first run of its size, or else copying it from
+  /// another node if this is the first run of its size on this node
+  ///
+  /// Other runs of the same size wait for the first to finish building it.
+  ///
+  /// @param point The Sweep_point
+  /// @return The seed universe
+  std::shared_ptr<const SimplicialManifold> seed(const Sweep_point& point) {
+    std::promise<std::shared_ptr<const SimplicialManifold>> promise;
+    Seed                                                    seed;
+    Seed                                                    source;
+    bool                                                    make{false};
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      const auto key = std::make_tuple(point.simplices, point.timeslices,
+                                       Thread_pool::instance().current_node());
+      auto found = seeds_.find(key);
+      if (found == seeds_.end()) {
+        seed = promise.get_future().share();
+        make = true;
+        for (const auto& other : seeds_) {
+          if (std::get<0>(other.first) == point.simplices &&
+              std::get<1>(other.first) == point.timeslices) {
+            source = other.second;
+            break;
+          }
+        }
+        seeds_.emplace(key, seed);
+      } else {
+        seed = found->second;
+      }
+    }
+    if (make) {
+      try {
+        if (source.valid()) {
+          // First touch places the copy on this node
+          Trace_span span("Copy seed", "sweep", point.simplices);
+          auto       original = source.get();
+          promise.set_value(std::make_shared<const SimplicialManifold>(
+              std::make_unique<Delaunay>(*original->triangulation)));
+        } else {
+          Trace_span         span("Build seed", "sweep", point.simplices);
+          SimplicialManifold universe(point.simplices, point.timeslices);
+          if (spec_.thermalization > 0) {
+            // Whichever run gets here first, thermalize at the couplings of
+            // the lowest-index point of this size
+            const auto& first = *std::find_if(
+                points_.begin(), points_.end(), [&point](const auto& other) {
+                  return other.simplices == point.simplices &&
+                         other.timeslices == point.timeslices;
+                });
+            Metropolis thermalize(first.alpha, first.k, first.lambda,
+                                  spec_.thermalization, spec_.thermalization);
+            swap(universe, thermalize(universe));
+          }
+          promise.set_value(
+              std::make_shared<const SimplicialManifold>(std::move(universe)));
+        }
+      } catch (...) {
+        promise.set_exception(std::current_exception());
+      }
+    }
+    return seed.get();
+  }
+
+  /// @brief Run one point and write its results
+  /// @param index Index of the point
+  /// @param results Stream receiving one line per run
+  void run_point(const std::size_t index, std::ostream& results) {
+    const auto& point = points_[index];
+    Trace_span  span("Sweep point", "sweep", static_cast<std::intmax_t>(index));
+    auto        start = std::chrono::steady_clock::now();
+
+    // Copy the seed's triangulation; the unique_ptr constructor classifies
+    // it afresh, so no handles refer back to the seed
+    auto               shared = seed(point);
+    SimplicialManifold universe(
+        std::make_unique<Delaunay>(*shared->triangulation));
+    shared.reset();
+
+    // Checkpoints go to a trajectory per point, since write_file() names
+    // files only by size and would mix up concurrent runs. Each run starts
+    // a new chain from the seed, so it replaces any trajectory left by an
+    // earlier sweep rather than appending to it.
+    auto filename = "sweep-" + std::to_string(index) + ".traj";
+    std::remove(filename.c_str());
+    Trajectory_writer trajectory(filename);
+    Metropolis        run(point.alpha, point.k, point.lambda, spec_.passes,
+                          spec_.checkpoint);
+    run.record_trajectory(trajectory);
+    swap(universe, run(universe));
+
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+
+    // The point index keeps concurrent runs' filenames distinct
+    if (spec_.save_triangulations) {
+      std::ofstream file("sweep-" + std::to_string(index) + "-" +
+                         generate_filename(topology_type::SPHERICAL, 3,
+                                           point.simplices, point.timeslices));
+      if (!file.is_open()) throw std::runtime_error("Unable to open file.");
+      file << *universe.triangulation;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    results << index << "," << point.alpha << "," << point.k << ","
+            << point.lambda << "," << point.simplices << ","
+            << point.timeslices << "," << universe.geometry->N3_31() << ","
+            << universe.geometry->N3_22() << "," << universe.geometry->N3_13()
+            << "," << universe.geometry->N1_TL() << ","
+            << universe.geometry->N1_SL() << "," << universe.geometry->N0()
+            << "," << elapsed.count() << std::endl;
+  }
+
+ public:
+  /// @brief Construct a Sweep from a specification
+  /// @param spec The Sweep_spec
+  explicit Sweep(Sweep_spec spec)
+      : spec_{std::move(spec)}, points_{sweep_points(spec_)} {}
+
+  /// @brief The points of the sweep
+  const auto& points() const noexcept { return points_; }
+
+  /// @brief The specification
+  const auto& spec() const noexcept { return spec_; }
+
+  /// @brief Run every point
+  ///
+  /// A run that throws is reported on std::cerr and doesn't stop the others.
+  ///
+  /// @param results Stream receiving a header and then one line per run,
+  /// flushed as each run finishes
+  /// @param jobs Most concurrent runs; 0 for one per worker of the pool
+  /// @return The number of runs that failed
+  std::intmax_t run(std::ostream& results, std::size_t jobs = 0) {
+    results << "point,alpha,k,lambda,simplices,timeslices,N3_31,N3_22,N3_13,"
+               "N1_TL,N1_SL,N0,seconds"
+            << std::endl;
+
+    std::atomic_intmax_t failed{0};
+    Thread_pool::instance().parallel_for(
+        0, points_.size(),
+        [this, &failed, &results](const std::size_t index) {
+          try {
+            run_point(index, results);
+          } catch (const std::exception& ex) {
+            std::cerr << "Sweep point " << index << " failed: " << ex.what()
+                      << std::endl;
+            ++failed;
+          }
+        },
+        jobs);
+    return failed;
+  }
+};
+
+#endif  // SRC_SWEEP_H_
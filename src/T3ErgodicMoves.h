@@ -0,0 +1,97 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Performs ergodic moves on T3 (2+1) spacetimes.
+///
+/// make_23_move(), make_32_move(), make_26_move(), and make_62_move() from
+/// S3ErgodicMoves.h work on a ToroidalManifold through the overloads here.
+/// A periodic triangulation can't flip vertices geometrically once its
+/// cells are no longer Delaunay, so these moves change only the
+/// triangulation data structure, checking causality combinatorially.
+///
+/// \done (2,3) move
+/// \done (3,2) move
+/// \done (2,6) move, shared with S3
+/// \done (6,2) move as a combinatorial collapse, shared with S3
+/// \todo (4,4) move
+
+/// @file T3ErgodicMoves.h
+/// @brief Pachner moves on 3D periodic triangulations
+/// @author Adam Getchell
+
+#ifndef SRC_T3ERGODICMOVES_H_
+#define SRC_T3ERGODICMOVES_H_
+
+// C++ headers
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+// CDT headers
+#include "S3ErgodicMoves.h"
+#include "ToroidalManifold.h"
+
+/// @brief Whether a (2,3) move can be made on a facet of a ToroidalManifold
+///
+/// As is_23_flippable() on a SimplicialManifold, except that a periodic
+/// triangulation flips combinatorially, so instead of being convex the two
+/// cells must not already have the new edge.
+///
+/// @param universe A ToroidalManifold
+/// @param cell The cell
+/// @param i The index of the vertex opposite the facet
+/// @return **True** if flipping the facet is a (2,3) move
+inline bool is_23_flippable(const ToroidalManifold& universe,
+                            const T3Cell_handle& cell, const int i) {
+  const auto lower = lower_timeslice(cell, universe.timeslices);
+  if (lower == 0) return false;
+  auto on_lower = 0;
+  for (auto k = 0; k < 4; ++k) {
+    if (cell->vertex(k)->info() == lower) ++on_lower;
+  }
+  if (on_lower != 2) return false;
+
+  auto neighbor = cell->neighbor(i);
+  auto top      = cell->vertex(i);
+  auto bottom   = neighbor->vertex(neighbor->index(cell));
+  // A spacelike edge would leave cells on a single timeslice
+  if (top == bottom || top->info() == bottom->info()) return false;
+
+  T3Cell_handle edge_cell;
+  int           j{0};
+  int           k{0};
+  return !universe.triangulation->tds().is_edge(top, bottom, edge_cell, j, k);
+}  // is_23_flippable()
+
+/// @brief Whether a (3,2) move can be made on an edge of a ToroidalManifold
+///
+/// As is_32_flippable() on a SimplicialManifold, except that a periodic
+/// triangulation flips combinatorially, so instead of being convex the
+/// ring must not already be a facet.
+///
+/// @param universe A ToroidalManifold
+/// @param first One vertex of the edge
+/// @param second The other vertex of the edge
+/// @param ring The vertices of the three cells around the edge not on it
+/// @return **True** if flipping the edge is a (3,2) move
+inline bool is_32_flippable(const ToroidalManifold&               universe,
+                            const T3Vertex_handle&                first,
+                            const T3Vertex_handle&                second,
+                            const std::array<T3Vertex_handle, 3>& ring) {
+  if (first->info() == second->info()) return false;
+  // Neither new cell may lie on a single timeslice
+  if (ring[0]->info() == ring[1]->info() && ring[0]->info() == ring[2]->info())
+    return false;
+
+  T3Cell_handle facet_cell;
+  int           i{0};
+  int           j{0};
+  int           k{0};
+  return !universe.triangulation->tds().is_facet(ring[0], ring[1], ring[2],
+                                                  facet_cell, i, j, k);
+}  // is_32_flippable()
+
+#endif  // SRC_T3ERGODICMOVES_H_
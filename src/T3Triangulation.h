@@ -0,0 +1,300 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Creates foliated toroidal triangulations
+///
+/// The number of desired timeslices is given, and each timeslice is a
+/// layer of random points at constant height in the unit cube. The points
+/// are inserted into a periodic Delaunay triangulation, so each timeslice
+/// is a 2-torus and time is periodic too: timeslice 1 follows timeslice
+/// **timeslices**. The spacetime is T2 x S1 with no boundary, so there is
+/// no spherical cap at either end.
+///
+/// Once foliated, the triangulation is kept as a 1-sheeted covering so
+/// that its data structure holds each simplex exactly once. Ergodic moves
+/// then work on the data structure alone (see T3ErgodicMoves.h), and the
+/// periodic offsets of cells are no longer meaningful.
+///
+/// \done Foliated periodic point generation
+/// \done Assign timeslices from the height of each point
+/// \done Fix cells that don't span adjacent timeslices
+/// \done Classify cells and edges with periodic time
+/// \todo Toroidal universes in Snapshot compaction and universe files
+
+/// @file T3Triangulation.h
+/// @brief Functions on 3D Toroidal (periodic) Delaunay Triangulations
+/// @author Adam Getchell
+
+#ifndef SRC_T3TRIANGULATION_H_
+#define SRC_T3TRIANGULATION_H_
+
+// CGAL headers
+#include <CGAL/Periodic_3_Delaunay_triangulation_3.h>
+#include <CGAL/Periodic_3_triangulation_ds_cell_base_3.h>
+#include <CGAL/Periodic_3_triangulation_ds_vertex_base_3.h>
+#include <CGAL/Periodic_3_triangulation_traits_3.h>
+#include <CGAL/Triangulation_cell_base_3.h>
+#include <CGAL/Triangulation_vertex_base_3.h>
+
+// C++ headers
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// CDT headers
+#include "S3Triangulation.h"
+
+using T3Traits = CGAL::Periodic_3_triangulation_traits_3<K>;
+// Used so that each timeslice is assigned an integer
+using T3Vb = CGAL::Triangulation_vertex_base_with_info_3<
+    std::intmax_t, T3Traits,
+    CGAL::Triangulation_vertex_base_3<
+        T3Traits, CGAL::Periodic_3_triangulation_ds_vertex_base_3<>>>;
+using T3Cb = CGAL::Triangulation_cell_base_with_info_3<
+    std::intmax_t, T3Traits,
+    CGAL::Triangulation_cell_base_3<
+        T3Traits, CGAL::Periodic_3_triangulation_ds_cell_base_3<>>>;
+using T3Tds = CGAL::Triangulation_data_structure_3<T3Vb, T3Cb>;
+using T3Delaunay =
+    CGAL::Periodic_3_Delaunay_triangulation_3<T3Traits, T3Tds>;
+using T3Cell_handle   = T3Delaunay::Cell_handle;
+using T3Vertex_handle = T3Delaunay::Vertex_handle;
+using T3Point         = T3Delaunay::Point;
+using T3Edge_handle   = Basic_edge_handle<T3Cell_handle>;
+
+/// The fewest timeslices for which adjacency in periodic time is
+/// unambiguous
+static constexpr std::intmax_t MIN_TOROIDAL_TIMESLICES = 3;
+
+/// @brief Check the number of timeslices of a toroidal triangulation
+/// @param timeslices The number of timeslices
+inline void check_toroidal_timeslices(const std::intmax_t timeslices) {
+  if (timeslices < MIN_TOROIDAL_TIMESLICES)
+    throw std::invalid_argument(
+        "Toroidal triangulations need at least 3 timeslices.");
+}  // check_toroidal_timeslices()
+
+/// @brief The lower timeslice of a cell in periodic time
+///
+/// A cell is correctly foliated if its vertices lie on exactly two
+/// adjacent timeslices, where timeslice **timeslices** is adjacent to
+/// timeslice 1.
+///
+/// @tparam Cell The Cell_handle type
+/// @param cell The cell
+/// @param timeslices The number of timeslices
+/// @return The lower of the cell's two timeslices, or 0 if the cell isn't
+/// correctly foliated
+template <typename Cell>
+auto lower_timeslice(const Cell& cell, const std::intmax_t timeslices) {
+  auto min_time = cell->vertex(0)->info();
+  auto max_time = min_time;
+  for (auto i = 1; i < 4; ++i) {
+    min_time = std::min(min_time, cell->vertex(i)->info());
+    max_time = std::max(max_time, cell->vertex(i)->info());
+  }
+  for (auto i = 0; i < 4; ++i) {
+    auto time = cell->vertex(i)->info();
+    if (time != min_time && time != max_time) return std::intmax_t{0};
+  }
+  if (max_time - min_time == 1) return min_time;
+  // The last timeslice is followed by the first
+  if (min_time == 1 && max_time == timeslices) return max_time;
+  return std::intmax_t{0};
+}  // lower_timeslice()
+
+/// @brief Classify cells and edges of a toroidal triangulation
+///
+/// As classify_all_simplices(), but with periodic time. Cells are
+/// classified as (3,1), (2,2), or (1,3) by the number of their vertices
+/// on their lower timeslice, and their type written to Cell_handle->info().
+///
+/// @param triangulation The toroidal triangulation, as a 1-sheeted
+/// covering
+/// @param timeslices The number of timeslices
+/// @return The Basic_geometry_tuple of **triangulation**
+inline auto classify_toroidal_simplices(const T3Delaunay&   triangulation,
+                                        const std::intmax_t timeslices) {
+#ifndef NDEBUG
+  std::cout << "Classifying toroidal simplices...." << std::endl;
+#endif
+  CDT_TIME_PHASE(phase::CLASSIFICATION);
+  const auto& tds = triangulation.tds();
+
+  std::vector<T3Cell_handle> three_one;
+  std::vector<T3Cell_handle> two_two;
+  std::vector<T3Cell_handle> one_three;
+  for (auto cit = tds.cells_begin(); cit != tds.cells_end(); ++cit) {
+    auto lower = lower_timeslice(cit, timeslices);
+    if (lower == 0)
+      throw std::runtime_error(
+          "Invalid simplex in classify_toroidal_simplices()!");
+    auto lower_vertices = 0;
+    for (auto i = 0; i < 4; ++i) {
+      if (cit->vertex(i)->info() == lower) ++lower_vertices;
+    }
+    if (lower_vertices == 3) {
+      cit->info() = 31;
+      three_one.emplace_back(cit);
+    } else if (lower_vertices == 2) {
+      cit->info() = 22;
+      two_two.emplace_back(cit);
+    } else {
+      cit->info() = 13;
+      one_three.emplace_back(cit);
+    }
+  }
+
+  std::vector<T3Edge_handle> timelike_edges;
+  std::vector<T3Edge_handle> spacelike_edges;
+  for (auto eit = tds.edges_begin(); eit != tds.edges_end(); ++eit) {
+    T3Edge_handle edge{eit->first, eit->second, eit->third};
+    if (eit->first->vertex(eit->second)->info() !=
+        eit->first->vertex(eit->third)->info()) {
+      timelike_edges.emplace_back(edge);
+    } else {
+      spacelike_edges.emplace_back(edge);
+    }
+  }
+
+  std::vector<T3Vertex_handle> vertices;
+  vertices.reserve(tds.number_of_vertices());
+  for (auto vit = tds.vertices_begin(); vit != tds.vertices_end(); ++vit) {
+    vertices.emplace_back(vit);
+  }
+
+#ifndef NDEBUG
+  std::cout << "There are " << three_one.size() << " (3,1) simplices and "
+            << two_two.size() << " (2,2) simplices" << std::endl;
+  std::cout << "and " << one_three.size() << " (1,3) simplices." << std::endl;
+  std::cout << "There are " << timelike_edges.size() << " timelike edges and "
+            << spacelike_edges.size() << " spacelike edges." << std::endl;
+#endif
+  return std::make_tuple(three_one, two_two, one_three, timelike_edges,
+                         spacelike_edges, vertices);
+}  // classify_toroidal_simplices()
+
+/// @brief Make foliated tori
+///
+/// Each timeslice is a layer of uniformly random points in the unit
+/// square, at height (timeslice - 1) / timeslices in the unit cube. The
+/// points are drawn with draw_random_real(), so inside a Random_scope
+/// they come from its stream.
+///
+/// @param simplices  The number of desired simplices in the triangulation
+/// @param timeslices The number of timeslices in the triangulation
+/// @return A std::vector of the points of every timeslice
+inline auto make_foliated_torus(const std::intmax_t simplices,
+                                const std::intmax_t timeslices) {
+  const auto points_per_timeslice =
+      expected_points_per_simplex(DIMENSION, simplices, timeslices);
+  CGAL_triangulation_precondition(points_per_timeslice >= 4);
+
+  std::vector<T3Point> points;
+  points.reserve(static_cast<std::size_t>(points_per_timeslice * timeslices));
+  for (std::intmax_t i = 0; i < timeslices; ++i) {
+    auto height = static_cast<double>(i) / static_cast<double>(timeslices);
+    for (std::intmax_t j = 0; j < points_per_timeslice; ++j) {
+      auto x = draw_random_real(0.0, 1.0);
+      auto y = draw_random_real(0.0, 1.0);
+      points.emplace_back(x, y, height);
+    }
+  }
+  return points;
+}  // make_foliated_torus()
+
+/// @brief Remove the vertices of cells that aren't correctly foliated
+///
+/// As fix_timeslices(), but with periodic time. The vertex with the highest
+/// timevalue of each bad cell is removed.
+///
+/// @param triangulation The toroidal triangulation, as a 1-sheeted
+/// covering
+/// @param timeslices The number of timeslices
+/// @return **True** if every cell was correctly foliated
+inline auto fix_toroidal_timeslices(T3Delaunay&         triangulation,
+                                    const std::intmax_t timeslices) {
+  std::intmax_t             valid{0};
+  std::intmax_t             invalid{0};
+  std::set<T3Vertex_handle> deleted_vertices;
+  const auto&               tds = triangulation.tds();
+  for (auto cit = tds.cells_begin(); cit != tds.cells_end(); ++cit) {
+    if (lower_timeslice(cit, timeslices) != 0) {
+      ++valid;
+      continue;
+    }
+    ++invalid;
+    auto max_vertex = 0;
+    for (auto i = 1; i < 4; ++i) {
+      if (cit->vertex(i)->info() > cit->vertex(max_vertex)->info())
+        max_vertex = i;
+    }
+    deleted_vertices.emplace(cit->vertex(max_vertex));
+  }
+
+  for (const auto& vertex : deleted_vertices) triangulation.remove(vertex);
+
+#ifndef NDEBUG
+  std::cout << "There are " << invalid << " invalid simplices and " << valid
+            << " valid simplices." << std::endl;
+#endif
+  return invalid == 0;
+}  // fix_toroidal_timeslices()
+
+/// @brief Make a triangulation from foliated 2-tori
+///
+/// The points of make_foliated_torus() are inserted into a periodic
+/// Delaunay triangulation of the unit cube, and each vertex is given the
+/// timevalue of its height. fix_toroidal_timeslices() then removes
+/// vertices of badly foliated cells, up to MAX_FOLIATION_FIX_PASSES times.
+///
+/// @param simplices  The number of desired simplices in the triangulation
+/// @param timeslices The number of timeslices in the triangulation
+/// @return A std::unique_ptr<T3Delaunay> to the foliated triangulation, as
+/// a 1-sheeted covering
+inline auto make_toroidal_triangulation(const std::intmax_t simplices,
+                                        const std::intmax_t timeslices) {
+  std::cout << "Generating toroidal universe ... " << std::endl;
+  Trace_span span("make_toroidal_triangulation", "generation");
+  check_toroidal_timeslices(timeslices);
+
+  auto triangulation = std::make_unique<T3Delaunay>(
+      T3Delaunay::Iso_cuboid(0, 0, 0, 1, 1, 1));
+  auto points = make_foliated_torus(simplices, timeslices);
+  {
+    Trace_span insertion("Insert vertices", "generation");
+    triangulation->insert(points.begin(), points.end(), true);
+  }
+
+  auto check_1_sheet = [&triangulation] {
+    if (!triangulation->is_triangulation_in_1_sheet())
+      throw std::domain_error(
+          "Too few points for a 1-sheeted toroidal triangulation.");
+    triangulation->convert_to_1_sheeted_covering();
+  };
+  check_1_sheet();
+
+  // Heights are exact multiples of 1 / timeslices
+  const auto& tds = triangulation->tds();
+  for (auto vit = tds.vertices_begin(); vit != tds.vertices_end(); ++vit) {
+    vit->info() =
+        std::lround(vit->point().z() * static_cast<double>(timeslices)) %
+            timeslices +
+        1;
+  }
+
+  for (std::intmax_t pass = 0; pass < MAX_FOLIATION_FIX_PASSES; ++pass) {
+    Trace_span fix("Fix pass", "generation", pass + 1);
+    auto       fixed = fix_toroidal_timeslices(*triangulation, timeslices);
+    check_1_sheet();
+    if (fixed) return triangulation;
+  }
+  throw std::logic_error("Toroidal triangulation not correctly foliated.");
+}  // make_toroidal_triangulation()
+
+#endif  // SRC_T3TRIANGULATION_H_
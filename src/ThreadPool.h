@@ -0,0 +1,447 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// One work-stealing pool of threads shared by every part of a run.
+///
+/// Point generation, the optimistic Metropolis engine, spectral dimension
+/// measurements, and parameter sweeps all submit tasks to
+/// Thread_pool::instance() instead of starting threads of their own, so
+/// however they are combined the run never has more busy threads than the
+/// pool. Each worker keeps a deque of tasks, runs its newest, and steals
+/// the oldest of another worker's when its own is empty. The thread calling
+/// parallel_for() works through the loop itself, so tasks may themselves
+/// call parallel_for() without tying up the pool: if no worker is free, the
+/// caller does the whole loop. It never picks up unrelated tasks while it
+/// waits, since one of those might block on something it has yet to do.
+///
+/// The pool has one worker per CPU the process may run on, which under
+/// Slurm or taskset is the allocation rather than the whole machine, unless
+/// configure() sets another size first. On Linux, workers are pinned to
+/// those CPUs, dealt out across NUMA nodes in turn, and an idle worker
+/// steals from workers on its own node before reaching across to another.
+/// Memory a task allocates and first writes is placed on its worker's node
+/// by the kernel, so a task that builds and then sweeps its own data, like
+/// a sweep run, keeps it local.
+///
+/// \done Work-stealing deques
+/// \done parallel_for() that works through its own loop while it waits
+/// \done Pin workers to the CPUs the process may run on
+/// \done Spread workers over NUMA nodes and steal from the nearest first
+
+/// @file ThreadPool.h
+/// @brief A shared work-stealing thread pool
+/// @author Adam Getchell
+
+#ifndef SRC_THREADPOOL_H_
+#define SRC_THREADPOOL_H_
+
+// C headers
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// C++ headers
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>  // NOLINT
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// @return The CPUs this process may run on
+inline std::vector<unsigned> available_cpus() {
+  std::vector<unsigned> cpus;
+#ifdef __linux__
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+    for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &mask)) cpus.emplace_back(cpu);
+    }
+  }
+#endif
+  if (cpus.empty()) {
+    const auto hardware = std::max(std::thread::hardware_concurrency(), 1u);
+    for (unsigned cpu = 0; cpu < hardware; ++cpu) cpus.emplace_back(cpu);
+  }
+  return cpus;
+}  // available_cpus()
+
+/// @brief Parse a Linux CPU or node list, such as "0-3,8-11"
+/// @param list The list
+/// @return The numbers in **list**
+inline std::vector<unsigned> parse_cpu_list(const std::string& list) {
+  std::vector<unsigned> numbers;
+  std::stringstream     ranges(list);
+  std::string           range;
+  while (std::getline(ranges, range, ',')) {
+    if (range.find_first_of("0123456789") == std::string::npos) continue;
+    const auto dash  = range.find('-');
+    const auto first = static_cast<unsigned>(std::stoul(range.substr(0, dash)));
+    const auto last =
+        dash == std::string::npos
+            ? first
+            : static_cast<unsigned>(std::stoul(range.substr(dash + 1)));
+    for (auto n = first; n <= last; ++n) numbers.emplace_back(n);
+  }
+  return numbers;
+}  // parse_cpu_list()
+
+/// @return The CPUs this process may run on, grouped by NUMA node
+inline std::vector<std::vector<unsigned>> numa_nodes() {
+  auto cpus = available_cpus();
+  std::vector<std::vector<unsigned>> nodes;
+#ifdef __linux__
+  const std::string sysfs{"/sys/devices/system/node/"};
+  std::ifstream     online(sysfs + "online");
+  std::string       list;
+  if (std::getline(online, list)) {
+    for (auto node : parse_cpu_list(list)) {
+      std::ifstream node_cpus(sysfs + "node" + std::to_string(node) +
+                              "/cpulist");
+      if (!std::getline(node_cpus, list)) continue;
+      std::vector<unsigned> allowed;
+      for (auto cpu : parse_cpu_list(list)) {
+        auto found = std::find(cpus.begin(), cpus.end(), cpu);
+        if (found == cpus.end()) continue;
+        allowed.emplace_back(cpu);
+        cpus.erase(found);
+      }
+      if (!allowed.empty()) nodes.emplace_back(std::move(allowed));
+    }
+  }
+#endif
+  // CPUs no node claims, or every CPU if there is no NUMA information
+  if (!cpus.empty()) nodes.emplace_back(std::move(cpus));
+  return nodes;
+}  // numa_nodes()
+
+/// @class Thread_pool
+/// @brief A fixed set of worker threads running submitted tasks
+class Thread_pool {
+ public:
+  using Task = std::function<void()>;
+
+  /// @brief Start the workers
+  /// @param threads Number of workers; 0 for one per available CPU
+  /// @param pin Whether to pin each worker to an available CPU
+  explicit Thread_pool(unsigned threads = 0, const bool pin = true) {
+    const auto nodes = numa_nodes();
+    if (threads == 0) {
+      for (const auto& node : nodes) threads += node.size();
+    }
+    nodes_ = std::min<std::size_t>(nodes.size(), threads);
+
+    // Deal workers out over the nodes, then order each one's victims
+    queues_ = std::vector<Worker_queue>(threads);
+    worker_nodes_.resize(threads);
+    for (unsigned t = 0; t < threads; ++t) worker_nodes_[t] = t % nodes_;
+    steal_order_.resize(threads);
+    for (std::size_t t = 0; t < threads; ++t) {
+      for (std::size_t n = 0; n < threads; ++n) {
+        steal_order_[t].emplace_back((t + n) % threads);
+      }
+      std::stable_partition(
+          steal_order_[t].begin(), steal_order_[t].end(),
+          [this, t](const std::size_t victim) {
+            return worker_nodes_[victim] == worker_nodes_[t];
+          });
+    }
+
+    workers_.reserve(threads);
+    for (unsigned t = 0; t < threads; ++t) {
+      workers_.emplace_back([this, t] { work(t); });
+#ifdef __linux__
+      if (pin) {
+        const auto& cpus = nodes[worker_nodes_[t]];
+        cpu_set_t   mask;
+        CPU_ZERO(&mask);
+        CPU_SET(cpus[(t / nodes_) % cpus.size()], &mask);
+        pthread_setaffinity_np(workers_.back().native_handle(), sizeof(mask),
+                               &mask);
+      }
+#else
+      static_cast<void>(pin);
+#endif
+    }
+  }
+
+  Thread_pool(const Thread_pool&) = delete;
+  Thread_pool& operator=(const Thread_pool&) = delete;
+
+  /// @brief Finish the queued tasks and stop the workers
+  ~Thread_pool() {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) worker.join();
+  }
+
+  /// @brief Set the size of the process-wide pool
+  ///
+  /// Must be called before the first call to instance().
+  ///
+  /// @param threads Number of workers; 0 for one per available CPU
+  /// @param pin Whether to pin each worker to an available CPU
+  static void configure(const unsigned threads, const bool pin = true) {
+    auto& settings = instance_settings();
+    if (settings.started)
+      throw std::logic_error("The thread pool is already running.");
+    settings.threads = threads;
+    settings.pin     = pin;
+  }
+
+  /// @brief The process-wide pool
+  static Thread_pool& instance() {
+    static Thread_pool pool = [] {
+      auto& settings   = instance_settings();
+      settings.started = true;
+      return Thread_pool(settings.threads, settings.pin);
+    }();
+    return pool;
+  }
+
+  /// @brief Gets the number of workers.
+  /// @return The number of workers
+  auto size() const noexcept { return static_cast<unsigned>(workers_.size()); }
+
+  /// @brief Gets the number of NUMA nodes the workers are spread over.
+  /// @return The number of nodes
+  auto nodes() const noexcept { return nodes_; }
+
+  /// @return The NUMA node of the worker running on this thread, or 0 if
+  /// it isn't one of this pool's workers
+  std::size_t current_node() const noexcept {
+    const auto index = current_worker();
+    return index < worker_nodes_.size() ? worker_nodes_[index] : 0;
+  }
+
+  /// @brief Queue a task
+  /// @tparam F A callable taking no arguments
+  /// @param task The task
+  /// @return A future for the result of **task**
+  template <typename F>
+  auto submit(F&& task) {
+    using Result  = std::invoke_result_t<std::decay_t<F>&>;
+    auto packaged = std::make_shared<std::packaged_task<Result()>>(
+        std::forward<F>(task));
+    auto result = packaged->get_future();
+    push([packaged] { (*packaged)(); });
+    return result;
+  }
+
+  /// @brief Wait for a future
+  ///
+  /// Other tasks aren't run meanwhile, so a task should only wait for
+  /// tasks that can't be queued behind it; use parallel_for() instead.
+  ///
+  /// @tparam T The type of the result
+  /// @param result The future
+  /// @return The result
+  template <typename T>
+  T wait(std::future<T>& result) {
+    return result.get();
+  }
+
+  /// @brief Call **body** on each index in [**begin**, **end**)
+  ///
+  /// Indices are shared among at most **tasks** tasks, including the
+  /// calling thread, as they finish. Once the caller runs out of indices it
+  /// waits only for helpers already running; helpers that start later
+  /// find the loop closed and return. The first exception thrown by
+  /// **body** is rethrown once every task has stopped.
+  ///
+  /// @tparam F A callable taking a std::size_t
+  /// @param begin The first index
+  /// @param end One past the last index
+  /// @param body The loop body
+  /// @param tasks Most tasks to run at once; 0 for one per worker
+  template <typename F>
+  void parallel_for(const std::size_t begin, const std::size_t end, F&& body,
+                    std::size_t tasks = 0) {
+    if (begin >= end) return;
+    if (tasks == 0) tasks = size();
+    tasks = std::max<std::size_t>(std::min(tasks, end - begin), 1);
+
+    std::atomic_size_t next{begin};
+    std::exception_ptr failure;
+    std::mutex         failure_mutex;
+    auto               loop = [&] {
+      try {
+        for (auto i = next++; i < end; i = next++) body(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(failure_mutex);
+        if (!failure) failure = std::current_exception();
+        next = end;
+      }
+    };
+
+    // Helpers may outlive this call, so they share only **state**, and
+    // touch the rest of this frame only while counted as running
+    auto state = std::make_shared<Loop_state>();
+    for (std::size_t t = 1; t < tasks; ++t) {
+      push([state, &loop] {
+        {
+          std::lock_guard<std::mutex> lock(state->mutex);
+          if (state->closed) return;
+          ++state->running;
+        }
+        loop();
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (--state->running == 0) state->finished.notify_all();
+      });
+    }
+    loop();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->closed = true;
+    state->finished.wait(lock, [&state] { return state->running == 0; });
+    lock.unlock();
+    if (failure) std::rethrow_exception(failure);
+  }
+
+ private:
+  /// @brief Settings for instance()
+  struct Settings {
+    unsigned threads{0};
+    bool     pin{true};
+    bool     started{false};
+  };
+
+  /// @brief Helpers of one parallel_for()
+  struct Loop_state {
+    std::mutex              mutex;
+    std::condition_variable finished;
+    std::size_t             running{0};
+    bool                    closed{false};
+  };
+
+  /// @brief A worker's tasks, newest at the back
+  struct Worker_queue {
+    std::mutex       mutex;
+    std::deque<Task> tasks;
+  };
+
+  static Settings& instance_settings() {
+    static Settings settings;
+    return settings;
+  }
+
+  /// @return The index of the worker of this pool running on this thread,
+  /// or size() if there is none
+  std::size_t current_worker() const noexcept {
+    return current_pool() == this ? current_index() : queues_.size();
+  }
+
+  static const Thread_pool*& current_pool() noexcept {
+    thread_local const Thread_pool* pool{nullptr};
+    return pool;
+  }
+
+  static std::size_t& current_index() noexcept {
+    thread_local std::size_t index{0};
+    return index;
+  }
+
+  /// @brief Queue a task on this thread's worker, or spread tasks from
+  /// other threads over the workers
+  void push(Task task) {
+    auto index = current_worker();
+    if (index == queues_.size()) index = next_queue_++ % queues_.size();
+    // Count the task first, so that whoever takes it never sees none
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      ++pending_;
+    }
+    {
+      std::lock_guard<std::mutex> lock(queues_[index].mutex);
+      queues_[index].tasks.emplace_back(std::move(task));
+    }
+    wake_.notify_one();
+  }
+
+  /// @brief Take the newest task of worker **index**, or else steal the
+  /// oldest task of another, on the same node if possible
+  bool take(const std::size_t index, Task& task) {
+    for (const auto victim : steal_order_[index]) {
+      auto& queue = queues_[victim];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.tasks.empty()) continue;
+      if (victim == index) {
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+      } else {
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+      }
+      --pending_;
+      return true;
+    }
+    return false;
+  }
+
+  /// @brief The loop of worker **index**
+  void work(const std::size_t index) {
+    current_pool()  = this;
+    current_index() = index;
+    for (;;) {
+      Task task;
+      if (take(index, task)) {
+        task();
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(sleep_mutex_);
+      wake_.wait(lock, [this] { return stopping_ || pending_ > 0; });
+      if (stopping_ && pending_ == 0) return;
+    }
+  }
+
+  /// @brief One deque of tasks per worker
+  std::vector<Worker_queue> queues_;
+
+  /// @brief The workers
+  std::vector<std::thread> workers_;
+
+  /// @brief Number of NUMA nodes with workers
+  std::size_t nodes_{1};
+
+  /// @brief The NUMA node of each worker
+  std::vector<std::size_t> worker_nodes_;
+
+  /// @brief The queues each worker tries in turn, itself and then its own
+  /// node first
+  std::vector<std::vector<std::size_t>> steal_order_;
+
+  /// @brief Where the next task from outside the pool goes
+  std::atomic_size_t next_queue_{0};
+
+  /// @brief Tasks queued and not yet taken
+  std::atomic_size_t pending_{0};
+
+  /// @brief Guards sleeping on **wake_**
+  std::mutex sleep_mutex_;
+
+  /// @brief Signalled when a task is queued or the pool stops
+  std::condition_variable wake_;
+
+  /// @brief Whether the pool is stopping
+  bool stopping_{false};
+};
+
+#endif  // SRC_THREADPOOL_H_
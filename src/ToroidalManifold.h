@@ -0,0 +1,250 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Data structures for operations on toroidal manifolds
+///
+/// A ToroidalManifold is used wherever a SimplicialManifold is: the
+/// Metropolis algorithm, MoveManager, Simulation, and trajectories work on
+/// either through the overloads of reclassify(), is_foliated(), cell_type(),
+/// VolumePerTimeslice(), print_results(), and make_snapshot() below.
+///
+/// \done ToroidalManifold with periodic time
+/// \done Copies reclassify their own triangulation
+
+/// @file  ToroidalManifold.h
+/// @brief Data structures for toroidal manifolds
+/// @author Adam Getchell
+
+#ifndef SRC_TOROIDALMANIFOLD_H_
+#define SRC_TOROIDALMANIFOLD_H_
+
+#include <map>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "FlipIndex.h"
+#include "SimplicialManifold.h"
+#include "Snapshot.h"
+#include "T3Triangulation.h"
+#include "Trace.h"
+
+using T3GeometryInfo = Basic_geometry_info<T3Delaunay>;
+
+/// @struct
+/// @brief A struct to hold a toroidal triangulation and geometry information
+///
+/// Unlike SimplicialManifold, copies reclassify the copied triangulation so
+/// that their geometry never refers to cells of the original.
+struct ToroidalManifold {
+  /// @brief Topology of the foliation
+  static constexpr topology_type TOPOLOGY = topology_type::TOROIDAL;
+
+  /// @brief std::unique_ptr to the periodic Delaunay triangulation
+  std::unique_ptr<T3Delaunay> triangulation;
+
+  /// @brief std::unique_ptr to T3GeometryInfo{}
+  std::unique_ptr<T3GeometryInfo> geometry;
+
+  /// @brief Facets on which a (2,3) move can be made
+  ///
+  /// Built by make_23_move() on first use, and kept current by each move
+  /// after that. Copies rebuild their own.
+  boost::optional<Flip_index<T3Cell_handle>> flippable_facets;
+
+  /// @brief Incident cell counts of edges, and edges on which a (3,2) move
+  /// can be made
+  ///
+  /// Built by make_32_move() on first use, and kept current by each move
+  /// after that.
+  boost::optional<Edge_index<T3Vertex_handle>> flippable_edges;
+
+  /// @brief Number of timeslices in periodic time
+  std::intmax_t timeslices{0};
+
+  /// @brief Default constructor
+  /// @return An empty ToroidalManifold{}
+  ToroidalManifold()
+      : triangulation{std::make_unique<T3Delaunay>()}
+      , geometry{std::make_unique<T3GeometryInfo>()} {}
+
+  /// @brief Constructor with std::unique_ptr<T3Delaunay>
+  /// @param manifold A foliated 1-sheeted covering, usually made by
+  /// make_toroidal_triangulation()
+  /// @param number_of_timeslices The number of timeslices in **manifold**
+  /// @return A ToroidalManifold{}
+  ToroidalManifold(std::unique_ptr<T3Delaunay>&& manifold,
+                   const std::intmax_t           number_of_timeslices)
+      : triangulation{std::move(manifold)}
+      , geometry{std::make_unique<T3GeometryInfo>(
+            classify_toroidal_simplices(*triangulation,
+                                        number_of_timeslices))}
+      , timeslices{number_of_timeslices} {}
+
+  /// @brief make_toroidal_triangulation constructor
+  /// @param simplices The number of desired simplices in the triangulation
+  /// @param number_of_timeslices The number of timeslices in the
+  /// triangulation
+  /// @return A populated ToroidalManifold{}
+  ToroidalManifold(const std::intmax_t simplices,
+                   const std::intmax_t number_of_timeslices)
+      : ToroidalManifold(
+            make_toroidal_triangulation(simplices, number_of_timeslices),
+            number_of_timeslices) {}
+
+  /// @brief Copy constructor
+  /// @param other The ToroidalManifold to copy
+  /// @return A copied and reclassified ToroidalManifold{}
+  ToroidalManifold(const ToroidalManifold& other)
+      : triangulation{std::make_unique<T3Delaunay>(*(other.triangulation))}
+      , geometry{std::make_unique<T3GeometryInfo>(
+            classify_toroidal_simplices(*triangulation, other.timeslices))}
+      , timeslices{other.timeslices} {
+#ifndef NDEBUG
+    std::cout << "ToroidalManifold copy ctor." << std::endl;
+#endif
+  }
+
+  /// @brief Default move constructor
+  ///
+  /// The triangulation itself isn't moved, so **geometry** stays valid.
+  ToroidalManifold(ToroidalManifold&&) = default;
+
+  /// @brief Default move assignment operator
+  /// @return A move-assigned ToroidalManifold{}
+  ToroidalManifold& operator=(ToroidalManifold&&) = default;
+
+  /// @brief Default destructor
+  ~ToroidalManifold() = default;
+
+  /// @brief Exception-safe swap
+  /// @param first  The first ToroidalManifold to be swapped
+  /// @param second The second ToroidalManifold to be swapped with.
+  friend void swap(ToroidalManifold& first, ToroidalManifold& second) {
+    using std::swap;
+    swap(first.triangulation, second.triangulation);
+    swap(first.geometry, second.geometry);
+    swap(first.flippable_facets, second.flippable_facets);
+    swap(first.flippable_edges, second.flippable_edges);
+    swap(first.timeslices, second.timeslices);
+  }
+};
+
+/// @brief Recalculate the geometry of a ToroidalManifold after a move
+/// @param universe The ToroidalManifold
+inline void reclassify(ToroidalManifold& universe) {
+  universe.geometry = std::make_unique<T3GeometryInfo>(
+      classify_toroidal_simplices(*universe.triangulation,
+                                  universe.timeslices));
+}  // reclassify()
+
+/// @brief Whether a cell of a ToroidalManifold is correctly foliated
+/// @param universe The ToroidalManifold
+/// @param cell A cell of its triangulation
+/// @return **True** if the cell spans adjacent timeslices in periodic time
+inline bool is_foliated(const ToroidalManifold& universe,
+                        const T3Cell_handle&    cell) {
+  return lower_timeslice(cell, universe.timeslices) != 0;
+}  // is_foliated()
+
+/// @brief The type of a cell of a ToroidalManifold
+/// @param universe The ToroidalManifold
+/// @param cell A cell of its triangulation
+/// @return 31, 22, or 13 by the number of its vertices on its lower
+/// timeslice, or 0 if it doesn't span adjacent timeslices
+inline std::int8_t cell_type(const ToroidalManifold& universe,
+                             const T3Cell_handle&    cell) {
+  auto lower = lower_timeslice(cell, universe.timeslices);
+  if (lower == 0) return 0;
+  auto on_lower = 0;
+  for (auto i = 0; i < 4; ++i) {
+    if (cell->vertex(i)->info() == lower) ++on_lower;
+  }
+  return Foliation<DIMENSION>::simplex_type(on_lower);
+}  // cell_type()
+
+/// @brief Print out runtime results of a ToroidalManifold
+/// @param universe The ToroidalManifold
+inline void print_results(const ToroidalManifold& universe) noexcept {
+  const auto& tds = universe.triangulation->tds();
+  std::cout << tds.number_of_vertices() << " vertices and "
+            << tds.number_of_edges() << " edges and "
+            << tds.number_of_facets() << " faces\n"
+            << "and " << tds.number_of_cells() << " cells." << std::endl;
+}  // print_results()
+
+/// @brief Count spacelike facets per timeslice of a ToroidalManifold
+///
+/// As VolumePerTimeslice() on a SimplicialManifold; every facet of a
+/// 1-sheeted covering is finite.
+///
+/// @param manifold The ToroidalManifold
+/// @return The **manifold** with its spacelike facets and timevalues saved
+inline auto VolumePerTimeslice(ToroidalManifold& manifold)
+    -> decltype(manifold) {
+#ifndef NDEBUG
+  std::cout << __PRETTY_FUNCTION__ << " called." << std::endl;
+#endif
+  Trace_span span("VolumePerTimeslice", "measurement");
+
+  print_results(manifold);
+
+  std::multimap<intmax_t, T3GeometryInfo::Facet> spacelike_facets;
+  const auto& tds = manifold.triangulation->tds();
+  for (auto fit = tds.facets_begin(); fit != tds.facets_end(); ++fit) {
+    std::set<intmax_t> facet_timevalues;
+    for (auto i = 0; i < 4; ++i) {
+      if (i != fit->second)
+        facet_timevalues.insert(fit->first->vertex(i)->info());
+    }
+    if (facet_timevalues.size() == 1)
+      spacelike_facets.insert({*facet_timevalues.begin(), *fit});
+  }
+
+  std::set<intmax_t> timevalues;
+  for (const auto& item : manifold.geometry->vertices) {
+    timevalues.insert(item->info());
+  }
+
+  for (const auto& timevalue : timevalues) {
+    std::cout << "Timeslice " << timevalue << " has "
+              << spacelike_facets.count(timevalue) << " spacelike faces."
+              << std::endl;
+  }
+
+  manifold.geometry->timevalues       = timevalues;
+  manifold.geometry->spacelike_facets = spacelike_facets;
+  return manifold;
+}  // VolumePerTimeslice()
+
+/// @brief Make a Snapshot of a ToroidalManifold
+///
+/// Every vertex and cell of a 1-sheeted covering is finite, so the
+/// Snapshot has no infinite cells.
+///
+/// @param universe A ToroidalManifold
+/// @return The Snapshot of **universe**
+inline auto make_snapshot(const ToroidalManifold& universe) {
+#ifndef NDEBUG
+  std::cout << __PRETTY_FUNCTION__ << " called." << std::endl;
+#endif
+  const auto& tds = universe.triangulation->tds();
+
+  std::vector<T3Vertex_handle> vertices;
+  vertices.reserve(tds.number_of_vertices());
+  for (auto vit = tds.vertices_begin(); vit != tds.vertices_end(); ++vit) {
+    vertices.emplace_back(vit);
+  }
+
+  std::vector<T3Cell_handle> cells;
+  cells.reserve(tds.number_of_cells());
+  for (auto cit = tds.cells_begin(); cit != tds.cells_end(); ++cit) {
+    cells.emplace_back(cit);
+  }
+
+  return snapshot_of(vertices, cells, [](const auto&) { return false; });
+}  // make_snapshot()
+
+#endif  // SRC_TOROIDALMANIFOLD_H_
@@ -0,0 +1,334 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Timestamped spans written as a Chrome trace, viewable in
+/// chrome://tracing or https://ui.perfetto.dev. Each thread records
+/// completed spans into its own lock-free single-producer, single-consumer
+/// ring buffer; a background thread drains the buffers and writes them to
+/// the trace file, so recording a span never waits on I/O. Tracing is
+/// enabled at runtime with Tracer::start(); when it is off, a span costs
+/// one atomic load.
+///
+/// \done Per-thread SPSC ring buffers
+/// \done Asynchronous flushing to Chrome trace event JSON
+/// \done Trace_span RAII spans
+
+/// @file Trace.h
+/// @brief Chrome trace export of simulation phases
+/// @author Adam Getchell
+
+#ifndef SRC_TRACE_H_
+#define SRC_TRACE_H_
+
+// C++ headers
+#include <array>
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <stdexcept>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+/// Value of Trace_event::value for spans without an argument
+static constexpr std::intmax_t TRACE_NO_VALUE =
+    std::numeric_limits<std::intmax_t>::min();
+
+/// Number of events each thread can buffer before the flusher drains them
+static constexpr std::size_t TRACE_BUFFER_CAPACITY = 1 << 14;
+
+/// How often the flusher drains the buffers
+static constexpr std::chrono::milliseconds TRACE_FLUSH_INTERVAL{50};
+
+/// @struct
+/// @brief A completed span
+///
+/// **name** and **category** must be string literals (or otherwise outlive
+/// the trace), since only the pointers are buffered.
+struct Trace_event {
+  /// @brief Name of the span
+  const char* name;
+
+  /// @brief Category of the span
+  const char* category;
+
+  /// @brief Start time in nanoseconds since the trace started
+  std::int64_t start;
+
+  /// @brief Duration in nanoseconds
+  std::int64_t duration;
+
+  /// @brief Optional argument, such as a pass number, or TRACE_NO_VALUE
+  std::intmax_t value;
+
+  /// @brief Trace-local id of the recording thread
+  std::uint32_t thread;
+};
+
+/// @class Trace_buffer
+/// @brief Fixed-size single-producer, single-consumer ring of Trace_events
+///
+/// The recording thread is the only producer and the flusher the only
+/// consumer. When the ring is full, new events are dropped and counted
+/// rather than blocking the producer.
+class Trace_buffer {
+ private:
+  /// @brief Event storage
+  std::array<Trace_event, TRACE_BUFFER_CAPACITY> events_;
+
+  /// @brief Next slot to write; advanced only by the producer
+  alignas(64) std::atomic_size_t head_{0};
+
+  /// @brief Next slot to read; advanced only by the consumer
+  alignas(64) std::atomic_size_t tail_{0};
+
+  /// @brief Events dropped because the ring was full
+  std::atomic_uintmax_t dropped_{0};
+
+ public:
+  /// @brief Id of the owning thread in the trace
+  std::uint32_t thread{0};
+
+  /// @brief Append an event (producer only)
+  /// @param event The completed span
+  /// @return **True** if there was room for the event
+  bool push(const Trace_event& event) noexcept {
+    auto head = head_.load(std::memory_order_relaxed);
+    auto tail = tail_.load(std::memory_order_acquire);
+    if (head - tail == TRACE_BUFFER_CAPACITY) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    events_[head % TRACE_BUFFER_CAPACITY] = event;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// @brief Remove all buffered events (consumer only)
+  /// @tparam Function Callable taking a const Trace_event&
+  /// @param consume Called on each event, oldest first
+  /// @return The number of events drained
+  template <typename Function>
+  std::size_t drain(Function&& consume) {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    auto head = head_.load(std::memory_order_acquire);
+    for (auto i = tail; i != head; ++i) {
+      consume(events_[i % TRACE_BUFFER_CAPACITY]);
+    }
+    tail_.store(head, std::memory_order_release);
+    return head - tail;
+  }
+
+  /// @brief Events dropped so far
+  auto dropped() const noexcept {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+};
+
+/// @class Tracer
+/// @brief Process-wide trace writer
+class Tracer {
+ private:
+  /// @brief Whether spans are being recorded
+  std::atomic_bool enabled_{false};
+
+  /// @brief Incremented by each start(), so threads re-register their buffers
+  std::atomic_uintmax_t generation_{0};
+
+  /// @brief Protects buffers_, file_, and stopping_
+  std::mutex mutex_;
+
+  /// @brief Buffers of every thread that has recorded in this trace
+  std::vector<std::shared_ptr<Trace_buffer>> buffers_;
+
+  /// @brief The trace file
+  std::ofstream file_;
+
+  /// @brief Whether an event has been written, for comma placement
+  bool wrote_event_{false};
+
+  /// @brief Tells the flusher to finish
+  bool stopping_{false};
+
+  /// @brief Wakes the flusher early when stopping
+  std::condition_variable wake_;
+
+  /// @brief Background thread draining buffers_ into file_
+  std::thread flusher_;
+
+  /// @brief Time zero of the trace
+  std::chrono::steady_clock::time_point epoch_;
+
+  /// @brief Write one event as Chrome trace JSON (mutex_ held)
+  void write(const Trace_event& event) {
+    file_ << (wrote_event_ ? ",\n" : "\n") << R"({"name":")" << event.name
+          << R"(","cat":")" << event.category << R"(","ph":"X","ts":)"
+          << static_cast<double>(event.start) / 1000.0
+          << R"(,"dur":)" << static_cast<double>(event.duration) / 1000.0
+          << R"(,"pid":1,"tid":)" << event.thread;
+    if (event.value != TRACE_NO_VALUE) {
+      file_ << R"(,"args":{"value":)" << event.value << "}";
+    }
+    file_ << "}";
+    wrote_event_ = true;
+  }
+
+  /// @brief Drain every buffer into file_ (mutex_ held)
+  void drain_all() {
+    for (auto& buffer : buffers_) {
+      buffer->drain([this](const Trace_event& event) { write(event); });
+    }
+  }
+
+  /// @brief Flusher thread body
+  void flush_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+      wake_.wait_for(lock, TRACE_FLUSH_INTERVAL);
+      drain_all();
+      file_.flush();
+    }
+  }
+
+  /// @brief Create and register a buffer for the calling thread
+  std::shared_ptr<Trace_buffer> register_buffer() {
+    auto                        buffer = std::make_shared<Trace_buffer>();
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffer->thread = static_cast<std::uint32_t>(buffers_.size());
+    buffers_.push_back(buffer);
+    return buffer;
+  }
+
+  Tracer() = default;
+
+ public:
+  Tracer(const Tracer&) = delete;
+  Tracer& operator=(const Tracer&) = delete;
+
+  /// @brief Stops any running trace
+  ~Tracer() { stop(); }
+
+  /// @brief The process-wide tracer
+  static Tracer& instance() {
+    static Tracer tracer;
+    return tracer;
+  }
+
+  /// @brief Start writing a trace
+  /// @param filename The trace file to create
+  void start(const std::string& filename) {
+    if (enabled()) throw std::logic_error("A trace is already running.");
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      file_.open(filename, std::ios::out | std::ios::trunc);
+      if (!file_.is_open())
+        throw std::runtime_error("Unable to open trace file " + filename);
+      file_ << "[";
+      buffers_.clear();
+      wrote_event_ = false;
+      stopping_    = false;
+      epoch_       = std::chrono::steady_clock::now();
+    }
+    ++generation_;
+    flusher_ = std::thread(&Tracer::flush_loop, this);
+    enabled_.store(true, std::memory_order_release);
+    std::cout << "Tracing to " << filename << std::endl;
+  }
+
+  /// @brief Stop tracing, write the remaining events, and close the file
+  ///
+  /// Spans still open when the trace stops are not recorded.
+  void stop() {
+    if (!enabled_.exchange(false)) return;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    wake_.notify_one();
+    flusher_.join();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    drain_all();
+    file_ << "\n]\n";
+    file_.close();
+    std::uintmax_t dropped{0};
+    for (const auto& buffer : buffers_) dropped += buffer->dropped();
+    if (dropped > 0) {
+      std::cerr << "Trace dropped " << dropped << " events." << std::endl;
+    }
+  }
+
+  /// @brief Whether a trace is running
+  bool enabled() const noexcept {
+    return enabled_.load(std::memory_order_acquire);
+  }
+
+  /// @brief Nanoseconds since the trace started
+  std::int64_t now() const {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - epoch_)
+        .count();
+  }
+
+  /// @brief Buffer a completed span from the calling thread
+  /// @param event The span; its **thread** is filled in here
+  void record(Trace_event event) {
+    thread_local std::shared_ptr<Trace_buffer> buffer;
+    thread_local std::uintmax_t                generation{0};
+    if (generation != generation_.load(std::memory_order_relaxed)) {
+      buffer     = register_buffer();
+      generation = generation_.load(std::memory_order_relaxed);
+    }
+    event.thread = buffer->thread;
+    buffer->push(event);
+  }
+};
+
+/// @class Trace_span
+/// @brief Records a span from construction to destruction
+class Trace_span {
+ private:
+  /// @brief Name of the span
+  const char* name_;
+
+  /// @brief Category of the span
+  const char* category_;
+
+  /// @brief Optional argument
+  std::intmax_t value_;
+
+  /// @brief Start time, or -1 if tracing was off
+  std::int64_t start_;
+
+ public:
+  /// @brief Open a span
+  /// @param name Name of the span, a string literal
+  /// @param category Category of the span, a string literal
+  /// @param value Optional argument, such as a pass number
+  Trace_span(const char* name, const char* category,
+             const std::intmax_t value = TRACE_NO_VALUE)
+      : name_{name}
+      , category_{category}
+      , value_{value}
+      , start_{Tracer::instance().enabled() ? Tracer::instance().now() : -1} {}
+
+  Trace_span(const Trace_span&) = delete;
+  Trace_span& operator=(const Trace_span&) = delete;
+
+  /// @brief Close the span
+  ~Trace_span() {
+    auto& tracer = Tracer::instance();
+    if (start_ < 0 || !tracer.enabled()) return;
+    tracer.record(Trace_event{name_, category_, start_, tracer.now() - start_,
+                              value_, 0});
+  }
+};
+
+#endif  // SRC_TRACE_H_
@@ -0,0 +1,534 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Trajectory files: many configurations of one run appended to a single
+/// file, instead of one CGAL text dump per checkpoint. Each frame is a
+/// Snapshot and the move statistics at a pass, packed compactly:
+///
+/// - vertex timevalues are run-length encoded, since Snapshots number
+///   vertices timeslice-major
+/// - cell vertices are delta-encoded against the first vertex of the cell,
+///   and first vertices against the previous cell's, since Snapshots sort
+///   cells by their lowest vertex along a space-filling curve
+/// - cell neighbors are delta-encoded against the cell's own index
+/// - all integers are zigzag LEB128 varints; coordinates stay raw doubles
+///
+/// When built with -DZSTD:BOOL=ON, each packed frame is further compressed
+/// with zstd. Readers index the file by hopping from frame header to frame
+/// header, so any frame can be read directly. A frame cut short by a crash
+/// is ignored, and cut off when the trajectory is next opened for writing.
+///
+/// \done Append-only trajectory files with packed frames
+/// \done Optional zstd compression
+/// \done Random access to frames
+
+/// @file Trajectory.h
+/// @brief Compressed trajectories of configurations
+/// @author Adam Getchell
+
+#ifndef SRC_TRAJECTORY_H_
+#define SRC_TRAJECTORY_H_
+
+// POSIX headers
+#include <unistd.h>
+
+// C++ headers
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <mutex>  // NOLINT
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef CDT_ZSTD
+#include <zstd.h>
+#endif
+
+// CDT headers
+#include "UniverseFile.h"
+
+/// Identifies a trajectory file
+static constexpr std::array<char, 8> TRAJECTORY_MAGIC{
+    {'C', 'D', 'T', 'T', 'R', 'A', 'J', '\0'}};
+
+/// Identifies the start of each frame
+static constexpr std::array<char, 4> TRAJECTORY_FRAME_MAGIC{
+    {'F', 'R', 'A', 'M'}};
+
+/// Layout version of trajectory files
+static constexpr std::uint32_t TRAJECTORY_VERSION = 1;
+
+/// zstd compression level of frames
+static constexpr int TRAJECTORY_ZSTD_LEVEL = 3;
+
+/// How a frame's payload is stored
+enum class trajectory_codec : std::uint32_t {
+  PACKED = 0,  ///< Packed varints, uncompressed
+  ZSTD         ///< Packed varints, compressed with zstd
+};
+
+/// @struct
+/// @brief Fixed header at the start of a trajectory file
+struct Trajectory_header {
+  std::array<char, 8> magic;
+  std::uint32_t       version;
+  std::uint32_t       byte_order;
+};
+
+/// @struct
+/// @brief Fixed header before each frame's payload
+struct Trajectory_frame_header {
+  std::array<char, 4> magic;
+  std::uint32_t       codec;
+  std::int64_t        pass;
+  std::int64_t        packed_size;
+  std::int64_t        stored_size;
+};
+
+static_assert(std::is_trivially_copyable<Trajectory_header>::value &&
+                  std::is_trivially_copyable<Trajectory_frame_header>::value,
+              "Trajectory headers are written byte for byte.");
+
+/// @brief Map a signed integer to an unsigned one with small magnitudes
+/// first: 0, -1, 1, -2, ...
+inline auto zigzag_encode(const std::int64_t value) noexcept {
+  return (static_cast<std::uint64_t>(value) << 1) ^
+         static_cast<std::uint64_t>(value >> 63);
+}  // zigzag_encode()
+
+/// @brief Invert zigzag_encode()
+inline auto zigzag_decode(const std::uint64_t value) noexcept {
+  return static_cast<std::int64_t>(value >> 1) ^
+         -static_cast<std::int64_t>(value & 1);
+}  // zigzag_decode()
+
+/// @class Frame_packer
+/// @brief Appends varints and raw values to a byte buffer
+class Frame_packer {
+ private:
+  std::vector<char> bytes_;
+
+ public:
+  /// @brief Append an unsigned LEB128 varint
+  void put(std::uint64_t value) {
+    while (value >= 0x80) {
+      bytes_.push_back(static_cast<char>(value | 0x80));
+      value >>= 7;
+    }
+    bytes_.push_back(static_cast<char>(value));
+  }
+
+  /// @brief Append a signed value as a zigzag varint
+  void put_signed(const std::int64_t value) { put(zigzag_encode(value)); }
+
+  /// @brief Append the raw bytes of a trivially copyable array
+  template <typename T>
+  void put_raw(const std::vector<T>& values) {
+    auto start = bytes_.size();
+    bytes_.resize(start + values.size() * sizeof(T));
+    if (!values.empty())
+      std::memcpy(&bytes_[start], values.data(), values.size() * sizeof(T));
+  }
+
+  /// @brief The packed bytes
+  auto& bytes() noexcept { return bytes_; }
+};
+
+/// @class Frame_unpacker
+/// @brief Reads what a Frame_packer wrote, checking bounds
+class Frame_unpacker {
+ private:
+  const std::vector<char>& bytes_;
+  std::size_t              position_{0};
+
+ public:
+  explicit Frame_unpacker(const std::vector<char>& bytes) : bytes_{bytes} {}
+
+  /// @brief Read an unsigned LEB128 varint
+  std::uint64_t get() {
+    std::uint64_t value{0};
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      if (position_ >= bytes_.size())
+        throw std::runtime_error("Trajectory frame is truncated.");
+      auto byte = static_cast<unsigned char>(bytes_[position_++]);
+      value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+      if (byte < 0x80) return value;
+    }
+    throw std::runtime_error("Trajectory frame has a bad varint.");
+  }
+
+  /// @brief Read a zigzag varint
+  std::int64_t get_signed() { return zigzag_decode(get()); }
+
+  /// @brief Read a count, checking it against what remains of the frame
+  /// @param bytes_per_item Minimum bytes each counted item occupies
+  std::size_t get_count(const std::size_t bytes_per_item) {
+    auto count = get();
+    if (count > (bytes_.size() - position_) / bytes_per_item)
+      throw std::runtime_error("Trajectory frame has a bad count.");
+    return static_cast<std::size_t>(count);
+  }
+
+  /// @brief Read the raw bytes of a trivially copyable array
+  template <typename T>
+  void get_raw(std::vector<T>& values, const std::size_t count) {
+    if (count > (bytes_.size() - position_) / sizeof(T))
+      throw std::runtime_error("Trajectory frame is truncated.");
+    values.resize(count);
+    if (count > 0)
+      std::memcpy(values.data(), &bytes_[position_], count * sizeof(T));
+    position_ += count * sizeof(T);
+  }
+};
+
+/// @brief Pack a Snapshot and move statistics into a frame payload
+/// @param snapshot The Snapshot
+/// @param attempted_moves Attempted moves so far
+/// @param successful_moves Successful moves so far
+/// @return The packed bytes
+inline auto pack_frame(const Snapshot& snapshot,
+                       const Move_tracker& attempted_moves,
+                       const Move_tracker& successful_moves) {
+  Frame_packer packer;
+  packer.put(static_cast<std::uint64_t>(snapshot.number_of_vertices()));
+  packer.put(static_cast<std::uint64_t>(snapshot.number_of_cells()));
+  packer.put(static_cast<std::uint64_t>(snapshot.number_of_finite_cells()));
+  for (auto moves : attempted_moves) packer.put_signed(moves);
+  for (auto moves : successful_moves) packer.put_signed(moves);
+
+  // Run-length encoded timevalues
+  std::vector<std::pair<std::intmax_t, std::uint64_t>> runs;
+  for (auto timevalue : snapshot.vertex_timevalues) {
+    if (runs.empty() || runs.back().first != timevalue) {
+      runs.emplace_back(timevalue, 0);
+    }
+    ++runs.back().second;
+  }
+  packer.put(runs.size());
+  for (const auto& run : runs) {
+    packer.put_signed(run.first);
+    packer.put(run.second);
+  }
+
+  packer.put_raw(snapshot.x);
+  packer.put_raw(snapshot.y);
+  packer.put_raw(snapshot.z);
+
+  Snapshot_index previous_first{0};
+  for (Snapshot_index c = 0; c < snapshot.number_of_cells(); ++c) {
+    auto first = snapshot.vertex(c, 0);
+    packer.put_signed(first - previous_first);
+    for (auto i = 1; i < 4; ++i) {
+      packer.put_signed(snapshot.vertex(c, i) - first);
+    }
+    previous_first = first;
+  }
+  for (Snapshot_index c = 0; c < snapshot.number_of_cells(); ++c) {
+    for (auto i = 0; i < 4; ++i) {
+      packer.put_signed(snapshot.neighbor(c, i) - c);
+    }
+  }
+  packer.put_raw(snapshot.cell_types);
+  return std::move(packer.bytes());
+}  // pack_frame()
+
+/// @brief Unpack a frame payload
+/// @param bytes The packed bytes
+/// @return The Snapshot and move statistics
+inline auto unpack_frame(const std::vector<char>& bytes) {
+  Frame_unpacker unpacker(bytes);
+  Universe_file  frame;
+  auto&          snapshot = frame.snapshot;
+  auto vertices     = unpacker.get_count(3 * sizeof(double));
+  auto cells        = unpacker.get_count(9);
+  auto finite_cells = unpacker.get();
+  if (finite_cells > cells)
+    throw std::runtime_error("Trajectory frame has a bad count.");
+  snapshot.finite_cells = static_cast<Snapshot_index>(finite_cells);
+  for (auto& moves : frame.attempted_moves) moves = unpacker.get_signed();
+  for (auto& moves : frame.successful_moves) moves = unpacker.get_signed();
+
+  auto runs = unpacker.get_count(2);
+  snapshot.vertex_timevalues.reserve(vertices);
+  for (std::size_t r = 0; r < runs; ++r) {
+    auto timevalue = unpacker.get_signed();
+    auto length    = unpacker.get();
+    if (length > vertices - snapshot.vertex_timevalues.size())
+      throw std::runtime_error("Trajectory frame has too many timevalues.");
+    snapshot.vertex_timevalues.insert(snapshot.vertex_timevalues.end(),
+                                      length, timevalue);
+  }
+  if (snapshot.vertex_timevalues.size() != vertices)
+    throw std::runtime_error("Trajectory frame has too few timevalues.");
+
+  unpacker.get_raw(snapshot.x, vertices);
+  unpacker.get_raw(snapshot.y, vertices);
+  unpacker.get_raw(snapshot.z, vertices);
+
+  snapshot.cell_vertices.resize(4 * cells);
+  std::int64_t previous_first{0};
+  for (std::size_t c = 0; c < cells; ++c) {
+    auto first = previous_first + unpacker.get_signed();
+    snapshot.cell_vertices[4 * c] = static_cast<Snapshot_index>(first);
+    for (auto i = 1; i < 4; ++i) {
+      snapshot.cell_vertices[4 * c + i] =
+          static_cast<Snapshot_index>(first + unpacker.get_signed());
+    }
+    previous_first = first;
+  }
+  snapshot.cell_neighbors.resize(4 * cells);
+  for (std::size_t c = 0; c < cells; ++c) {
+    for (auto i = 0; i < 4; ++i) {
+      snapshot.cell_neighbors[4 * c + i] = static_cast<Snapshot_index>(
+          static_cast<std::int64_t>(c) + unpacker.get_signed());
+    }
+  }
+  unpacker.get_raw(snapshot.cell_types, cells);
+
+  check_snapshot_indices(snapshot);
+  return frame;
+}  // unpack_frame()
+
+/// @brief Hop from frame header to frame header of a trajectory file
+///
+/// A final frame cut short, say by a crash while it was being written, is
+/// skipped.
+///
+/// @tparam Visit Callable with the offset and header of a frame
+/// @param file The trajectory file
+/// @param size Size of the file in bytes
+/// @param visit Called for each complete frame, in file order
+/// @return The end of the last complete frame
+template <typename Visit>
+std::int64_t scan_trajectory_frames(std::istream& file, const std::int64_t size,
+                                    Visit&& visit) {
+  constexpr auto frame_header_size =
+      static_cast<std::int64_t>(sizeof(Trajectory_frame_header));
+  auto offset = static_cast<std::int64_t>(sizeof(Trajectory_header));
+  while (offset + frame_header_size <= size) {
+    Trajectory_frame_header header{};
+    file.seekg(offset);
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != TRAJECTORY_FRAME_MAGIC ||
+        header.stored_size < 0)
+      throw std::invalid_argument("Trajectory frame header is corrupt.");
+    if (header.stored_size > size - offset - frame_header_size) break;
+    visit(offset, header);
+    offset += frame_header_size + header.stored_size;
+  }
+  file.clear();
+  return offset;
+}  // scan_trajectory_frames()
+
+/// @class Trajectory_writer
+/// @brief Appends frames to a trajectory file
+class Trajectory_writer {
+ private:
+  /// @brief The trajectory file
+  std::ofstream file_;
+
+  /// @brief How frames are stored
+  trajectory_codec codec_;
+
+  /// @brief Serializes appends
+  std::mutex mutex_;
+
+  /// @brief Pass of the last frame already in the file, or 0
+  std::intmax_t last_pass_{0};
+
+ public:
+  /// @brief Open a trajectory file for appending, creating it if needed
+  ///
+  /// A final frame cut short by a crash is cut off first, so that the
+  /// frames appended after it can be read.
+  ///
+  /// @param filename The trajectory file
+  explicit Trajectory_writer(const std::string& filename)
+#ifdef CDT_ZSTD
+      : codec_{trajectory_codec::ZSTD} {
+#else
+      : codec_{trajectory_codec::PACKED} {
+#endif
+    std::ifstream existing(filename, std::ios::in | std::ios::binary);
+    existing.seekg(0, std::ios::end);
+    auto size = std::max(static_cast<std::int64_t>(existing.tellg()),
+                         std::int64_t{0});
+    existing.seekg(0);
+    Trajectory_header header{};
+    auto has_header = static_cast<bool>(existing.read(
+        reinterpret_cast<char*>(&header), sizeof(header)));
+    auto is_empty = !has_header && existing.gcount() == 0;
+    if (!is_empty &&
+        (!has_header || header.magic != TRAJECTORY_MAGIC ||
+         header.version != TRAJECTORY_VERSION ||
+         header.byte_order != UNIVERSE_FILE_BYTE_ORDER))
+      throw std::invalid_argument(filename + " is not a trajectory file.");
+    if (!is_empty) {
+      auto end = scan_trajectory_frames(
+          existing, size,
+          [this](std::int64_t, const Trajectory_frame_header& frame) {
+            last_pass_ = frame.pass;
+          });
+      existing.close();
+      if (end < size && ::truncate(filename.c_str(), end) != 0)
+        throw std::runtime_error("Unable to truncate " + filename);
+    }
+
+    file_.open(filename, std::ios::out | std::ios::app | std::ios::binary);
+    if (!file_.is_open()) throw std::runtime_error("Unable to open file.");
+    if (is_empty) {
+      header = Trajectory_header{TRAJECTORY_MAGIC, TRAJECTORY_VERSION,
+                                 UNIVERSE_FILE_BYTE_ORDER};
+      file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+  }
+
+  /// @brief Gets the pass of the last frame in the file when it was
+  /// opened, so that a run appending to it can number its passes on
+  /// @return last_pass_
+  auto last_pass() const noexcept { return last_pass_; }
+
+  /// @brief Append a frame
+  /// @param snapshot The configuration
+  /// @param pass The pass at which it was taken
+  /// @param attempted_moves Attempted moves so far
+  /// @param successful_moves Successful moves so far
+  void append(const Snapshot& snapshot, const std::intmax_t pass,
+              const Move_tracker& attempted_moves,
+              const Move_tracker& successful_moves) {
+    auto packed = pack_frame(snapshot, attempted_moves, successful_moves);
+    Trajectory_frame_header header{TRAJECTORY_FRAME_MAGIC,
+                                   static_cast<std::uint32_t>(codec_), pass,
+                                   static_cast<std::int64_t>(packed.size()),
+                                   static_cast<std::int64_t>(packed.size())};
+    const auto* stored = &packed;
+#ifdef CDT_ZSTD
+    std::vector<char> compressed(ZSTD_compressBound(packed.size()));
+    auto size = ZSTD_compress(compressed.data(), compressed.size(),
+                              packed.data(), packed.size(),
+                              TRAJECTORY_ZSTD_LEVEL);
+    if (ZSTD_isError(size))
+      throw std::runtime_error(ZSTD_getErrorName(size));
+    compressed.resize(size);
+    header.stored_size = static_cast<std::int64_t>(size);
+    stored             = &compressed;
+#endif
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file_.write(stored->data(), static_cast<std::streamsize>(stored->size()));
+    file_.flush();
+    if (!file_) throw std::runtime_error("Unable to write trajectory frame.");
+  }
+
+  /// @brief Append a frame of a SimplicialManifold
+  /// @tparam T The manifold type
+  /// @param universe The SimplicialManifold
+  /// @param pass The pass at which it was taken
+  /// @param attempted_moves Attempted moves so far
+  /// @param successful_moves Successful moves so far
+  template <typename T>
+  void append_universe(T&& universe, const std::intmax_t pass,
+                       const Move_tracker& attempted_moves,
+                       const Move_tracker& successful_moves) {
+    append(make_snapshot(universe), pass, attempted_moves, successful_moves);
+  }
+};
+
+/// @class Trajectory_reader
+/// @brief Random access to the frames of a trajectory file
+class Trajectory_reader {
+ private:
+  /// @brief Where to find a frame
+  struct Frame_index {
+    std::int64_t            offset;
+    Trajectory_frame_header header;
+  };
+
+  /// @brief The trajectory file
+  std::ifstream file_;
+
+  /// @brief Every complete frame, in file order
+  std::vector<Frame_index> frames_;
+
+ public:
+  /// @brief Open a trajectory file and index its frames
+  ///
+  /// Only the frame headers are read. A final frame cut short, say by a
+  /// crash while it was being written, is left out of the index.
+  ///
+  /// @param filename The trajectory file
+  explicit Trajectory_reader(const std::string& filename)
+      : file_{filename, std::ios::in | std::ios::binary} {
+    if (!file_.is_open())
+      throw std::invalid_argument("Unable to open trajectory " + filename);
+    file_.seekg(0, std::ios::end);
+    auto size = static_cast<std::int64_t>(file_.tellg());
+    file_.seekg(0);
+
+    Trajectory_header header{};
+    if (!file_.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != TRAJECTORY_MAGIC)
+      throw std::invalid_argument(filename + " is not a trajectory file.");
+    if (header.version != TRAJECTORY_VERSION)
+      throw std::invalid_argument("Unsupported trajectory version.");
+    if (header.byte_order != UNIVERSE_FILE_BYTE_ORDER)
+      throw std::invalid_argument("Trajectory has the wrong byte order.");
+
+    scan_trajectory_frames(
+        file_, size,
+        [this](const std::int64_t offset,
+               const Trajectory_frame_header& frame) {
+          frames_.push_back(Frame_index{offset, frame});
+        });
+  }
+
+  /// @brief Number of complete frames
+  auto size() const noexcept { return frames_.size(); }
+
+  /// @brief Pass at which frame i was taken
+  auto pass(const std::size_t i) const { return frames_.at(i).header.pass; }
+
+  /// @brief Read frame i
+  /// @param i The frame
+  /// @return The Snapshot and move statistics of the frame
+  Universe_file read(const std::size_t i) {
+    const auto& frame = frames_.at(i);
+    std::vector<char> stored(
+        static_cast<std::size_t>(frame.header.stored_size));
+    file_.seekg(frame.offset + sizeof(Trajectory_frame_header));
+    if (!file_.read(stored.data(), static_cast<std::streamsize>(stored.size())))
+      throw std::runtime_error("Unable to read trajectory frame.");
+
+    switch (static_cast<trajectory_codec>(frame.header.codec)) {
+      case trajectory_codec::PACKED:
+        return unpack_frame(stored);
+      case trajectory_codec::ZSTD: {
+#ifdef CDT_ZSTD
+        if (frame.header.packed_size < 0)
+          throw std::runtime_error("Trajectory frame size is corrupt.");
+        std::vector<char> packed(
+            static_cast<std::size_t>(frame.header.packed_size));
+        auto size = ZSTD_decompress(packed.data(), packed.size(),
+                                    stored.data(), stored.size());
+        if (ZSTD_isError(size) || size != packed.size())
+          throw std::runtime_error("Trajectory frame failed to decompress.");
+        return unpack_frame(packed);
+#else
+        throw std::runtime_error(
+            "Trajectory frame is zstd-compressed; rebuild with "
+            "-DZSTD:BOOL=ON to read it.");
+#endif
+      }
+    }
+    throw std::runtime_error("Trajectory frame has an unknown codec.");
+  }
+};
+
+#endif  // SRC_TRAJECTORY_H_
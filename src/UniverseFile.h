@@ -0,0 +1,342 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Binary universe files for warm starts. A universe file holds a Snapshot
+/// of a foliated triangulation, its vertex timevalues and cell types, the
+/// Metropolis move statistics, and the seed and number of passes of the run
+/// so far, so a warm start continues the run's random numbers rather than
+/// replaying them. Loading rebuilds the triangulation
+/// directly with rebuild_triangulation() rather than re-inserting points,
+/// so a thermalized universe can be branched into many production runs.
+///
+/// The layout is a fixed header followed by fixed-width arrays, each
+/// starting on a UNIVERSE_FILE_ALIGNMENT boundary.
+///
+/// \done Save and load Snapshots with move statistics
+/// \done Save the seed and pass count of the run
+
+/// @file UniverseFile.h
+/// @brief Save and load universes for warm starts
+/// @author Adam Getchell
+
+#ifndef SRC_UNIVERSEFILE_H_
+#define SRC_UNIVERSEFILE_H_
+
+// C++ headers
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// CDT headers
+#include "S3ErgodicMoves.h"
+#include "Snapshot.h"
+
+/// Identifies a universe file
+static constexpr std::array<char, 8> UNIVERSE_FILE_MAGIC{
+    {'C', 'D', 'T', 'U', 'N', 'I', 'V', '\0'}};
+
+/// Layout version of universe files
+static constexpr std::uint32_t UNIVERSE_FILE_VERSION = 2;
+
+/// Written in native byte order, to detect files from other architectures
+static constexpr std::uint32_t UNIVERSE_FILE_BYTE_ORDER = 0x01020304;
+
+/// Alignment of each array in a universe file
+static constexpr std::int64_t UNIVERSE_FILE_ALIGNMENT = 64;
+
+static_assert(sizeof(std::intmax_t) == sizeof(std::int64_t),
+              "Universe files store timevalues as 64-bit integers.");
+
+/// @struct
+/// @brief Fixed header at the start of a universe file
+///
+/// Offsets are in bytes from the start of the file. **seed** holds the run
+/// seed only if **seeded** is 1.
+struct Universe_header {
+  std::array<char, 8>         magic;
+  std::uint32_t               version;
+  std::uint32_t               byte_order;
+  std::int64_t                vertices;
+  std::int64_t                cells;
+  std::int64_t                finite_cells;
+  std::array<std::int64_t, 5> attempted_moves;
+  std::array<std::int64_t, 5> successful_moves;
+  std::int64_t                passes;
+  std::uint64_t               seed;
+  std::int64_t                seeded;
+  std::int64_t                timevalues_offset;
+  std::int64_t                x_offset;
+  std::int64_t                y_offset;
+  std::int64_t                z_offset;
+  std::int64_t                cell_vertices_offset;
+  std::int64_t                cell_neighbors_offset;
+  std::int64_t                cell_types_offset;
+  std::int64_t                file_size;
+};
+
+static_assert(std::is_trivially_copyable<Universe_header>::value,
+              "Universe_header is written byte for byte.");
+
+/// @struct
+/// @brief The contents of a universe file
+struct Universe_file {
+  /// @brief The foliated triangulation
+  Snapshot snapshot;
+
+  /// @brief Attempted (2,3), (3,2), (2,6), (6,2), and (4,4) moves
+  Move_tracker attempted_moves{};
+
+  /// @brief Successful (2,3), (3,2), (2,6), (6,2), and (4,4) moves
+  Move_tracker successful_moves{};
+
+  /// @brief Passes made so far
+  std::intmax_t passes{0};
+
+  /// @brief The run seed, if any
+  std::optional<std::uint64_t> seed{};
+};
+
+/// @brief Round an offset up to the next UNIVERSE_FILE_ALIGNMENT boundary
+inline auto align_universe_offset(const std::int64_t offset) noexcept {
+  return (offset + UNIVERSE_FILE_ALIGNMENT - 1) / UNIVERSE_FILE_ALIGNMENT *
+         UNIVERSE_FILE_ALIGNMENT;
+}  // align_universe_offset()
+
+/// @brief Lay out the arrays of a universe file
+/// @param vertices Number of finite vertices
+/// @param cells Number of cells, finite and infinite
+/// @return A header with counts and offsets filled in
+inline auto universe_layout(const std::int64_t vertices,
+                            const std::int64_t cells) noexcept {
+  Universe_header header{};
+  header.magic      = UNIVERSE_FILE_MAGIC;
+  header.version    = UNIVERSE_FILE_VERSION;
+  header.byte_order = UNIVERSE_FILE_BYTE_ORDER;
+  header.vertices   = vertices;
+  header.cells      = cells;
+
+  auto offset = align_universe_offset(sizeof(Universe_header));
+  auto next   = [&offset](const std::int64_t bytes) {
+    auto start = offset;
+    offset     = align_universe_offset(offset + bytes);
+    return start;
+  };
+  header.timevalues_offset = next(vertices * sizeof(std::int64_t));
+  header.x_offset          = next(vertices * sizeof(double));
+  header.y_offset          = next(vertices * sizeof(double));
+  header.z_offset          = next(vertices * sizeof(double));
+  header.cell_vertices_offset =
+      next(4 * cells * sizeof(Snapshot_index));
+  header.cell_neighbors_offset =
+      next(4 * cells * sizeof(Snapshot_index));
+  header.cell_types_offset = next(cells * sizeof(std::int8_t));
+  header.file_size         = offset;
+  return header;
+}  // universe_layout()
+
+/// @brief Write a Snapshot and move statistics to a universe file
+/// @param filename The file to create
+/// @param snapshot The Snapshot
+/// @param attempted_moves Attempted moves so far
+/// @param successful_moves Successful moves so far
+/// @param passes Passes made so far
+/// @param seed The run seed, if any
+inline void write_universe(const std::string&                  filename,
+                           const Snapshot&                     snapshot,
+                           const Move_tracker&                 attempted_moves,
+                           const Move_tracker&                 successful_moves,
+                           const std::intmax_t                 passes = 0,
+                           const std::optional<std::uint64_t>& seed = {}) {
+  auto header = universe_layout(snapshot.number_of_vertices(),
+                                snapshot.number_of_cells());
+  header.finite_cells = snapshot.number_of_finite_cells();
+  for (std::size_t i = 0; i < attempted_moves.size(); ++i) {
+    header.attempted_moves[i]  = attempted_moves[i];
+    header.successful_moves[i] = successful_moves[i];
+  }
+  header.passes = passes;
+  header.seed   = seed.value_or(0);
+  header.seeded = seed ? 1 : 0;
+
+  std::ofstream file(filename, std::ios::out | std::ios::binary);
+  if (!file.is_open()) throw std::runtime_error("Unable to open file.");
+
+  auto write_at = [&file](const std::int64_t offset, const void* data,
+                          const std::size_t bytes) {
+    // Zero-fill the padding up to offset
+    static const std::array<char, UNIVERSE_FILE_ALIGNMENT> zeros{};
+    auto position = static_cast<std::int64_t>(file.tellp());
+    file.write(zeros.data(), offset - position);
+    file.write(static_cast<const char*>(data),
+               static_cast<std::streamsize>(bytes));
+  };
+  write_at(0, &header, sizeof(header));
+  write_at(header.timevalues_offset, snapshot.vertex_timevalues.data(),
+           snapshot.vertex_timevalues.size() * sizeof(std::int64_t));
+  write_at(header.x_offset, snapshot.x.data(),
+           snapshot.x.size() * sizeof(double));
+  write_at(header.y_offset, snapshot.y.data(),
+           snapshot.y.size() * sizeof(double));
+  write_at(header.z_offset, snapshot.z.data(),
+           snapshot.z.size() * sizeof(double));
+  write_at(header.cell_vertices_offset, snapshot.cell_vertices.data(),
+           snapshot.cell_vertices.size() * sizeof(Snapshot_index));
+  write_at(header.cell_neighbors_offset, snapshot.cell_neighbors.data(),
+           snapshot.cell_neighbors.size() * sizeof(Snapshot_index));
+  write_at(header.cell_types_offset, snapshot.cell_types.data(),
+           snapshot.cell_types.size() * sizeof(std::int8_t));
+  write_at(header.file_size, nullptr, 0);
+
+  if (!file) throw std::runtime_error("Unable to write " + filename);
+}  // write_universe()
+
+/// @brief Save a SimplicialManifold and move statistics to a universe file
+/// @tparam T The manifold type
+/// @param filename The file to create
+/// @param universe The SimplicialManifold
+/// @param attempted_moves Attempted moves so far
+/// @param successful_moves Successful moves so far
+/// @param passes Passes made so far
+/// @param seed The run seed, if any
+template <typename T>
+void save_universe(const std::string& filename, T&& universe,
+                   const Move_tracker&                 attempted_moves,
+                   const Move_tracker&                 successful_moves,
+                   const std::intmax_t                 passes = 0,
+                   const std::optional<std::uint64_t>& seed = {}) {
+  std::cout << "Saving universe to " << filename << std::endl;
+  write_universe(filename, make_snapshot(universe), attempted_moves,
+                 successful_moves, passes, seed);
+}  // save_universe()
+
+/// @brief Check that a header describes a readable universe file
+/// @param header The header
+/// @param size Size of the file in bytes
+inline void check_universe_header(const Universe_header& header,
+                                  const std::int64_t     size) {
+  if (header.magic != UNIVERSE_FILE_MAGIC)
+    throw std::invalid_argument("Not a universe file.");
+  if (header.version != UNIVERSE_FILE_VERSION)
+    throw std::invalid_argument("Unsupported universe file version.");
+  if (header.byte_order != UNIVERSE_FILE_BYTE_ORDER)
+    throw std::invalid_argument("Universe file has the wrong byte order.");
+  if (header.vertices < 0 || header.cells < 0 || header.finite_cells < 0 ||
+      header.finite_cells > header.cells || header.passes < 0 ||
+      (header.seeded != 0 && header.seeded != 1) ||
+      header.vertices > std::numeric_limits<Snapshot_index>::max() ||
+      header.cells > std::numeric_limits<Snapshot_index>::max())
+    throw std::invalid_argument("Universe file has invalid counts.");
+
+  // Universe_view reads every array at its offset in the mapping, so each
+  // must be exactly where the counts put it
+  auto layout = universe_layout(header.vertices, header.cells);
+  if (layout.timevalues_offset != header.timevalues_offset ||
+      layout.x_offset != header.x_offset ||
+      layout.y_offset != header.y_offset ||
+      layout.z_offset != header.z_offset ||
+      layout.cell_vertices_offset != header.cell_vertices_offset ||
+      layout.cell_neighbors_offset != header.cell_neighbors_offset ||
+      layout.cell_types_offset != header.cell_types_offset ||
+      layout.file_size != header.file_size || header.file_size > size)
+    throw std::invalid_argument("Universe file is truncated or corrupt.");
+}  // check_universe_header()
+
+/// @brief Check that every vertex and neighbor index of a Snapshot is in
+/// range
+///
+/// rebuild_triangulation() and the measurements use indices unchecked, so
+/// snapshots read from files are checked first.
+///
+/// @tparam T Snapshot, or another type with the same accessors
+/// @param snapshot The Snapshot
+template <typename T>
+void check_snapshot_indices(const T& snapshot) {
+  for (Snapshot_index c = 0; c < snapshot.number_of_cells(); ++c) {
+    for (auto i = 0; i < 4; ++i) {
+      auto v = snapshot.vertex(c, i);
+      if (v < INFINITE_VERTEX || v >= snapshot.number_of_vertices())
+        throw std::invalid_argument("Universe file has invalid vertices.");
+      auto n = snapshot.neighbor(c, i);
+      if (n < 0 || n >= snapshot.number_of_cells())
+        throw std::invalid_argument("Universe file has invalid neighbors.");
+    }
+  }
+}  // check_snapshot_indices()
+
+/// @brief Whether a file starts like a universe file
+/// @param filename The file to check
+/// @return **True** if the file begins with UNIVERSE_FILE_MAGIC
+inline bool is_universe_file(const std::string& filename) {
+  std::ifstream       file(filename, std::ios::in | std::ios::binary);
+  std::array<char, 8> magic{};
+  return file.read(magic.data(), magic.size()) && magic == UNIVERSE_FILE_MAGIC;
+}  // is_universe_file()
+
+/// @brief Read a universe file
+/// @param filename The file to read
+/// @return The Universe_file
+inline auto read_universe(const std::string& filename) {
+#ifndef NDEBUG
+  std::cout << __PRETTY_FUNCTION__ << " called." << std::endl;
+#endif
+  std::ifstream file(filename, std::ios::in | std::ios::binary);
+  if (!file.is_open())
+    throw std::invalid_argument("Unable to open universe " + filename);
+  file.seekg(0, std::ios::end);
+  auto size = static_cast<std::int64_t>(file.tellg());
+  file.seekg(0);
+
+  Universe_header header{};
+  if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    throw std::invalid_argument("Not a universe file.");
+  check_universe_header(header, size);
+
+  Universe_file universe;
+  for (std::size_t i = 0; i < universe.attempted_moves.size(); ++i) {
+    universe.attempted_moves[i]  = header.attempted_moves[i];
+    universe.successful_moves[i] = header.successful_moves[i];
+  }
+  universe.passes = header.passes;
+  if (header.seeded == 1) universe.seed = header.seed;
+
+  auto& snapshot        = universe.snapshot;
+  snapshot.finite_cells = static_cast<Snapshot_index>(header.finite_cells);
+  auto read_at = [&file](const std::int64_t offset, auto& values,
+                         const std::int64_t count) {
+    values.resize(static_cast<std::size_t>(count));
+    file.seekg(offset);
+    file.read(reinterpret_cast<char*>(values.data()),
+              static_cast<std::streamsize>(count * sizeof(values[0])));
+  };
+  read_at(header.timevalues_offset, snapshot.vertex_timevalues,
+          header.vertices);
+  read_at(header.x_offset, snapshot.x, header.vertices);
+  read_at(header.y_offset, snapshot.y, header.vertices);
+  read_at(header.z_offset, snapshot.z, header.vertices);
+  read_at(header.cell_vertices_offset, snapshot.cell_vertices,
+          4 * header.cells);
+  read_at(header.cell_neighbors_offset, snapshot.cell_neighbors,
+          4 * header.cells);
+  read_at(header.cell_types_offset, snapshot.cell_types, header.cells);
+  if (!file) throw std::runtime_error("Unable to read " + filename);
+
+  check_snapshot_indices(snapshot);
+  return universe;
+}  // read_universe()
+
+/// @brief Rebuild a SimplicialManifold from a universe file
+/// @param universe The Universe_file
+/// @return The SimplicialManifold, with its geometry classified
+inline auto load_universe(const Universe_file& universe) {
+  return SimplicialManifold(rebuild_triangulation(universe.snapshot));
+}  // load_universe()
+
+#endif  // SRC_UNIVERSEFILE_H_
@@ -0,0 +1,206 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Read-only, memory-mapped views of universe files for analysis tools.
+/// Opening a view maps the file and checks its header; the vertex, cell,
+/// and neighbor arrays are then read in place, so the operating system
+/// pages in only the parts a tool touches. A Universe_view has the same
+/// accessors as a Snapshot, so volume_per_timeslice() and
+/// rebuild_triangulation() work on either.
+///
+/// \done Memory-mapped universe files
+/// \todo Windows support
+
+/// @file UniverseView.h
+/// @brief Memory-mapped read-only universe files
+/// @author Adam Getchell
+
+#ifndef SRC_UNIVERSEVIEW_H_
+#define SRC_UNIVERSEVIEW_H_
+
+// POSIX headers
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// C++ headers
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+// CDT headers
+#include "UniverseFile.h"
+
+/// @class Universe_view
+/// @brief A read-only, memory-mapped universe file
+///
+/// Only the header is checked when the view is opened. Call
+/// check_snapshot_indices() on the view before trusting the indices of a
+/// file from elsewhere; rebuild_triangulation() does not check them.
+class Universe_view {
+ private:
+  /// @brief Start of the mapping
+  const char* data_{nullptr};
+
+  /// @brief Length of the mapping in bytes
+  std::size_t size_{0};
+
+  /// @brief The file header, at the start of the mapping
+  const Universe_header* header_{nullptr};
+
+  /// @brief An array of the file
+  /// @tparam T The element type
+  /// @param offset The array's offset in bytes
+  template <typename T>
+  const T* array(const std::int64_t offset) const noexcept {
+    return reinterpret_cast<const T*>(data_ + offset);
+  }
+
+  /// @brief Unmap the file, if mapped
+  void unmap() noexcept {
+    if (data_ != nullptr) munmap(const_cast<char*>(data_), size_);
+    data_   = nullptr;
+    size_   = 0;
+    header_ = nullptr;
+  }
+
+ public:
+  /// @brief Map a universe file
+  /// @param filename The file to open
+  explicit Universe_view(const std::string& filename) {
+    auto descriptor = open(filename.c_str(), O_RDONLY);
+    if (descriptor < 0)
+      throw std::invalid_argument("Unable to open universe " + filename);
+
+    struct stat status {};
+    if (fstat(descriptor, &status) != 0 ||
+        status.st_size < static_cast<off_t>(sizeof(Universe_header))) {
+      close(descriptor);
+      throw std::invalid_argument("Not a universe file.");
+    }
+    size_ = static_cast<std::size_t>(status.st_size);
+
+    auto mapping = mmap(nullptr, size_, PROT_READ, MAP_SHARED, descriptor, 0);
+    // The mapping keeps the file open
+    close(descriptor);
+    if (mapping == MAP_FAILED)
+      throw std::runtime_error("Unable to map universe " + filename);
+    data_   = static_cast<const char*>(mapping);
+    header_ = reinterpret_cast<const Universe_header*>(data_);
+
+    try {
+      check_universe_header(*header_, static_cast<std::int64_t>(size_));
+    } catch (...) {
+      unmap();
+      throw;
+    }
+  }
+
+  ~Universe_view() { unmap(); }
+
+  Universe_view(const Universe_view&) = delete;
+  Universe_view& operator=(const Universe_view&) = delete;
+
+  /// @brief Move constructor
+  /// @param other The Universe_view to take the mapping from
+  Universe_view(Universe_view&& other) noexcept
+      : data_{std::exchange(other.data_, nullptr)}
+      , size_{std::exchange(other.size_, 0)}
+      , header_{std::exchange(other.header_, nullptr)} {}
+
+  /// @brief Move assignment operator
+  /// @param other The Universe_view to take the mapping from
+  /// @return This Universe_view
+  Universe_view& operator=(Universe_view&& other) noexcept {
+    if (this != &other) {
+      unmap();
+      data_   = std::exchange(other.data_, nullptr);
+      size_   = std::exchange(other.size_, 0);
+      header_ = std::exchange(other.header_, nullptr);
+    }
+    return *this;
+  }
+
+  /// @brief Number of finite vertices
+  auto number_of_vertices() const noexcept {
+    return static_cast<Snapshot_index>(header_->vertices);
+  }
+
+  /// @brief Number of cells, finite and infinite
+  auto number_of_cells() const noexcept {
+    return static_cast<Snapshot_index>(header_->cells);
+  }
+
+  /// @brief Number of finite cells, which are stored first
+  auto number_of_finite_cells() const noexcept {
+    return static_cast<Snapshot_index>(header_->finite_cells);
+  }
+
+  /// @brief Timevalue of vertex v
+  auto timevalue(const Snapshot_index v) const noexcept {
+    return static_cast<std::intmax_t>(
+        array<std::int64_t>(header_->timevalues_offset)[v]);
+  }
+
+  /// @brief Point of vertex v
+  auto point(const Snapshot_index v) const {
+    return Point(array<double>(header_->x_offset)[v],
+                 array<double>(header_->y_offset)[v],
+                 array<double>(header_->z_offset)[v]);
+  }
+
+  /// @brief Vertex i of cell c
+  auto vertex(const Snapshot_index c, const int i) const noexcept {
+    return array<Snapshot_index>(header_->cell_vertices_offset)[4 * c + i];
+  }
+
+  /// @brief Neighbor i of cell c, opposite vertex i
+  auto neighbor(const Snapshot_index c, const int i) const noexcept {
+    return array<Snapshot_index>(header_->cell_neighbors_offset)[4 * c + i];
+  }
+
+  /// @brief Whether cell c contains the vertex at infinity
+  auto is_infinite(const Snapshot_index c) const noexcept {
+    return c >= number_of_finite_cells();
+  }
+
+  /// @brief Type of cell c
+  auto cell_type(const Snapshot_index c) const noexcept {
+    return array<std::int8_t>(header_->cell_types_offset)[c];
+  }
+
+  /// @brief Attempted moves saved with the universe
+  auto attempted_moves() const noexcept {
+    Move_tracker moves{};
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+      moves[i] = header_->attempted_moves[i];
+    }
+    return moves;
+  }
+
+  /// @brief Successful moves saved with the universe
+  auto successful_moves() const noexcept {
+    Move_tracker moves{};
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+      moves[i] = header_->successful_moves[i];
+    }
+    return moves;
+  }
+
+  /// @brief Passes made before the universe was saved
+  auto passes() const noexcept {
+    return static_cast<std::intmax_t>(header_->passes);
+  }
+
+  /// @brief The seed of the run that saved the universe, if any
+  auto seed() const noexcept {
+    return header_->seeded == 1 ? std::optional<std::uint64_t>{header_->seed}
+                                : std::nullopt;
+  }
+};
+
+#endif  // SRC_UNIVERSEVIEW_H_
@@ -40,6 +40,9 @@
 // Boost
 // #include <boost/type_index.hpp>
 
+// CDT headers
+#include "Philox.h"
+
 using Gmpzf = CGAL::Gmpzf;
 
 enum class topology_type { TOROIDAL, SPHERICAL };
@@ -203,18 +206,23 @@ void write_file(const T& universe, const topology_type& topology,
 /// using a non-deterministic random number generator, if supported. There
 /// may be exceptions thrown if a random device is not available. See:
 /// http://www.cplusplus.com/reference/random/random_device/
-/// for more details.
+/// for more details. Inside a Random_scope the integer is drawn from its
+/// stream instead, so seeded runs are reproducible.
 ///
 /// @param min_value  The minimum value in the range
 /// @param max_value  The maximum value in the range
 /// @return A random integer between min_value and max_value
 inline auto generate_random_signed(const intmax_t min_value,
                                    const intmax_t max_value) noexcept {
-  // Non-deterministic random number generator
-  std::random_device                      generator;
-  std::uniform_int_distribution<intmax_t> distribution(min_value, max_value);
-
-  auto result = distribution(generator);
+  intmax_t result;
+  if (auto* stream = current_random_stream()) {
+    result = stream->uniform_int(min_value, max_value);
+  } else {
+    // Non-deterministic random number generator
+    std::random_device                      generator;
+    std::uniform_int_distribution<intmax_t> distribution(min_value, max_value);
+    result = distribution(generator);
+  }
 
 #ifdef DETAILED_DEBUGGING
   std::cout << "Random " << (typeid(result)).name() << " is " << result
@@ -236,13 +244,33 @@ inline auto generate_random_timeslice(const unsigned max_timeslice) noexcept {
   return generate_random_signed(1, max_timeslice);
 }  // generate_random_timeslice()
 
+/// @brief Draw a random real number without reporting it
+///
+/// As generate_random_real(), without its debug output, for bulk draws
+/// such as the points of a new universe.
+///
+/// @tparam T The real number type
+/// @param min_value The minimum value in the range
+/// @param max_value The maximum value in the range
+/// @return A random real number between min_value and max_value, inclusive
+template <typename T>
+auto draw_random_real(const T min_value, const T max_value) noexcept {
+  if (auto* stream = current_random_stream()) {
+    return stream->uniform_real(min_value, max_value);
+  }
+  std::random_device                generator;
+  std::uniform_real_distribution<T> distribution(min_value, max_value);
+  return distribution(generator);
+}  // draw_random_real()
+
 /// @brief Generate random real numbers
 ///
 /// This function generates a random real number from [min_value, max_value]
 /// using a non-deterministic random number generator, if supported. There
 /// may be exceptions thrown if a random device is not available. See:
 /// http://www.cplusplus.com/reference/random/random_device/
-/// for more details.
+/// for more details. Inside a Random_scope the number is drawn from its
+/// stream instead, so seeded runs are reproducible.
 ///
 /// @tparam T The real number type
 /// @param min_value The minimum value in the range
@@ -250,10 +278,7 @@ inline auto generate_random_timeslice(const unsigned max_timeslice) noexcept {
 /// @return A random real number between min_value and max_value, inclusive
 template <typename T>
 auto generate_random_real(const T min_value, const T max_value) noexcept {
-  std::random_device                generator;
-  std::uniform_real_distribution<T> distribution(min_value, max_value);
-
-  auto result = distribution(generator);
+  auto result = draw_random_real(min_value, max_value);
 
 #ifndef NDEBUG
   std::cout << "Random trial is " << result << std::endl;
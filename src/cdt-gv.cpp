@@ -8,6 +8,8 @@
 /// http://doc.cgal.org/latest/Geomview/Geomview_2gv_terrain_8cpp-example.html
 ///
 /// \done Load files generated by cdt.cpp
+/// \done Map universe files saved by cdt --save instead of re-inserting
+/// points
 /// \done Invoke Geomview
 /// \done Use <a href="https://github.com/docopt/docopt.cpp">docopt</a>
 /// for a beautiful command line interface.
@@ -20,8 +22,6 @@
 /// @author Adam Getchell
 
 // CGAL headers
-#include <CGAL/Delaunay_triangulation_3.h>
-#include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
 #include <CGAL/IO/Geomview_stream.h>
 #include <CGAL/IO/Triangulation_geomview_ostream_3.h>
 #include <CGAL/Projection_traits_xy_3.h>
@@ -30,15 +30,17 @@
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <string>
 
 // Docopt
 #include "docopt/docopt.h"
 
-using K        = CGAL::Exact_predicates_inexact_constructions_kernel;
-using Delaunay = CGAL::Delaunay_triangulation_3<K>;
-using Gt3      = CGAL::Projection_traits_xy_3<K>;
-using Point3   = Gt3::Point;
+// CDT headers
+#include "UniverseView.h"
+
+using Gt3    = CGAL::Projection_traits_xy_3<K>;
+using Point3 = Gt3::Point;
 
 /// Help message parsed by docopt into options
 static const char USAGE[]{
@@ -50,8 +52,9 @@ A program that loads d-dimensional triangulated spacetimes
 with a defined causal structure generated by cdt.cpp into a GeomView
 pipeline for visualization.
 
-Note that the standard output of CDT++ includes cell neighbors, and should
-be truncated to just include points.
+Universe files saved with cdt --save are memory-mapped and rebuilt
+directly. Note that the standard output of CDT++ includes cell neighbors,
+and should be truncated to just include points.
 
 Usage:./cdt-gv --file FILE
 
@@ -92,18 +95,26 @@ int main(int argc, char* const argv[]) {
   gv.set_line_width(4);
   gv.set_bg_color(CGAL::Color(0, 200, 200));
 
-  Delaunay      D;
-  std::ifstream iFile(file, std::ios::in);
-  Point3        p;
-
-  // Insert points from file into Delaunay triangulation
-  while (iFile >> p) {
-    D.insert(p);
+  std::unique_ptr<Delaunay> D;
+  if (is_universe_file(file)) {
+    // Map the file and rebuild the triangulation without re-inserting points
+    Universe_view view(file);
+    check_snapshot_indices(view);
+    D = rebuild_triangulation(view);
+  } else {
+    D = std::make_unique<Delaunay>();
+    std::ifstream iFile(file, std::ios::in);
+    Point3        p;
+
+    // Insert points from file into Delaunay triangulation
+    while (iFile >> p) {
+      D->insert(p);
+    }
   }
 
   std::cout << "Drawing 3D Delaunay triangulation in wired mode." << std::endl;
   gv.set_wired(true);
-  gv << D;
+  gv << *D;
 
   std::cout << "Enter a key to finish" << std::endl;
   char ch;
@@ -42,11 +42,11 @@ int main() {
   SimplicialManifold universe(simplices, timeslices);
 
   // Queue up simulation with desired algorithm
-  my_simulation.queue(
-      [&my_algorithm](SimplicialManifold s) { return my_algorithm(s); });
+  my_simulation.queue([&my_algorithm](SimplicialManifold& s) {
+    swap(s, my_algorithm(s));
+  });
   // Measure results
-  my_simulation.queue(
-      [](SimplicialManifold s) { return VolumePerTimeslice(s); });
+  my_simulation.queue([](SimplicialManifold& s) { VolumePerTimeslice(s); });
   // my_simulation.queue(print_results())
 
   // Run it
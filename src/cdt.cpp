@@ -22,7 +22,11 @@
 #include <CGAL/Real_timer.h>
 
 // C++ headers
+#include <algorithm>
+#include <fstream>
 #include <map>
+#include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
@@ -31,8 +35,18 @@
 #include "docopt/docopt.h"
 
 // CDT headers
+#include "CombinatorialErgodicMoves.h"
+#include "CombinatorialManifold.h"
+#include "MeasurementPipeline.h"
 #include "Metropolis.h"
+#include "OptimisticMetropolis.h"
 #include "Simulation.h"
+#include "Sweep.h"
+#include "T3ErgodicMoves.h"
+#include "ThreadPool.h"
+#include "ToroidalManifold.h"
+#include "Trajectory.h"
+#include "UniverseFile.h"
 
 /// Help message parsed by docopt into options
 static const char USAGE[]{
@@ -46,11 +60,22 @@ to the Metropolis algorithm. Specify the number of passes to control
 how much evolution is desired. Each pass attempts a number of ergodic
 moves equal to the number of simplices in the simulation.
 
-Usage:./cdt (--spherical | --toroidal) -n SIMPLICES -t TIMESLICES [-d DIM] -k K --alpha ALPHA --lambda LAMBDA [-p PASSES] [-c CHECKPOINT]
+Usage:./cdt (--spherical | --toroidal) [--combinatorial] [--optimistic THREADS] [--seed SEED] [--threads THREADS] -n SIMPLICES -t TIMESLICES [-d DIM] -k K --alpha ALPHA --lambda LAMBDA [-p PASSES] [-c CHECKPOINT] [--profiles FILE] [--cadence PASSES] [--trajectory FILE] [--save FILE] [--trace FILE]
+      ./cdt --load FILE [--combinatorial] [--optimistic THREADS] [--seed SEED] [--threads THREADS] -k K --alpha ALPHA --lambda LAMBDA [-p PASSES] [-c CHECKPOINT] [--profiles FILE] [--cadence PASSES] [--trajectory FILE] [--save FILE] [--trace FILE]
+      ./cdt --batch SPEC [-j JOBS] [--threads THREADS] [--trace FILE]
 
 Examples:
 ./cdt --spherical -n 64000 -t 256 --alpha 1.1 -k 2.2 --lambda 3.3 --passes 1000
 ./cdt --s -n64000 -t256 -a1.1 -k2.2 -l3.3 -p1000
+./cdt --t -n6400 -t16 -a0.6 -k1.1 -l0.1 -p100
+./cdt --s --combinatorial -n64000 -t256 -a1.1 -k2.2 -l3.3 -p1000
+./cdt --s --optimistic 8 -n64000 -t256 -a1.1 -k2.2 -l3.3 -p1000
+./cdt --s --optimistic 8 --seed 42 -n64000 -t256 -a1.1 -k2.2 -l3.3 -p1000
+./cdt --load thermalized.univ -a1.1 -k2.2 -l3.3 -p1000 --save next.univ
+./cdt --load thermalized.univ -a1.1 -k2.2 -l3.3 -p1000 --trajectory run.traj
+./cdt --load thermalized.univ -a1.1 -k2.2 -l3.3 -p1000 --profiles volumes.csv
+./cdt --batch sweep.txt -j 8
+./cdt --batch sweep.txt --threads 16
 
 Options:
   -h --help                   Show this message
@@ -64,8 +89,156 @@ Options:
   -l --lambda LAMBDA          K * Cosmological constant
   -p --passes PASSES          Number of passes [default: 100]
   -c --checkpoint CHECKPOINT  Checkpoint every n passes [default: 10]
+  --combinatorial             Make ergodic moves on a coordinate-free copy
+                              of a spherical universe
+  --optimistic THREADS        Make combinatorial moves on THREADS threads,
+                              0 for one per worker thread
+  --seed SEED                 Make the same moves on every run with SEED,
+                              on any number of threads
+  --profiles FILE             Measure volume profiles on other threads while
+                              the passes go on, and write them to FILE
+  --cadence PASSES            Measure every n passes [default: 1]
+  --trajectory FILE           Append each checkpoint to the trajectory FILE
+                              instead of writing a file per checkpoint
+  --save FILE                 Save the final universe and move statistics
+  --load FILE                 Continue from a universe saved with --save,
+                              from its last pass and with its seed
+  --trace FILE                Write a Chrome trace of the run to FILE
+  --batch SPEC                Run every point of the sweep specified in SPEC
+  -j --jobs JOBS              Concurrent runs in a batch, 0 for one per
+                              worker thread [default: 0]
+  --threads THREADS           Worker threads shared by every part of the
+                              run, 0 for one per available CPU [default: 0]
 )"};
 
+/// @brief Wait for the measurements of a run to finish and report them
+///
+/// @param pipeline The pipeline snapshots were published to, or nullptr
+void finish_measurements(Measurement_pipeline* pipeline) {
+  if (pipeline == nullptr) return;
+  Trace_span span("Finish measurements", "simulation");
+  pipeline->finish();
+  std::cout << "Measured " << pipeline->Measured() << " snapshots; passes "
+            << "waited for measurements " << pipeline->Stalls() << " times."
+            << std::endl;
+}  // finish_measurements()
+
+/// @brief Run a toroidal universe
+///
+/// The toroidal counterpart of the spherical path through main(), on a
+/// ToroidalManifold.
+///
+/// @param simplices Approximate number of simplices
+/// @param timeslices Number of timeslices
+/// @param alpha The timelike edge length
+/// @param k \f$k=\frac{1}{8\pi G_{Newton}}\f$
+/// @param lambda \f$\lambda=k*\Lambda\f$
+/// @param passes Number of passes of ergodic moves
+/// @param checkpoint Checkpoint every n passes
+/// @param trajectory The trajectory to record checkpoints to, or nullptr
+/// @param seed The seed of the moves' random numbers, if any
+/// @param pipeline The pipeline to publish snapshots to, or nullptr
+/// @param cadence Publish every n passes
+/// @param timer The running time, stopped when the run is finished
+void run_toroidal(const std::intmax_t simplices, const std::intmax_t timeslices,
+                  const long double alpha, const long double k,
+                  const long double lambda, const std::intmax_t passes,
+                  const std::intmax_t checkpoint, Trajectory_writer* trajectory,
+                  const std::optional<std::uint64_t> seed,
+                  Measurement_pipeline* pipeline, const std::intmax_t cadence,
+                  CGAL::Real_timer& timer) {
+  Basic_metropolis<ToroidalManifold> my_algorithm(alpha, k, lambda, passes,
+                                                  checkpoint);
+  if (trajectory != nullptr) {
+    my_algorithm.record_trajectory(*trajectory);
+    my_algorithm.start_after(trajectory->last_pass());
+  }
+  if (seed) my_algorithm.use_seed(*seed);
+  if (pipeline != nullptr) my_algorithm.publish_to(*pipeline, cadence);
+
+  ToroidalManifold universe;
+  {
+    Trace_span span("Generate universe", "simulation");
+    // A seeded run places its points from the seed as well
+    std::optional<Random_scope> random;
+    if (seed) random.emplace(*seed, 0, UNIVERSE_PROPOSAL);
+    ToroidalManifold populated_universe(simplices, timeslices);
+    swap(universe, populated_universe);
+  }
+
+  Basic_simulation<ToroidalManifold> my_simulation;
+  my_simulation.queue([&my_algorithm](ToroidalManifold& s) {
+    swap(s, my_algorithm(s));
+  });
+  my_simulation.queue([](ToroidalManifold& s) { VolumePerTimeslice(s); });
+
+  std::cout << "Universe has been initialized ..." << std::endl;
+  std::cout << "Now performing " << passes << " passes of ergodic moves."
+            << std::endl;
+  universe = my_simulation.start(std::move(universe));
+  finish_measurements(pipeline);
+
+  timer.stop();
+  std::cout << "Final toroidal triangulation has ";
+  print_results(universe, timer);
+
+  if (trajectory != nullptr) {
+    // The last checkpoint already recorded the final universe
+    auto last_pass = my_algorithm.PassOffset() + passes;
+    if (checkpoint == 0 || last_pass % checkpoint != 0) {
+      trajectory->append_universe(universe, last_pass,
+                                  my_algorithm.AttemptedMoves(),
+                                  my_algorithm.SuccessfulMoves());
+    }
+  } else {
+    write_file(universe, topology_type::TOROIDAL, 3,
+               universe.geometry->number_of_cells(), timeslices);
+  }
+}  // run_toroidal()
+
+/// @brief Run the Metropolis algorithm on a combinatorial copy of a
+/// spherical universe
+///
+/// The universe is converted to a CombinatorialManifold for the passes of
+/// ergodic moves and back afterwards, and the move statistics, pass count,
+/// seed, and measurement pipeline of **algorithm** carry over, so the rest of main()
+/// can't tell the difference.
+///
+/// @tparam Algorithm The Metropolis algorithm on a CombinatorialManifold
+/// @param universe A SimplicialManifold, replaced by the result
+/// @param algorithm The Metropolis algorithm whose parameters are used
+/// @param combinatorial The Metropolis algorithm that makes the moves
+/// @param trajectory The trajectory to record checkpoints to, or nullptr
+template <typename Algorithm>
+void run_combinatorial(SimplicialManifold& universe, Metropolis& algorithm,
+                       Algorithm&         combinatorial,
+                       Trajectory_writer* trajectory) {
+  if (trajectory != nullptr) combinatorial.record_trajectory(*trajectory);
+  if (auto seed = algorithm.Seed()) combinatorial.use_seed(*seed);
+  if (auto* pipeline = algorithm.Pipeline())
+    combinatorial.publish_to(*pipeline, algorithm.Cadence());
+  if (algorithm.TotalMoves() > 0) {
+    combinatorial.restore_moves(algorithm.AttemptedMoves(),
+                                algorithm.SuccessfulMoves());
+  }
+  combinatorial.start_after(algorithm.PassOffset());
+
+  CombinatorialManifold working;
+  {
+    Trace_span            span("Convert universe", "simulation");
+    CombinatorialManifold converted(universe);
+    swap(working, converted);
+  }
+  swap(working, combinatorial(working));
+
+  Trace_span         span("Convert universe", "simulation");
+  SimplicialManifold result = to_simplicial_manifold(working);
+  swap(universe, result);
+  algorithm.restore_moves(combinatorial.AttemptedMoves(),
+                          combinatorial.SuccessfulMoves(),
+                          algorithm.PassOffset());
+}  // run_combinatorial()
+
 /// @brief The main path of the CDT++ program
 ///
 /// @param[in,out]  argc  Argument count = 1 + number of arguments
@@ -88,19 +261,69 @@ int main(int argc, char* const argv[]) {
     //   std::cout << arg.first << " " << arg.second << std::endl;
     // }
 
+    // Optionally trace the run; view in chrome://tracing or Perfetto
+    if (args["--trace"]) Tracer::instance().start(args["--trace"].asString());
+
+    // Size the thread pool every part of the run shares
+    Thread_pool::configure(
+        static_cast<unsigned>(std::stoul(args["--threads"].asString())));
+    std::cout << "Worker threads = " << Thread_pool::instance().size()
+              << std::endl;
+
+    // Run a parameter sweep instead of a single simulation
+    if (args["--batch"]) {
+      auto          spec_file = args["--batch"].asString();
+      std::ifstream spec_stream(spec_file);
+      if (!spec_stream.is_open())
+        throw std::invalid_argument("Unable to open sweep " + spec_file);
+      Sweep sweep(parse_sweep(spec_stream));
+      std::cout << "Running " << sweep.points().size() << " sweep points."
+                << std::endl;
+      std::ofstream results(sweep.spec().output);
+      if (!results.is_open())
+        throw std::invalid_argument("Unable to open " + sweep.spec().output);
+      auto failed = sweep.run(results, std::stoull(args["--jobs"].asString()));
+      t.stop();
+      std::cout << "Sweep finished in " << t.time() << " seconds with "
+                << failed << " failed points." << std::endl;
+      Tracer::instance().stop();
+      return failed == 0 ? 0 : 1;
+    }
+
+    // Optionally continue from a saved universe
+    boost::optional<Universe_file> saved;
+    if (args["--load"]) {
+      Trace_span span("Load universe", "simulation");
+      saved = read_universe(args["--load"].asString());
+    }
+
     // Parse docopt::values in args map
-    auto simplices  = std::stoull(args["-n"].asString());
-    auto timeslices = std::stoull(args["-t"].asString());
+    std::uintmax_t simplices{0};
+    std::uintmax_t timeslices{0};
+    if (saved) {
+      const auto& timevalues = saved->snapshot.vertex_timevalues;
+      simplices = saved->snapshot.number_of_finite_cells();
+      timeslices =
+          timevalues.empty()
+              ? 0
+              : *std::max_element(timevalues.begin(), timevalues.end());
+    } else {
+      simplices  = std::stoull(args["-n"].asString());
+      timeslices = std::stoull(args["-t"].asString());
+    }
     auto dimensions = std::stoull(args["-d"].asString());
     auto alpha      = std::stold(args["--alpha"].asString());
     auto k          = std::stold(args["-k"].asString());
     auto lambda     = std::stold(args["--lambda"].asString());
     auto passes     = std::stoull(args["--passes"].asString());
     auto checkpoint = std::stoull(args["--checkpoint"].asString());
+    auto cadence    = std::stoll(args["--cadence"].asString());
+    std::optional<std::uint64_t> seed;
+    if (args["--seed"]) seed = std::stoull(args["--seed"].asString());
 
     // Topology of simulation
     topology_type topology;
-    if (args["--spherical"].asBool()) {
+    if (args["--spherical"].asBool() || saved) {
       topology = topology_type::SPHERICAL;
     } else {
       topology = topology_type::TOROIDAL;
@@ -119,26 +342,93 @@ int main(int argc, char* const argv[]) {
     std::cout << "Lambda = " << lambda << std::endl;
     std::cout << "Number of passes = " << passes << std::endl;
     std::cout << "Checkpoint every n passes = " << checkpoint << std::endl;
+    if (seed) std::cout << "Seed = " << *seed << std::endl;
     std::cout << "User = " << getEnvVar("USER") << std::endl;
     std::cout << "Hostname = " << hostname() << std::endl;
 
+    // Optionally append checkpoints to a single trajectory file
+    std::unique_ptr<Trajectory_writer> trajectory;
+    if (args["--trajectory"]) {
+      trajectory =
+          std::make_unique<Trajectory_writer>(args["--trajectory"].asString());
+      std::cout << "Recording checkpoints to "
+                << args["--trajectory"].asString() << std::endl;
+    }
+
+    // Optionally measure volume profiles while the passes go on
+    std::ofstream                         profiles;
+    std::unique_ptr<Measurement_pipeline> pipeline;
+    if (args["--profiles"]) {
+      auto profiles_file = args["--profiles"].asString();
+      profiles.open(profiles_file);
+      if (!profiles.is_open())
+        throw std::invalid_argument("Unable to open " + profiles_file);
+      pipeline = std::make_unique<Measurement_pipeline>();
+      pipeline->add_observer(Volume_profile_writer(profiles));
+      std::cout << "Measuring volume profiles every " << cadence
+                << " passes to " << profiles_file << std::endl;
+    }
+
+    // Toroidal universes have their own manifold type
+    if (topology == topology_type::TOROIDAL) {
+      if (args["--combinatorial"].asBool() || args["--optimistic"])
+        throw std::invalid_argument(
+            "Only spherical universes can be combinatorial.");
+      if (args["--save"])
+        throw std::invalid_argument("Only spherical universes can be saved.");
+      if (dimensions != 3)
+        throw std::invalid_argument("Currently, dimensions cannot be >3.");
+      if (std::abs(alpha) < 0.5)
+        throw std::domain_error("Alpha in 3D should be greater than 1/2.");
+      run_toroidal(static_cast<std::intmax_t>(simplices),
+                   static_cast<std::intmax_t>(timeslices), alpha, k, lambda,
+                   static_cast<std::intmax_t>(passes),
+                   static_cast<std::intmax_t>(checkpoint), trajectory.get(),
+                   seed, pipeline.get(), cadence, t);
+      Tracer::instance().stop();
+      return 0;
+    }
+
     // Initialize simulation
     Simulation my_simulation;
 
     // Initialize the Metropolis algorithm
     // \todo: add strong exception-safety guarantee on Metropolis functor
     Metropolis my_algorithm(alpha, k, lambda, passes, checkpoint);
+    if (trajectory) my_algorithm.record_trajectory(*trajectory);
+    if (seed) my_algorithm.use_seed(*seed);
+    if (pipeline) my_algorithm.publish_to(*pipeline, cadence);
 
     // Initialize triangulation
     SimplicialManifold universe;
 
     // Queue up simulation with desired algorithm
-    my_simulation.queue(
-        [&my_algorithm](SimplicialManifold s) { return my_algorithm(s); });
+    if (args["--optimistic"]) {
+      auto threads = static_cast<unsigned>(
+          std::stoul(args["--optimistic"].asString()));
+      my_simulation.queue(
+          [&my_algorithm, &trajectory, threads](SimplicialManifold& s) {
+            Optimistic_metropolis combinatorial(
+                my_algorithm.Alpha(), my_algorithm.K(), my_algorithm.Lambda(),
+                my_algorithm.Passes(), my_algorithm.Checkpoint(), threads);
+            run_combinatorial(s, my_algorithm, combinatorial,
+                              trajectory.get());
+          });
+    } else if (args["--combinatorial"].asBool()) {
+      my_simulation.queue([&my_algorithm, &trajectory](SimplicialManifold& s) {
+        Basic_metropolis<CombinatorialManifold> combinatorial(
+            my_algorithm.Alpha(), my_algorithm.K(), my_algorithm.Lambda(),
+            my_algorithm.Passes(), my_algorithm.Checkpoint());
+        run_combinatorial(s, my_algorithm, combinatorial, trajectory.get());
+      });
+    } else {
+      my_simulation.queue([&my_algorithm](SimplicialManifold& s) {
+        swap(s, my_algorithm(s));
+      });
+    }
 
     // Measure results
-    my_simulation.queue(
-        [](SimplicialManifold s) { return VolumePerTimeslice(s); });
+    my_simulation.queue([](SimplicialManifold& s) { VolumePerTimeslice(s); });
 
     // Ensure Triangle inequalities hold
     // See http://arxiv.org/abs/hep-th/0105267 for details
@@ -147,23 +437,41 @@ int main(int argc, char* const argv[]) {
       throw std::domain_error("Alpha in 3D should be greater than 1/2.");
     }
 
-    switch (topology) {
-      case topology_type::SPHERICAL:
-        if (dimensions == 3) {
-          SimplicialManifold populated_universe(simplices, timeslices);
-          // SimplicialManifold swapperator for no-throw
-          swap(universe, populated_universe);
-        } else {
-          t.stop();  // End running time counter
-          throw std::invalid_argument("Currently, dimensions cannot be >3.");
-        }
-        break;
-      case topology_type::TOROIDAL:
-        t.stop();  // End running time counter
-        throw std::invalid_argument(
-            "Toroidal triangulations not yet supported.");  // NOLINT
+    if (saved) {
+      // Rebuild the saved triangulation directly, without re-inserting points
+      Trace_span         span("Rebuild universe", "simulation");
+      SimplicialManifold loaded_universe = load_universe(saved.get());
+      swap(universe, loaded_universe);
+      my_algorithm.restore_moves(saved->attempted_moves,
+                                 saved->successful_moves, saved->passes);
+      // Continue the saved run's random numbers unless given another seed
+      if (!seed && saved->seed) my_algorithm.use_seed(*saved->seed);
+      std::cout << "Continuing from pass " << saved->passes << std::endl;
+      saved = boost::none;
+    } else {
+      switch (topology) {
+        case topology_type::SPHERICAL:
+          if (dimensions == 3) {
+            Trace_span         span("Generate universe", "simulation");
+            SimplicialManifold populated_universe(simplices, timeslices);
+            // SimplicialManifold swapperator for no-throw
+            swap(universe, populated_universe);
+          } else {
+            t.stop();  // End running time counter
+            throw std::invalid_argument(
+                "Currently, dimensions cannot be >3.");
+          }
+          break;
+        case topology_type::TOROIDAL:
+          // Handled by run_toroidal() above
+          break;
+      }
     }
 
+    // Number passes on from the last frame of the trajectory appended to
+    if (trajectory && trajectory->last_pass() > my_algorithm.PassOffset())
+      my_algorithm.start_after(trajectory->last_pass());
+
     if (!fix_timeslices(universe.triangulation)) {
       t.stop();  // End running time counter
       throw std::logic_error("Delaunay triangulation not correctly foliated.");
@@ -175,19 +483,43 @@ int main(int argc, char* const argv[]) {
 
     // The main work of the program
     universe = my_simulation.start(std::move(universe));
+    finish_measurements(pipeline.get());
 
     // Output results
     t.stop();  // End running time counter
     std::cout << "Final Delaunay triangulation has ";
     print_results(universe, t);
 
+    // Passes are numbered on from those of a loaded universe
+    auto last_pass =
+        my_algorithm.PassOffset() + static_cast<std::intmax_t>(passes);
+
     // Write results to file
     // Strong exception-safety guarantee
     // \todo: Fixup so that cell->info() and vertex->info() values
     //                   are written
-    write_file(universe, topology, dimensions,
-               universe.triangulation->number_of_finite_cells(), timeslices);
+    if (trajectory) {
+      // The last checkpoint already recorded the final universe
+      if (checkpoint == 0 || last_pass % checkpoint != 0) {
+        trajectory->append_universe(universe, last_pass,
+                                    my_algorithm.AttemptedMoves(),
+                                    my_algorithm.SuccessfulMoves());
+      }
+    } else {
+      write_file(universe, topology, dimensions,
+                 universe.triangulation->number_of_finite_cells(), timeslices);
+    }
+
+    // Save the universe to continue from with --load
+    if (args["--save"]) {
+      save_universe(args["--save"].asString(), universe,
+                    my_algorithm.AttemptedMoves(),
+                    my_algorithm.SuccessfulMoves(), last_pass,
+                    my_algorithm.Seed());
+    }
 
+    // Write remaining trace events
+    Tracer::instance().stop();
     return 0;
   } catch (std::domain_error& DomainError) {
     std::cerr << DomainError.what() << std::endl;
@@ -0,0 +1,231 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Tests for combinatorial ergodic moves: (2,3), (3,2), (2,6), (6,2)
+
+/// @file CombinatorialErgodicMovesTest.cpp
+/// @brief Tests for combinatorial ergodic moves
+/// @author Adam Getchell
+
+// clang-format off
+#include <utility>
+#include <vector>
+#include "CombinatorialErgodicMoves.h"
+#include "Metropolis.h"
+#include "MoveManager.h"
+#include "gmock/gmock.h"
+// clang-format on
+
+class CombinatorialErgodicMoveTest : public ::testing::Test {
+ public:
+  CombinatorialErgodicMoveTest()
+      : universe_{6400, 8}
+      , attempted_moves_{}
+      , N3_31_before{universe_.geometry->N3_31()}
+      , N3_22_before{universe_.geometry->N3_22()}
+      , N3_13_before{universe_.geometry->N3_13()}
+      , timelike_edges_before{universe_.geometry->N1_TL()}
+      , spacelike_edges_before{universe_.geometry->N1_SL()}
+      , vertices_before{universe_.geometry->N0()} {}
+
+  /// @brief Check that every cell is still causal and the triangulation
+  /// is valid
+  void expect_foliated() {
+    const auto& triangulation = *universe_.triangulation;
+    EXPECT_TRUE(triangulation.is_valid(true))
+        << "Triangulation is invalid after move.";
+    for (std::intmax_t c = 0; c < triangulation.number_of_cells(); ++c) {
+      EXPECT_TRUE(is_foliated(universe_, static_cast<Combinatorial_cell>(c)))
+          << "A cell doesn't span adjacent timeslices.";
+    }
+  }
+
+  /// @brief Combinatorial manifold containing pointer to triangulation
+  /// and geometric information.
+  CombinatorialManifold universe_;
+
+  /// @brief A count of all attempted moves.
+  Move_tracker attempted_moves_;
+
+  /// @brief Initial number of (3,1) simplices
+  std::intmax_t N3_31_before;
+
+  /// @brief Initial number of (2,2) simplices
+  std::intmax_t N3_22_before;
+
+  /// @brief Initial number of (1,3) simplices
+  std::intmax_t N3_13_before;
+
+  /// @brief Initial number of timelike edges
+  std::intmax_t timelike_edges_before;
+
+  /// @brief Initial number of spacelike edges
+  std::intmax_t spacelike_edges_before;
+
+  /// @brief Initial number of vertices
+  std::intmax_t vertices_before;
+};
+
+TEST_F(CombinatorialErgodicMoveTest, MakeA23Move) {
+  make_ergodic_move<move_type::TWO_THREE>(universe_, attempted_moves_);
+  reclassify(universe_);
+  expect_foliated();
+
+  EXPECT_EQ(universe_.geometry->N3_31(), N3_31_before)
+      << "(3,1) simplices changed.";
+
+  EXPECT_EQ(universe_.geometry->N3_22(), N3_22_before + 1)
+      << "(2,2) simplices did not increase by 1.";
+
+  EXPECT_EQ(universe_.geometry->N3_13(), N3_13_before)
+      << "(1,3) simplices changed.";
+
+  EXPECT_EQ(universe_.geometry->N1_TL(), timelike_edges_before + 1)
+      << "Timelike edges did not increase by 1.";
+
+  EXPECT_EQ(universe_.geometry->N1_SL(), spacelike_edges_before)
+      << "Spacelike edges changed.";
+
+  EXPECT_EQ(attempted_moves_[0], 1) << "A (2,3) move took more than 1 try.";
+}
+
+TEST_F(CombinatorialErgodicMoveTest, MakeA32Move) {
+  // Make a (3,2) move possible
+  make_ergodic_move<move_type::TWO_THREE>(universe_, attempted_moves_);
+  reclassify(universe_);
+  make_ergodic_move<move_type::THREE_TWO>(universe_, attempted_moves_);
+  reclassify(universe_);
+  expect_foliated();
+
+  EXPECT_EQ(universe_.geometry->N3_22(), N3_22_before)
+      << "(2,2) simplices did not decrease by 1.";
+
+  EXPECT_EQ(universe_.geometry->N1_TL(), timelike_edges_before)
+      << "Timelike edges did not decrease by 1.";
+
+  EXPECT_EQ(universe_.geometry->N0(), vertices_before)
+      << "Vertices changed.";
+}
+
+TEST_F(CombinatorialErgodicMoveTest, MakeA26Move) {
+  make_ergodic_move<move_type::TWO_SIX>(universe_, attempted_moves_);
+  reclassify(universe_);
+  expect_foliated();
+
+  EXPECT_EQ(universe_.geometry->N3_31(), N3_31_before + 2)
+      << "(3,1) simplices did not increase by 2.";
+
+  EXPECT_EQ(universe_.geometry->N3_13(), N3_13_before + 2)
+      << "(1,3) simplices did not increase by 2.";
+
+  EXPECT_EQ(universe_.geometry->N1_TL(), timelike_edges_before + 2)
+      << "Timelike edges did not increase by 2.";
+
+  EXPECT_EQ(universe_.geometry->N1_SL(), spacelike_edges_before + 3)
+      << "Spacelike edges did not increase by 3.";
+
+  EXPECT_EQ(universe_.geometry->N0(), vertices_before + 1)
+      << "A vertex was not added to the triangulation.";
+}
+
+TEST_F(CombinatorialErgodicMoveTest, MakeA62MoveUndoesA26Move) {
+  // The new vertex of a (2,6) move can always be collapsed
+  make_ergodic_move<move_type::TWO_SIX>(universe_, attempted_moves_);
+  reclassify(universe_);
+  auto added = last_move_vertices<Combinatorial_vertex>().front();
+  ASSERT_TRUE(universe_.triangulation->is_62_movable(added))
+      << "The vertex added by a (2,6) move isn't (6,2) movable.";
+
+  universe_.triangulation->collapse_62(added);
+  reclassify(universe_);
+  expect_foliated();
+
+  EXPECT_EQ(universe_.geometry->N3_31(), N3_31_before)
+      << "(3,1) simplices weren't restored.";
+
+  EXPECT_EQ(universe_.geometry->N3_13(), N3_13_before)
+      << "(1,3) simplices weren't restored.";
+
+  EXPECT_EQ(universe_.geometry->N1_TL(), timelike_edges_before)
+      << "Timelike edges weren't restored.";
+
+  EXPECT_EQ(universe_.geometry->N1_SL(), spacelike_edges_before)
+      << "Spacelike edges weren't restored.";
+
+  EXPECT_EQ(universe_.geometry->N0(), vertices_before)
+      << "The vertex wasn't removed.";
+}
+
+TEST_F(CombinatorialErgodicMoveTest, UndoEachMove) {
+  for (auto move : {move_type::TWO_THREE, move_type::THREE_TWO,
+                    move_type::TWO_SIX, move_type::SIX_TWO}) {
+    switch (move) {
+      case move_type::TWO_THREE:
+        make_ergodic_move<move_type::TWO_THREE>(universe_, attempted_moves_);
+        break;
+      case move_type::THREE_TWO:
+        make_ergodic_move<move_type::THREE_TWO>(universe_, attempted_moves_);
+        break;
+      case move_type::TWO_SIX:
+        make_ergodic_move<move_type::TWO_SIX>(universe_, attempted_moves_);
+        break;
+      default:
+        make_ergodic_move<move_type::SIX_TWO>(universe_, attempted_moves_);
+        break;
+    }
+    ASSERT_TRUE(last_move_record<CombinatorialManifold>().move == move)
+        << "The move wasn't recorded.";
+
+    undo_move(universe_);
+    reclassify(universe_);
+    expect_foliated();
+
+    EXPECT_EQ(universe_.geometry->N3_31(), N3_31_before)
+        << "(3,1) simplices weren't restored.";
+
+    EXPECT_EQ(universe_.geometry->N3_22(), N3_22_before)
+        << "(2,2) simplices weren't restored.";
+
+    EXPECT_EQ(universe_.geometry->N3_13(), N3_13_before)
+        << "(1,3) simplices weren't restored.";
+
+    EXPECT_EQ(universe_.geometry->N1_TL(), timelike_edges_before)
+        << "Timelike edges weren't restored.";
+
+    EXPECT_EQ(universe_.geometry->N1_SL(), spacelike_edges_before)
+        << "Spacelike edges weren't restored.";
+
+    EXPECT_EQ(universe_.geometry->N0(), vertices_before)
+        << "Vertices weren't restored.";
+  }
+}
+
+TEST_F(CombinatorialErgodicMoveTest, MoveManagerChecksEachMove) {
+  auto maybe_universe   = boost::make_optional(true, universe_);
+  auto maybe_move_count = boost::make_optional(true, attempted_moves_);
+  MoveManager<decltype(maybe_universe), decltype(maybe_move_count)> manager(
+      std::move(maybe_universe), std::move(maybe_move_count));
+
+  EXPECT_TRUE(manager.make_move(move_type::TWO_SIX))
+      << "(2,6) move failed its checks.";
+
+  EXPECT_TRUE(manager.make_move(move_type::SIX_TWO))
+      << "(6,2) move failed its checks.";
+
+  EXPECT_TRUE(manager.make_move(move_type::TWO_THREE))
+      << "(2,3) move failed its checks.";
+
+  EXPECT_TRUE(manager.make_move(move_type::THREE_TWO))
+      << "(3,2) move failed its checks.";
+}
+
+TEST_F(CombinatorialErgodicMoveTest, MetropolisRuns) {
+  Basic_metropolis<CombinatorialManifold> testrun(0.6, 1.1, 0.1, 1, 1);
+  testrun(universe_);
+
+  EXPECT_GT(testrun.TotalMoves(), 0) << "No moves were attempted.";
+
+  EXPECT_GT(testrun.SuccessfulTwoSixMoves(), 0)
+      << "No (2,6) moves succeeded.";
+}
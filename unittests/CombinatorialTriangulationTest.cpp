@@ -0,0 +1,153 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Tests that combinatorial triangulations match the Delaunay
+/// triangulations they are made from.
+
+/// @file CombinatorialTriangulationTest.cpp
+/// @brief Tests for flat, coordinate-free foliated triangulations
+/// @author Adam Getchell
+
+// clang-format off
+#include <utility>
+
+#include "CombinatorialErgodicMoves.h"
+#include "CombinatorialManifold.h"
+#include "Measurements.h"
+#include "gmock/gmock.h"
+// clang-format on
+
+class CombinatorialTriangulationTest : public ::testing::Test {
+ public:
+  CombinatorialTriangulationTest()
+      : simplicial_{6400, 8}, universe_{simplicial_} {}
+
+  /// @brief The Delaunay triangulation converted
+  SimplicialManifold simplicial_;
+
+  /// @brief Its combinatorial copy
+  CombinatorialManifold universe_;
+};
+
+TEST_F(CombinatorialTriangulationTest, CountsMatchDelaunay) {
+  const auto& triangulation = *universe_.triangulation;
+  EXPECT_TRUE(triangulation.is_valid(true))
+      << "Converted triangulation is invalid.";
+
+  EXPECT_EQ(universe_.geometry->N3_31(), simplicial_.geometry->N3_31())
+      << "(3,1) simplices don't match.";
+
+  EXPECT_EQ(universe_.geometry->N3_22(), simplicial_.geometry->N3_22())
+      << "(2,2) simplices don't match.";
+
+  EXPECT_EQ(universe_.geometry->N3_13(), simplicial_.geometry->N3_13())
+      << "(1,3) simplices don't match.";
+
+  EXPECT_EQ(universe_.geometry->N1_TL(), simplicial_.geometry->N1_TL())
+      << "Timelike edges don't match.";
+
+  EXPECT_EQ(universe_.geometry->N1_SL(), simplicial_.geometry->N1_SL())
+      << "Spacelike edges don't match.";
+
+  EXPECT_EQ(universe_.geometry->N0(), simplicial_.geometry->N0())
+      << "Vertices don't match.";
+
+  EXPECT_EQ(triangulation.number_of_cells(),
+            simplicial_.triangulation->number_of_cells())
+      << "Infinite cells don't match.";
+
+  EXPECT_EQ(triangulation.number_of_finite_facets(),
+            simplicial_.triangulation->number_of_finite_facets())
+      << "Facets don't match.";
+}
+
+TEST_F(CombinatorialTriangulationTest, ConvertsBack) {
+  Move_tracker attempted_moves{};
+  make_ergodic_move<move_type::TWO_SIX>(universe_, attempted_moves);
+  make_ergodic_move<move_type::TWO_THREE>(universe_, attempted_moves);
+  reclassify(universe_);
+
+  auto converted = to_simplicial_manifold(universe_);
+  EXPECT_TRUE(converted.triangulation->tds().is_valid())
+      << "Converted Delaunay triangulation is invalid.";
+
+  EXPECT_EQ(converted.geometry->number_of_cells(),
+            universe_.geometry->number_of_cells())
+      << "Cells weren't converted.";
+
+  EXPECT_EQ(converted.geometry->number_of_edges(),
+            universe_.geometry->number_of_edges())
+      << "Edges weren't converted.";
+
+  EXPECT_EQ(converted.geometry->N0(), universe_.geometry->N0())
+      << "Vertices weren't converted.";
+
+  VolumePerTimeslice(converted);
+  VolumePerTimeslice(universe_);
+  for (const auto& timeslice : *universe_.geometry->spacelike_facets) {
+    EXPECT_EQ(static_cast<std::intmax_t>(
+                  converted.geometry->spacelike_facets->count(timeslice.first)),
+              timeslice.second)
+        << "Timeslice " << timeslice.first << " has the wrong volume.";
+  }
+}
+
+TEST_F(CombinatorialTriangulationTest, CopiesAreIndependent) {
+  CombinatorialManifold copy(universe_);
+  Move_tracker          attempted_moves{};
+  make_ergodic_move<move_type::TWO_SIX>(copy, attempted_moves);
+  reclassify(copy);
+
+  EXPECT_EQ(copy.geometry->N0(), universe_.geometry->N0() + 1)
+      << "The copy didn't gain a vertex.";
+
+  EXPECT_EQ(universe_.triangulation->number_of_vertices(),
+            simplicial_.geometry->N0())
+      << "The original changed.";
+
+  EXPECT_TRUE(universe_.triangulation->is_valid(true))
+      << "The original is invalid.";
+}
+
+TEST_F(CombinatorialTriangulationTest, MovesChangeTheVersionsOfTheirCells) {
+  auto&         triangulation = *universe_.triangulation;
+  std::intmax_t draws{0};
+  auto          choice = choose_candidate(
+      triangulation.number_of_cells(),
+      [](std::intmax_t) { return true; },
+      [&triangulation](const std::intmax_t cell) {
+        int i{0};
+        return triangulation.is_26_movable(
+            static_cast<Combinatorial_cell>(cell), i);
+      },
+      draws);
+  ASSERT_GE(choice, 0) << "No (2,6) move is possible.";
+  auto cell = static_cast<Combinatorial_cell>(choice);
+  int  i{0};
+  triangulation.is_26_movable(cell, i);
+  auto other             = triangulation.neighbor(cell, i);
+  auto bystander         = triangulation.neighbor(cell, (i + 1) & 3);
+  auto cell_version      = triangulation.version(cell);
+  auto other_version     = triangulation.version(other);
+  auto bystander_version = triangulation.version(bystander);
+
+  triangulation.insert_in_facet(cell, i);
+  EXPECT_NE(triangulation.version(cell), cell_version)
+      << "A replaced cell kept its version.";
+  EXPECT_NE(triangulation.version(other), other_version)
+      << "A replaced cell kept its version.";
+  EXPECT_EQ(triangulation.version(bystander), bystander_version)
+      << "A neighboring cell changed its version.";
+
+  // Collapsing the new vertex renumbers cells, which changes them too
+  auto center = static_cast<Combinatorial_vertex>(
+      triangulation.number_of_vertices() - 1);
+  auto last =
+      static_cast<Combinatorial_cell>(triangulation.number_of_cells() - 1);
+  auto last_version = triangulation.version(last);
+  triangulation.collapse_62(center);
+  EXPECT_NE(triangulation.version(last), last_version)
+      << "A deleted cell kept its version.";
+  EXPECT_TRUE(triangulation.is_valid(true)) << "Triangulation is invalid.";
+}
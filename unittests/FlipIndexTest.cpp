@@ -0,0 +1,92 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Tests for the indexes of (2,3)-flippable facets and (3,2)-flippable
+/// edges.
+
+/// @file FlipIndexTest.cpp
+/// @brief Tests for FlipIndex.h
+/// @author Adam Getchell
+
+#include <array>
+
+#include "FlipIndex.h"
+#include "gmock/gmock.h"
+
+class FlipIndexTest : public ::testing::Test {
+ public:
+  /// @brief Stand-ins for cells, whose pointers serve as Cell_handles
+  std::array<int, 3> cells_{};
+
+  /// @brief An index over the stand-in cells
+  Flip_index<int*> index_;
+};
+
+TEST_F(FlipIndexTest, InsertsEachFacetOnce) {
+  EXPECT_TRUE(index_.insert(&cells_[0], 1)) << "Facet wasn't inserted.";
+  EXPECT_FALSE(index_.insert(&cells_[0], 1)) << "Facet was inserted twice.";
+  EXPECT_TRUE(index_.insert(&cells_[0], 2)) << "Second facet wasn't inserted.";
+
+  EXPECT_EQ(index_.size(), 2) << "Index has the wrong size.";
+  EXPECT_TRUE(index_.contains(&cells_[0], 1)) << "Facet is missing.";
+  EXPECT_FALSE(index_.contains(&cells_[0], 3)) << "Facet wasn't inserted.";
+  EXPECT_FALSE(index_.contains(&cells_[1], 1)) << "Cell wasn't inserted.";
+}
+
+TEST_F(FlipIndexTest, ErasingKeepsTheRestDrawable) {
+  for (auto& cell : cells_) {
+    for (auto i = 0; i < 4; ++i) index_.insert(&cell, i);
+  }
+  EXPECT_TRUE(index_.erase(&cells_[0], 0)) << "Facet wasn't erased.";
+  EXPECT_FALSE(index_.erase(&cells_[0], 0)) << "Facet was erased twice.";
+  index_.erase(&cells_[1]);
+
+  EXPECT_EQ(index_.size(), 7) << "Index has the wrong size.";
+  EXPECT_FALSE(index_.contains(&cells_[1], 2)) << "Cell wasn't erased.";
+
+  // Every position still holds a facet the index contains
+  for (std::size_t n = 0; n < index_.size(); ++n) {
+    EXPECT_TRUE(index_.contains(index_[n].first, index_[n].second))
+        << "Position " << n << " is stale.";
+    EXPECT_NE(index_[n].first, &cells_[1]) << "Erased cell is drawable.";
+  }
+
+  index_.clear();
+  EXPECT_TRUE(index_.empty()) << "Index wasn't cleared.";
+}
+
+TEST(EdgeIndexTest, KeysEdgesInEitherOrder) {
+  std::array<int, 3> vertices{};
+  Edge_index<int*>   index;
+  index.set_degree(&vertices[0], &vertices[1], 3);
+  EXPECT_EQ(index.degree(&vertices[1], &vertices[0]), 3)
+      << "Edge degree depends on the order of its vertices.";
+
+  EXPECT_TRUE(index.insert(&vertices[1], &vertices[0])) << "Edge not added.";
+  EXPECT_FALSE(index.insert(&vertices[0], &vertices[1])) << "Edge added twice.";
+  EXPECT_TRUE(index.insert(&vertices[1], &vertices[2])) << "Edge not added.";
+  EXPECT_EQ(index.size(), 2) << "Set has the wrong size.";
+
+  EXPECT_TRUE(index.erase(&vertices[0], &vertices[1])) << "Edge not erased.";
+  EXPECT_EQ(index.degree(&vertices[0], &vertices[1]), 3)
+      << "Erasing an edge from the set forgot its degree.";
+  EXPECT_TRUE(index.contains(index[0].first, index[0].second))
+      << "The remaining edge is stale.";
+
+  index.forget(&vertices[2], &vertices[1]);
+  EXPECT_TRUE(index.empty()) << "Forgotten edge is still in the set.";
+  EXPECT_EQ(index.number_of_edges(), 1) << "Edge wasn't forgotten.";
+}
+
+TEST(EdgeIndexTest, VisitsEachEdgeOncePerPass) {
+  std::array<int, 2> vertices{};
+  Edge_index<int*>   index;
+  index.begin_pass();
+  EXPECT_TRUE(index.visit(&vertices[0], &vertices[1])) << "Edge not visited.";
+  EXPECT_FALSE(index.visit(&vertices[1], &vertices[0]))
+      << "Edge visited twice in a pass.";
+  index.begin_pass();
+  EXPECT_TRUE(index.visit(&vertices[1], &vertices[0]))
+      << "Edge not visited in a new pass.";
+}
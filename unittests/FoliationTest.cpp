@@ -0,0 +1,64 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Tests for simplex types and move deltas of D-dimensional foliations.
+
+/// @file FoliationTest.cpp
+/// @brief Tests for Foliation.h
+/// @author Adam Getchell
+
+#include <array>
+#include <cstdint>
+
+#include "Foliation.h"
+#include "gmock/gmock.h"
+
+// Classification happens at compile time
+static_assert(Foliation<3>::classify(std::array<int, 4>{{1, 1, 1, 2}}) == 31,
+              "A (3,1) simplex is misclassified.");
+static_assert(Foliation<4>::classify(std::array<int, 5>{{2, 2, 3, 3, 3}}) ==
+                  23,
+              "A (2,3) simplex is misclassified.");
+
+TEST(FoliationTest, SimplexTypesOfEachDimension) {
+  EXPECT_THAT(Foliation<3>::SIMPLEX_TYPES, ::testing::ElementsAre(31, 22, 13))
+      << "(2+1) simplex types are wrong.";
+
+  EXPECT_THAT(Foliation<4>::SIMPLEX_TYPES,
+              ::testing::ElementsAre(41, 32, 23, 14))
+      << "(3+1) simplex types are wrong.";
+
+  for (std::size_t i = 0; i < Foliation<4>::SIMPLEX_TYPES.size(); ++i) {
+    EXPECT_EQ(Foliation<4>::type_index(Foliation<4>::SIMPLEX_TYPES[i]), i)
+        << "A simplex type has the wrong index.";
+  }
+}
+
+TEST(FoliationTest, ClassifiesSimplicesSpanningOneTimeslice) {
+  using Timevalues = std::array<std::intmax_t, 5>;
+
+  EXPECT_EQ(Foliation<4>::classify(Timevalues{{4, 4, 4, 4, 5}}), 41)
+      << "A (4,1) simplex is misclassified.";
+
+  EXPECT_EQ(Foliation<4>::classify(Timevalues{{5, 4, 5, 5, 5}}), 14)
+      << "A (1,4) simplex is misclassified.";
+
+  EXPECT_EQ(Foliation<4>::classify(Timevalues{{3, 3, 3, 3, 3}}), 0)
+      << "A simplex on one timeslice was classified.";
+
+  EXPECT_EQ(Foliation<4>::classify(Timevalues{{3, 3, 4, 4, 5}}), 0)
+      << "A simplex spanning two timeslices was classified.";
+}
+
+TEST(FoliationTest, MovesPreserveTheEulerCharacteristic) {
+  // Vertices - edges + facets - cells is unchanged, where each cell has 4
+  // facets and each facet 2 cells
+  for (const auto& delta : Foliated_moves<3>::DELTAS) {
+    auto cells  = delta[0] + delta[1] + delta[2];
+    auto edges  = delta[3] + delta[4];
+    auto facets = 2 * cells;
+    EXPECT_EQ(delta[5] - edges + facets - cells, 0)
+        << "A move changes the Euler characteristic.";
+  }
+}
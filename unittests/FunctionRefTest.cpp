@@ -59,6 +59,7 @@ TEST(FunctionRefTest, DISABLED_ComplexLambda) {
   };
 
   test_universe = move_23_lambda(test_universe, moves);
+  reclassify(test_universe);
   std::cout << "Attempted (2,3) moves = " << std::get<0>(moves) << std::endl;
 
   /// \todo Figure out why move_23_lambda invalidates the tds
@@ -115,6 +116,7 @@ TEST(FunctionRefTest, ComplexFunctionRef) {
       complex_ref(move_23_lambda);
 
   test_universe = complex_ref(test_universe, moves);
+  reclassify(test_universe);
   std::cout << "Attempted (2,3) moves = " << moves[0] << std::endl;
 
   EXPECT_TRUE(test_universe.triangulation->tds().is_valid(true))
@@ -174,6 +176,7 @@ TEST(FunctionRefTest, ComplexFunctionRefWithOptionals) {
 
   maybe_moved_universe =
       complex_ref(maybe_moved_universe.get(), maybe_move_count.get());
+  reclassify(maybe_moved_universe.get());
 
   //  test_universe = complex_ref(test_universe, moves);
   std::cout << "Attempted (2,3) moves = " << maybe_move_count.get()[0]
@@ -0,0 +1,94 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Tests for phase timers and retry histograms.
+
+/// @file InstrumentationTest.cpp
+/// @brief Tests for hot-path instrumentation
+/// @author Adam Getchell
+
+#include <thread>  // NOLINT
+
+#include "Instrumentation.h"
+#include "gmock/gmock.h"
+
+class InstrumentationTest : public ::testing::Test {
+ protected:
+  InstrumentationTest() { Instrumentation::instance().reset(); }
+};
+
+TEST(Instrumentation, RetryBuckets) {
+  EXPECT_EQ(retry_bucket(1), 0) << "1 attempt not in the first bucket.";
+
+  EXPECT_EQ(retry_bucket(2), 1) << "2 attempts not in the second bucket.";
+
+  EXPECT_EQ(retry_bucket(3), 1) << "3 attempts not in the second bucket.";
+
+  EXPECT_EQ(retry_bucket(4), 2) << "4 attempts not in the third bucket.";
+
+  EXPECT_EQ(retry_bucket(1000000), RETRY_BUCKETS - 1)
+      << "Many attempts not in the last bucket.";
+}
+
+TEST_F(InstrumentationTest, ScopedPhaseTimer) {
+  {
+    Scoped_phase_timer timer(phase::MOVE);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  auto report = Instrumentation::instance().report();
+
+  EXPECT_EQ(report.calls[static_cast<std::size_t>(phase::MOVE)], 1)
+      << "Timer didn't count its phase.";
+
+  EXPECT_GE(report.nanoseconds[static_cast<std::size_t>(phase::MOVE)],
+            1000000)
+      << "Timer didn't record the elapsed time.";
+
+  EXPECT_EQ(report.calls[static_cast<std::size_t>(phase::VALIDATION)], 0)
+      << "Timer counted the wrong phase.";
+}
+
+TEST_F(InstrumentationTest, NestedPhasesAreExclusive) {
+  {
+    Scoped_phase_timer outer(phase::MOVE);
+    Scoped_phase_timer inner(phase::CLASSIFICATION);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  auto report = Instrumentation::instance().report();
+
+  EXPECT_GE(report.nanoseconds[static_cast<std::size_t>(phase::CLASSIFICATION)],
+            10000000)
+      << "The nested timer didn't record the elapsed time.";
+
+  EXPECT_LT(report.nanoseconds[static_cast<std::size_t>(phase::MOVE)],
+            report.nanoseconds[static_cast<std::size_t>(phase::CLASSIFICATION)])
+      << "The outer timer counted the nested phase.";
+}
+
+TEST_F(InstrumentationTest, ThreadsAreSummed) {
+  auto work = [] {
+    for (auto i = 0; i < 100; ++i) {
+      Instrumentation::record_phase(phase::PROPOSAL, 1);
+      Instrumentation::record_retries(0, 5);
+    }
+  };
+  std::thread first(work);
+  std::thread second(work);
+  first.join();
+  second.join();
+  work();
+  auto report = Instrumentation::instance().report();
+
+  EXPECT_EQ(report.calls[static_cast<std::size_t>(phase::PROPOSAL)], 300)
+      << "Counts from exited and live threads weren't summed.";
+
+  EXPECT_EQ(report.retries[0][retry_bucket(5)], 300)
+      << "Retry histogram wasn't summed.";
+
+  Instrumentation::instance().reset();
+  report = Instrumentation::instance().report();
+
+  EXPECT_EQ(report.calls[static_cast<std::size_t>(phase::PROPOSAL)], 0)
+      << "reset() didn't zero the counters.";
+}
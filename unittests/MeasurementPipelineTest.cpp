@@ -0,0 +1,147 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Tests for measurements of snapshots taken while the passes go on
+
+/// @file MeasurementPipelineTest.cpp
+/// @brief Tests for MeasurementPipeline.h
+/// @author Adam Getchell
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "MeasurementPipeline.h"
+#include "Metropolis.h"
+#include "gmock/gmock.h"
+
+TEST(MeasurementPipelineTest, QueueIsFirstInFirstOut) {
+  Bounded_queue<int> queue(3);
+  for (auto n : {1, 2, 3}) {
+    EXPECT_TRUE(queue.try_push(n)) << "A queue with room refused a value.";
+  }
+  auto extra = 4;
+  EXPECT_FALSE(queue.try_push(extra)) << "A full queue took a value.";
+
+  int value{0};
+  for (auto n : {1, 2, 3}) {
+    ASSERT_TRUE(queue.try_pop(value)) << "A value was lost.";
+    EXPECT_EQ(value, n) << "Values came out of order.";
+  }
+  EXPECT_FALSE(queue.try_pop(value)) << "An empty queue gave a value.";
+}
+
+TEST(MeasurementPipelineTest, MeasuresEveryFrameOnce) {
+  Thread_pool                  pool(4);
+  Measurement_pipeline         pipeline(2, 0, pool);
+  std::mutex                   passes_mutex;
+  std::multiset<std::intmax_t> passes;
+  pipeline.add_observer([&](const Measurement_frame& frame) {
+    std::lock_guard<std::mutex> lock(passes_mutex);
+    passes.insert(frame.pass);
+  });
+
+  for (std::intmax_t pass = 1; pass <= 100; ++pass) {
+    pipeline.publish(Snapshot{}, pass, {}, {});
+  }
+  pipeline.finish();
+
+  EXPECT_EQ(pipeline.Measured(), 100) << "Frames weren't all measured.";
+  EXPECT_EQ(passes.size(), 100u) << "Frames weren't all measured.";
+  for (std::intmax_t pass = 1; pass <= 100; ++pass) {
+    EXPECT_EQ(passes.count(pass), 1u) << "A frame wasn't measured once.";
+  }
+}
+
+TEST(MeasurementPipelineTest, FullQueueMeasuresOnlyItsOwnFrames) {
+  // Like a chain inside a sweep: the only worker is publishing, so a full
+  // queue must not hand it a task that waits for the chain to finish
+  Thread_pool        pool(1);
+  std::promise<void> started;
+  std::promise<void> finished;
+  auto               done  = finished.get_future().share();
+  auto               chain = pool.submit([&] {
+    started.set_value();
+    Measurement_pipeline pipeline(2, 0, pool);
+    pipeline.add_observer([](const Measurement_frame&) {});
+    for (std::intmax_t pass = 1; pass <= 10; ++pass) {
+      pipeline.publish(Snapshot{}, pass, {}, {});
+    }
+    pipeline.finish();
+    finished.set_value();
+    return pipeline.Measured();
+  });
+  started.get_future().wait();
+  auto other = pool.submit([done] { done.wait(); });
+
+  EXPECT_EQ(pool.wait(chain), 10) << "Frames weren't all measured.";
+  pool.wait(other);
+}
+
+TEST(MeasurementPipelineTest, FinishRethrows) {
+  Thread_pool          pool(2);
+  Measurement_pipeline pipeline(2, 0, pool);
+  pipeline.add_observer([](const Measurement_frame& frame) {
+    if (frame.pass == 3) throw std::runtime_error("Failed.");
+  });
+  for (std::intmax_t pass = 1; pass <= 5; ++pass) {
+    pipeline.publish(Snapshot{}, pass, {}, {});
+  }
+  EXPECT_THROW(pipeline.finish(), std::runtime_error)
+      << "An exception in an observer was lost.";
+
+  EXPECT_THROW(pipeline.add_observer([](const Measurement_frame&) {}),
+               std::logic_error)
+      << "An observer was added after frames were published.";
+}
+
+TEST(MeasurementPipelineTest, WritesVolumeProfiles) {
+  SimplicialManifold universe(640, 4);
+  auto               snapshot = make_snapshot(universe);
+  auto               volumes  = volume_per_timeslice(snapshot);
+
+  std::ostringstream   profiles;
+  Measurement_pipeline pipeline;
+  pipeline.add_observer(Volume_profile_writer(profiles));
+  pipeline.publish(std::move(snapshot), 7, {}, {});
+  pipeline.finish();
+
+  std::istringstream rows(profiles.str());
+  std::string        row;
+  std::getline(rows, row);
+  EXPECT_EQ(row, "pass,timeslice,volume") << "The header is missing.";
+  for (const auto& [timeslice, volume] : volumes) {
+    std::getline(rows, row);
+    EXPECT_EQ(row, "7," + std::to_string(timeslice) + "," +
+                       std::to_string(volume))
+        << "A volume was written wrong.";
+  }
+}
+
+TEST(MeasurementPipelineTest, MetropolisPublishesAtCadence) {
+  SimplicialManifold   universe(640, 4);
+  Measurement_pipeline pipeline;
+  std::atomic_intmax_t largest_pass{0};
+  pipeline.add_observer([&largest_pass](const Measurement_frame& frame) {
+    auto pass = largest_pass.load();
+    while (pass < frame.pass &&
+           !largest_pass.compare_exchange_weak(pass, frame.pass)) {
+    }
+  });
+
+  Metropolis testrun(0.6, 1.1, 0.1, 4, 1);
+  testrun.publish_to(pipeline, 2);
+  swap(universe, testrun(universe));
+  pipeline.finish();
+
+  EXPECT_EQ(pipeline.Published(), 2) << "Wrong number of frames published.";
+  EXPECT_EQ(largest_pass, 4) << "The last pass wasn't published.";
+
+  EXPECT_THROW(testrun.publish_to(pipeline, 0), std::invalid_argument)
+      << "A cadence of zero passes was accepted.";
+}
@@ -135,6 +135,92 @@ TEST_F(MetropolisTest, Ctor) {
       << "SuccessfulFourFourMoves not initialized to 0.";
 }
 
+TEST_F(MetropolisTest, RestoreMoves) {
+  Metropolis   testrun(Alpha, K, Lambda, passes, output_every_n_passes);
+  Move_tracker attempted{{5, 4, 3, 2, 0}};
+  Move_tracker successful{{2, 2, 1, 1, 0}};
+  testrun.restore_moves(attempted, successful, 30);
+
+  EXPECT_EQ(testrun.AttemptedMoves(), attempted)
+      << "Attempted moves weren't restored.";
+
+  EXPECT_EQ(testrun.SuccessfulMoves(), successful)
+      << "Successful moves weren't restored.";
+
+  EXPECT_EQ(testrun.TotalMoves(), 14) << "Total moves don't add up.";
+
+  EXPECT_EQ(testrun.PassOffset(), 30) << "Passes don't follow on.";
+}
+
+TEST_F(MetropolisTest, FlippableFacetsPersist) {
+  Metropolis testrun(Alpha, K, Lambda, 0, output_every_n_passes);
+  auto&      result        = testrun(universe_);
+  const auto triangulation = result.triangulation.get();
+  const auto builds        = flip_index_builds()[0];
+
+  for (auto attempt = 0; attempt < 20; ++attempt)
+    testrun.make_move(move_type::TWO_THREE);
+
+  EXPECT_EQ(flip_index_builds()[0], builds)
+      << "Flippable facets were rebuilt between attempts.";
+
+  EXPECT_EQ(result.triangulation.get(), triangulation)
+      << "Attempts were made on a copy of the manifold.";
+
+  ASSERT_TRUE(result.flippable_facets) << "Flippable facets were dropped.";
+
+  // Compare the maintained index with one built from scratch
+  auto maintained         = *result.flippable_facets;
+  result.flippable_facets = boost::none;
+  const auto& rebuilt     = flippable_23_facets(result);
+  EXPECT_EQ(maintained.size(), rebuilt.size())
+      << "The index has the wrong number of flippable facets.";
+  for (std::size_t n = 0; n < rebuilt.size(); ++n) {
+    EXPECT_TRUE(maintained.contains(rebuilt[n].first, rebuilt[n].second))
+        << "A flippable facet is missing from the index.";
+  }
+}
+
+TEST_F(MetropolisTest, FlippableEdgesPersist) {
+  Metropolis testrun(Alpha, K, Lambda, 0, output_every_n_passes);
+  auto&      result        = testrun(universe_);
+  const auto triangulation = result.triangulation.get();
+  const auto builds        = flip_index_builds()[1];
+
+  for (auto attempt = 0; attempt < 10; ++attempt) {
+    testrun.make_move(move_type::TWO_THREE);
+    testrun.make_move(move_type::THREE_TWO);
+  }
+
+  EXPECT_EQ(flip_index_builds()[1], builds)
+      << "Edge degrees were recounted between proposals.";
+
+  EXPECT_EQ(result.triangulation.get(), triangulation)
+      << "Proposals were made on a copy of the manifold.";
+
+  ASSERT_TRUE(result.flippable_edges) << "Flippable edges were dropped.";
+
+  // Compare the maintained degrees and index with ones built from scratch
+  auto maintained        = *result.flippable_edges;
+  result.flippable_edges = boost::none;
+  const auto& rebuilt    = flippable_32_edges(result);
+  EXPECT_EQ(maintained.number_of_edges(), rebuilt.number_of_edges())
+      << "Degrees are known for the wrong number of edges.";
+  EXPECT_EQ(maintained.size(), rebuilt.size())
+      << "The index has the wrong number of flippable edges.";
+  for (std::size_t n = 0; n < rebuilt.size(); ++n) {
+    EXPECT_TRUE(maintained.contains(rebuilt[n].first, rebuilt[n].second))
+        << "A flippable edge is missing from the index.";
+  }
+  for (const auto& edge : result.geometry->timelike_edges) {
+    auto cell = std::get<0>(edge);
+    auto u    = cell->vertex(static_cast<int>(std::get<1>(edge)));
+    auto v    = cell->vertex(static_cast<int>(std::get<2>(edge)));
+    EXPECT_EQ(maintained.degree(u, v), rebuilt.degree(u, v))
+        << "An edge has the wrong degree.";
+  }
+}
+
 // This test can take a long time
 // Here lie Segfaults
 TEST_F(MetropolisTest, DISABLED_Operator) {
@@ -207,6 +207,36 @@ TEST_F(MoveManagerTest, Swapperator) {
       << "Swapped universe has incorrect number of (1,3) simplices.";
 }
 
+TEST_F(MoveManagerTest, MovesKeepGeometry) {
+  const auto* geometry = universe_.geometry.get();
+
+  SimplicialManifold moved{std::move(universe_)};
+
+  EXPECT_EQ(moved.geometry.get(), geometry)
+      << "Move constructor recalculated the geometry.";
+
+  // Chained moves assign a manifold to itself
+  auto& same = moved;
+  moved      = std::move(same);
+
+  EXPECT_EQ(moved.geometry.get(), geometry)
+      << "Self move assignment recalculated the geometry.";
+
+  universe_ = std::move(moved);
+
+  EXPECT_EQ(universe_.geometry.get(), geometry)
+      << "Move assignment recalculated the geometry.";
+
+  EXPECT_EQ(universe_.geometry->N3_31(), N3_31_before)
+      << "Moved universe has incorrect number of (3,1) simplices.";
+
+  EXPECT_EQ(universe_.geometry->N1_TL(), timelike_edges_before)
+      << "Moved universe has incorrect number of timelike edges.";
+
+  EXPECT_EQ(universe_.geometry->N0(), vertices_before)
+      << "Moved universe has incorrect number of vertices.";
+}
+
 TEST_F(MoveManagerTest, OptionTypesTest) {
   EXPECT_TRUE(universe_.triangulation->tds().is_valid(true))
       << "Constructed universe_ is invalid.";
@@ -654,3 +684,169 @@ TEST_F(MoveManagerTest, MakeA62Move) {
   EXPECT_GT(attempted_moves_[3], 0)
       << "Move manager didn't return an attempted (2,6) move.";
 }
+
+TEST_F(MoveManagerTest, StaticDispatch) {
+  // Make working copies
+  boost::optional<decltype(universe_)> maybe_moved_universe{universe_};
+  auto maybe_move_count = boost::make_optional(true, attempted_moves_);
+
+  // Initialize MoveManager
+  MoveManager<decltype(maybe_moved_universe), decltype(maybe_move_count)>
+      this_move(std::move(maybe_moved_universe), std::move(maybe_move_count));
+
+  ASSERT_TRUE(this_move.make_move<move_type::TWO_THREE>())
+      << "(2,3) move invalid.";
+
+  ASSERT_TRUE(this_move.make_move(move_type::TWO_SIX))
+      << "(2,6) move invalid.";
+
+  auto& moved = this_move.universe_.get();
+
+  EXPECT_TRUE(moved.triangulation->tds().is_valid(true))
+      << "Moved triangulation invalid.";
+
+  EXPECT_EQ(moved.geometry->N3_31(), N3_31_before + 2)
+      << "(3,1) simplices did not increase by 2.";
+
+  EXPECT_EQ(moved.geometry->N3_22(), N3_22_before + 1)
+      << "(2,2) simplices did not increase by 1.";
+
+  EXPECT_EQ(moved.geometry->N3_13(), N3_13_before + 2)
+      << "(1,3) simplices did not increase by 2.";
+
+  EXPECT_EQ(moved.geometry->N1_TL(), timelike_edges_before + 3)
+      << "Timelike edges did not increase by 3.";
+
+  EXPECT_EQ(moved.geometry->N1_SL(), spacelike_edges_before + 3)
+      << "Spacelike edges did not increase by 3.";
+
+  EXPECT_EQ(moved.geometry->N0(), vertices_before + 1)
+      << "A vertex was not added to the triangulation.";
+
+  EXPECT_GT(this_move.attempted_moves_.get()[0], 0)
+      << "Move manager didn't record an attempted (2,3) move.";
+
+  EXPECT_GT(this_move.attempted_moves_.get()[2], 0)
+      << "Move manager didn't record an attempted (2,6) move.";
+
+  EXPECT_FALSE(this_move.make_move(move_type::FOUR_FOUR))
+      << "Unimplemented (4,4) move reported success.";
+
+  EXPECT_FALSE(this_move.universe_)
+      << "Failed move didn't disengage the working manifold.";
+}
+
+TEST_F(MoveManagerTest, InPlace) {
+  const auto* triangulation = universe_.triangulation.get();
+  const auto  moves_before  = attempted_moves_;
+  MoveManager<SimplicialManifold&, Move_tracker&> this_move(universe_,
+                                                            attempted_moves_);
+
+  ASSERT_TRUE(this_move.make_move(move_type::TWO_SIX))
+      << "(2,6) move invalid.";
+
+  EXPECT_EQ(universe_.triangulation.get(), triangulation)
+      << "The move wasn't made on the manifold itself.";
+
+  EXPECT_EQ(universe_.geometry->N0(), vertices_before + 1)
+      << "A vertex was not added to the manifold.";
+
+  EXPECT_GT(attempted_moves_[2], 0)
+      << "Move manager didn't record an attempted (2,6) move.";
+
+  // Roll back the move as a failed one would be
+  this_move.roll_back(moves_before);
+
+  EXPECT_TRUE(universe_.triangulation->tds().is_valid(true))
+      << "Triangulation invalid after rolling back.";
+
+  EXPECT_EQ(universe_.geometry->N3_31(), N3_31_before)
+      << "(3,1) simplices weren't restored.";
+
+  EXPECT_EQ(universe_.geometry->N3_13(), N3_13_before)
+      << "(1,3) simplices weren't restored.";
+
+  EXPECT_EQ(universe_.geometry->N0(), vertices_before)
+      << "The vertex wasn't removed.";
+
+  EXPECT_EQ(attempted_moves_, moves_before)
+      << "Attempts of the rolled back move were kept.";
+
+  EXPECT_FALSE(this_move.make_move(move_type::FOUR_FOUR))
+      << "Unimplemented (4,4) move reported success.";
+
+  EXPECT_EQ(universe_.geometry->N0(), vertices_before)
+      << "A failed move changed the manifold.";
+}
+
+TEST_F(MoveManagerTest, GeometryFollowsMoves) {
+  const auto* geometry = universe_.geometry.get();
+  MoveManager<SimplicialManifold&, Move_tracker&> this_move(universe_,
+                                                            attempted_moves_);
+
+  auto expect_reclassified = [this](const char* after) {
+    GeometryInfo reclassified{classify_all_simplices(universe_.triangulation)};
+    EXPECT_EQ(universe_.geometry->N3_31(), reclassified.N3_31())
+        << "(3,1) simplices differ after " << after;
+    EXPECT_EQ(universe_.geometry->N3_22(), reclassified.N3_22())
+        << "(2,2) simplices differ after " << after;
+    EXPECT_EQ(universe_.geometry->N3_13(), reclassified.N3_13())
+        << "(1,3) simplices differ after " << after;
+    EXPECT_EQ(universe_.geometry->N1_TL(), reclassified.N1_TL())
+        << "Timelike edges differ after " << after;
+    EXPECT_EQ(universe_.geometry->N1_SL(), reclassified.N1_SL())
+        << "Spacelike edges differ after " << after;
+    EXPECT_EQ(universe_.geometry->N0(), reclassified.N0())
+        << "Vertices differ after " << after;
+  };
+
+  for (auto move : {move_type::TWO_THREE, move_type::THREE_TWO,
+                    move_type::TWO_SIX, move_type::SIX_TWO}) {
+    ASSERT_TRUE(this_move.make_move(move)) << "Move invalid.";
+    expect_reclassified("a move");
+
+    this_move.roll_back(attempted_moves_);
+    expect_reclassified("rolling it back");
+  }
+
+  EXPECT_EQ(universe_.geometry.get(), geometry)
+      << "The geometry was replaced instead of following the moves.";
+
+  for (const auto& cell : universe_.geometry->three_one) {
+    EXPECT_TRUE(universe_.triangulation->tds().is_cell(cell))
+        << "The geometry holds a deleted cell.";
+  }
+}
+
+TEST_F(MoveManagerTest, LocalValidity) {
+  // Make working copies
+  boost::optional<decltype(universe_)> maybe_moved_universe{universe_};
+  auto maybe_move_count = boost::make_optional(true, attempted_moves_);
+
+  // Initialize MoveManager
+  MoveManager<decltype(maybe_moved_universe), decltype(maybe_move_count)>
+      this_move(std::move(maybe_moved_universe), std::move(maybe_move_count));
+
+  // Setup move
+  auto move_26_lambda = [](
+      SimplicialManifold manifold,
+      Move_tracker&      attempted_moves) -> SimplicialManifold {
+    return make_26_move(std::move(manifold), attempted_moves);
+  };
+  function_ref<SimplicialManifold(SimplicialManifold, Move_tracker&)> move_26(
+      move_26_lambda);
+
+  ASSERT_TRUE(this_move.make_move(move_26)) << "Move invalid.";
+
+  EXPECT_EQ(last_move_vertices().size(), 1u)
+      << "(2,6) move didn't record its new vertex.";
+
+  EXPECT_TRUE(this_move.check_local_validity())
+      << "Star of the new vertex is invalid.";
+
+  // Break the foliation in the star of the new vertex
+  last_move_vertices().front()->info() += 2;
+
+  EXPECT_FALSE(this_move.check_local_validity())
+      << "Local check missed a cell that doesn't span exactly 1 timeslice.";
+}
@@ -0,0 +1,87 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Tests for the Metropolis-Hastings algorithm with optimistic concurrency
+
+/// @file OptimisticMetropolisTest.cpp
+/// @brief Tests for OptimisticMetropolis.h
+/// @author Adam Getchell
+
+#include "OptimisticMetropolis.h"
+#include "gmock/gmock.h"
+
+class OptimisticMetropolisTest : public ::testing::Test {
+ public:
+  OptimisticMetropolisTest() : universe_{6400, 8} {}
+
+  /// @brief Combinatorial manifold containing pointer to triangulation
+  /// and geometric information.
+  CombinatorialManifold universe_;
+};
+
+TEST_F(OptimisticMetropolisTest, RunsOnSeveralThreads) {
+  Optimistic_metropolis testrun(0.6, 1.1, 0.1, 2, 2, 4);
+  swap(universe_, testrun(universe_));
+
+  EXPECT_EQ(testrun.Threads(), 4u) << "Wrong number of threads.";
+
+  EXPECT_GT(testrun.TotalMoves(), 0) << "No moves were attempted.";
+
+  EXPECT_GT(testrun.SuccessfulMoves()[2], 0) << "No (2,6) moves succeeded.";
+
+  EXPECT_TRUE(universe_.triangulation->is_valid(true))
+      << "Concurrent moves left the triangulation invalid.";
+
+  // The counts kept by each move match a recount from scratch
+  Combinatorial_triangulation recounted(make_snapshot(universe_));
+  EXPECT_EQ(universe_.geometry->N3_31(), recounted.N3_31())
+      << "(3,1) simplices are miscounted.";
+  EXPECT_EQ(universe_.geometry->N3_22(), recounted.N3_22())
+      << "(2,2) simplices are miscounted.";
+  EXPECT_EQ(universe_.geometry->N1_TL(), recounted.N1_TL())
+      << "Timelike edges are miscounted.";
+}
+
+TEST_F(OptimisticMetropolisTest, CountsEachAttemptOnce) {
+  // No passes, so the universe stays with testrun
+  Optimistic_metropolis testrun(0.6, 1.1, 0.1, 0, 1, 2);
+  testrun(universe_);
+  auto attempted_before = testrun.AttemptedMoves()[2];
+
+  Optimistic_metropolis::Proposal proposal;
+  for (auto n = 0; n < 100; ++n) {
+    testrun.attempt_move(move_type::TWO_SIX, proposal);
+  }
+  EXPECT_EQ(testrun.AttemptedMoves()[2], attempted_before + 100)
+      << "Attempts weren't counted once each.";
+
+  EXPECT_GT(testrun.SuccessfulMoves()[2], 0) << "No (2,6) moves succeeded.";
+}
+
+TEST_F(OptimisticMetropolisTest, SeededRunsMatchOnAnyNumberOfThreads) {
+  CombinatorialManifold other_universe(universe_);
+
+  Optimistic_metropolis one_thread(0.6, 1.1, 0.1, 2, 2, 1);
+  one_thread.use_seed(20171018);
+  swap(universe_, one_thread(universe_));
+
+  Optimistic_metropolis four_threads(0.6, 1.1, 0.1, 2, 2, 4);
+  four_threads.use_seed(20171018);
+  swap(other_universe, four_threads(other_universe));
+
+  EXPECT_EQ(one_thread.AttemptedMoves(), four_threads.AttemptedMoves())
+      << "Seeded runs attempted different moves.";
+
+  EXPECT_EQ(one_thread.SuccessfulMoves(), four_threads.SuccessfulMoves())
+      << "Seeded runs made different moves.";
+
+  auto one_thread_result   = make_snapshot(universe_);
+  auto four_threads_result = make_snapshot(other_universe);
+  EXPECT_EQ(one_thread_result.cell_vertices,
+            four_threads_result.cell_vertices)
+      << "Seeded runs ended with different triangulations.";
+  EXPECT_EQ(one_thread_result.cell_neighbors,
+            four_threads_result.cell_neighbors)
+      << "Seeded runs ended with different triangulations.";
+}
@@ -0,0 +1,80 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Tests for counter-based random number streams
+
+/// @file PhiloxTest.cpp
+/// @brief Tests for Philox.h
+/// @author Adam Getchell
+
+#include <array>
+#include <cstdint>
+
+#include "Utilities.h"
+#include "gmock/gmock.h"
+
+// The known answers of Random123
+static_assert(philox4x32({{0, 0, 0, 0}}, {{0, 0}})[0] == 0x6627e8d5,
+              "Philox4x32-10 is wrong.");
+
+TEST(PhiloxTest, MatchesKnownAnswers) {
+  EXPECT_THAT(philox4x32({{0, 0, 0, 0}}, {{0, 0}}),
+              ::testing::ElementsAre(0x6627e8d5, 0xe169c58d, 0xbc57ac4c,
+                                     0x9b00dbd8))
+      << "Zero counter and key give the wrong words.";
+
+  EXPECT_THAT(philox4x32({{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}},
+                         {{0xffffffff, 0xffffffff}}),
+              ::testing::ElementsAre(0x408f276d, 0x41c83b0e, 0xa20bc7c6,
+                                     0x6d5451fd))
+      << "All-ones counter and key give the wrong words.";
+
+  EXPECT_THAT(philox4x32({{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}},
+                         {{0xa4093822, 0x299f31d0}}),
+              ::testing::ElementsAre(0xd16cfe09, 0x94fdcceb, 0x5001e420,
+                                     0x24126ea1))
+      << "Digits of pi give the wrong words.";
+}
+
+TEST(PhiloxTest, StreamsDependOnlyOnTheirKey) {
+  Random_stream first(42, 3, 1000);
+  Random_stream second(42, 3, 1000);
+  Random_stream other(42, 3, 1001);
+  auto          differ = false;
+  for (auto n = 0; n < 100; ++n) {
+    auto draw = first.next();
+    EXPECT_EQ(draw, second.next()) << "Equal keys gave different draws.";
+    differ = differ || draw != other.next();
+  }
+  EXPECT_TRUE(differ) << "Different proposals gave the same draws.";
+}
+
+TEST(PhiloxTest, DrawsStayInRange) {
+  Random_stream stream(7, 1, 0);
+  for (auto n = 0; n < 1000; ++n) {
+    auto choice = stream.uniform_int(0, 3);
+    EXPECT_GE(choice, 0) << "Integer below its range.";
+    EXPECT_LE(choice, 3) << "Integer above its range.";
+
+    auto trial = stream.uniform_real(0.0L, 1.0L);
+    EXPECT_GE(trial, 0.0L) << "Probability below 0.";
+    EXPECT_LE(trial, 1.0L) << "Probability above 1.";
+  }
+}
+
+TEST(PhiloxTest, ScopesMakeDrawsReproducible) {
+  std::array<std::intmax_t, 10> first{};
+  std::array<std::intmax_t, 10> second{};
+  {
+    Random_scope random(2017, 5, 12);
+    for (auto& choice : first) choice = generate_random_signed(0, 1000000);
+  }
+  EXPECT_EQ(current_random_stream(), nullptr)
+      << "A scope didn't restore the stream it replaced.";
+  {
+    Random_scope random(2017, 5, 12);
+    for (auto& choice : second) choice = generate_random_signed(0, 1000000);
+  }
+  EXPECT_EQ(first, second) << "The same scope drew different numbers.";
+}
@@ -142,6 +142,7 @@ TEST_F(S3ErgodicMoveTest, MakeA32Move) {
 
 TEST_F(S3ErgodicMoveTest, MakeA26Move) {
   universe_ = std::move(make_26_move(std::move(universe_), attempted_moves_));
+  reclassify(universe_);
   std::cout << "Attempted (2,6) moves = " << attempted_moves_[2] << std::endl;
 
   EXPECT_TRUE(universe_.triangulation->tds().is_valid(true))
@@ -177,6 +178,7 @@ TEST_F(S3ErgodicMoveTest, MakeA26Move) {
 
 TEST_F(S3ErgodicMoveTest, MakeA62Move) {
   universe_ = std::move(make_62_move(std::move(universe_), attempted_moves_));
+  reclassify(universe_);
   std::cout << "Attempted (6,2) moves = " << attempted_moves_[3] << std::endl;
   // We expect the triangulation to be valid, but not necessarily Delaunay
   EXPECT_TRUE(universe_.triangulation->tds().is_valid())
@@ -210,6 +212,147 @@ TEST_F(S3ErgodicMoveTest, MakeA62Move) {
       << attempted_moves_[3] << " attempted (6,2) moves.";
 }
 
+TEST_F(S3ErgodicMoveTest, MakeA62MoveUndoesA26Move) {
+  // The new vertex of a (2,6) move can always be collapsed
+  make_ergodic_move<move_type::TWO_SIX>(universe_, attempted_moves_);
+  reclassify(universe_);
+  auto added = last_move_vertices().front();
+  ASSERT_TRUE(find_62_movable(universe_, added))
+      << "The vertex added by a (2,6) move isn't (6,2) movable.";
+
+  ASSERT_TRUE(remove_62_vertex(universe_, added))
+      << "The vertex added by a (2,6) move wasn't collapsed.";
+  reclassify(universe_);
+
+  EXPECT_TRUE(universe_.triangulation->tds().is_valid(true))
+      << "Triangulation is invalid.";
+
+  EXPECT_EQ(universe_.geometry->N3_31(), N3_31_before)
+      << "(3,1) simplices weren't restored.";
+
+  EXPECT_EQ(universe_.geometry->N3_13(), N3_13_before)
+      << "(1,3) simplices weren't restored.";
+
+  EXPECT_EQ(universe_.geometry->N1_TL(), timelike_edges_before)
+      << "Timelike edges weren't restored.";
+
+  EXPECT_EQ(universe_.geometry->N1_SL(), spacelike_edges_before)
+      << "Spacelike edges weren't restored.";
+
+  EXPECT_EQ(universe_.geometry->N0(), vertices_before)
+      << "The vertex wasn't removed.";
+}
+
+TEST_F(S3ErgodicMoveTest, UndoEachMove) {
+  for (auto move : {move_type::TWO_THREE, move_type::THREE_TWO,
+                    move_type::TWO_SIX, move_type::SIX_TWO}) {
+    switch (move) {
+      case move_type::TWO_THREE:
+        make_ergodic_move<move_type::TWO_THREE>(universe_, attempted_moves_);
+        break;
+      case move_type::THREE_TWO:
+        make_ergodic_move<move_type::THREE_TWO>(universe_, attempted_moves_);
+        break;
+      case move_type::TWO_SIX:
+        make_ergodic_move<move_type::TWO_SIX>(universe_, attempted_moves_);
+        break;
+      default:
+        make_ergodic_move<move_type::SIX_TWO>(universe_, attempted_moves_);
+        break;
+    }
+    reclassify(universe_);
+    ASSERT_TRUE(last_move_record<SimplicialManifold>().move == move)
+        << "The move wasn't recorded.";
+
+    undo_move(universe_);
+    reclassify(universe_);
+
+    EXPECT_TRUE(universe_.triangulation->tds().is_valid(true))
+        << "Triangulation is invalid after undoing a move.";
+
+    EXPECT_EQ(universe_.geometry->N3_31(), N3_31_before)
+        << "(3,1) simplices weren't restored.";
+
+    EXPECT_EQ(universe_.geometry->N3_22(), N3_22_before)
+        << "(2,2) simplices weren't restored.";
+
+    EXPECT_EQ(universe_.geometry->N3_13(), N3_13_before)
+        << "(1,3) simplices weren't restored.";
+
+    EXPECT_EQ(universe_.geometry->N1_TL(), timelike_edges_before)
+        << "Timelike edges weren't restored.";
+
+    EXPECT_EQ(universe_.geometry->N1_SL(), spacelike_edges_before)
+        << "Spacelike edges weren't restored.";
+
+    EXPECT_EQ(universe_.geometry->N0(), vertices_before)
+        << "Vertices weren't restored.";
+  }
+}
+
+TEST_F(S3ErgodicMoveTest, FlippableFacetsStayCurrent) {
+  make_ergodic_move<move_type::TWO_THREE>(universe_, attempted_moves_);
+  reclassify(universe_);
+  EXPECT_EQ(attempted_moves_[0], 1) << "A (2,3) move took more than 1 try.";
+
+  make_ergodic_move<move_type::TWO_SIX>(universe_, attempted_moves_);
+  reclassify(universe_);
+  make_ergodic_move<move_type::THREE_TWO>(universe_, attempted_moves_);
+  reclassify(universe_);
+  make_ergodic_move<move_type::SIX_TWO>(universe_, attempted_moves_);
+  reclassify(universe_);
+  make_ergodic_move<move_type::TWO_THREE>(universe_, attempted_moves_);
+  reclassify(universe_);
+  EXPECT_EQ(attempted_moves_[0], 2) << "A (2,3) move took more than 1 try.";
+
+  // Compare the maintained index with one built from scratch
+  auto maintained = *universe_.flippable_facets;
+  universe_.flippable_facets = boost::none;
+  const auto& rebuilt = flippable_23_facets(universe_);
+  EXPECT_EQ(maintained.size(), rebuilt.size())
+      << "The index has the wrong number of flippable facets.";
+  for (std::size_t n = 0; n < rebuilt.size(); ++n) {
+    EXPECT_TRUE(maintained.contains(rebuilt[n].first, rebuilt[n].second))
+        << "A flippable facet is missing from the index.";
+  }
+}
+
+TEST_F(S3ErgodicMoveTest, FlippableEdgesStayCurrent) {
+  make_ergodic_move<move_type::THREE_TWO>(universe_, attempted_moves_);
+  reclassify(universe_);
+  EXPECT_EQ(attempted_moves_[1], 1) << "A (3,2) move took more than 1 try.";
+
+  make_ergodic_move<move_type::TWO_SIX>(universe_, attempted_moves_);
+  reclassify(universe_);
+  make_ergodic_move<move_type::TWO_THREE>(universe_, attempted_moves_);
+  reclassify(universe_);
+  make_ergodic_move<move_type::SIX_TWO>(universe_, attempted_moves_);
+  reclassify(universe_);
+  make_ergodic_move<move_type::THREE_TWO>(universe_, attempted_moves_);
+  reclassify(universe_);
+  EXPECT_EQ(attempted_moves_[1], 2) << "A (3,2) move took more than 1 try.";
+
+  // Compare the maintained index with one built from scratch
+  auto maintained = *universe_.flippable_edges;
+  universe_.flippable_edges = boost::none;
+  const auto& rebuilt = flippable_32_edges(universe_);
+  EXPECT_EQ(maintained.number_of_edges(), rebuilt.number_of_edges())
+      << "Degrees are known for the wrong number of edges.";
+  EXPECT_EQ(maintained.size(), rebuilt.size())
+      << "The index has the wrong number of flippable edges.";
+  for (std::size_t n = 0; n < rebuilt.size(); ++n) {
+    EXPECT_TRUE(maintained.contains(rebuilt[n].first, rebuilt[n].second))
+        << "A flippable edge is missing from the index.";
+  }
+  for (const auto& edge : universe_.geometry->timelike_edges) {
+    auto cell = std::get<0>(edge);
+    auto u    = cell->vertex(static_cast<int>(std::get<1>(edge)));
+    auto v    = cell->vertex(static_cast<int>(std::get<2>(edge)));
+    EXPECT_EQ(maintained.degree(u, v), rebuilt.degree(u, v))
+        << "An edge has the wrong degree.";
+  }
+}
+
 TEST_F(S3ErgodicMoveTest, DISABLED_MakeA44Move) {
   // Stash the old spacelike edges
   auto old_edges = universe_.geometry->spacelike_edges;
@@ -0,0 +1,85 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Checks that Simulation stages run in order on the manifold in place.
+
+/// @file SimulationTest.cpp
+/// @brief Tests for the Simulation pipeline
+/// @author Adam Getchell
+
+#include <utility>
+#include <vector>
+
+#include "Measurements.h"
+#include "Simulation.h"
+#include "gmock/gmock.h"
+
+class SimulationTest : public ::testing::Test {
+ public:
+  SimulationTest() : universe_{make_triangulation(6400, 7)} {}
+
+  /// @brief Simplicial manifold containing pointer to triangulation
+  /// and geometric information.
+  SimplicialManifold universe_;
+
+  /// @brief The Simulation under test
+  Simulation simulation_;
+};
+
+TEST_F(SimulationTest, StagesRunInOrderInPlace) {
+  const auto*      triangulation = universe_.triangulation.get();
+  std::vector<int> order;
+
+  simulation_.queue([&order, triangulation](SimplicialManifold& s) {
+    EXPECT_EQ(s.triangulation.get(), triangulation)
+        << "First stage received a copy of the manifold.";
+    order.push_back(1);
+  });
+  simulation_.queue([&order, triangulation](SimplicialManifold& s) {
+    VolumePerTimeslice(s);
+    EXPECT_EQ(s.triangulation.get(), triangulation)
+        << "Second stage received a copy of the manifold.";
+    order.push_back(2);
+  });
+
+  simulation_.run(universe_);
+
+  EXPECT_THAT(order, ::testing::ElementsAre(1, 2))
+      << "Stages didn't run in the order queued.";
+
+  EXPECT_EQ(universe_.triangulation.get(), triangulation)
+      << "Running the Simulation replaced the triangulation.";
+
+  EXPECT_TRUE(universe_.geometry->timevalues)
+      << "VolumePerTimeslice() stage didn't update the manifold.";
+}
+
+TEST_F(SimulationTest, StartMovesTheManifold) {
+  const auto* triangulation = universe_.triangulation.get();
+  simulation_.queue([](SimplicialManifold& s) { VolumePerTimeslice(s); });
+
+  universe_ = simulation_.start(std::move(universe_));
+
+  EXPECT_EQ(universe_.triangulation.get(), triangulation)
+      << "start() copied the triangulation.";
+}
+
+TEST_F(SimulationTest, SnapshotStage) {
+  auto cells = static_cast<std::intmax_t>(
+      universe_.triangulation->number_of_finite_cells());
+  std::intmax_t snapshot_cells{0};
+  std::intmax_t calls{0};
+
+  simulation_.queue_snapshot([&](const Snapshot& snapshot) {
+    snapshot_cells = snapshot.number_of_finite_cells();
+    ++calls;
+  });
+
+  simulation_.run(universe_);
+
+  EXPECT_EQ(calls, 1) << "Snapshot stage didn't run exactly once.";
+
+  EXPECT_EQ(snapshot_cells, cells)
+      << "Snapshot stage saw a different number of cells.";
+}
@@ -0,0 +1,163 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Checks that Snapshots faithfully and compactly copy a triangulation.
+
+/// @file SnapshotTest.cpp
+/// @brief Tests for compact triangulation snapshots
+/// @author Adam Getchell
+
+#include <algorithm>
+#include <utility>
+
+#include "Measurements.h"
+#include "S3ErgodicMoves.h"
+#include "Snapshot.h"
+#include "gmock/gmock.h"
+
+TEST(Snapshot, MortonCode) {
+  EXPECT_EQ(morton_code(1, 0, 0), 1) << "x bit not in position 0.";
+
+  EXPECT_EQ(morton_code(0, 1, 0), 2) << "y bit not in position 1.";
+
+  EXPECT_EQ(morton_code(0, 0, 1), 4) << "z bit not in position 2.";
+
+  EXPECT_EQ(morton_code(2, 0, 0), 8) << "Bits not interleaved.";
+}
+
+class SnapshotTest : public ::testing::Test {
+ public:
+  SnapshotTest()
+      : universe_{make_triangulation(6400, 7)}
+      , snapshot_{make_snapshot(universe_)} {}
+
+  /// @brief Simplicial manifold containing pointer to triangulation
+  /// and geometric information.
+  SimplicialManifold universe_;
+
+  /// @brief The Snapshot of universe_
+  Snapshot snapshot_;
+};
+
+TEST_F(SnapshotTest, Sizes) {
+  EXPECT_EQ(snapshot_.number_of_vertices(), universe_.geometry->N0())
+      << "Snapshot has the wrong number of vertices.";
+
+  EXPECT_EQ(snapshot_.number_of_finite_cells(),
+            universe_.geometry->number_of_cells())
+      << "Snapshot has the wrong number of finite cells.";
+
+  EXPECT_EQ(snapshot_.number_of_cells(),
+            universe_.triangulation->number_of_cells())
+      << "Snapshot has the wrong number of cells.";
+
+  EXPECT_EQ(snapshot_.cell_vertices.size(), 4 * snapshot_.cell_types.size())
+      << "Snapshot cell vertices have the wrong size.";
+
+  EXPECT_EQ(std::count(snapshot_.cell_types.begin(),
+                       snapshot_.cell_types.end(), 22),
+            universe_.geometry->N3_22())
+      << "Snapshot has the wrong number of (2,2) cells.";
+}
+
+TEST_F(SnapshotTest, TimesliceMajorOrder) {
+  EXPECT_TRUE(std::is_sorted(snapshot_.vertex_timevalues.begin(),
+                             snapshot_.vertex_timevalues.end()))
+      << "Vertices are not numbered timeslice-major.";
+
+  for (Snapshot_index c = 0; c < snapshot_.number_of_cells(); ++c) {
+    auto has_infinite_vertex = false;
+    for (auto i = 0; i < 4; ++i) {
+      if (snapshot_.vertex(c, i) == INFINITE_VERTEX) has_infinite_vertex = true;
+    }
+    EXPECT_EQ(has_infinite_vertex, snapshot_.is_infinite(c))
+        << "Finite cells are not stored first.";
+  }
+}
+
+TEST_F(SnapshotTest, NeighborsAreMutual) {
+  for (Snapshot_index c = 0; c < snapshot_.number_of_cells(); ++c) {
+    for (auto i = 0; i < 4; ++i) {
+      auto n      = snapshot_.neighbor(c, i);
+      auto mutual = false;
+      for (auto j = 0; j < 4; ++j) {
+        if (snapshot_.neighbor(n, j) == c) mutual = true;
+      }
+      EXPECT_TRUE(mutual) << "Cell " << n << " doesn't neighbor cell " << c;
+    }
+  }
+}
+
+TEST_F(SnapshotTest, VolumePerTimeslice) {
+  VolumePerTimeslice(universe_);
+  auto volumes = volume_per_timeslice(snapshot_);
+
+  for (const auto& volume : volumes) {
+    EXPECT_EQ(volume.second,
+              universe_.geometry->spacelike_facets->count(volume.first))
+        << "Timeslice " << volume.first << " has the wrong volume.";
+  }
+}
+
+TEST_F(SnapshotTest, RebuildTriangulation) {
+  auto triangulation = rebuild_triangulation(snapshot_);
+
+  EXPECT_TRUE(triangulation->tds().is_valid())
+      << "Rebuilt triangulation is invalid.";
+
+  EXPECT_EQ(triangulation->number_of_vertices(),
+            universe_.triangulation->number_of_vertices())
+      << "Rebuilt triangulation has the wrong number of vertices.";
+
+  EXPECT_EQ(triangulation->number_of_finite_cells(),
+            universe_.triangulation->number_of_finite_cells())
+      << "Rebuilt triangulation has the wrong number of finite cells.";
+}
+
+TEST_F(SnapshotTest, Compact) {
+  auto N3_31 = universe_.geometry->N3_31();
+  auto N3_22 = universe_.geometry->N3_22();
+  auto N3_13 = universe_.geometry->N3_13();
+  auto N1_TL = universe_.geometry->N1_TL();
+
+  compact(std::move(universe_));
+
+  EXPECT_TRUE(universe_.triangulation->tds().is_valid())
+      << "Compacted triangulation is invalid.";
+
+  EXPECT_EQ(universe_.geometry->N3_31(), N3_31)
+      << "Compaction changed the number of (3,1) simplices.";
+
+  EXPECT_EQ(universe_.geometry->N3_22(), N3_22)
+      << "Compaction changed the number of (2,2) simplices.";
+
+  EXPECT_EQ(universe_.geometry->N3_13(), N3_13)
+      << "Compaction changed the number of (1,3) simplices.";
+
+  EXPECT_EQ(universe_.geometry->N1_TL(), N1_TL)
+      << "Compaction changed the number of timelike edges.";
+
+  auto compacted = make_snapshot(universe_);
+
+  EXPECT_EQ(compacted.vertex_timevalues, snapshot_.vertex_timevalues)
+      << "Compaction changed the vertex order.";
+
+  EXPECT_EQ(compacted.cell_vertices, snapshot_.cell_vertices)
+      << "Compaction changed the cell order.";
+}
+
+TEST_F(SnapshotTest, MovesAfterCompaction) {
+  // Build the flip indexes against the triangulation about to be replaced
+  Move_tracker attempted_moves{};
+  make_23_move(std::move(universe_), attempted_moves);
+  make_32_move(std::move(universe_), attempted_moves);
+
+  compact(std::move(universe_));
+
+  make_23_move(std::move(universe_), attempted_moves);
+  make_32_move(std::move(universe_), attempted_moves);
+
+  EXPECT_TRUE(universe_.triangulation->tds().is_valid())
+      << "A move after compaction used a stale flip index.";
+}
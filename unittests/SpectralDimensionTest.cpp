@@ -0,0 +1,104 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Checks that diffusion on the dual graph is set up and conserves
+/// probability, and that the return probability is sensible.
+
+/// @file SpectralDimensionTest.cpp
+/// @brief Tests for the spectral dimension
+/// @author Adam Getchell
+
+#include <numeric>
+#include <vector>
+
+#include "SpectralDimension.h"
+#include "gmock/gmock.h"
+
+class SpectralDimensionTest : public ::testing::Test {
+ public:
+  SpectralDimensionTest()
+      : universe_{make_triangulation(6400, 7)}
+      , graph_{make_dual_graph(universe_)} {}
+
+  /// @brief Simplicial manifold containing pointer to triangulation
+  /// and geometric information.
+  SimplicialManifold universe_;
+
+  /// @brief The dual graph of universe_
+  DualGraph graph_;
+};
+
+TEST_F(SpectralDimensionTest, DualGraph) {
+  EXPECT_EQ(graph_.number_of_nodes(),
+            universe_.triangulation->number_of_finite_cells())
+      << "Dual graph doesn't have a node for every finite cell.";
+
+  EXPECT_EQ(graph_.row_offsets.size(), graph_.number_of_nodes() + 1)
+      << "Dual graph row offsets have the wrong size.";
+
+  EXPECT_EQ(graph_.neighbors.size() % 2, 0)
+      << "Dual graph edges are not symmetric.";
+
+  for (std::size_t node = 0; node < graph_.number_of_nodes(); ++node) {
+    EXPECT_LE(graph_.degree(node), 4) << "A cell has more than 4 neighbors.";
+  }
+
+  EXPECT_EQ(graph_.cell_types.front(), 31)
+      << "Dual graph nodes are not numbered in classification order.";
+}
+
+TEST_F(SpectralDimensionTest, DiffusionConservesProbability) {
+  std::vector<double> current(graph_.number_of_nodes(), 0.0);
+  std::vector<double> next(graph_.number_of_nodes(), 0.0);
+  current[0] = 1.0;
+
+  for (auto sigma = 0; sigma < 10; ++sigma) {
+    diffuse(graph_, current, &next, DIFFUSION_CONSTANT);
+    current.swap(next);
+  }
+
+  EXPECT_NEAR(std::accumulate(current.begin(), current.end(), 0.0), 1.0, 1e-9)
+      << "Heat kernel evolution doesn't conserve probability.";
+}
+
+TEST_F(SpectralDimensionTest, HeatKernelReturnProbability) {
+  std::vector<std::size_t> origins{0, 1, 2, 3};
+  auto probability = heat_kernel_return_probability(graph_, origins, 20);
+
+  ASSERT_EQ(probability.size(), 21) << "P(sigma) has the wrong size.";
+
+  EXPECT_DOUBLE_EQ(probability[0], 1.0) << "P(0) should be 1.";
+
+  for (const auto& p : probability) {
+    EXPECT_TRUE(IsBetween(p, 0.0, 1.0)) << "P(sigma) is not a probability.";
+  }
+
+  EXPECT_LT(probability[20], probability[1])
+      << "Return probability doesn't decay.";
+}
+
+TEST_F(SpectralDimensionTest, RandomWalkReturnProbability) {
+  auto probability = random_walk_return_probability(graph_, 10000, 20, 42);
+
+  ASSERT_EQ(probability.size(), 21) << "P(sigma) has the wrong size.";
+
+  EXPECT_DOUBLE_EQ(probability[0], 1.0) << "P(0) should be 1.";
+
+  EXPECT_NEAR(probability[1], 1.0 - DIFFUSION_CONSTANT, 0.05)
+      << "Walkers don't stay put at the lazy walk rate.";
+
+  auto repeat = random_walk_return_probability(graph_, 10000, 20, 42, 0.5, 2);
+  auto again  = random_walk_return_probability(graph_, 10000, 20, 42, 0.5, 2);
+
+  EXPECT_EQ(repeat, again) << "Random walk streams aren't reproducible.";
+}
+
+TEST_F(SpectralDimensionTest, SpectralDimension) {
+  auto result = SpectralDimension(universe_, 4, 30);
+
+  EXPECT_EQ(result.first.size(), result.second.size())
+      << "P(sigma) and D_S(sigma) have different sizes.";
+
+  EXPECT_GT(result.second[10], 0) << "Spectral dimension should be positive.";
+}
@@ -0,0 +1,116 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Checks that sweep specifications parse and that batches run every point.
+
+/// @file SweepTest.cpp
+/// @brief Tests for batch parameter sweeps
+/// @author Adam Getchell
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#include "Sweep.h"
+#include "gmock/gmock.h"
+
+using ::testing::ElementsAre;
+using ::testing::StartsWith;
+
+TEST(Sweep, ParsesListsAndRanges) {
+  std::istringstream input(R"(# A small grid
+alpha      = 0.6:0.8:0.1
+k          = 1.1
+lambda     = 0.1, 0.2
+simplices  = 6400 64000
+timeslices = 16
+passes     = 5   # per point
+output     = results.csv
+)");
+  auto spec = parse_sweep(input);
+
+  ASSERT_EQ(spec.alphas.size(), 3u) << "Range didn't include its stop value.";
+
+  EXPECT_NEAR(static_cast<double>(spec.alphas.back()), 0.8, 1e-9)
+      << "Range has the wrong last value.";
+
+  EXPECT_EQ(spec.lambdas.size(), 2u) << "Comma-separated list misparsed.";
+
+  EXPECT_THAT(spec.simplices, ElementsAre(6400, 64000))
+      << "Whitespace-separated list misparsed.";
+
+  EXPECT_EQ(spec.passes, 5) << "Comment wasn't stripped.";
+
+  EXPECT_EQ(spec.output, "results.csv") << "Output file misparsed.";
+
+  EXPECT_EQ(sweep_points(spec).size(), 12u)
+      << "Grid isn't the product of every list.";
+}
+
+TEST(Sweep, RejectsBadSpecifications) {
+  std::istringstream unknown("alpha = 0.6\nbeta = 1\n");
+  EXPECT_THROW(parse_sweep(unknown), std::invalid_argument)
+      << "Unknown key accepted.";
+
+  std::istringstream missing("alpha = 0.6\nk = 1.1\n");
+  EXPECT_THROW(parse_sweep(missing), std::invalid_argument)
+      << "Missing keys accepted.";
+
+  std::istringstream triangle(
+      "alpha = 0.3\nk = 1.1\nlambda = 0.1\nsimplices = 640\ntimeslices = 4\n");
+  EXPECT_THROW(parse_sweep(triangle), std::domain_error)
+      << "Alpha violating triangle inequalities accepted.";
+}
+
+TEST(Sweep, RunsEveryPoint) {
+  std::istringstream input(R"(alpha = 0.6
+k = 1.1
+lambda = 0.1, 0.2
+simplices = 640
+timeslices = 4
+passes = 1
+checkpoint = 10
+save_triangulations = 0
+)");
+  Sweep              sweep(parse_sweep(input));
+  std::ostringstream results;
+
+  EXPECT_EQ(sweep.run(results, 2), 0) << "Some sweep points failed.";
+
+  std::istringstream lines(results.str());
+  std::string        line;
+  std::intmax_t      count{0};
+  ASSERT_TRUE(std::getline(lines, line));
+  EXPECT_THAT(line, StartsWith("point,alpha")) << "Missing header.";
+  while (std::getline(lines, line)) ++count;
+
+  EXPECT_EQ(count, 2) << "Not every point wrote a line of results.";
+}
+
+TEST(Sweep, RerunsReplaceTrajectories) {
+  auto spec = [] {
+    std::istringstream input(R"(alpha = 0.6
+k = 1.1
+lambda = 0.1
+simplices = 640
+timeslices = 4
+passes = 1
+checkpoint = 1
+save_triangulations = 0
+)");
+    return parse_sweep(input);
+  };
+  for (auto run = 0; run < 2; ++run) {
+    Sweep              sweep(spec());
+    std::ostringstream results;
+    ASSERT_EQ(sweep.run(results, 1), 0) << "The sweep point failed.";
+  }
+
+  Trajectory_reader reader("sweep-0.traj");
+  EXPECT_EQ(reader.size(), std::size_t{1})
+      << "A second sweep appended to the first one's trajectory.";
+
+  EXPECT_EQ(reader.pass(0), 1) << "The new chain's passes don't start at 1.";
+  std::remove("sweep-0.traj");
+}
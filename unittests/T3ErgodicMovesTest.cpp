@@ -0,0 +1,246 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Tests for T3 ergodic moves: (2,3), (3,2), (2,6), (6,2)
+
+/// @file T3ErgodicMovesTest.cpp
+/// @brief Tests for T3 ergodic moves
+/// @author Adam Getchell
+
+// clang-format off
+#include <utility>
+#include <vector>
+#include "Metropolis.h"
+#include "MoveManager.h"
+#include "T3ErgodicMoves.h"
+#include "gmock/gmock.h"
+// clang-format on
+
+class T3ErgodicMoveTest : public ::testing::Test {
+ public:
+  T3ErgodicMoveTest()
+      : universe_{6400, 8}
+      , attempted_moves_{}
+      , N3_31_before{universe_.geometry->N3_31()}
+      , N3_22_before{universe_.geometry->N3_22()}
+      , N3_13_before{universe_.geometry->N3_13()}
+      , timelike_edges_before{universe_.geometry->N1_TL()}
+      , spacelike_edges_before{universe_.geometry->N1_SL()}
+      , vertices_before{universe_.geometry->N0()} {}
+
+  /// @brief Check that every cell is still causal and the data structure
+  /// is valid
+  void expect_foliated() {
+    const auto& tds = universe_.triangulation->tds();
+    EXPECT_TRUE(tds.is_valid(true)) << "tds is invalid after move.";
+    for (auto cit = tds.cells_begin(); cit != tds.cells_end(); ++cit) {
+      EXPECT_TRUE(is_foliated(universe_, cit))
+          << "A cell doesn't span adjacent timeslices.";
+    }
+  }
+
+  /// @brief Toroidal manifold containing pointer to triangulation
+  /// and geometric information.
+  ToroidalManifold universe_;
+
+  /// @brief A count of all attempted moves.
+  Move_tracker attempted_moves_;
+
+  /// @brief Initial number of (3,1) simplices
+  std::intmax_t N3_31_before;
+
+  /// @brief Initial number of (2,2) simplices
+  std::intmax_t N3_22_before;
+
+  /// @brief Initial number of (1,3) simplices
+  std::intmax_t N3_13_before;
+
+  /// @brief Initial number of timelike edges
+  std::intmax_t timelike_edges_before;
+
+  /// @brief Initial number of spacelike edges
+  std::intmax_t spacelike_edges_before;
+
+  /// @brief Initial number of vertices
+  std::intmax_t vertices_before;
+};
+
+TEST_F(T3ErgodicMoveTest, MakeA23Move) {
+  make_ergodic_move<move_type::TWO_THREE>(universe_, attempted_moves_);
+  reclassify(universe_);
+  expect_foliated();
+
+  EXPECT_EQ(universe_.geometry->N3_31(), N3_31_before)
+      << "(3,1) simplices changed.";
+
+  EXPECT_EQ(universe_.geometry->N3_22(), N3_22_before + 1)
+      << "(2,2) simplices did not increase by 1.";
+
+  EXPECT_EQ(universe_.geometry->N3_13(), N3_13_before)
+      << "(1,3) simplices changed.";
+
+  EXPECT_EQ(universe_.geometry->N1_TL(), timelike_edges_before + 1)
+      << "Timelike edges did not increase by 1.";
+
+  EXPECT_EQ(universe_.geometry->N1_SL(), spacelike_edges_before)
+      << "Spacelike edges changed.";
+}
+
+TEST_F(T3ErgodicMoveTest, MakeA32Move) {
+  // Make a (3,2) move possible
+  make_ergodic_move<move_type::TWO_THREE>(universe_, attempted_moves_);
+  reclassify(universe_);
+  make_ergodic_move<move_type::THREE_TWO>(universe_, attempted_moves_);
+  reclassify(universe_);
+  expect_foliated();
+
+  EXPECT_EQ(universe_.geometry->N3_22(), N3_22_before)
+      << "(2,2) simplices did not decrease by 1.";
+
+  EXPECT_EQ(universe_.geometry->N1_TL(), timelike_edges_before)
+      << "Timelike edges did not decrease by 1.";
+
+  EXPECT_EQ(universe_.geometry->N0(), vertices_before)
+      << "Vertices changed.";
+}
+
+TEST_F(T3ErgodicMoveTest, MakeA26Move) {
+  make_ergodic_move<move_type::TWO_SIX>(universe_, attempted_moves_);
+  reclassify(universe_);
+  expect_foliated();
+
+  EXPECT_EQ(universe_.geometry->N3_31(), N3_31_before + 2)
+      << "(3,1) simplices did not increase by 2.";
+
+  EXPECT_EQ(universe_.geometry->N3_13(), N3_13_before + 2)
+      << "(1,3) simplices did not increase by 2.";
+
+  EXPECT_EQ(universe_.geometry->N1_TL(), timelike_edges_before + 2)
+      << "Timelike edges did not increase by 2.";
+
+  EXPECT_EQ(universe_.geometry->N1_SL(), spacelike_edges_before + 3)
+      << "Spacelike edges did not increase by 3.";
+
+  EXPECT_EQ(universe_.geometry->N0(), vertices_before + 1)
+      << "A vertex was not added to the triangulation.";
+}
+
+TEST_F(T3ErgodicMoveTest, MakeA62MoveUndoesA26Move) {
+  // The new vertex of a (2,6) move can always be collapsed
+  make_ergodic_move<move_type::TWO_SIX>(universe_, attempted_moves_);
+  reclassify(universe_);
+  auto added = last_move_vertices<T3Vertex_handle>().front();
+  ASSERT_TRUE(find_62_movable(universe_, added))
+      << "The vertex added by a (2,6) move isn't (6,2) movable.";
+
+  ASSERT_TRUE(remove_62_vertex(universe_, added))
+      << "The vertex added by a (2,6) move wasn't collapsed.";
+  reclassify(universe_);
+  expect_foliated();
+
+  EXPECT_EQ(universe_.geometry->N3_31(), N3_31_before)
+      << "(3,1) simplices weren't restored.";
+
+  EXPECT_EQ(universe_.geometry->N3_13(), N3_13_before)
+      << "(1,3) simplices weren't restored.";
+
+  EXPECT_EQ(universe_.geometry->N1_TL(), timelike_edges_before)
+      << "Timelike edges weren't restored.";
+
+  EXPECT_EQ(universe_.geometry->N1_SL(), spacelike_edges_before)
+      << "Spacelike edges weren't restored.";
+
+  EXPECT_EQ(universe_.geometry->N0(), vertices_before)
+      << "The vertex wasn't removed.";
+}
+
+TEST_F(T3ErgodicMoveTest, FlippableFacetsStayCurrent) {
+  make_ergodic_move<move_type::TWO_SIX>(universe_, attempted_moves_);
+  reclassify(universe_);
+  make_ergodic_move<move_type::TWO_THREE>(universe_, attempted_moves_);
+  reclassify(universe_);
+  make_ergodic_move<move_type::THREE_TWO>(universe_, attempted_moves_);
+  reclassify(universe_);
+  make_ergodic_move<move_type::SIX_TWO>(universe_, attempted_moves_);
+  reclassify(universe_);
+  make_ergodic_move<move_type::TWO_THREE>(universe_, attempted_moves_);
+  reclassify(universe_);
+  EXPECT_EQ(attempted_moves_[0], 2) << "A (2,3) move took more than 1 try.";
+
+  // Compare the maintained index with one built from scratch
+  auto maintained = *universe_.flippable_facets;
+  universe_.flippable_facets = boost::none;
+  const auto& rebuilt = flippable_23_facets(universe_);
+  EXPECT_EQ(maintained.size(), rebuilt.size())
+      << "The index has the wrong number of flippable facets.";
+  for (std::size_t n = 0; n < rebuilt.size(); ++n) {
+    EXPECT_TRUE(maintained.contains(rebuilt[n].first, rebuilt[n].second))
+        << "A flippable facet is missing from the index.";
+  }
+}
+
+TEST_F(T3ErgodicMoveTest, FlippableEdgesStayCurrent) {
+  make_ergodic_move<move_type::THREE_TWO>(universe_, attempted_moves_);
+  reclassify(universe_);
+  EXPECT_EQ(attempted_moves_[1], 1) << "A (3,2) move took more than 1 try.";
+
+  make_ergodic_move<move_type::TWO_SIX>(universe_, attempted_moves_);
+  reclassify(universe_);
+  make_ergodic_move<move_type::TWO_THREE>(universe_, attempted_moves_);
+  reclassify(universe_);
+  make_ergodic_move<move_type::SIX_TWO>(universe_, attempted_moves_);
+  reclassify(universe_);
+  make_ergodic_move<move_type::THREE_TWO>(universe_, attempted_moves_);
+  reclassify(universe_);
+  EXPECT_EQ(attempted_moves_[1], 2) << "A (3,2) move took more than 1 try.";
+
+  // Compare the maintained index with one built from scratch
+  auto maintained = *universe_.flippable_edges;
+  universe_.flippable_edges = boost::none;
+  const auto& rebuilt = flippable_32_edges(universe_);
+  EXPECT_EQ(maintained.number_of_edges(), rebuilt.number_of_edges())
+      << "Degrees are known for the wrong number of edges.";
+  EXPECT_EQ(maintained.size(), rebuilt.size())
+      << "The index has the wrong number of flippable edges.";
+  for (std::size_t n = 0; n < rebuilt.size(); ++n) {
+    EXPECT_TRUE(maintained.contains(rebuilt[n].first, rebuilt[n].second))
+        << "A flippable edge is missing from the index.";
+  }
+  for (const auto& edge : universe_.geometry->timelike_edges) {
+    auto cell = std::get<0>(edge);
+    auto u    = cell->vertex(static_cast<int>(std::get<1>(edge)));
+    auto v    = cell->vertex(static_cast<int>(std::get<2>(edge)));
+    EXPECT_EQ(maintained.degree(u, v), rebuilt.degree(u, v))
+        << "An edge has the wrong degree.";
+  }
+}
+
+TEST_F(T3ErgodicMoveTest, MoveManagerChecksEachMove) {
+  auto maybe_universe   = boost::make_optional(true, universe_);
+  auto maybe_move_count = boost::make_optional(true, attempted_moves_);
+  MoveManager<decltype(maybe_universe), decltype(maybe_move_count)> manager(
+      std::move(maybe_universe), std::move(maybe_move_count));
+
+  EXPECT_TRUE(manager.make_move(move_type::TWO_SIX))
+      << "(2,6) move failed its checks.";
+
+  EXPECT_TRUE(manager.make_move(move_type::SIX_TWO))
+      << "(6,2) move failed its checks.";
+
+  EXPECT_TRUE(manager.make_move(move_type::TWO_THREE))
+      << "(2,3) move failed its checks.";
+
+  EXPECT_TRUE(manager.make_move(move_type::THREE_TWO))
+      << "(3,2) move failed its checks.";
+}
+
+TEST_F(T3ErgodicMoveTest, MetropolisRuns) {
+  Basic_metropolis<ToroidalManifold> testrun(0.6, 1.1, 0.1, 1, 1);
+  testrun(universe_);
+
+  EXPECT_GT(testrun.TotalMoves(), 0) << "No moves were attempted.";
+
+  EXPECT_GT(testrun.SuccessfulTwoSixMoves(), 0)
+      << "No (2,6) moves succeeded.";
+}
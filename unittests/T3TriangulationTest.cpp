@@ -0,0 +1,138 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Tests that foliated tetrahedrons are constructed correctly
+/// in a periodic Delaunay triangulation.
+
+/// @file T3TriangulationTest.cpp
+/// @brief Tests for correctly foliated toroidal triangulations
+/// @author Adam Getchell
+
+// clang-format off
+#include <utility>
+
+#include "T3Triangulation.h"
+#include "ToroidalManifold.h"
+#include "gmock/gmock.h"
+// clang-format on
+
+TEST(T3Triangulation, LowerTimesliceIsPeriodic) {
+  T3Tds tds;
+  auto  cell = tds.create_cell(tds.create_vertex(), tds.create_vertex(),
+                              tds.create_vertex(), tds.create_vertex());
+  auto set_times = [&cell](std::intmax_t a, std::intmax_t b, std::intmax_t c,
+                           std::intmax_t d) {
+    cell->vertex(0)->info() = a;
+    cell->vertex(1)->info() = b;
+    cell->vertex(2)->info() = c;
+    cell->vertex(3)->info() = d;
+  };
+
+  set_times(2, 2, 2, 3);
+  EXPECT_EQ(lower_timeslice(cell, 4), 2) << "Adjacent timeslices failed.";
+
+  set_times(4, 1, 1, 4);
+  EXPECT_EQ(lower_timeslice(cell, 4), 4)
+      << "The last timeslice doesn't precede the first.";
+
+  set_times(1, 1, 3, 3);
+  EXPECT_EQ(lower_timeslice(cell, 4), 0)
+      << "A cell skipping a timeslice was foliated.";
+
+  set_times(1, 2, 3, 3);
+  EXPECT_EQ(lower_timeslice(cell, 4), 0)
+      << "A cell spanning three timeslices was foliated.";
+
+  set_times(2, 2, 2, 2);
+  EXPECT_EQ(lower_timeslice(cell, 4), 0)
+      << "A cell on one timeslice was foliated.";
+}
+
+TEST(T3Triangulation, RejectsTooFewTimeslices) {
+  EXPECT_THROW(ToroidalManifold universe(640, 2), std::invalid_argument)
+      << "Two timeslices aren't unambiguously periodic.";
+}
+
+TEST(T3Triangulation, SeededToriAreTheSame) {
+  auto seeded_torus = [] {
+    Random_scope random(42, 0, UNIVERSE_PROPOSAL);
+    return make_foliated_torus(640, 4);
+  };
+  auto first  = seeded_torus();
+  auto second = seeded_torus();
+
+  ASSERT_EQ(first.size(), second.size()) << "Tori have different sizes.";
+  for (std::size_t i = 0; i < first.size(); ++i) {
+    ASSERT_EQ(first[i], second[i]) << "Point " << i << " differs.";
+  }
+}
+
+TEST(T3Triangulation, ToroidalManifold_SimplicesTimeslicesCtor) {
+  constexpr auto   simplices  = static_cast<std::intmax_t>(6400);
+  constexpr auto   timeslices = static_cast<std::intmax_t>(8);
+  ToroidalManifold universe(simplices, timeslices);
+  const auto&      tds = universe.triangulation->tds();
+
+  EXPECT_TRUE(universe.triangulation->is_triangulation_in_1_sheet())
+      << "Triangulation isn't a 1-sheeted covering.";
+
+  EXPECT_EQ(tds.number_of_cells(), universe.geometry->number_of_cells())
+      << "Triangulation has wrong number of cells.";
+
+  EXPECT_EQ(tds.number_of_edges(), universe.geometry->number_of_edges())
+      << "Triangulation has wrong number of edges.";
+
+  EXPECT_EQ(tds.number_of_vertices(), universe.geometry->N0())
+      << "Triangulation has the wrong number of vertices.";
+
+  for (const auto& vertex : universe.geometry->vertices) {
+    EXPECT_TRUE(IsBetween<std::intmax_t>(vertex->info(), 1, timeslices))
+        << "Vertex timevalue " << vertex->info() << " is out of range.";
+  }
+
+  for (auto cit = tds.cells_begin(); cit != tds.cells_end(); ++cit) {
+    EXPECT_TRUE(is_foliated(universe, cit))
+        << "A cell doesn't span adjacent timeslices.";
+  }
+
+  EXPECT_EQ(universe.geometry->N3_31(), universe.geometry->N3_13())
+      << "A closed foliation has as many (3,1) as (1,3) simplices.";
+
+  EXPECT_TRUE(universe.triangulation->is_valid())
+      << "Triangulation is not Delaunay.";
+
+  EXPECT_TRUE(tds.is_valid()) << "Triangulation is invalid.";
+}
+
+TEST(T3Triangulation, CopiesAreReclassified) {
+  ToroidalManifold universe(6400, 8);
+  ToroidalManifold copy(universe);
+
+  EXPECT_EQ(copy.geometry->N3_22(), universe.geometry->N3_22())
+      << "(2,2) simplices changed in the copy.";
+
+  EXPECT_TRUE(copy.triangulation->tds().is_cell(copy.geometry->two_two[0]))
+      << "The copy's geometry refers to the original triangulation.";
+}
+
+TEST(T3Triangulation, SnapshotHasNoInfiniteCells) {
+  ToroidalManifold universe(6400, 8);
+  auto             snapshot = make_snapshot(universe);
+
+  EXPECT_EQ(snapshot.number_of_finite_cells(), snapshot.number_of_cells())
+      << "A toroidal snapshot has infinite cells.";
+
+  EXPECT_EQ(snapshot.number_of_cells(), universe.geometry->number_of_cells())
+      << "Snapshot has wrong number of cells.";
+
+  auto volumes = volume_per_timeslice(snapshot);
+  VolumePerTimeslice(universe);
+  for (const auto& volume : volumes) {
+    EXPECT_EQ(
+        static_cast<std::intmax_t>(
+            universe.geometry->spacelike_facets->count(volume.first)),
+        volume.second)
+        << "Timeslice " << volume.first << " has the wrong volume.";
+  }
+}
@@ -0,0 +1,107 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Tests for the shared work-stealing thread pool
+
+/// @file ThreadPoolTest.cpp
+/// @brief Tests for ThreadPool.h
+/// @author Adam Getchell
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+#include "ThreadPool.h"
+#include "gmock/gmock.h"
+
+TEST(ThreadPoolTest, SubmittedTasksReturnResults) {
+  Thread_pool pool(2);
+  auto        answer = pool.submit([] { return 6 * 7; });
+  EXPECT_EQ(pool.wait(answer), 42) << "A task returned the wrong result.";
+}
+
+TEST(ThreadPoolTest, ParallelForVisitsEachIndexOnce) {
+  Thread_pool                  pool(4);
+  std::vector<std::atomic_int> visits(1000);
+  pool.parallel_for(0, visits.size(), [&visits](const std::size_t i) {
+    ++visits[i];
+  });
+  for (const auto& count : visits) {
+    EXPECT_EQ(count, 1) << "An index wasn't visited exactly once.";
+  }
+}
+
+TEST(ThreadPoolTest, NestedLoopsRunOnOneWorker) {
+  // Each task waiting on an inner loop runs the inner tasks itself
+  Thread_pool     pool(1);
+  std::atomic_int inner{0};
+  pool.parallel_for(0, 8, [&pool, &inner](std::size_t) {
+    pool.parallel_for(0, 8, [&inner](std::size_t) { ++inner; });
+  });
+  EXPECT_EQ(inner, 64) << "Nested loops didn't finish.";
+}
+
+TEST(ThreadPoolTest, WaitersRunOnlyTheirOwnLoop) {
+  // Like a sweep building a shared seed universe: the first body runs an
+  // inner loop and then releases the others, so whoever waits on the inner
+  // loop must not pick up an outer body and block on itself
+  Thread_pool        pool(2);
+  std::promise<void> built;
+  auto               ready = built.get_future().share();
+  std::atomic_bool   building{false};
+  pool.parallel_for(0, 8, [&](std::size_t) {
+    if (!building.exchange(true)) {
+      pool.parallel_for(0, 64, [](std::size_t) {});
+      built.set_value();
+    }
+    ready.wait();
+  });
+  EXPECT_TRUE(building) << "The loop didn't run.";
+}
+
+TEST(ThreadPoolTest, ParallelForRethrows) {
+  Thread_pool pool(2);
+  EXPECT_THROW(pool.parallel_for(0, 100,
+                                 [](const std::size_t i) {
+                                   if (i == 50)
+                                     throw std::runtime_error("Failed.");
+                                 }),
+               std::runtime_error)
+      << "An exception in a task was lost.";
+}
+
+TEST(ThreadPoolTest, ParsesCpuLists) {
+  EXPECT_THAT(parse_cpu_list("0-3,8,10-11"),
+              ::testing::ElementsAre(0, 1, 2, 3, 8, 10, 11))
+      << "A CPU list was misread.";
+
+  EXPECT_TRUE(parse_cpu_list("").empty()) << "An empty list has CPUs.";
+}
+
+TEST(ThreadPoolTest, WorkersAreSpreadOverNumaNodes) {
+  const auto nodes = numa_nodes();
+  ASSERT_FALSE(nodes.empty()) << "No CPUs were found.";
+
+  Thread_pool pool(4);
+  EXPECT_EQ(pool.nodes(), std::min<std::size_t>(nodes.size(), 4))
+      << "Workers weren't spread over every node.";
+
+  std::vector<std::size_t> worker_nodes(100);
+  pool.parallel_for(0, worker_nodes.size(),
+                    [&pool, &worker_nodes](const std::size_t i) {
+                      worker_nodes[i] = pool.current_node();
+                    });
+  for (const auto node : worker_nodes) {
+    EXPECT_LT(node, pool.nodes()) << "A task ran on an unknown node.";
+  }
+}
+
+TEST(ThreadPoolTest, SharedPoolCannotBeResizedOnceRunning) {
+  EXPECT_GT(Thread_pool::instance().size(), 0u) << "The pool has no workers.";
+
+  EXPECT_THROW(Thread_pool::configure(2), std::logic_error)
+      << "The running pool was resized.";
+}
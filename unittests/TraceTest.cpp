@@ -0,0 +1,91 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Tests for Chrome trace export.
+
+/// @file TraceTest.cpp
+/// @brief Tests for trace spans and buffers
+/// @author Adam Getchell
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+
+#include "Trace.h"
+#include "gmock/gmock.h"
+
+using ::testing::HasSubstr;
+using ::testing::StartsWith;
+
+TEST(Trace, BufferIsFirstInFirstOut) {
+  auto buffer = std::make_unique<Trace_buffer>();
+  for (std::intmax_t i = 0; i < 3; ++i) {
+    EXPECT_TRUE(buffer->push(Trace_event{"Test", "test", 0, 0, i, 0}))
+        << "Push failed on an empty buffer.";
+  }
+  std::vector<std::intmax_t> values;
+  auto                       drained = buffer->drain(
+      [&values](const Trace_event& event) { values.push_back(event.value); });
+
+  EXPECT_EQ(drained, 3) << "Wrong number of events drained.";
+
+  EXPECT_THAT(values, ::testing::ElementsAre(0, 1, 2))
+      << "Events not drained in order.";
+}
+
+TEST(Trace, FullBufferDrops) {
+  auto buffer = std::make_unique<Trace_buffer>();
+  for (std::size_t i = 0; i < TRACE_BUFFER_CAPACITY; ++i) {
+    buffer->push(Trace_event{"Test", "test", 0, 0, TRACE_NO_VALUE, 0});
+  }
+
+  EXPECT_FALSE(buffer->push(Trace_event{"Test", "test", 0, 0, 0, 0}))
+      << "Push succeeded on a full buffer.";
+
+  EXPECT_EQ(buffer->dropped(), 1) << "Dropped event not counted.";
+
+  buffer->drain([](const Trace_event&) {});
+
+  EXPECT_TRUE(buffer->push(Trace_event{"Test", "test", 0, 0, 0, 0}))
+      << "Push failed after draining.";
+}
+
+TEST(Trace, WritesChromeTrace) {
+  const std::string filename = "TraceTest.json";
+  Tracer::instance().start(filename);
+
+  EXPECT_TRUE(Tracer::instance().enabled()) << "Tracer didn't start.";
+
+  { Trace_span span("Main", "test"); }
+  std::thread worker([] { Trace_span span("Worker", "test", 42); });
+  worker.join();
+  Tracer::instance().stop();
+
+  EXPECT_FALSE(Tracer::instance().enabled()) << "Tracer didn't stop.";
+
+  std::ifstream     file(filename);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  auto trace = contents.str();
+
+  EXPECT_THAT(trace, StartsWith("[")) << "Trace is not a JSON array.";
+
+  EXPECT_THAT(trace, HasSubstr(R"("name":"Main")")) << "Main span missing.";
+
+  EXPECT_THAT(trace, HasSubstr(R"("args":{"value":42})"))
+      << "Worker span or its argument missing.";
+
+  EXPECT_THAT(trace, HasSubstr("]")) << "Trace not closed.";
+
+  std::remove(filename.c_str());
+}
+
+TEST(Trace, SpansAreFreeWhenOff) {
+  ASSERT_FALSE(Tracer::instance().enabled()) << "Tracer is running.";
+
+  // Nothing should be recorded, and nothing should throw
+  { Trace_span span("Off", "test"); }
+}
@@ -0,0 +1,190 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Checks that trajectory frames round-trip and can be read in any order.
+
+/// @file TrajectoryTest.cpp
+/// @brief Tests for trajectory files
+/// @author Adam Getchell
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+
+#include "Trajectory.h"
+#include "gmock/gmock.h"
+
+class TrajectoryTest : public ::testing::Test {
+ public:
+  TrajectoryTest()
+      : universe_{make_triangulation(6400, 7)}
+      , filename_{"TrajectoryTest.traj"} {}
+
+  virtual void SetUp() { std::remove(filename_.c_str()); }
+
+  virtual void TearDown() { std::remove(filename_.c_str()); }
+
+  /// @brief Simplicial manifold containing pointer to triangulation
+  /// and geometric information.
+  SimplicialManifold universe_;
+
+  /// @brief The trajectory file written by each test
+  std::string filename_;
+};
+
+TEST(Trajectory, ZigzagRoundTrip) {
+  for (std::int64_t value :
+       {std::int64_t{0}, std::int64_t{-1}, std::int64_t{1},
+        std::int64_t{-64}, std::int64_t{64},
+        std::numeric_limits<std::int64_t>::min(),
+        std::numeric_limits<std::int64_t>::max()}) {
+    EXPECT_EQ(zigzag_decode(zigzag_encode(value)), value)
+        << value << " didn't round-trip.";
+  }
+  EXPECT_LT(zigzag_encode(-1), zigzag_encode(64))
+      << "Small magnitudes should encode small.";
+}
+
+TEST_F(TrajectoryTest, FrameRoundTrip) {
+  Move_tracker attempted{{5, 4, 3, 2, 1}};
+  Move_tracker successful{{1, 1, 1, 1, 0}};
+  auto         snapshot = make_snapshot(universe_);
+  auto         packed   = pack_frame(snapshot, attempted, successful);
+  auto         frame    = unpack_frame(packed);
+
+  EXPECT_EQ(frame.attempted_moves, attempted)
+      << "Attempted moves weren't restored.";
+
+  EXPECT_EQ(frame.successful_moves, successful)
+      << "Successful moves weren't restored.";
+
+  EXPECT_EQ(frame.snapshot.vertex_timevalues, snapshot.vertex_timevalues)
+      << "Vertex timevalues weren't restored.";
+
+  EXPECT_EQ(frame.snapshot.x, snapshot.x) << "Points weren't restored.";
+
+  EXPECT_EQ(frame.snapshot.cell_vertices, snapshot.cell_vertices)
+      << "Cells weren't restored.";
+
+  EXPECT_EQ(frame.snapshot.cell_neighbors, snapshot.cell_neighbors)
+      << "Neighbors weren't restored.";
+
+  EXPECT_EQ(frame.snapshot.cell_types, snapshot.cell_types)
+      << "Cell types weren't restored.";
+
+  EXPECT_EQ(frame.snapshot.number_of_finite_cells(),
+            snapshot.number_of_finite_cells())
+      << "Finite cell count wasn't restored.";
+
+  auto unpacked_size =
+      snapshot.vertex_timevalues.size() * sizeof(std::intmax_t) +
+      snapshot.cell_vertices.size() * sizeof(Snapshot_index) +
+      snapshot.cell_neighbors.size() * sizeof(Snapshot_index);
+  EXPECT_LT(packed.size(), unpacked_size)
+      << "Packing didn't shrink the frame.";
+}
+
+TEST_F(TrajectoryTest, RandomAccess) {
+  {
+    Trajectory_writer writer(filename_);
+    writer.append_universe(universe_, 10, Move_tracker{{1, 0, 0, 0, 0}},
+                           Move_tracker{});
+    writer.append_universe(universe_, 20, Move_tracker{{2, 0, 0, 0, 0}},
+                           Move_tracker{});
+  }
+  {
+    // Reopening continues the trajectory
+    Trajectory_writer writer(filename_);
+    writer.append_universe(universe_, 30, Move_tracker{{3, 0, 0, 0, 0}},
+                           Move_tracker{});
+  }
+
+  Trajectory_reader reader(filename_);
+  ASSERT_EQ(reader.size(), std::size_t{3}) << "Frames are missing.";
+
+  EXPECT_EQ(reader.pass(1), 20) << "Frame passes are wrong.";
+
+  EXPECT_EQ(reader.read(2).attempted_moves[0], 3)
+      << "The last frame wasn't read.";
+
+  auto first = reader.read(0);
+  EXPECT_EQ(first.attempted_moves[0], 1) << "The first frame wasn't read.";
+
+  auto rebuilt = load_universe(first);
+  EXPECT_TRUE(rebuilt.triangulation->tds().is_valid())
+      << "A frame didn't rebuild a valid triangulation.";
+
+  EXPECT_EQ(rebuilt.geometry->N3_22(), universe_.geometry->N3_22())
+      << "(2,2) simplices changed.";
+}
+
+TEST_F(TrajectoryTest, IgnoresTruncatedFrame) {
+  {
+    Trajectory_writer writer(filename_);
+    writer.append_universe(universe_, 1, Move_tracker{}, Move_tracker{});
+    writer.append_universe(universe_, 2, Move_tracker{}, Move_tracker{});
+  }
+  {
+    // Cut the last frame short, as a crash while writing it would
+    std::ifstream in(filename_, std::ios::binary);
+    std::string   contents((std::istreambuf_iterator<char>(in)),
+                         std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream out(filename_, std::ios::binary | std::ios::trunc);
+    out.write(contents.data(),
+              static_cast<std::streamsize>(contents.size() - 16));
+  }
+
+  Trajectory_reader reader(filename_);
+  ASSERT_EQ(reader.size(), std::size_t{1})
+      << "The truncated frame was indexed.";
+
+  EXPECT_EQ(reader.pass(0), 1) << "The complete frame was lost.";
+}
+
+TEST_F(TrajectoryTest, AppendsAfterTruncatedFrame) {
+  {
+    Trajectory_writer writer(filename_);
+    writer.append_universe(universe_, 1, Move_tracker{}, Move_tracker{});
+    writer.append_universe(universe_, 2, Move_tracker{}, Move_tracker{});
+  }
+  {
+    // Cut the last frame short, as a crash while writing it would
+    std::ifstream in(filename_, std::ios::binary);
+    std::string   contents((std::istreambuf_iterator<char>(in)),
+                         std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream out(filename_, std::ios::binary | std::ios::trunc);
+    out.write(contents.data(),
+              static_cast<std::streamsize>(contents.size() - 16));
+  }
+  {
+    Trajectory_writer writer(filename_);
+    EXPECT_EQ(writer.last_pass(), 1) << "The last complete frame was missed.";
+    writer.append_universe(universe_, 3, Move_tracker{}, Move_tracker{});
+  }
+
+  Trajectory_reader reader(filename_);
+  ASSERT_EQ(reader.size(), std::size_t{2})
+      << "Frames after the truncated one were lost.";
+
+  EXPECT_EQ(reader.pass(1), 3) << "The appended frame wasn't read.";
+
+  EXPECT_TRUE(load_universe(reader.read(1)).triangulation->tds().is_valid())
+      << "The appended frame didn't rebuild a valid triangulation.";
+}
+
+TEST_F(TrajectoryTest, RejectsOtherFiles) {
+  {
+    std::ofstream file(filename_);
+    file << "Not a trajectory file.";
+  }
+  EXPECT_THROW(Trajectory_reader reader(filename_), std::invalid_argument)
+      << "A text file was read as a trajectory.";
+
+  EXPECT_THROW(Trajectory_writer writer(filename_), std::invalid_argument)
+      << "A text file was appended to as a trajectory.";
+}
@@ -0,0 +1,121 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Checks that universe files round-trip triangulations and move statistics.
+
+/// @file UniverseFileTest.cpp
+/// @brief Tests for saving and loading universes
+/// @author Adam Getchell
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <optional>
+#include <string>
+
+#include "UniverseFile.h"
+#include "gmock/gmock.h"
+
+class UniverseFileTest : public ::testing::Test {
+ public:
+  UniverseFileTest()
+      : universe_{make_triangulation(6400, 7)}
+      , filename_{"UniverseFileTest.univ"} {}
+
+  virtual void TearDown() { std::remove(filename_.c_str()); }
+
+  /// @brief Simplicial manifold containing pointer to triangulation
+  /// and geometric information.
+  SimplicialManifold universe_;
+
+  /// @brief The universe file written by each test
+  std::string filename_;
+};
+
+TEST_F(UniverseFileTest, RoundTrip) {
+  Move_tracker attempted{{5, 4, 3, 2, 1}};
+  Move_tracker successful{{1, 1, 1, 1, 0}};
+  auto         snapshot = make_snapshot(universe_);
+  write_universe(filename_, snapshot, attempted, successful, 120, 42);
+
+  auto saved = read_universe(filename_);
+
+  EXPECT_EQ(saved.attempted_moves, attempted)
+      << "Attempted moves weren't restored.";
+
+  EXPECT_EQ(saved.successful_moves, successful)
+      << "Successful moves weren't restored.";
+
+  EXPECT_EQ(saved.passes, 120) << "The pass count wasn't restored.";
+
+  EXPECT_EQ(saved.seed, std::optional<std::uint64_t>{42})
+      << "The seed wasn't restored.";
+
+  EXPECT_EQ(saved.snapshot.vertex_timevalues, snapshot.vertex_timevalues)
+      << "Vertex timevalues weren't restored.";
+
+  EXPECT_EQ(saved.snapshot.x, snapshot.x) << "Points weren't restored.";
+
+  EXPECT_EQ(saved.snapshot.cell_vertices, snapshot.cell_vertices)
+      << "Cells weren't restored.";
+
+  EXPECT_EQ(saved.snapshot.cell_neighbors, snapshot.cell_neighbors)
+      << "Neighbors weren't restored.";
+
+  EXPECT_EQ(saved.snapshot.cell_types, snapshot.cell_types)
+      << "Cell types weren't restored.";
+
+  EXPECT_EQ(saved.snapshot.number_of_finite_cells(),
+            snapshot.number_of_finite_cells())
+      << "Finite cell count wasn't restored.";
+}
+
+TEST_F(UniverseFileTest, LoadRebuildsTheManifold) {
+  save_universe(filename_, universe_, Move_tracker{}, Move_tracker{});
+  auto saved = read_universe(filename_);
+  EXPECT_FALSE(saved.seed) << "An unseeded run saved a seed.";
+  auto loaded = load_universe(saved);
+
+  EXPECT_TRUE(loaded.triangulation->tds().is_valid())
+      << "Loaded triangulation is invalid.";
+
+  EXPECT_EQ(loaded.geometry->N3_31(), universe_.geometry->N3_31())
+      << "(3,1) simplices changed.";
+
+  EXPECT_EQ(loaded.geometry->N3_22(), universe_.geometry->N3_22())
+      << "(2,2) simplices changed.";
+
+  EXPECT_EQ(loaded.geometry->N3_13(), universe_.geometry->N3_13())
+      << "(1,3) simplices changed.";
+
+  EXPECT_EQ(loaded.geometry->N1_TL(), universe_.geometry->N1_TL())
+      << "Timelike edges changed.";
+
+  EXPECT_EQ(loaded.geometry->N0(), universe_.geometry->N0())
+      << "Vertices changed.";
+}
+
+TEST_F(UniverseFileTest, RejectsOtherFiles) {
+  {
+    std::ofstream file(filename_);
+    file << "Not a universe file, but long enough to hold a header. "
+         << std::string(256, ' ');
+  }
+  EXPECT_THROW(read_universe(filename_), std::invalid_argument)
+      << "A text file was read as a universe.";
+
+  save_universe(filename_, universe_, Move_tracker{}, Move_tracker{});
+  {
+    // Truncate the file
+    std::ifstream in(filename_, std::ios::binary);
+    std::string   contents((std::istreambuf_iterator<char>(in)),
+                         std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream out(filename_, std::ios::binary | std::ios::trunc);
+    out.write(contents.data(),
+              static_cast<std::streamsize>(contents.size() / 2));
+  }
+  EXPECT_THROW(read_universe(filename_), std::invalid_argument)
+      << "A truncated universe file was read.";
+}
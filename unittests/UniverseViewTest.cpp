@@ -0,0 +1,142 @@
+/// Causal Dynamical Triangulations in C++ using CGAL
+///
+/// Copyright © 2017 Adam Getchell
+///
+/// Checks that memory-mapped universe files read the same as Snapshots.
+
+/// @file UniverseViewTest.cpp
+/// @brief Tests for memory-mapped universe files
+/// @author Adam Getchell
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <utility>
+
+#include "UniverseView.h"
+#include "gmock/gmock.h"
+
+class UniverseViewTest : public ::testing::Test {
+ public:
+  UniverseViewTest()
+      : universe_{make_triangulation(6400, 7)}
+      , snapshot_{make_snapshot(universe_)}
+      , filename_{"UniverseViewTest.univ"} {}
+
+  virtual void SetUp() {
+    write_universe(filename_, snapshot_, Move_tracker{{4, 3, 2, 1, 0}},
+                   Move_tracker{{1, 1, 1, 1, 0}});
+  }
+
+  virtual void TearDown() { std::remove(filename_.c_str()); }
+
+  /// @brief Simplicial manifold containing pointer to triangulation
+  /// and geometric information.
+  SimplicialManifold universe_;
+
+  /// @brief The Snapshot of universe_
+  Snapshot snapshot_;
+
+  /// @brief The universe file written by each test
+  std::string filename_;
+};
+
+TEST_F(UniverseViewTest, MatchesSnapshot) {
+  ASSERT_TRUE(is_universe_file(filename_)) << "Magic number not written.";
+
+  Universe_view view(filename_);
+
+  ASSERT_EQ(view.number_of_vertices(), snapshot_.number_of_vertices())
+      << "Vertex count differs.";
+
+  ASSERT_EQ(view.number_of_cells(), snapshot_.number_of_cells())
+      << "Cell count differs.";
+
+  EXPECT_EQ(view.number_of_finite_cells(), snapshot_.number_of_finite_cells())
+      << "Finite cell count differs.";
+
+  for (Snapshot_index v = 0; v < view.number_of_vertices(); ++v) {
+    ASSERT_EQ(view.timevalue(v), snapshot_.timevalue(v))
+        << "Timevalue of vertex " << v << " differs.";
+    ASSERT_EQ(view.point(v), snapshot_.point(v))
+        << "Point of vertex " << v << " differs.";
+  }
+
+  for (Snapshot_index c = 0; c < view.number_of_cells(); ++c) {
+    ASSERT_EQ(view.cell_type(c), snapshot_.cell_type(c))
+        << "Type of cell " << c << " differs.";
+    for (auto i = 0; i < 4; ++i) {
+      ASSERT_EQ(view.vertex(c, i), snapshot_.vertex(c, i))
+          << "Vertex " << i << " of cell " << c << " differs.";
+      ASSERT_EQ(view.neighbor(c, i), snapshot_.neighbor(c, i))
+          << "Neighbor " << i << " of cell " << c << " differs.";
+    }
+  }
+
+  EXPECT_EQ(view.attempted_moves(), (Move_tracker{{4, 3, 2, 1, 0}}))
+      << "Attempted moves differ.";
+
+  EXPECT_EQ(view.successful_moves(), (Move_tracker{{1, 1, 1, 1, 0}}))
+      << "Successful moves differ.";
+
+  EXPECT_EQ(view.passes(), 0) << "Pass count differs.";
+
+  EXPECT_FALSE(view.seed()) << "An unseeded run has a seed.";
+}
+
+TEST_F(UniverseViewTest, MeasuresAndRebuilds) {
+  Universe_view view(filename_);
+  EXPECT_NO_THROW(check_snapshot_indices(view)) << "Indices out of range.";
+
+  EXPECT_EQ(volume_per_timeslice(view), volume_per_timeslice(snapshot_))
+      << "Volume per timeslice differs between view and Snapshot.";
+
+  auto triangulation = rebuild_triangulation(view);
+
+  EXPECT_TRUE(triangulation->tds().is_valid())
+      << "Triangulation rebuilt from a view is invalid.";
+
+  EXPECT_EQ(triangulation->number_of_finite_cells(),
+            universe_.triangulation->number_of_finite_cells())
+      << "Rebuilt triangulation has a different number of cells.";
+}
+
+TEST_F(UniverseViewTest, Moves) {
+  Universe_view view(filename_);
+  auto          cells = view.number_of_cells();
+  Universe_view moved(std::move(view));
+
+  EXPECT_EQ(moved.number_of_cells(), cells)
+      << "Moved-to view lost the mapping.";
+}
+
+TEST_F(UniverseViewTest, RejectsOtherFiles) {
+  {
+    std::ofstream file(filename_, std::ios::trunc);
+    file << "Not a universe file, but long enough to hold a header. "
+         << std::string(256, ' ');
+  }
+  EXPECT_FALSE(is_universe_file(filename_)) << "Text file has the magic.";
+
+  EXPECT_THROW(Universe_view view(filename_), std::invalid_argument)
+      << "A text file was mapped as a universe.";
+
+  EXPECT_THROW(Universe_view view("does-not-exist.univ"),
+               std::invalid_argument)
+      << "A missing file was mapped.";
+}
+
+TEST_F(UniverseViewTest, RejectsCorruptOffsets) {
+  {
+    // Point the x coordinates far past the end of the file
+    std::fstream file(filename_,
+                      std::ios::in | std::ios::out | std::ios::binary);
+    std::int64_t offset = std::int64_t{1} << 40;
+    file.seekp(offsetof(Universe_header, x_offset));
+    file.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+  }
+  EXPECT_THROW(Universe_view view(filename_), std::invalid_argument)
+      << "A view was made of arrays outside the file.";
+}